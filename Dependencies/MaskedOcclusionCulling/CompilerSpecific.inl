@@ -77,12 +77,16 @@
 		free(ptr);
 	}
 
-	FORCE_INLINE void __cpuidex(int* cpuinfo, int function, int subfunction)
+	// Newer GCC/clang headers declare their own __cpuidex/_xgetbv (the latter requiring -mxsave), so use private names
+	#define __cpuidex moc_cpuidex
+	#define _xgetbv moc_xgetbv
+
+	FORCE_INLINE void moc_cpuidex(int* cpuinfo, int function, int subfunction)
 	{
 		__cpuid_count(function, subfunction, cpuinfo[0], cpuinfo[1], cpuinfo[2], cpuinfo[3]);
 	}
 
-	FORCE_INLINE unsigned long long _xgetbv(unsigned int index)
+	FORCE_INLINE unsigned long long moc_xgetbv(unsigned int index)
 	{
 		unsigned int eax, edx;
 		__asm__ __volatile__(
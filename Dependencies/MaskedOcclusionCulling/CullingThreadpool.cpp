@@ -277,7 +277,10 @@ void CullingThreadpool::ThreadMain(unsigned int threadIdx)
 					RenderJobQueue::BinningJob &sjob = job->mBinningJob;
 					for (unsigned int i = 0; i < mNumBins; ++i)
 						job->mRenderJobs[i].mTriIdx = 0;
-					mMOC->BinTriangles(sjob.mVerts, sjob.mTris, sjob.nTris, job->mRenderJobs, mBinsW, mBinsH, sjob.mMatrix, sjob.mBfWinding, sjob.mClipPlanes, *sjob.mVtxLayout);
+					if (sjob.mQuantizedVerts != nullptr)
+						mMOC->BinTrianglesQuantized(sjob.mQuantizedVerts, sjob.mQuantizedTris, sjob.nTris, job->mRenderJobs, mBinsW, mBinsH, sjob.mMatrix, sjob.mBfWinding, sjob.mClipPlanes);
+					else
+						mMOC->BinTriangles(sjob.mVerts, sjob.mTris, sjob.nTris, job->mRenderJobs, mBinsW, mBinsH, sjob.mMatrix, sjob.mBfWinding, sjob.mClipPlanes, *sjob.mVtxLayout);
 					mRenderQueue->FinishedBinningJob(job);
 				}
 				continue;
@@ -446,6 +449,31 @@ void CullingThreadpool::RenderTriangles(const float *inVtx, const unsigned int *
 		RenderJobQueue::Job *job = mRenderQueue->GetWriteJob();
 		job->mBinningJob.mVerts = inVtx;
 		job->mBinningJob.mTris = inTris + i * 3;
+		job->mBinningJob.mQuantizedVerts = nullptr;
+		job->mBinningJob.mQuantizedTris = nullptr;
+		job->mBinningJob.nTris = nTris - i < TRIS_PER_JOB ? nTris - i : TRIS_PER_JOB;
+		job->mBinningJob.mMatrix = mCurrentMatrix;
+		job->mBinningJob.mClipPlanes = clipPlaneMask;
+		job->mBinningJob.mBfWinding = bfWinding;
+		job->mBinningJob.mVtxLayout = mVertexLayouts.GetData();
+		mRenderQueue->AdvanceWriteJob();
+	}
+}
+
+void CullingThreadpool::RenderTrianglesQuantized(const unsigned short *inVtx, const unsigned short *inTris, int nTris, BackfaceWinding bfWinding, ClipPlanes clipPlaneMask)
+{
+	for (int i = 0; i < nTris; i += TRIS_PER_JOB)
+	{
+		// Yield if work queue is full 
+		while (!mRenderQueue->CanWrite())
+			std::this_thread::yield();
+
+		// Create new renderjob
+		RenderJobQueue::Job *job = mRenderQueue->GetWriteJob();
+		job->mBinningJob.mVerts = nullptr;
+		job->mBinningJob.mTris = nullptr;
+		job->mBinningJob.mQuantizedVerts = inVtx;
+		job->mBinningJob.mQuantizedTris = inTris + i * 3;
 		job->mBinningJob.nTris = nTris - i < TRIS_PER_JOB ? nTris - i : TRIS_PER_JOB;
 		job->mBinningJob.mMatrix = mCurrentMatrix;
 		job->mBinningJob.mClipPlanes = clipPlaneMask;
@@ -70,6 +70,8 @@ protected:
 		{
 			const float*        mVerts;
 			const unsigned int* mTris;
+			const unsigned short* mQuantizedVerts;	// Used instead of mVerts/mTris when not null
+			const unsigned short* mQuantizedTris;
 			unsigned int        nTris;
 
 			const float*        mMatrix;
@@ -277,6 +279,12 @@ public:
 	 */
 	void RenderTriangles(const float *inVtx, const unsigned int *inTris, int nTris, BackfaceWinding bfWinding = MaskedOcclusionCulling::BACKFACE_CW, ClipPlanes clipPlaneMask = MaskedOcclusionCulling::CLIP_PLANE_ALL);
 
+	/*
+	 * \brief Asynchronously render quantized occluder triangles, see MaskedOcclusionCulling::RenderTrianglesQuantized()
+	 *        and RenderTriangles() above.
+	 */
+	void RenderTrianglesQuantized(const unsigned short *inVtx, const unsigned short *inTris, int nTris, BackfaceWinding bfWinding = MaskedOcclusionCulling::BACKFACE_CW, ClipPlanes clipPlaneMask = MaskedOcclusionCulling::CLIP_PLANE_ALL);
+
 	/*
 	 * \brief Occlusion query for a rectangle with a given depth, see MaskedOcclusionCulling::TestRect().
 	 *
@@ -363,6 +363,17 @@ public:
 	 */
 	virtual CullingResult RenderTriangles(const float *inVtx, const unsigned int *inTris, int nTris, const float *modelToClipMatrix = nullptr, BackfaceWinding bfWinding = BACKFACE_CW, ClipPlanes clipPlaneMask = CLIP_PLANE_ALL, const VertexLayout &vtxLayout = VertexLayout(16, 4, 12)) = 0;
 
+	/*!
+	 * \brief Same as RenderTriangles(), but for 16-bit quantized vertices and 16-bit indices.
+	 *
+	 * \param inVtx Pointer to an array of input vertices, four packed unsigned 16-bit values
+	 *        per vertex with the same (x,y,-,w) meaning as the default vertex layout. The values
+	 *        are converted to float as-is, so the dequantization scale and bias must be part of
+	 *        modelToClipMatrix.
+	 * \param inTris Pointer to an array of 16-bit vertex indices.
+	 */
+	virtual CullingResult RenderTrianglesQuantized(const unsigned short *inVtx, const unsigned short *inTris, int nTris, const float *modelToClipMatrix, BackfaceWinding bfWinding = BACKFACE_CW, ClipPlanes clipPlaneMask = CLIP_PLANE_ALL) = 0;
+
 	/*!
 	 * \brief Occlusion query for a rectangle with a given depth. The rectangle is given 
 	 *        in normalized device coordinates where (x,y) coordinates between [-1,1] map 
@@ -455,6 +466,12 @@ public:
 	 */
 	virtual void BinTriangles(const float *inVtx, const unsigned int *inTris, int nTris, TriList *triLists, unsigned int nBinsW, unsigned int nBinsH, const float *modelToClipMatrix = nullptr, BackfaceWinding bfWinding = BACKFACE_CW, ClipPlanes clipPlaneMask = CLIP_PLANE_ALL, const VertexLayout &vtxLayout = VertexLayout(16, 4, 12)) = 0;
 
+	/*!
+	 * \brief Same as BinTriangles(), but for 16-bit quantized vertices and 16-bit indices. See
+	 *        RenderTrianglesQuantized().
+	 */
+	virtual void BinTrianglesQuantized(const unsigned short *inVtx, const unsigned short *inTris, int nTris, TriList *triLists, unsigned int nBinsW, unsigned int nBinsH, const float *modelToClipMatrix, BackfaceWinding bfWinding = BACKFACE_CW, ClipPlanes clipPlaneMask = CLIP_PLANE_ALL) = 0;
+
 	/*!
 	 * \brief Renders all occluder triangles in a trilist. This function can be used in
 	 *        combination with BinTriangles() to create a threded (binning) rasterizer. The
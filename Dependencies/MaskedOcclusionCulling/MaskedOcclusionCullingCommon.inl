@@ -107,6 +107,29 @@ template<> FORCE_INLINE void VtxFetch4<0>(__mw *v, const unsigned int *inTrisPtr
 	(void)v; (void)inTrisPtr; (void)triVtx; (void)inVtx; (void)numLanes;
 }
 
+// Same as VtxFetch4, but for four packed 16-bit unsigned (x, y, z, w) values and 16-bit indices. The values are widened
+// to float here, the dequantization scale/bias is expected to be part of the model to clip matrix.
+template<int N> FORCE_INLINE void VtxFetch4Quantized(__mw *v, const unsigned short *inTrisPtr, int triVtx, const unsigned short *inVtx, int numLanes)
+{
+	const int ssePart = (SIMD_LANES / 4) - N;
+	for (int k = 0; k < 4; k++)
+	{
+		int lane = 4 * ssePart + k;
+		if (numLanes > lane)
+		{
+			__m128i vtx = _mm_loadl_epi64((const __m128i *)&inVtx[(unsigned int)inTrisPtr[lane * 3 + triVtx] << 2]);
+			v[k] = _mmw_insertf32x4_ps(v[k], _mm_cvtepi32_ps(_mm_unpacklo_epi16(vtx, _mm_setzero_si128())), ssePart);
+		}
+	}
+	VtxFetch4Quantized<N - 1>(v, inTrisPtr, triVtx, inVtx, numLanes);
+}
+
+template<> FORCE_INLINE void VtxFetch4Quantized<0>(__mw *v, const unsigned short *inTrisPtr, int triVtx, const unsigned short *inVtx, int numLanes)
+{
+	// Workaround for unused parameter warning
+	(void)v; (void)inTrisPtr; (void)triVtx; (void)inVtx; (void)numLanes;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Private class containing the implementation
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -661,6 +684,44 @@ public:
 		}
 	}
 
+	FORCE_INLINE void GatherVerticesQuantized(__mw *vtxX, __mw *vtxY, __mw *vtxW, const unsigned short *inVtx, const unsigned short *inTrisPtr, int numLanes)
+	{
+		// Same as GatherVerticesFast() for four packed 16-bit x, y, z, w-values
+		assert(numLanes >= 1);
+
+		__mw v[4], swz[4];
+		for (int i = 0; i < 3; i++)
+		{
+			VtxFetch4Quantized<SIMD_LANES / 4>(v, inTrisPtr, i, inVtx, numLanes);
+
+			swz[0] = _mmw_shuffle_ps(v[0], v[1], 0x44);
+			swz[2] = _mmw_shuffle_ps(v[0], v[1], 0xEE);
+			swz[1] = _mmw_shuffle_ps(v[2], v[3], 0x44);
+			swz[3] = _mmw_shuffle_ps(v[2], v[3], 0xEE);
+
+			vtxX[i] = _mmw_shuffle_ps(swz[0], swz[1], 0x88);
+			vtxY[i] = _mmw_shuffle_ps(swz[0], swz[1], 0xDD);
+			vtxW[i] = _mmw_shuffle_ps(swz[2], swz[3], 0xDD);
+		}
+	}
+
+	template<int FAST_GATHER>
+	FORCE_INLINE void GatherInput(__mw *vtxX, __mw *vtxY, __mw *vtxW, const float *inVtx, const unsigned int *inTrisPtr, int numLanes, const VertexLayout &vtxLayout)
+	{
+		if (FAST_GATHER)
+			GatherVerticesFast(vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes);
+		else
+			GatherVertices(vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes, vtxLayout);
+	}
+
+	// Quantized input always has the packed layout
+	template<int FAST_GATHER>
+	FORCE_INLINE void GatherInput(__mw *vtxX, __mw *vtxY, __mw *vtxW, const unsigned short *inVtx, const unsigned short *inTrisPtr, int numLanes, const VertexLayout &vtxLayout)
+	{
+		(void)vtxLayout;
+		GatherVerticesQuantized(vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes);
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Rasterization functions
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1501,8 +1562,8 @@ public:
 		return cullResult;
 	}
 
-	template<int TEST_Z, int FAST_GATHER>
-	FORCE_INLINE CullingResult RenderTriangles(const float *inVtx, const unsigned int *inTris, int nTris, const float *modelToClipMatrix, BackfaceWinding bfWinding, ClipPlanes clipPlaneMask, const VertexLayout &vtxLayout)
+	template<int TEST_Z, int FAST_GATHER, typename VtxType, typename IdxType>
+	FORCE_INLINE CullingResult RenderTriangles(const VtxType *inVtx, const IdxType *inTris, int nTris, const float *modelToClipMatrix, BackfaceWinding bfWinding, ClipPlanes clipPlaneMask, const VertexLayout &vtxLayout)
 	{
 		assert(mMaskedHiZBuffer != nullptr);
 
@@ -1521,7 +1582,7 @@ public:
 		__m128 clipTriBuffer[MAX_CLIPPED * 3];
 		int cullResult = CullingResult::VIEW_CULLED;
 
-		const unsigned int *inTrisPtr = inTris;
+		const IdxType *inTrisPtr = inTris;
 		int numLanes = SIMD_LANES;
 		int triIndex = 0;
 		while (triIndex < nTris || clipHead != clipTail)
@@ -1603,6 +1664,12 @@ public:
 		return retVal;
 	}
 
+	CullingResult RenderTrianglesQuantized(const unsigned short *inVtx, const unsigned short *inTris, int nTris, const float *modelToClipMatrix, BackfaceWinding bfWinding, ClipPlanes clipPlaneMask) override
+	{
+		// Not recorded, the recorder only stores float vertices
+		return (CullingResult)RenderTriangles<0, 1>(inVtx, inTris, nTris, modelToClipMatrix, bfWinding, clipPlaneMask, VertexLayout(16, 4, 12));
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Occlusion query functions
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1744,8 +1811,8 @@ public:
 		return CullingResult::OCCLUDED;
 	}
 
-	template<bool FAST_GATHER>
-	FORCE_INLINE void BinTriangles(const float *inVtx, const unsigned int *inTris, int nTris, TriList *triLists, unsigned int nBinsW, unsigned int nBinsH, const float *modelToClipMatrix, BackfaceWinding bfWinding, ClipPlanes clipPlaneMask, const VertexLayout &vtxLayout)
+	template<bool FAST_GATHER, typename VtxType, typename IdxType>
+	FORCE_INLINE void BinTriangles(const VtxType *inVtx, const IdxType *inTris, int nTris, TriList *triLists, unsigned int nBinsW, unsigned int nBinsH, const float *modelToClipMatrix, BackfaceWinding bfWinding, ClipPlanes clipPlaneMask, const VertexLayout &vtxLayout)
 	{
 		assert(mMaskedHiZBuffer != nullptr);
 
@@ -1760,7 +1827,7 @@ public:
 		int clipTail = 0;
 		__m128 clipTriBuffer[MAX_CLIPPED * 3];
 
-		const unsigned int *inTrisPtr = inTris;
+		const IdxType *inTrisPtr = inTris;
 		int numLanes = SIMD_LANES;
 		int triIndex = 0;
 		while (triIndex < nTris || clipHead != clipTail)
@@ -1861,8 +1928,13 @@ public:
 			BinTriangles<false>(inVtx, inTris, nTris, triLists, nBinsW, nBinsH, modelToClipMatrix, bfWinding, clipPlaneMask, vtxLayout);
 	}
 
-    template<int FAST_GATHER>
-    void GatherTransformClip( int & clipHead, int & clipTail, int & numLanes, int nTris, int & triIndex, __mw * vtxX, __mw * vtxY, __mw * vtxW, const float * inVtx, const unsigned int * &inTrisPtr, const VertexLayout & vtxLayout, const float * modelToClipMatrix, __m128 * clipTriBuffer, unsigned int &triMask, ClipPlanes clipPlaneMask )
+	void BinTrianglesQuantized(const unsigned short *inVtx, const unsigned short *inTris, int nTris, TriList *triLists, unsigned int nBinsW, unsigned int nBinsH, const float *modelToClipMatrix, BackfaceWinding bfWinding, ClipPlanes clipPlaneMask) override
+	{
+		BinTriangles<true>(inVtx, inTris, nTris, triLists, nBinsW, nBinsH, modelToClipMatrix, bfWinding, clipPlaneMask, VertexLayout(16, 4, 12));
+	}
+
+    template<int FAST_GATHER, typename VtxType, typename IdxType>
+    void GatherTransformClip( int & clipHead, int & clipTail, int & numLanes, int nTris, int & triIndex, __mw * vtxX, __mw * vtxY, __mw * vtxW, const VtxType * inVtx, const IdxType * &inTrisPtr, const VertexLayout & vtxLayout, const float * modelToClipMatrix, __m128 * clipTriBuffer, unsigned int &triMask, ClipPlanes clipPlaneMask )
     {
         //////////////////////////////////////////////////////////////////////////////
         // Assemble triangles from the index list 
@@ -1886,10 +1958,7 @@ public:
 #endif
 
             if( numLanes > 0 ) {
-                if( FAST_GATHER )
-                    GatherVerticesFast( vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes );
-                else
-                    GatherVertices( vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes, vtxLayout );
+                GatherInput<FAST_GATHER>( vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes, vtxLayout );
 
                 TransformVerts( vtxX, vtxY, vtxW, modelToClipMatrix );
             }
@@ -1918,10 +1987,7 @@ public:
             triMask = ( 1U << numLanes ) - 1;
             triClipMask = triMask;
 
-            if( FAST_GATHER )
-                GatherVerticesFast( vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes );
-            else
-                GatherVertices( vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes, vtxLayout );
+            GatherInput<FAST_GATHER>( vtxX, vtxY, vtxW, inVtx, inTrisPtr, numLanes, vtxLayout );
 
             TransformVerts( vtxX, vtxY, vtxW, modelToClipMatrix );
 
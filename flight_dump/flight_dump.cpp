@@ -0,0 +1,213 @@
+//
+// Prints the flight recorder snapshot (profiler_flight_format.h) from a skyrim64_test crash dump. Only the minidump
+// header and stream directory are parsed, so this doesn't need dbghelp and runs anywhere.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include "profiler_flight_format.h"
+
+using namespace Profiler::FlightRecorderFormat;
+
+#pragma pack(push, 1)
+struct MinidumpHeader
+{
+	uint32_t Signature;
+	uint32_t Version;
+	uint32_t NumberOfStreams;
+	uint32_t StreamDirectoryRva;
+	uint32_t CheckSum;
+	uint32_t TimeDateStamp;
+	uint64_t Flags;
+};
+
+struct MinidumpDirectory
+{
+	uint32_t StreamType;
+	uint32_t DataSize;
+	uint32_t Rva;
+};
+#pragma pack(pop)
+
+constexpr uint32_t MinidumpSignature = 0x504D444D;	// 'MDMP'
+
+bool ReadAt(FILE *File, uint64_t Offset, void *Buffer, size_t Size)
+{
+	return fseek(File, (long)Offset, SEEK_SET) == 0 && (Size == 0 || fread(Buffer, Size, 1, File) == 1);
+}
+
+// Accepts either a full minidump or a raw stream that was already extracted
+bool LoadStream(const char *FilePath, std::vector<uint8_t>& Out)
+{
+	FILE *f = fopen(FilePath, "rb");
+
+	if (!f)
+	{
+		printf("Unable to open %s\n", FilePath);
+		return false;
+	}
+
+	uint32_t signature = 0;
+	bool found = false;
+
+	if (ReadAt(f, 0, &signature, sizeof(signature)) && signature == MinidumpSignature)
+	{
+		MinidumpHeader header;
+
+		if (ReadAt(f, 0, &header, sizeof(header)))
+		{
+			for (uint32_t i = 0; i < header.NumberOfStreams && !found; i++)
+			{
+				MinidumpDirectory entry;
+
+				if (!ReadAt(f, header.StreamDirectoryRva + (uint64_t)i * sizeof(entry), &entry, sizeof(entry)))
+					break;
+
+				if (entry.StreamType == DumpStreamType)
+				{
+					Out.resize(entry.DataSize);
+					found = ReadAt(f, entry.Rva, Out.data(), Out.size());
+				}
+			}
+		}
+
+		if (!found)
+			printf("%s doesn't contain a flight recorder stream\n", FilePath);
+	}
+	else if (signature == Magic)
+	{
+		fseek(f, 0, SEEK_END);
+		Out.resize(ftell(f));
+		found = ReadAt(f, 0, Out.data(), Out.size());
+	}
+	else
+	{
+		printf("%s is not a minidump\n", FilePath);
+	}
+
+	fclose(f);
+	return found;
+}
+
+void PrintEvent(const Event& E, double MsBeforeCrash, double TicksPerMs)
+{
+	printf("  %12.3f ms  %-14s", -MsBeforeCrash, GetEventTypeName(E.Type));
+
+	switch (E.Type)
+	{
+	case EVENT_FRAME:
+		printf("#%llu", (unsigned long long)E.Arg0);
+		break;
+
+	case EVENT_JOB_BEGIN:
+		printf("function +0x%llX, parameter 0x%llX", (unsigned long long)E.Arg0, (unsigned long long)E.Arg1);
+		break;
+
+	case EVENT_JOB_END:
+		printf("function +0x%llX", (unsigned long long)E.Arg0);
+		break;
+
+	case EVENT_FORM_LOOKUP:
+		printf("form %08llX -> 0x%llX", (unsigned long long)E.Arg0, (unsigned long long)E.Arg1);
+		break;
+
+	case EVENT_RENDER_PASS:
+		printf("geometry 0x%llX, shader 0x%llX, technique 0x%08X", (unsigned long long)E.Arg0, (unsigned long long)E.Arg1, E.Arg2);
+		break;
+
+	case EVENT_LOCK_WAIT_BEGIN:
+		printf("lock 0x%llX, owner %u", (unsigned long long)E.Arg0, E.Arg2);
+		break;
+
+	case EVENT_LOCK_WAIT_END:
+		printf("lock 0x%llX, waited %.3f ms", (unsigned long long)E.Arg0, (TicksPerMs > 0.0) ? E.Arg1 / TicksPerMs : 0.0);
+		break;
+
+	default:
+		printf("0x%llX 0x%llX 0x%X", (unsigned long long)E.Arg0, (unsigned long long)E.Arg1, E.Arg2);
+		break;
+	}
+
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <crash.dmp> [events per thread]\n", argv[0]);
+		return 1;
+	}
+
+	const uint32_t maxEvents = (argc >= 3) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 64;
+	std::vector<uint8_t> stream;
+
+	if (!LoadStream(argv[1], stream))
+		return 1;
+
+	StreamHeader header;
+
+	if (stream.size() < sizeof(header))
+	{
+		printf("Flight recorder stream is truncated\n");
+		return 1;
+	}
+
+	memcpy(&header, stream.data(), sizeof(header));
+
+	if (header.Magic != Magic || header.Version != Version)
+	{
+		printf("Expected a version %u flight recorder stream\n", Version);
+		return 1;
+	}
+
+	const double ticksPerMs = header.TicksPerSecond / 1000.0;
+
+	printf("Module base 0x%llX, %u threads, crashed on thread %u\n", (unsigned long long)header.ModuleBase, header.ThreadCount,
+		header.CrashThreadId);
+
+	size_t offset = sizeof(header);
+
+	for (uint32_t i = 0; i < header.ThreadCount; i++)
+	{
+		ThreadHeader thread;
+
+		if (offset + sizeof(thread) > stream.size())
+			break;
+
+		memcpy(&thread, stream.data() + offset, sizeof(thread));
+		offset += sizeof(thread);
+
+		thread.Name[sizeof(thread.Name) - 1] = '\0';
+
+		if (offset + (size_t)thread.EventCount * sizeof(Event) > stream.size())
+		{
+			printf("Thread %u: truncated\n", thread.ThreadId);
+			break;
+		}
+
+		std::vector<Event> events(thread.EventCount);
+		memcpy(events.data(), stream.data() + offset, events.size() * sizeof(Event));
+		offset += events.size() * sizeof(Event);
+
+		if (events.empty())
+			continue;
+
+		printf("\nThread %u%s%s%s%s, %u events\n", thread.ThreadId, thread.Name[0] ? " \"" : "", thread.Name, thread.Name[0] ? "\"" : "",
+			(thread.ThreadId == header.CrashThreadId) ? " (CRASHED)" : "", thread.EventCount);
+
+		// Newest events last, right before the crash
+		const size_t first = events.size() - std::min<size_t>(events.size(), maxEvents);
+
+		for (size_t j = first; j < events.size(); j++)
+		{
+			const double msBeforeCrash = (ticksPerMs > 0.0) ? (double)(int64_t)(header.SnapshotTimestamp - events[j].Timestamp) / ticksPerMs : 0.0;
+			PrintEvent(events[j], msBeforeCrash, ticksPerMs);
+		}
+	}
+
+	return 0;
+}
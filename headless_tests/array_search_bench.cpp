@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "BSTArraySearch.h"
+
+//
+// BSTArraySearch find/count throughput per kernel set from 8 to 1M elements, against a plain loop. Find searches for
+// a value that isn't there so every call scans the whole array, the same as count.
+//
+//   array_search_bench [min_count] [max_count]
+//
+using BenchClock = std::chrono::steady_clock;
+
+volatile uint64_t g_Sink;
+
+template<typename T>
+uint32_t FindLoop(const T *Data, uint32_t Count, T Value)
+{
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		if (Data[i] == Value)
+			return i;
+	}
+
+	return BSTArraySearch::NotFound;
+}
+
+template<typename T>
+uint32_t CountLoop(const T *Data, uint32_t Count, T Value)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < Count; i++)
+		count += (Data[i] == Value) ? 1 : 0;
+
+	return count;
+}
+
+// Nanoseconds per call, best of 3 to filter out scheduler noise. Small arrays are called many times per run.
+template<typename T, typename Func>
+double NsPerCall(Func Kernel, const std::vector<T>& Data, T Value)
+{
+	const uint32_t count = (uint32_t)Data.size();
+	const uint32_t calls = std::max<uint32_t>(16, (1u << 24) / std::max<uint32_t>(count, 1));
+	double best = 1e30;
+
+	for (int run = 0; run < 3; run++)
+	{
+		uint64_t sum = 0;
+		const auto start = BenchClock::now();
+
+		for (uint32_t i = 0; i < calls; i++)
+			sum += Kernel(Data.data(), count, Value);
+
+		const double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / calls;
+		g_Sink = sum;
+
+		if (ns < best)
+			best = ns;
+	}
+
+	return best;
+}
+
+template<typename T, typename FindFunc, typename CountFunc>
+void BenchKernels(const char *Name, FindFunc Find, CountFunc Count, uint32_t MinCount, uint32_t MaxCount)
+{
+	for (uint32_t count = MinCount; count <= MaxCount; count *= 4)
+	{
+		std::vector<T> data(count);
+
+		for (uint32_t i = 0; i < count; i++)
+			data[i] = (T)(i * 2 + 1);
+
+		const double findNs = NsPerCall<T>(Find, data, (T)0);
+		const double countNs = NsPerCall<T>(Count, data, (T)0);
+		const double bytes = (double)count * sizeof(T);
+
+		printf("%-8s %6zu %10u %12.1f %10.2f %12.1f %10.2f\n", Name, sizeof(T) * 8, count, findNs, bytes / findNs, countNs, bytes / countNs);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t minCount = (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 8;
+	const uint32_t maxCount = (argc > 2) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1u << 20;
+
+	printf("Dispatched kernels: %s\n", BSTArraySearch::GetKernelName());
+	printf("%-8s %6s %10s %12s %10s %12s %10s\n", "Kernel", "Bits", "Elements", "find (ns)", "GB/s", "count (ns)", "GB/s");
+
+	BenchKernels<uint32_t>("Loop", &FindLoop<uint32_t>, &CountLoop<uint32_t>, minCount, maxCount);
+	BenchKernels<uint64_t>("Loop", &FindLoop<uint64_t>, &CountLoop<uint64_t>, minCount, maxCount);
+
+	for (const BSTArraySearch::KernelSet *kernels : { &BSTArraySearch::KernelsSSE2, &BSTArraySearch::KernelsSSE41, &BSTArraySearch::KernelsAVX2, &BSTArraySearch::KernelsAVX512 })
+	{
+		if (!BSTArraySearch::IsSupported(*kernels))
+		{
+			printf("%-8s not supported\n", kernels->Name);
+			continue;
+		}
+
+		BenchKernels<uint32_t>(kernels->Name, kernels->Find32, kernels->Count32, minCount, maxCount);
+		BenchKernels<uint64_t>(kernels->Name, kernels->Find64, kernels->Count64, minCount, maxCount);
+	}
+
+	return 0;
+}
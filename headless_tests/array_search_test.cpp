@@ -0,0 +1,171 @@
+#include <random>
+#include <vector>
+#include "test_common.h"
+#include "BSTArraySearch.h"
+
+//
+// Every BSTArraySearch kernel set the CPU supports against plain loops: all lengths from 0 to 257 (so every unrolled,
+// single vector and scalar tail length is hit) at every element offset within a cache line, with the match in each
+// position, several matches and no match. 64-bit values that only differ in one half catch a broken SSE2 64-bit
+// compare.
+//
+using namespace BSTArraySearch;
+
+constexpr uint32_t MaxLength = 257;
+
+template<typename T>
+uint32_t FindScalar(const T *Data, uint32_t Count, T Value)
+{
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		if (Data[i] == Value)
+			return i;
+	}
+
+	return NotFound;
+}
+
+template<typename T>
+uint32_t CountScalar(const T *Data, uint32_t Count, T Value)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < Count; i++)
+		count += (Data[i] == Value) ? 1 : 0;
+
+	return count;
+}
+
+template<typename T>
+T MakeTarget()
+{
+	if constexpr (sizeof(T) == 8)
+		return 0x1234567890ABCDEFull;
+	else
+		return 0x90ABCDEF;
+}
+
+// Never equal to the target, but half of them share the target's low or high 32 bits
+template<typename T>
+T MakeFiller(std::mt19937& Rng, T Target)
+{
+	T value;
+
+	do
+	{
+		if constexpr (sizeof(T) == 8)
+		{
+			switch (Rng() % 4)
+			{
+			case 0: value = (Target & 0xFFFFFFFF00000000ull) | Rng(); break;
+			case 1: value = (Target & 0xFFFFFFFFull) | ((uint64_t)Rng() << 32); break;
+			default: value = ((uint64_t)Rng() << 32) | Rng(); break;
+			}
+		}
+		else
+		{
+			value = (Rng() % 2) ? (Target ^ (1u << (Rng() % 32))) : Rng();
+		}
+	} while (value == Target);
+
+	return value;
+}
+
+template<typename T, typename FindFunc, typename CountFunc>
+void CheckKernels(const char *Name, FindFunc Find, CountFunc Count)
+{
+	// One cache line of slack in front for the misaligned starts
+	constexpr uint32_t lineElements = 64 / sizeof(T);
+
+	std::mt19937 rng(1234);
+	const T target = MakeTarget<T>();
+
+	alignas(64) static T storage[lineElements + MaxLength];
+	const int failuresBefore = g_TestFailures;
+
+	for (uint32_t offset = 0; offset < lineElements; offset++)
+	{
+		T *data = &storage[offset];
+
+		for (uint32_t length = 0; length <= MaxLength; length++)
+		{
+			for (uint32_t i = 0; i < lineElements + MaxLength; i++)
+				storage[i] = MakeFiller(rng, target);
+
+			// No match, including right past the end of the range
+			if (offset + length < lineElements + MaxLength)
+				data[length] = target;
+
+			TEST_CHECK_MSG(Find(data, length, target) == NotFound, "%s %zu-bit find, offset %u, length %u", Name, sizeof(T) * 8, offset, length);
+			TEST_CHECK_MSG(Count(data, length, target) == 0, "%s %zu-bit count, offset %u, length %u", Name, sizeof(T) * 8, offset, length);
+
+			// A single match in every position, the last one being in the scalar tail
+			for (uint32_t position = 0; position < length; position++)
+			{
+				const T old = data[position];
+				data[position] = target;
+
+				const uint32_t found = Find(data, length, target);
+				TEST_CHECK_MSG(found == position, "%s %zu-bit find, offset %u, length %u: %u vs %u", Name, sizeof(T) * 8, offset, length, found, position);
+				TEST_CHECK_MSG(Count(data, length, target) == 1, "%s %zu-bit count, offset %u, length %u, position %u", Name, sizeof(T) * 8, offset, length, position);
+
+				data[position] = old;
+			}
+
+			// Several matches: find has to return the first one and count has to see all of them
+			for (uint32_t i = 0; i < length; i++)
+			{
+				if (rng() % 8 == 0)
+					data[i] = target;
+			}
+
+			TEST_CHECK_MSG(Find(data, length, target) == FindScalar(data, length, target), "%s %zu-bit find, offset %u, length %u", Name, sizeof(T) * 8, offset, length);
+			TEST_CHECK_MSG(Count(data, length, target) == CountScalar(data, length, target), "%s %zu-bit count, offset %u, length %u", Name, sizeof(T) * 8, offset, length);
+
+			// Enough to diagnose, don't flood the log
+			if (g_TestFailures - failuresBefore > 16)
+				return;
+		}
+	}
+
+	// Every element matches
+	for (uint32_t i = 0; i < MaxLength; i++)
+		storage[i] = target;
+
+	TEST_CHECK_MSG(Find(storage, MaxLength, target) == 0, "%s %zu-bit find, all matches", Name, sizeof(T) * 8);
+	TEST_CHECK_MSG(Count(storage, MaxLength, target) == MaxLength, "%s %zu-bit count, all matches", Name, sizeof(T) * 8);
+}
+
+void CheckDispatch()
+{
+	// The templated entry points go through whichever kernels were picked
+	const uint32_t ids[] = { 5, 6, 7, 8, 9, 10, 11, 12, 13, 7 };
+	const void *pointers[] = { &ids[0], &ids[1], nullptr, &ids[3], nullptr };
+
+	TEST_CHECK(Find(ids, 10, 7u) == 2);
+	TEST_CHECK(Count(ids, 10, 7u) == 2);
+	TEST_CHECK(Find(ids, 10, 4u) == NotFound);
+	TEST_CHECK(Find(pointers, 5, (const void *)nullptr) == 2);
+	TEST_CHECK(Count(pointers, 5, (const void *)nullptr) == 2);
+}
+
+int main()
+{
+	printf("Dispatched kernels: %s\n", GetKernelName());
+
+	for (const KernelSet *kernels : { &KernelsSSE2, &KernelsSSE41, &KernelsAVX2, &KernelsAVX512 })
+	{
+		if (!IsSupported(*kernels))
+		{
+			printf("%s: not supported, skipped\n", kernels->Name);
+			continue;
+		}
+
+		CheckKernels<uint32_t>(kernels->Name, kernels->Find32, kernels->Count32);
+		CheckKernels<uint64_t>(kernels->Name, kernels->Find64, kernels->Count64);
+	}
+
+	CheckDispatch();
+
+	return TestResult("array_search_test");
+}
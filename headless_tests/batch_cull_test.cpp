@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "test_common.h"
+#include "MOC_BatchCullKernels.h"
+
+//
+// The SSE batch projection kernels (the fallback for CPUs without AVX2/FMA) against the scalar reference, for random
+// cameras and every partial chunk length, plus the cases that have to be flagged Unknown.
+//
+using namespace MOC_BatchCull;
+
+void Multiply(const float (&A)[4][4], const float (&B)[4][4], float (&Out)[4][4])
+{
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+			Out[i][j] = A[i][0] * B[0][j] + A[i][1] * B[1][j] + A[i][2] * B[2][j] + A[i][3] * B[3][j];
+	}
+}
+
+// Row vector convention like DirectXMath: camera relative rotation, then a left handed perspective projection
+Camera MakeTestCamera(std::mt19937& Rng)
+{
+	std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+	const float yaw = angle(Rng);
+	const float pitch = angle(Rng) * 0.25f;
+
+	const float forward[3] = { cosf(pitch) * sinf(yaw), cosf(pitch) * cosf(yaw), sinf(pitch) };
+	const float right[3] = { cosf(yaw), -sinf(yaw), 0.0f };
+	const float up[3] =
+	{
+		right[1] * forward[2] - right[2] * forward[1],
+		right[2] * forward[0] - right[0] * forward[2],
+		right[0] * forward[1] - right[1] * forward[0],
+	};
+
+	Camera cam;
+	const float view[4][4] =
+	{
+		{ right[0], up[0], forward[0], 0.0f },
+		{ right[1], up[1], forward[1], 0.0f },
+		{ right[2], up[2], forward[2], 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f },
+	};
+
+	const float nearZ = 5.0f;
+	const float farZ = 100000.0f;
+	const float yScale = 1.0f / tanf(0.567f);
+	const float proj[4][4] =
+	{
+		{ yScale / 1.7777f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, yScale, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, farZ / (farZ - nearZ), 1.0f },
+		{ 0.0f, 0.0f, -nearZ * farZ / (farZ - nearZ), 0.0f },
+	};
+
+	memcpy(cam.View, view, sizeof(view));
+	Multiply(view, proj, cam.ViewProj);
+
+	cam.Position[0] = std::uniform_real_distribution<float>(-100000.0f, 100000.0f)(Rng);
+	cam.Position[1] = std::uniform_real_distribution<float>(-100000.0f, 100000.0f)(Rng);
+	cam.Position[2] = std::uniform_real_distribution<float>(-2000.0f, 4000.0f)(Rng);
+	return cam;
+}
+
+struct Output
+{
+	float XMin[128], YMin[128], XMax[128], YMax[128], WMin[128];
+	uint64_t Unknown[2];
+
+	Rects Get()
+	{
+		return { XMin, YMin, XMax, YMax, WMin };
+	}
+
+	bool IsUnknown(uint32_t Index) const
+	{
+		return (Unknown[Index / 64] >> (Index % 64)) & 1;
+	}
+};
+
+bool Close(float A, float B)
+{
+	return fabsf(A - B) <= 0.00001f * std::max(1.0f, std::max(fabsf(A), fabsf(B)));
+}
+
+bool Matches(const Output& A, const Output& B, uint32_t Count)
+{
+	// Nothing past Count may be written
+	for (uint32_t i = Count; i < 128; i++)
+	{
+		if (A.IsUnknown(i) || B.IsUnknown(i))
+			return false;
+	}
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		if (A.IsUnknown(i) != B.IsUnknown(i))
+			return false;
+
+		if (!A.IsUnknown(i) && (!Close(A.XMin[i], B.XMin[i]) || !Close(A.YMin[i], B.YMin[i]) || !Close(A.XMax[i], B.XMax[i]) ||
+			!Close(A.YMax[i], B.YMax[i]) || !Close(A.WMin[i], B.WMin[i])))
+			return false;
+	}
+
+	return true;
+}
+
+template<class Isa>
+void Project(const Camera& Cam, bool Spheres, const std::vector<float> (&In)[6], uint32_t Count, Output& Out)
+{
+	Out.Unknown[0] = 0;
+	Out.Unknown[1] = 0;
+
+	for (uint32_t base = 0; base < Count; base += 64)
+	{
+		const uint32_t count = std::min<uint32_t>(Count - base, 64);
+		const Rects rects { &Out.XMin[base], &Out.YMin[base], &Out.XMax[base], &Out.YMax[base], &Out.WMin[base] };
+
+		if (Spheres)
+			ProjectSpheresKernel<Isa>(Cam, &In[0][base], &In[1][base], &In[2][base], &In[3][base], count, rects, &Out.Unknown[base / 64]);
+		else
+			ProjectAABBsKernel<Isa>(Cam, &In[0][base], &In[1][base], &In[2][base], &In[3][base], &In[4][base], &In[5][base], count, rects, &Out.Unknown[base / 64]);
+	}
+}
+
+void TestAgainstScalar()
+{
+	std::mt19937 rng(35);
+	uint32_t unknownSeen = 0;
+	uint32_t knownSeen = 0;
+
+	for (uint32_t round = 0; round < 2000; round++)
+	{
+		const Camera cam = MakeTestCamera(rng);
+		const bool spheres = (round % 2) == 0;
+
+		// Every chunk tail length, including more than one mask word
+		const uint32_t count = 1 + (round % 128);
+
+		std::uniform_real_distribution<float> offset(-6000.0f, 6000.0f);
+		std::uniform_real_distribution<float> extent(0.5f, 800.0f);
+		std::vector<float> in[6];
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			in[0].push_back(cam.Position[0] + offset(rng));
+			in[1].push_back(cam.Position[1] + offset(rng));
+			in[2].push_back(cam.Position[2] + offset(rng) * 0.25f);
+			in[3].push_back(extent(rng));
+			in[4].push_back(extent(rng));
+			in[5].push_back(extent(rng));
+		}
+
+		Output reference;
+		Output sse;
+		Project<IsaScalar>(cam, spheres, in, count, reference);
+		Project<IsaSSE>(cam, spheres, in, count, sse);
+
+		TEST_CHECK_MSG(Matches(reference, sse, count), "round %u, %s, count %u", round, spheres ? "spheres" : "boxes", count);
+
+		for (uint32_t i = 0; i < count; i++)
+			(reference.IsUnknown(i) ? unknownSeen : knownSeen)++;
+
+		if (g_TestFailures > 0)
+			return;
+	}
+
+	// The random scenes have to exercise both outcomes for the comparison to mean anything
+	TEST_CHECK(unknownSeen > 1000 && knownSeen > 1000);
+}
+
+void TestUnknownCases()
+{
+	std::mt19937 rng(7);
+	const Camera cam = MakeTestCamera(rng);
+
+	const float forward[3] = { cam.View[0][2], cam.View[1][2], cam.View[2][2] };
+	std::vector<float> in[6];
+
+	auto add = [&](float Distance, float Extent)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			in[axis].push_back(cam.Position[axis] + forward[axis] * Distance);
+			in[axis + 3].push_back(Extent);
+		}
+	};
+
+	add(0.0f, 50.0f);		// Camera inside
+	add(-1000.0f, 50.0f);	// Behind the camera
+	add(2000.0f, 50.0f);	// In front, fully visible
+	add(30.0f, 50.0f);		// Crossing the near plane
+
+	for (bool spheres : { true, false })
+	{
+		Output sse;
+		Project<IsaSSE>(cam, spheres, in, 4, sse);
+
+		TEST_CHECK(sse.IsUnknown(0));
+		TEST_CHECK(sse.IsUnknown(1));
+		TEST_CHECK(!sse.IsUnknown(2));
+		TEST_CHECK(sse.IsUnknown(3));
+
+		// Straight ahead: a small rect around the screen center, in front of the near plane
+		TEST_CHECK(sse.XMin[2] < 0.0f && sse.XMax[2] > 0.0f && sse.YMin[2] < 0.0f && sse.YMax[2] > 0.0f);
+		TEST_CHECK(sse.XMax[2] - sse.XMin[2] < 0.2f && sse.WMin[2] > 1900.0f && sse.WMin[2] < 2000.0f);
+	}
+}
+
+int main()
+{
+	TestAgainstScalar();
+	TestUnknownCases();
+
+	return TestResult("batch_cull_test");
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "engine_stubs.h"
+#include "BSTArray.h"
+
+//
+// BSTOwnedArray vs std::vector for the operations the engine leans on: appending, iterating, searching (through the
+// dispatched BSTArraySearch kernels, see array_search_bench for the kernels alone) and front insertion. The memory
+// stub zeroes every allocation like the game heap does, which is included in the growth numbers.
+//
+//   bstarray_bench [count]
+//
+using BenchClock = std::chrono::steady_clock;
+
+volatile uint64_t g_Sink;
+
+template<typename Func>
+double NsPerOp(size_t Count, Func Callback)
+{
+	// Best of 3 to filter out scheduler noise
+	double best = 1e30;
+
+	for (int run = 0; run < 3; run++)
+	{
+		const auto start = BenchClock::now();
+		Callback();
+		const double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / Count;
+
+		if (ns < best)
+			best = ns;
+	}
+
+	return best;
+}
+
+struct Result
+{
+	double PushBack;
+	double PushBackReserved;
+	double Iterate;
+	double Find;
+	double InsertFront;
+};
+
+template<typename Array>
+Result Bench(uint32_t Count)
+{
+	Result result;
+	Array values;
+
+	result.PushBack = NsPerOp(Count, [&]()
+	{
+		Array temp;
+
+		for (uint32_t i = 0; i < Count; i++)
+			temp.push_back(i);
+
+		g_Sink = temp.size();
+	});
+
+	result.PushBackReserved = NsPerOp(Count, [&]()
+	{
+		values.clear();
+		values.reserve(Count);
+
+		for (uint32_t i = 0; i < Count; i++)
+			values.push_back(i);
+	});
+
+	result.Iterate = NsPerOp(Count, [&]()
+	{
+		uint64_t sum = 0;
+
+		for (uint32_t value : values)
+			sum += value;
+
+		g_Sink = sum;
+	});
+
+	// Small arrays are the common case for engine searches (form lists, ref handles)
+	const uint32_t searchSize = std::min<uint32_t>(Count, 64);
+	Array small;
+
+	for (uint32_t i = 0; i < searchSize; i++)
+		small.push_back(i);
+
+	result.Find = NsPerOp(Count, [&]()
+	{
+		uint64_t sum = 0;
+
+		for (uint32_t i = 0; i < Count; i++)
+			sum += std::find(small.begin(), small.end(), i % (searchSize * 2)) - small.begin();
+
+		g_Sink = sum;
+	});
+
+	const uint32_t insertCount = std::min<uint32_t>(Count, 4096);
+
+	result.InsertFront = NsPerOp(insertCount, [&]()
+	{
+		Array temp;
+
+		for (uint32_t i = 0; i < insertCount; i++)
+		{
+			if constexpr (std::is_same_v<Array, std::vector<uint32_t>>)
+				temp.insert(temp.begin(), i);
+			else
+				temp.insert(0, i);
+		}
+
+		g_Sink = temp.size();
+	});
+
+	return result;
+}
+
+void Print(const char *Name, const Result& R)
+{
+	printf("%-14s %12.2f %12.2f %12.2f %12.2f %12.2f\n", Name, R.PushBack, R.PushBackReserved, R.Iterate, R.Find, R.InsertFront);
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t count = (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1000000;
+
+	printf("%u elements, ns/op\n", count);
+	printf("%-14s %12s %12s %12s %12s %12s\n", "", "push_back", "reserved", "iterate", "find(64)", "insert(0)");
+	Print("BSTOwnedArray", Bench<BSTOwnedArray<uint32_t>>(count));
+	Print("std::vector", Bench<std::vector<uint32_t>>(count));
+
+	return 0;
+}
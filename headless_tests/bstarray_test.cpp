@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <string>
+#include <random>
+#include <vector>
+#include <new>
+#include "test_common.h"
+#include "engine_stubs.h"
+#include "memory_stub.h"
+#include "BSTArray.h"
+
+//
+// BSTOwnedArray against std::vector under random mutations, plus the ownership rules that keep BSTArray safe to
+// embed in engine objects.
+//
+struct Tracked
+{
+	inline static int64_t Live;
+
+	std::string Text;
+
+	Tracked(const char *Value = "") : Text(Value) { Live++; }
+	Tracked(const std::string& Value) : Text(Value) { Live++; }
+	Tracked(const Tracked& Other) : Text(Other.Text) { Live++; }
+	Tracked(Tracked&& Other) noexcept : Text(std::move(Other.Text)) { Live++; }
+	~Tracked() { Live--; }
+
+	Tracked& operator=(const Tracked& Other) = default;
+	Tracked& operator=(Tracked&& Other) noexcept = default;
+
+	bool operator==(const Tracked& Other) const
+	{
+		return Text == Other.Text;
+	}
+};
+
+template<typename Array, typename T>
+bool Matches(const Array& Values, const std::vector<T>& Reference)
+{
+	if (Values.size() != Reference.size() || Values.capacity() < Values.size())
+		return false;
+
+	for (uint32_t i = 0; i < Values.size(); i++)
+	{
+		if (!(Values[i] == Reference[i]))
+			return false;
+	}
+
+	return true;
+}
+
+template<typename Array, typename T, typename MakeFunc>
+void RandomOperations(uint32_t Seed, MakeFunc Make)
+{
+	Array values;
+	std::vector<T> reference;
+	std::mt19937 rng(Seed);
+
+	for (uint32_t i = 0; i < 200000; i++)
+	{
+		const T value = Make(rng() % 1000);
+
+		switch (rng() % 12)
+		{
+		case 0:
+		case 1:
+		case 2:
+			values.push_back(value);
+			reference.push_back(value);
+			break;
+
+		case 3:
+			if (!reference.empty())
+			{
+				// Element of the same array, which may be relocated by the growth
+				const uint32_t index = rng() % reference.size();
+				values.push_back(values[index]);
+				reference.push_back(T(reference[index]));
+			}
+			break;
+
+		case 4:
+			if (!reference.empty())
+			{
+				values.pop_back();
+				reference.pop_back();
+			}
+			break;
+
+		case 5:
+		{
+			const uint32_t pos = rng() % (reference.size() + 1);
+			values.insert(pos, value);
+			reference.insert(reference.begin() + pos, value);
+			break;
+		}
+
+		case 6:
+			if (!reference.empty())
+			{
+				const uint32_t first = rng() % reference.size();
+				const uint32_t last = first + rng() % (reference.size() - first + 1);
+				values.erase(first, last);
+				reference.erase(reference.begin() + first, reference.begin() + last);
+			}
+			break;
+
+		case 7:
+			if (!reference.empty())
+			{
+				const uint32_t pos = rng() % reference.size();
+				values.erase_unordered(pos);
+				reference[pos] = reference.back();
+				reference.pop_back();
+			}
+			break;
+
+		case 8:
+		{
+			const uint32_t count = rng() % 64;
+			values.resize(count, value);
+			reference.resize(count, value);
+			break;
+		}
+
+		case 9:
+			values.reserve(rng() % 128);
+			break;
+
+		case 10:
+			values.shrink_to_fit();
+			break;
+
+		case 11:
+		{
+			const uint32_t index = values.find(value);
+			auto itr = std::find(reference.begin(), reference.end(), value);
+
+			TEST_CHECK((index == Array::npos) == (itr == reference.end()));
+			TEST_CHECK(index == Array::npos || index == (uint32_t)(itr - reference.begin()));
+			TEST_CHECK(values.count(value) == (uint32_t)std::count(reference.begin(), reference.end(), value));
+			break;
+		}
+		}
+
+		if (reference.size() > 256)
+		{
+			values.clear();
+			reference.clear();
+		}
+
+		TEST_CHECK(Matches(values, reference));
+
+		if (g_TestFailures > 0)
+			return;
+	}
+}
+
+void TestCopyAndMove()
+{
+	BSTOwnedArray<Tracked> a;
+
+	for (int i = 0; i < 100; i++)
+		a.emplace_back(std::to_string(i));
+
+	BSTOwnedArray<Tracked> b(a);
+	TEST_CHECK(b.size() == 100 && b.data() != a.data() && b[42].Text == "42");
+
+	b[0].Text = "changed";
+	TEST_CHECK(a[0].Text == "0");
+
+	// Heap buffers are stolen, not copied
+	const Tracked *buffer = a.data();
+	BSTOwnedArray<Tracked> c(std::move(a));
+	TEST_CHECK(c.data() == buffer && c.size() == 100);
+	TEST_CHECK(a.size() == 0 && a.capacity() == 0);
+
+	c = b;
+	TEST_CHECK(c.size() == 100 && c[0].Text == "changed");
+
+	b = std::move(c);
+	TEST_CHECK(b.size() == 100 && c.empty());
+
+	// Inline storage has to move element by element
+	BSTOwnedSmallArray<Tracked, 4> small;
+	small.emplace_back("x");
+	small.emplace_back("y");
+	TEST_CHECK(small.QInlineBuffer());
+
+	BSTOwnedSmallArray<Tracked, 4> smallMoved(std::move(small));
+	TEST_CHECK(smallMoved.QInlineBuffer() && smallMoved.size() == 2 && smallMoved[1].Text == "y");
+	TEST_CHECK(small.empty());
+
+	// Outgrowing the inline buffer moves to the heap, copies of that stay independent
+	for (int i = 0; i < 10; i++)
+		smallMoved.emplace_back("z");
+
+	TEST_CHECK(!smallMoved.QInlineBuffer() && smallMoved.size() == 12);
+
+	BSTOwnedSmallArray<Tracked, 4> smallCopy(smallMoved);
+	TEST_CHECK(smallCopy.size() == 12 && smallCopy[0].Text == "x");
+}
+
+void TestInlineStorage()
+{
+	const int64_t allocations = g_StubAllocations;
+
+	{
+		BSTOwnedSmallArray<uint32_t, 8> values;
+
+		for (uint32_t i = 0; i < 8; i++)
+			values.push_back(i);
+
+		// Fits without touching the heap
+		TEST_CHECK(values.QInlineBuffer() && g_StubAllocations == allocations);
+
+		values.push_back(8);
+		TEST_CHECK(!values.QInlineBuffer() && g_StubAllocations == allocations + 1);
+
+		for (uint32_t i = 0; i < 9; i++)
+			TEST_CHECK(values[i] == i);
+	}
+
+	TEST_CHECK(g_StubAllocations == allocations);
+}
+
+void TestMirrorNeverFrees()
+{
+	//
+	// Stand-in for an engine object with an embedded array. Our code may grow it (through the shared heap) but must
+	// never free it just because a wrapper went away; the engine does that itself later.
+	//
+	struct EngineObject
+	{
+		uint64_t Header;
+		BSTArray<uint32_t> Values;
+	};
+
+	alignas(EngineObject) uint8_t storage[sizeof(EngineObject)];
+	auto object = new (storage) EngineObject();
+
+	object->Values.push_back(1);
+	object->Values.push_back(2);
+
+	const int64_t allocations = g_StubAllocations;
+	void *buffer = object->Values.data();
+
+	object->~EngineObject();
+
+	TEST_CHECK(g_StubAllocations == allocations);
+
+	// Engine side of the cleanup
+	MemoryManager::Deallocate(nullptr, buffer, true);
+}
+
+int main()
+{
+	const int64_t allocations = g_StubAllocations;
+
+	RandomOperations<BSTOwnedArray<uint32_t>, uint32_t>(1, [](uint32_t Value) { return Value; });
+	RandomOperations<BSTOwnedArray<uint64_t>, uint64_t>(2, [](uint32_t Value) { return (uint64_t)Value << 33; });
+	RandomOperations<BSTOwnedArray<Tracked>, Tracked>(3, [](uint32_t Value) { return Tracked(std::to_string(Value)); });
+	RandomOperations<BSTOwnedSmallArray<uint32_t, 6>, uint32_t>(4, [](uint32_t Value) { return Value; });
+	RandomOperations<BSTOwnedSmallArray<Tracked, 3>, Tracked>(5, [](uint32_t Value) { return Tracked(std::to_string(Value)); });
+	TestCopyAndMove();
+	TestInlineStorage();
+	TestMirrorNeverFrees();
+
+	TEST_CHECK(Tracked::Live == 0);
+	TEST_CHECK(g_StubAllocations == allocations);
+
+	return TestResult("bstarray_test");
+}
@@ -0,0 +1,231 @@
+#include <math.h>
+#include <vector>
+#include "test_common.h"
+#include "profiler_clock.h"
+#include "MOC_BudgetController.h"
+
+//
+// MOC_BudgetController against simulated frame costs: trimming and giving back occluders, the hysteresis band, the
+// occluder and resolution clamps, resize pacing, the predicted cost check before stepping up, and convergence of a
+// cost that depends on both the occluder count and the resolution.
+//
+const MOC_BudgetController::Resolution Resolutions[] =
+{
+	{ 1280, 720 },
+	{ 1152, 648 },
+	{ 1024, 576 },
+	{ 896, 504 },
+	{ 768, 432 },
+	{ 640, 360 },
+};
+
+constexpr uint32_t LevelCount = sizeof(Resolutions) / sizeof(Resolutions[0]);
+constexpr float TargetMs = 2.0f;
+
+uint64_t MsToTicks(float Ms)
+{
+	return (uint64_t)llround(Ms * (double)Profiler::Clock::GetFrequency() / 1000.0);
+}
+
+float GetAreaRatio(uint32_t Level)
+{
+	return (float)(Resolutions[Level].Width * Resolutions[Level].Height) / (float)(Resolutions[0].Width * Resolutions[0].Height);
+}
+
+bool Step(MOC_BudgetController& Controller, bool Enabled, float RasterMs, float QueryMs, uint32_t Submitted)
+{
+	return Controller.Update(Enabled, TargetMs, MsToTicks(RasterMs), MsToTicks(QueryMs), Submitted);
+}
+
+// Settles the moving averages without letting the controller act on them
+void WarmUp(MOC_BudgetController& Controller, float RasterMs, float QueryMs)
+{
+	for (uint32_t i = 0; i < 200; i++)
+		Step(Controller, false, RasterMs, QueryMs, 0);
+}
+
+void TestHysteresis()
+{
+	// Anywhere inside the band leaves everything alone
+	for (float factor : { 0.91f, 1.0f, 1.09f })
+	{
+		MOC_BudgetController controller(Resolutions, LevelCount);
+		WarmUp(controller, TargetMs * factor * 0.75f, TargetMs * factor * 0.25f);
+
+		uint32_t changes = 0;
+
+		for (uint32_t frame = 0; frame < 1000; frame++)
+			changes += Step(controller, true, TargetMs * factor * 0.75f, TargetMs * factor * 0.25f, 5000) ? 1 : 0;
+
+		TEST_CHECK_MSG(changes == 0 && controller.GetLevel() == 0, "%.2f: %u resizes", factor, changes);
+		TEST_CHECK_MSG(controller.GetOccluderBudget() == MOC_BudgetController::UnlimitedOccluders, "%.2f: %u", factor, controller.GetOccluderBudget());
+	}
+
+	// Just above it the farthest occluders go right away
+	MOC_BudgetController controller(Resolutions, LevelCount);
+	WarmUp(controller, TargetMs * 1.12f, 0.0f);
+
+	Step(controller, true, TargetMs * 1.12f, 0.0f, 1000);
+	TEST_CHECK_MSG(controller.GetOccluderBudget() == 1000 - (1000 / 32), "%u", controller.GetOccluderBudget());
+
+	Step(controller, true, TargetMs * 1.12f, 0.0f, 1000);
+	TEST_CHECK_MSG(controller.GetOccluderBudget() == 969 - (969 / 32), "%u", controller.GetOccluderBudget());
+
+	// Back inside the band it holds steady
+	WarmUp(controller, TargetMs, 0.0f);
+	const uint32_t budget = controller.GetOccluderBudget();
+
+	for (uint32_t frame = 0; frame < 100; frame++)
+		Step(controller, true, TargetMs, 0.0f, 1000);
+
+	TEST_CHECK_MSG(controller.GetOccluderBudget() == budget, "%u vs %u", controller.GetOccluderBudget(), budget);
+}
+
+void TestGiveBack()
+{
+	MOC_BudgetController controller(Resolutions, LevelCount);
+	WarmUp(controller, TargetMs * 2.0f, 0.0f);
+
+	for (uint32_t frame = 0; frame < 10; frame++)
+		Step(controller, true, TargetMs * 2.0f, 0.0f, 1000);
+
+	// Under the band (once the average catches up), occluders come back a little at a time and resolution is left
+	// alone. The limit goes away as soon as everything submitted fits.
+	uint32_t previous = controller.GetOccluderBudget();
+	uint32_t raises = 0;
+
+	TEST_CHECK_MSG(previous < 1000, "%u", previous);
+
+	for (uint32_t frame = 0; frame < 500 && controller.GetOccluderBudget() != MOC_BudgetController::UnlimitedOccluders; frame++)
+	{
+		Step(controller, true, 0.1f, 0.0f, 1000);
+		const uint32_t budget = controller.GetOccluderBudget();
+
+		if (raises > 0 && budget != MOC_BudgetController::UnlimitedOccluders)
+			TEST_CHECK_MSG(budget == previous + std::max(previous / 64, 1u), "%u -> %u", previous, budget);
+
+		if (budget > previous)
+			raises++;
+
+		TEST_CHECK(controller.GetLevel() == 0);
+		previous = budget;
+	}
+
+	TEST_CHECK_MSG(raises > 1, "%u", raises);
+	TEST_CHECK_MSG(controller.GetOccluderBudget() == MOC_BudgetController::UnlimitedOccluders, "%u", controller.GetOccluderBudget());
+}
+
+void TestClamps()
+{
+	// A cost occluders can't fix. The budget bottoms out at MinOccluders, and resolution steps down at the resize pace
+	// and stops at the smallest level.
+	MOC_BudgetController controller(Resolutions, LevelCount);
+	WarmUp(controller, 0.0f, TargetMs * 3.0f);
+
+	std::vector<uint32_t> resizeFrames;
+	uint32_t minBudget = MOC_BudgetController::UnlimitedOccluders;
+
+	for (uint32_t frame = 1; frame <= 2000; frame++)
+	{
+		if (Step(controller, true, 0.0f, TargetMs * 3.0f, 200))
+			resizeFrames.push_back(frame);
+
+		minBudget = std::min(minBudget, controller.GetOccluderBudget());
+	}
+
+	TEST_CHECK_MSG(minBudget == MOC_BudgetController::MinOccluders, "%u", minBudget);
+	TEST_CHECK_MSG(controller.GetOccluderBudget() == MOC_BudgetController::MinOccluders, "%u", controller.GetOccluderBudget());
+	TEST_CHECK_MSG(controller.GetLevel() == LevelCount - 1, "%u", controller.GetLevel());
+	TEST_CHECK_MSG(resizeFrames.size() == LevelCount - 1, "%zu", resizeFrames.size());
+
+	if (!resizeFrames.empty())
+		TEST_CHECK_MSG(resizeFrames[0] == MOC_BudgetController::ResizeFrames, "%u", resizeFrames[0]);
+
+	for (size_t i = 1; i < resizeFrames.size(); i++)
+		TEST_CHECK_MSG(resizeFrames[i] - resizeFrames[i - 1] == MOC_BudgetController::ResizeCooldownFrames, "%u -> %u", resizeFrames[i - 1], resizeFrames[i]);
+
+	// Fewer occluders than the minimum doesn't push the budget below it
+	MOC_BudgetController few(Resolutions, LevelCount);
+	WarmUp(few, TargetMs * 3.0f, 0.0f);
+	Step(few, true, TargetMs * 3.0f, 0.0f, 10);
+
+	TEST_CHECK_MSG(few.GetOccluderBudget() == MOC_BudgetController::MinOccluders, "%u", few.GetOccluderBudget());
+
+	// Turning the controller off undoes everything at once
+	TEST_CHECK(Step(controller, false, 0.0f, TargetMs * 3.0f, 200));
+	TEST_CHECK(controller.GetLevel() == 0);
+	TEST_CHECK(controller.GetOccluderBudget() == MOC_BudgetController::UnlimitedOccluders);
+}
+
+// Drops one level with a cost that doesn't depend on occluders, then runs RasterAtLevel0 (scaled by the pixel count)
+// until the level settles
+uint32_t RunStepUp(float RasterAtLevel0, uint32_t Frames)
+{
+	MOC_BudgetController controller(Resolutions, LevelCount);
+	WarmUp(controller, 0.0f, TargetMs * 3.0f);
+
+	while (controller.GetLevel() == 0)
+		Step(controller, true, 0.0f, TargetMs * 3.0f, 100);
+
+	for (uint32_t frame = 0; frame < Frames; frame++)
+		Step(controller, true, RasterAtLevel0 * GetAreaRatio(controller.GetLevel()), 0.0f, 100);
+
+	return controller.GetLevel();
+}
+
+void TestStepUp()
+{
+	// 0.8x the target at level 1 would be ~0.99x at level 0, inside the band. Stepping up would only bounce back.
+	const uint32_t held = RunStepUp(TargetMs * 0.8f / GetAreaRatio(1), 2000);
+	TEST_CHECK_MSG(held == 1, "%u", held);
+
+	// 0.6x at level 1 is ~0.74x at level 0, so it goes back up once the cooldown is over
+	const uint32_t restored = RunStepUp(TargetMs * 0.6f / GetAreaRatio(1), 2000);
+	TEST_CHECK_MSG(restored == 0, "%u", restored);
+}
+
+void TestConvergence()
+{
+	// Raster cost is linear in the occluders drawn and the pixel count, queries are fixed. Starts at 2.25x the target.
+	constexpr float msPerOccluder = 0.004f;
+	constexpr float queryMs = 0.5f;
+	constexpr uint32_t submitted = 1000;
+
+	MOC_BudgetController controller(Resolutions, LevelCount);
+	uint32_t resizes = 0;
+	double lateCost = 0.0;
+	uint32_t lateFrames = 0;
+
+	for (uint32_t frame = 0; frame < 3000; frame++)
+	{
+		const uint32_t drawn = std::min(controller.GetOccluderBudget(), submitted);
+		const float rasterMs = msPerOccluder * drawn * GetAreaRatio(controller.GetLevel());
+
+		resizes += Step(controller, true, rasterMs, queryMs, submitted) ? 1 : 0;
+
+		if (frame >= 2500)
+		{
+			lateCost += rasterMs + queryMs;
+			lateFrames++;
+		}
+	}
+
+	const double averageMs = lateCost / lateFrames;
+
+	TEST_CHECK_MSG(averageMs > TargetMs * (1.0f - MOC_BudgetController::Hysteresis) && averageMs < TargetMs * (1.0f + MOC_BudgetController::Hysteresis), "%.3fms", averageMs);
+	TEST_CHECK_MSG(resizes <= 2, "%u resizes", resizes);
+	TEST_CHECK_MSG(fabsf(controller.GetRasterMs() + controller.GetQueryMs() - (float)averageMs) < TargetMs * 0.1f, "%.3f + %.3f vs %.3f", controller.GetRasterMs(), controller.GetQueryMs(), averageMs);
+}
+
+int main()
+{
+	Profiler::Clock::Initialize();
+
+	TestHysteresis();
+	TestGiveBack();
+	TestClamps();
+	TestStepUp();
+	TestConvergence();
+
+	return TestResult("budget_controller_test");
+}
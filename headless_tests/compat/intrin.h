@@ -0,0 +1,40 @@
+#pragma once
+
+//
+// Stand-in for MSVC's <intrin.h> so the portable engine headers build with GCC and Clang. Only what those headers
+// actually use is provided. <cpuid.h> isn't used because it defines __cpuid as a macro with a different signature.
+//
+#include <stdint.h>
+#include <x86intrin.h>
+
+#ifndef __forceinline
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
+inline void __cpuidex(int CpuInfo[4], int Function, int SubFunction)
+{
+	asm volatile("cpuid" : "=a"(CpuInfo[0]), "=b"(CpuInfo[1]), "=c"(CpuInfo[2]), "=d"(CpuInfo[3]) : "a"(Function), "c"(SubFunction));
+}
+
+inline void __cpuid(int CpuInfo[4], int Function)
+{
+	__cpuidex(CpuInfo, Function, 0);
+}
+
+inline unsigned char _BitScanForward(unsigned long *Index, uint32_t Mask)
+{
+	if (Mask == 0)
+		return 0;
+
+	*Index = __builtin_ctz(Mask);
+	return 1;
+}
+
+inline unsigned char _BitScanForward64(unsigned long *Index, uint64_t Mask)
+{
+	if (Mask == 0)
+		return 0;
+
+	*Index = __builtin_ctzll(Mask);
+	return 1;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+//
+// Stand-in for <windows.h> so the portable engine headers build with GCC and Clang. Only what those headers actually
+// use is provided: interlocked operations map to GCC builtins and WaitOnAddress/WakeByAddressAll to futexes.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+typedef int32_t LONG;
+typedef int BOOL;
+typedef uint32_t DWORD;
+typedef void *PVOID;
+
+#define INFINITE 0xFFFFFFFF
+
+inline LONG InterlockedCompareExchange(volatile LONG *Destination, LONG Exchange, LONG Comparand)
+{
+	return __sync_val_compare_and_swap(Destination, Comparand, Exchange);
+}
+
+inline LONG InterlockedExchange(volatile LONG *Target, LONG Value)
+{
+	return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+inline LONG InterlockedIncrement(volatile LONG *Addend)
+{
+	return __atomic_add_fetch(Addend, 1, __ATOMIC_SEQ_CST);
+}
+
+inline LONG InterlockedDecrement(volatile LONG *Addend)
+{
+	return __atomic_sub_fetch(Addend, 1, __ATOMIC_SEQ_CST);
+}
+
+inline BOOL SwitchToThread()
+{
+	return sched_yield() == 0;
+}
+
+// 32-bit compares only, which is all the engine headers wait on
+inline BOOL WaitOnAddress(volatile void *Address, PVOID CompareAddress, size_t AddressSize, DWORD Milliseconds)
+{
+	static_cast<void>(AddressSize);
+	static_cast<void>(Milliseconds);
+
+	syscall(SYS_futex, (int *)Address, FUTEX_WAIT_PRIVATE, *(int *)CompareAddress, nullptr, nullptr, 0);
+	return 1;
+}
+
+inline void WakeByAddressAll(PVOID Address)
+{
+	syscall(SYS_futex, (int *)Address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
@@ -0,0 +1,74 @@
+#include "test_common.h"
+#include "BSCRC32.h"
+
+//
+// BSCRC32 replaces the engine's CRC32_Lazy (sub_140C06030) for GlobalFormList lookups. That function can't be called
+// off-target, so both inlined paths are checked against a bit-at-a-time reference of the same CRC instead: reflected
+// CRC-32, polynomial 0xEDB88320, zero seed, no final XOR, over the 4 key bytes in little endian order.
+//
+// That only proves the fast paths match the reference. The Debug build of PatchTESForm still compares them against the
+// engine function itself for every base ID.
+//
+uint32_t ReferenceHash(uint32_t Key)
+{
+	uint32_t crc = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		crc ^= (Key >> (i * 8)) & 0xFF;
+
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+	}
+
+	return crc;
+}
+
+void CheckRange(uint32_t First, uint32_t Count)
+{
+	static uint32_t keys[4096];
+	static uint32_t hashes[4096];
+
+	for (uint32_t base = 0; base < Count; base += 4096)
+	{
+		const uint32_t batch = (Count - base < 4096) ? Count - base : 4096;
+
+		for (uint32_t i = 0; i < batch; i++)
+			keys[i] = First + base + i;
+
+		BSCRC32::HashBatch(keys, hashes, batch);
+
+		for (uint32_t i = 0; i < batch; i++)
+		{
+			const uint32_t expected = ReferenceHash(keys[i]);
+
+			TEST_CHECK_MSG(BSCRC32::HashTable(keys[i]) == expected, "table, key %08X", keys[i]);
+			TEST_CHECK_MSG(!BSCRC32::HasCLMUL || BSCRC32::HashCLMUL(keys[i]) == expected, "clmul, key %08X", keys[i]);
+			TEST_CHECK_MSG(hashes[i] == expected, "batch, key %08X", keys[i]);
+
+			// Enough to diagnose, don't flood the log
+			if (g_TestFailures > 16)
+				return;
+		}
+	}
+}
+
+int main()
+{
+	printf("PCLMULQDQ: %s\n", BSCRC32::HasCLMUL ? "yes" : "no (table path only)");
+
+	// Every base ID in the first plugin slot, then the first and last few thousand IDs of every other load order index
+	CheckRange(0, 1u << 24);
+
+	for (uint32_t plugin = 1; plugin < 256; plugin++)
+	{
+		CheckRange(plugin << 24, 4096);
+		CheckRange((plugin << 24) + (1u << 24) - 4096, 4096);
+	}
+
+	// Odd batch sizes exercise the remainder loop
+	CheckRange(0x12345, 3);
+	CheckRange(0xFFFFFFFF, 1);
+
+	return TestResult("crc32_test");
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "test_common.h"
+#include "patches/rendering/DynamicBufferRing.h"
+
+//
+// DynamicBufferRing rotation against a mock device whose GPU finishes with a buffer a fixed number of rotations after
+// it was signaled: wrapping around a ring that never has to wait, growth up to the GPU latency, and blocking on a
+// stalled fence once the ring can't grow any more.
+//
+class MockBufferDevice : public DynamicBufferDevice
+{
+public:
+	uint64_t Now = 0;					// One tick per rotation
+	uint64_t Latency;					// Ticks from Signal() until the GPU is done with a slot
+	uint32_t MaxCreatable;				// CreateSlot() fails from this slot ID on
+	uint32_t StallSleepMs = 0;			// Real time spent in Wait(), so stall accounting has something to measure
+
+	uint32_t Created = 0;
+	uint32_t Waits = 0;
+	uint64_t DoneAt[DynamicBufferRing::MaxSlots] = {};
+	uint64_t SignaledAt[DynamicBufferRing::MaxSlots] = {};
+	bool Signaled[DynamicBufferRing::MaxSlots] = {};
+
+	MockBufferDevice(uint64_t Latency, uint32_t MaxCreatable = DynamicBufferRing::MaxSlots) : Latency(Latency), MaxCreatable(MaxCreatable)
+	{
+	}
+
+	bool CreateSlot(uint32_t Slot) override
+	{
+		TEST_CHECK_MSG(Slot == Created, "%u vs %u", Slot, Created);
+
+		if (Slot >= MaxCreatable)
+			return false;
+
+		Created++;
+		return true;
+	}
+
+	void Signal(uint32_t Slot) override
+	{
+		Signaled[Slot] = true;
+		SignaledAt[Slot] = Now;
+		DoneAt[Slot] = Now + Latency;
+	}
+
+	bool IsComplete(uint32_t Slot) override
+	{
+		return Now >= DoneAt[Slot];
+	}
+
+	void Wait(uint32_t Slot) override
+	{
+		Waits++;
+
+		if (StallSleepMs > 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(StallSleepMs));
+
+		Now = std::max(Now, DoneAt[Slot]);
+	}
+};
+
+// Every allocation fills most of a slot, so each one rotates. Checks that the ring never hands out a slot the GPU still
+// owns and that a reused slot is always the one that was signaled longest ago.
+void RunRotations(MockBufferDevice& Device, DynamicBufferRing& Ring, uint32_t Rotations)
+{
+	const uint32_t size = Ring.GetSlotSize() - Ring.GetSlotSize() / 4;
+
+	for (uint32_t i = 0; i < Rotations; i++)
+	{
+		uint32_t offset;
+		const uint32_t slot = Ring.Allocate(size, &offset);
+
+		TEST_CHECK(offset + size <= Ring.GetSlotSize());
+
+		if (offset == 0 && Device.Signaled[slot])
+		{
+			TEST_CHECK_MSG(Device.IsComplete(slot), "slot %u handed out at %llu, done at %llu", slot, (unsigned long long)Device.Now, (unsigned long long)Device.DoneAt[slot]);
+
+			for (uint32_t other = 0; other < Device.Created; other++)
+			{
+				if (other != slot && Device.Signaled[other])
+					TEST_CHECK_MSG(Device.SignaledAt[other] >= Device.SignaledAt[slot], "slot %u reused before %u", slot, other);
+			}
+		}
+
+		Device.Now++;
+	}
+}
+
+void TestWrap()
+{
+	// The GPU keeps up with 3 buffers, so the ring cycles through them in order without growing or waiting
+	MockBufferDevice device(1);
+	DynamicBufferRing ring(&device, 1024, 3);
+
+	uint32_t offset;
+	TEST_CHECK(ring.Allocate(600, &offset) == 0 && offset == 0);
+	TEST_CHECK(ring.Allocate(400, &offset) == 0 && offset == 600);
+
+	for (uint32_t expected : { 1u, 2u, 0u, 1u, 2u, 0u })
+	{
+		TEST_CHECK(ring.Allocate(600, &offset) == expected && offset == 0);
+		device.Now++;
+	}
+
+	ring.EndFrame();
+
+	const auto& stats = ring.GetLastFrameStats();
+	TEST_CHECK_MSG(stats.Rotations == 6 && stats.Stalls == 0 && stats.SlotCount == 3, "%u rotations, %u stalls, %u slots", stats.Rotations, stats.Stalls, stats.SlotCount);
+	TEST_CHECK(device.Created == 3 && device.Waits == 0);
+}
+
+void TestGrowth()
+{
+	// A ring that can grow ends up one slot deeper than the GPU latency and never waits
+	for (uint64_t latency : { 1, 2, 4, 7 })
+	{
+		MockBufferDevice device(latency);
+		DynamicBufferRing ring(&device, 1024, 3);
+
+		RunRotations(device, ring, 500);
+		ring.EndFrame();
+
+		const uint32_t expectedSlots = std::max<uint32_t>((uint32_t)latency + 1, 3);
+		TEST_CHECK_MSG(ring.GetSlotCount() == expectedSlots, "latency %llu: %u slots", (unsigned long long)latency, ring.GetSlotCount());
+		TEST_CHECK_MSG(device.Waits == 0, "latency %llu: %u waits", (unsigned long long)latency, device.Waits);
+		TEST_CHECK(ring.GetLastFrameStats().Stalls == 0);
+	}
+}
+
+void TestStalledFence()
+{
+	// The GPU is far behind and the device can't create more than 4 buffers. The ring grows once, then has to block on
+	// the oldest buffer every time, and the time spent in Wait() is charged to the frame.
+	MockBufferDevice device(40, 4);
+	device.StallSleepMs = 2;
+
+	DynamicBufferRing ring(&device, 1024, 3);
+
+	RunRotations(device, ring, 20);
+	ring.EndFrame();
+
+	const auto& stats = ring.GetLastFrameStats();
+	TEST_CHECK_MSG(ring.GetSlotCount() == 4, "%u slots", ring.GetSlotCount());
+	TEST_CHECK_MSG(stats.Stalls == device.Waits && stats.Stalls > 0, "%u stalls, %u waits", stats.Stalls, device.Waits);
+	TEST_CHECK_MSG(stats.StallNs >= stats.Stalls * device.StallSleepMs * 1000000ull, "%llu ns for %u stalls", (unsigned long long)stats.StallNs, stats.Stalls);
+	TEST_CHECK(stats.Rotations == 19);
+
+	// A new frame starts from zero
+	ring.EndFrame();
+	TEST_CHECK(ring.GetLastFrameStats().Stalls == 0 && ring.GetLastFrameStats().StallNs == 0 && ring.GetLastFrameStats().SlotCount == 4);
+}
+
+void TestMaxSlotCount()
+{
+	// Growth stops at the ring's own limit even when the device could create more
+	MockBufferDevice device(40);
+	DynamicBufferRing ring(&device, 1024, 2, 5);
+
+	RunRotations(device, ring, 100);
+
+	TEST_CHECK_MSG(ring.GetSlotCount() == 5 && device.Created == 5, "%u slots, %u created", ring.GetSlotCount(), device.Created);
+	TEST_CHECK(device.Waits > 0);
+}
+
+int main()
+{
+	TestWrap();
+	TestGrowth();
+	TestStalledFence();
+	TestMaxSlotCount();
+
+	return TestResult("dynamic_buffer_ring_test");
+}
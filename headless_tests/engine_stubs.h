@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+//
+// The xutil.h macros engine headers expect to get from common.h. Assertion failures abort so CTest reports them.
+//
+#define Assert(Cond)					if(!(Cond)) { fprintf(stderr, "%s(%d): assertion failed: %s\n", __FILE__, __LINE__, #Cond); abort(); }
+#define AssertDebug(Cond)				Assert(Cond)
+#define AssertMsg(Cond, Msg)			AssertMsgVa(Cond, Msg)
+#define AssertMsgDebug(Cond, Msg)		AssertMsgVa(Cond, Msg)
+#define AssertMsgVa(Cond, Msg, ...)		if(!(Cond)) { fprintf(stderr, "%s(%d): assertion failed: %s: " Msg "\n", __FILE__, __LINE__, #Cond, ##__VA_ARGS__); abort(); }
+
+// Engine layouts follow MSVC's rules (no tail padding reuse), which GCC and Clang don't match for non-POD bases
+#ifdef _MSC_VER
+#define static_assert_offset(Structure, Member, Offset) static_assert(offsetof(Structure, Member) == Offset, #Structure "::" #Member)
+#else
+#define static_assert_offset(Structure, Member, Offset) static_assert(true)
+#endif
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "test_common.h"
+#include "patches/rendering/FramePacer.h"
+
+//
+// FramePacer on the OS clock with clock_nanosleep (or the waitable timer on Windows): a 60 FPS schedule under uneven
+// frame work, restarting the schedule after a late frame, the spin tail limits, and the timer-only SleepFor().
+//
+// The bounds are loose enough for a busy CI machine. A broken pacer misses them by whole milliseconds.
+//
+constexpr double TargetIntervalMs = 1000.0 / 60.0;
+
+void SpinFor(FramePacer& Pacer, uint64_t Nanoseconds)
+{
+	const uint64_t end = Pacer.Now() + Pacer.NsToTicks(Nanoseconds);
+
+	while (Pacer.Now() < end)
+		;
+}
+
+double TicksToMs(FramePacer& Pacer, uint64_t Ticks)
+{
+	return (double)Ticks / (double)Pacer.NsToTicks(1000000);
+}
+
+void TestSteadyPacing()
+{
+	FramePacer pacer;
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<uint32_t> workMs(2, 8);
+	std::vector<double> intervals;
+
+	uint64_t last = pacer.Now();
+
+	for (uint32_t frame = 0; frame < 120; frame++)
+	{
+		SpinFor(pacer, workMs(rng) * 1000000ull);
+		pacer.PaceFrame(TargetIntervalMs);
+
+		const uint64_t now = pacer.Now();
+
+		if (frame > 0)
+			intervals.push_back(TicksToMs(pacer, now - last));
+
+		last = now;
+	}
+
+	std::sort(intervals.begin(), intervals.end());
+	const double median = intervals[intervals.size() / 2];
+	const auto window = pacer.ConsumeErrorWindow();
+
+	// Every frame after the first one should wait since the work is well under the interval, but a preempted frame can
+	// still come in late and restart the schedule
+	TEST_CHECK_MSG(window.Count >= 110 && window.Count <= 119, "%llu", (unsigned long long)window.Count);
+	TEST_CHECK_MSG(median > TargetIntervalMs - 0.25 && median < TargetIntervalMs + 0.25, "%.3fms", median);
+	TEST_CHECK_MSG(window.P50Us < 250.0, "%.1fus", window.P50Us);
+	TEST_CHECK_MSG(window.SpinUs >= FramePacer::MinSpinNs / 1000.0 && window.SpinUs <= FramePacer::MaxSpinNs / 1000.0, "%.1fus", window.SpinUs);
+
+	// Nothing new since the last window
+	TEST_CHECK(pacer.ConsumeErrorWindow().Count == 0);
+}
+
+void TestLateFrame()
+{
+	FramePacer pacer;
+
+	pacer.PaceFrame(TargetIntervalMs);
+	SpinFor(pacer, 5 * 1000000ull);
+	pacer.PaceFrame(TargetIntervalMs);
+
+	// Twice the interval in one frame. The pacer starts over instead of presenting the next frames back to back.
+	SpinFor(pacer, 34 * 1000000ull);
+
+	uint64_t start = pacer.Now();
+	pacer.PaceFrame(TargetIntervalMs);
+	const double lateWaitMs = TicksToMs(pacer, pacer.Now() - start);
+
+	TEST_CHECK_MSG(lateWaitMs < 5.0, "%.3fms", lateWaitMs);
+
+	// The next deadline is a full interval after the late frame
+	start = pacer.Now();
+	pacer.PaceFrame(TargetIntervalMs);
+	const double nextWaitMs = TicksToMs(pacer, pacer.Now() - start);
+
+	TEST_CHECK_MSG(nextWaitMs > TargetIntervalMs - 1.0 && nextWaitMs < TargetIntervalMs + 5.0, "%.3fms", nextWaitMs);
+
+	// Only the two frames that actually waited are in the error window
+	TEST_CHECK(pacer.ConsumeErrorWindow().Count == 2);
+}
+
+void TestSleepFor()
+{
+	FramePacer pacer;
+
+	for (uint64_t ns : { 500000ull, 1000000ull, 4000000ull })
+	{
+		const double targetMs = ns / 1000000.0;
+		double bestMs = 1000.0;
+
+		// Never early. The best of a few tries has to be nowhere near the 15.6ms scheduler tick; any single one can
+		// lose its core to another process.
+		for (uint32_t i = 0; i < 5; i++)
+		{
+			const uint64_t start = pacer.Now();
+			FramePacer::SleepFor(ns);
+			const double sleptMs = TicksToMs(pacer, pacer.Now() - start);
+
+			TEST_CHECK_MSG(sleptMs >= targetMs, "%.3fms for %.3fms", sleptMs, targetMs);
+			bestMs = std::min(bestMs, sleptMs);
+		}
+
+		TEST_CHECK_MSG(bestMs < targetMs + 5.0, "%.3fms for %.3fms", bestMs, targetMs);
+	}
+}
+
+int main()
+{
+	TestSteadyPacing();
+	TestLateFrame();
+	TestSleepFor();
+
+	return TestResult("frame_pacer_test");
+}
@@ -0,0 +1,268 @@
+#include <math.h>
+#include <string.h>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "test_common.h"
+#include "profiler_clock.h"
+#include "profiler_hitch.h"
+
+//
+// Profiler::HitchDetector on synthetic frame times: no detection during warmup or cooldown, both the Multiplier and
+// MinExcessMs thresholds, scopes appended (and missing) mid-run, and GetTopGrowth() ranking by growth over each
+// scope's median rather than its mean.
+//
+using namespace Profiler;
+
+int64_t MsToTicks(double Ms)
+{
+	return (int64_t)llround(Ms * (double)Clock::GetFrequency() / 1000.0);
+}
+
+// Feeds Count frames of FrameTimeMs without any scopes and returns how many were flagged
+uint32_t Feed(HitchDetector& Detector, float FrameTimeMs, uint32_t Count)
+{
+	uint32_t hitches = 0;
+
+	for (uint32_t i = 0; i < Count; i++)
+		hitches += Detector.AddFrame(FrameTimeMs, nullptr, 0) ? 1 : 0;
+
+	return hitches;
+}
+
+void TestWarmup()
+{
+	HitchDetector::Settings settings;
+	auto detector = std::make_unique<HitchDetector>(settings);
+
+	// Every frame before WarmupFrames is ignored, even a huge one
+	TEST_CHECK(Feed(*detector, 10.0f, settings.WarmupFrames - 1) == 0);
+	TEST_CHECK(!detector->AddFrame(1000.0f, nullptr, 0));
+
+	// The first frame after warmup is judged. The spike above is 1 of 120 frames, under the 95th percentile.
+	TEST_CHECK_MSG(detector->GetBaselineMs() == 10.0f, "%.2f", detector->GetBaselineMs());
+	TEST_CHECK(detector->AddFrame(1000.0f, nullptr, 0));
+}
+
+void TestCooldown()
+{
+	HitchDetector::Settings settings;
+	auto detector = std::make_unique<HitchDetector>(settings);
+
+	Feed(*detector, 10.0f, 400);
+	TEST_CHECK(detector->AddFrame(100.0f, nullptr, 0));
+
+	// Nothing triggers for CooldownFrames frames, then the next spike does
+	uint32_t suppressed = 0;
+
+	for (uint32_t i = 0; i < settings.CooldownFrames; i++)
+		suppressed += detector->AddFrame(100.0f, nullptr, 0) ? 1 : 0;
+
+	TEST_CHECK_MSG(suppressed == 0, "%u", suppressed);
+
+	// 121 spikes in 521 frames push the 95th percentile up, so settle it again first. That's longer than the cooldown.
+	Feed(*detector, 10.0f, HitchDetector::BaselineFrames);
+	TEST_CHECK_MSG(detector->GetBaselineMs() == 10.0f, "%.2f", detector->GetBaselineMs());
+	TEST_CHECK(detector->AddFrame(100.0f, nullptr, 0));
+
+	// One frame past the cooldown is enough
+	HitchDetector::Settings shortCooldown;
+	shortCooldown.CooldownFrames = 5;
+
+	auto quick = std::make_unique<HitchDetector>(shortCooldown);
+	Feed(*quick, 10.0f, 400);
+
+	TEST_CHECK(quick->AddFrame(100.0f, nullptr, 0));
+	TEST_CHECK(Feed(*quick, 100.0f, 5) == 0);
+	TEST_CHECK(quick->AddFrame(100.0f, nullptr, 0));
+}
+
+// One fresh detector per frame time so cooldowns don't interfere
+bool IsHitch(float BaselineMs, float FrameTimeMs, const HitchDetector::Settings& Settings = {})
+{
+	auto detector = std::make_unique<HitchDetector>(Settings);
+	Feed(*detector, BaselineMs, 400);
+
+	return detector->AddFrame(FrameTimeMs, nullptr, 0);
+}
+
+void TestThresholds()
+{
+	// Both have to hold: at least 2x the baseline and at least 10ms over it
+	TEST_CHECK(!IsHitch(10.0f, 19.9f));
+	TEST_CHECK(IsHitch(10.0f, 20.0f));
+
+	// 2.5x, but only 3ms over. Fast frames jitter a lot relative to their length.
+	TEST_CHECK(!IsHitch(2.0f, 5.0f));
+	TEST_CHECK(!IsHitch(2.0f, 11.9f));
+	TEST_CHECK(IsHitch(2.0f, 12.0f));
+
+	// 15ms over, but only 1.5x. Slow frames vary a lot in absolute terms.
+	TEST_CHECK(!IsHitch(30.0f, 45.0f));
+	TEST_CHECK(IsHitch(30.0f, 60.0f));
+
+	HitchDetector::Settings strict;
+	strict.Multiplier = 1.5f;
+	strict.MinExcessMs = 2.0f;
+
+	TEST_CHECK(IsHitch(10.0f, 15.0f, strict));
+	TEST_CHECK(!IsHitch(10.0f, 14.9f, strict));
+	TEST_CHECK(!IsHitch(2.0f, 3.9f, strict));
+
+	// The baseline is the 95th percentile: 1 frame in 25 at 50ms doesn't move it, 1 in 10 does
+	auto detector = std::make_unique<HitchDetector>();
+
+	for (uint32_t i = 0; i < HitchDetector::BaselineFrames; i++)
+		detector->AddFrame((i % 25 == 0) ? 50.0f : 10.0f, nullptr, 0);
+
+	detector->AddFrame(10.0f, nullptr, 0);
+	TEST_CHECK_MSG(detector->GetBaselineMs() == 10.0f, "%.2f", detector->GetBaselineMs());
+
+	for (uint32_t i = 0; i < HitchDetector::BaselineFrames; i++)
+		detector->AddFrame((i % 10 == 0) ? 50.0f : 10.0f, nullptr, 0);
+
+	detector->AddFrame(10.0f, nullptr, 0);
+	TEST_CHECK_MSG(detector->GetBaselineMs() == 50.0f, "%.2f", detector->GetBaselineMs());
+}
+
+void TestScopes()
+{
+	// Fresh pages are zeroed anyway. Dirty the memory first so a new scope only has no history if it was cleared.
+	auto storage = std::make_unique<uint8_t[]>(sizeof(HitchDetector));
+	memset(storage.get(), 0xCD, sizeof(HitchDetector));
+
+	HitchDetector *detector = new (storage.get()) HitchDetector();
+	int64_t totals[3] = {};
+
+	// Two scopes for a while, then a third one shows up
+	for (uint32_t frame = 0; frame < 50; frame++)
+	{
+		totals[0] += MsToTicks(1.0);
+		totals[1] += MsToTicks(2.0);
+		detector->AddFrame(10.0f, totals, 2);
+	}
+
+	TEST_CHECK(detector->GetScopeCount() == 2);
+
+	for (uint32_t frame = 0; frame < 10; frame++)
+	{
+		totals[0] += MsToTicks(1.0);
+		totals[1] += MsToTicks(2.0);
+		totals[2] += MsToTicks(3.0);
+		detector->AddFrame(10.0f, totals, 3);
+	}
+
+	TEST_CHECK(detector->GetScopeCount() == 3);
+	TEST_CHECK(detector->GetHistoryCount() == 60);
+
+	// Existing scopes keep their history, the new one has none before it appeared
+	for (uint32_t age = 0; age < detector->GetHistoryCount(); age++)
+	{
+		TEST_CHECK_MSG(fabs(detector->GetScopeMs(0, age) - 1.0) < 0.001, "age %u: %f", age, detector->GetScopeMs(0, age));
+		TEST_CHECK_MSG(fabs(detector->GetScopeMs(1, age) - 2.0) < 0.001, "age %u: %f", age, detector->GetScopeMs(1, age));
+
+		const double expected = (age < 10) ? 3.0 : 0.0;
+		TEST_CHECK_MSG(fabs(detector->GetScopeMs(2, age) - expected) < 0.001, "age %u: %f", age, detector->GetScopeMs(2, age));
+	}
+
+	// A frame that passes fewer scopes records nothing for the rest, and the next full frame picks up from the old
+	// totals
+	totals[0] += MsToTicks(1.0);
+	detector->AddFrame(10.0f, totals, 1);
+
+	TEST_CHECK(detector->GetScopeCount() == 3);
+	TEST_CHECK(detector->GetScopeMs(1, 0) == 0.0 && detector->GetScopeMs(2, 0) == 0.0);
+
+	totals[0] += MsToTicks(1.0);
+	totals[1] += MsToTicks(2.0);
+	totals[2] += MsToTicks(3.0);
+	detector->AddFrame(10.0f, totals, 3);
+
+	TEST_CHECK_MSG(fabs(detector->GetScopeMs(1, 0) - 2.0) < 0.001, "%f", detector->GetScopeMs(1, 0));
+	TEST_CHECK_MSG(fabs(detector->GetScopeMs(2, 0) - 3.0) < 0.001, "%f", detector->GetScopeMs(2, 0));
+
+	// Anything past MaxScopes is dropped
+	std::vector<int64_t> many(HitchDetector::MaxScopes + 10, 0);
+	detector->AddFrame(10.0f, many.data(), (uint32_t)many.size());
+
+	TEST_CHECK_MSG(detector->GetScopeCount() == HitchDetector::MaxScopes, "%u", detector->GetScopeCount());
+}
+
+void TestTopGrowth()
+{
+	auto detector = std::make_unique<HitchDetector>();
+	int64_t totals[4] = {};
+
+	HitchDetector::ScopeGrowth top[4];
+	TEST_CHECK(detector->GetTopGrowth(top, 4) == 0);
+
+	// 0: steady 1ms
+	// 1: 5ms with a 100ms outlier every 4th frame. The median stays at 5, the mean is ~29.
+	// 2: steady 0.5ms
+	// 3: steady 2ms
+	for (uint32_t frame = 0; frame < HitchDetector::HistoryFrames * 2; frame++)
+	{
+		totals[0] += MsToTicks(1.0);
+		totals[1] += MsToTicks((frame % 4 == 0) ? 100.0 : 5.0);
+		totals[2] += MsToTicks(0.5);
+		totals[3] += MsToTicks(2.0);
+		detector->AddFrame(10.0f, totals, 4);
+	}
+
+	// The hitch frame: 2 grew by 9.5ms, 0 by 3ms, 1 by 1ms and 3 shrank by 1ms
+	totals[0] += MsToTicks(4.0);
+	totals[1] += MsToTicks(6.0);
+	totals[2] += MsToTicks(10.0);
+	totals[3] += MsToTicks(1.0);
+	detector->AddFrame(40.0f, totals, 4);
+
+	const uint32_t count = detector->GetTopGrowth(top, 4);
+	const uint32_t expectedOrder[] = { 2, 0, 1, 3 };
+	const double expectedBaseline[] = { 0.5, 1.0, 5.0, 2.0 };
+	const double expectedFrame[] = { 10.0, 4.0, 6.0, 1.0 };
+
+	TEST_CHECK_MSG(count == 4, "%u", count);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		TEST_CHECK_MSG(top[i].Scope == expectedOrder[i], "rank %u: scope %u", i, top[i].Scope);
+		TEST_CHECK_MSG(fabs(top[i].BaselineMs - expectedBaseline[i]) < 0.001, "rank %u: baseline %f", i, top[i].BaselineMs);
+		TEST_CHECK_MSG(fabs(top[i].FrameMs - expectedFrame[i]) < 0.001, "rank %u: frame %f", i, top[i].FrameMs);
+	}
+
+	// Fewer than the scope count returns the largest ones
+	TEST_CHECK(detector->GetTopGrowth(top, 2) == 2);
+	TEST_CHECK(top[0].Scope == 2 && top[1].Scope == 0);
+
+	// The report leads with the same ranking
+	const char *scopeNames[] = { "Steady", "Spiky", "Grew", "Shrank" };
+	const char *counterNames[] = { "Draws" };
+	auto telemetry = std::make_unique<FrameTelemetry>(counterNames, 1);
+
+	for (uint32_t i = 0; i < 10; i++)
+		telemetry->Record(FrameSample { 0, 10.0f, 8.0f, 50.0f, 25.0f, 0.0f, 0.0f, { 100 } });
+
+	std::string report;
+	TEST_CHECK(detector->FormatReport(report, scopeNames, *telemetry));
+
+	const size_t grew = report.find("Grew");
+	const size_t steady = report.find("Steady");
+
+	TEST_CHECK_MSG(report.rfind("Hitch: 40.00 ms", 0) == 0, "%.40s", report.c_str());
+	TEST_CHECK_MSG(grew != std::string::npos && steady != std::string::npos && grew < steady, "%zu %zu", grew, steady);
+	TEST_CHECK(report.find(",Draws,Grew (ms)") != std::string::npos);
+}
+
+int main()
+{
+	Clock::Initialize();
+
+	TestWarmup();
+	TestCooldown();
+	TestThresholds();
+	TestScopes();
+	TestTopGrowth();
+
+	return TestResult("hitch_detector_test");
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include "BSTLocklessQueue.h"
+
+#if HAVE_TBB
+#include <tbb/concurrent_queue.h>
+#endif
+
+//
+// Pointer throughput of BSTLocklessQueue::PtrMultiProdCons with N producers and N consumers, against a mutex-guarded
+// deque and (when found) tbb::concurrent_queue, which is what MOC_Renderer still uses. Every queue is driven through
+// non-blocking try/yield loops so only the queue itself differs.
+//
+//   lockless_queue_bench [items per producer]
+//
+using BenchClock = std::chrono::steady_clock;
+
+struct BSTQueue
+{
+	BSTLocklessQueue::PtrMultiProdCons<void, 1024, 0> Queue;
+
+	bool TryPush(void *const *Items, uint32_t Count)
+	{
+		return Queue.TryPushBatch(Items, Count, true) == Count;
+	}
+
+	uint32_t TryPop(void **Items, uint32_t Max)
+	{
+		return Queue.TryPopBatch(Items, Max);
+	}
+};
+
+struct MutexQueue
+{
+	std::mutex Lock;
+	std::deque<void *> Queue;
+
+	bool TryPush(void *const *Items, uint32_t Count)
+	{
+		std::lock_guard lock(Lock);
+
+		if (Queue.size() + Count > 1024)
+			return false;
+
+		Queue.insert(Queue.end(), Items, Items + Count);
+		return true;
+	}
+
+	uint32_t TryPop(void **Items, uint32_t Max)
+	{
+		std::lock_guard lock(Lock);
+		uint32_t count = 0;
+
+		for (; count < Max && !Queue.empty(); count++)
+		{
+			Items[count] = Queue.front();
+			Queue.pop_front();
+		}
+
+		return count;
+	}
+};
+
+#if HAVE_TBB
+struct TBBQueue
+{
+	tbb::concurrent_bounded_queue<void *> Queue;
+
+	TBBQueue()
+	{
+		Queue.set_capacity(1024);
+	}
+
+	bool TryPush(void *const *Items, uint32_t Count)
+	{
+		// No batch API, so batches aren't atomic here
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			while (!Queue.try_push(Items[i]))
+				std::this_thread::yield();
+		}
+
+		return true;
+	}
+
+	uint32_t TryPop(void **Items, uint32_t Max)
+	{
+		uint32_t count = 0;
+
+		while (count < Max && Queue.try_pop(Items[count]))
+			count++;
+
+		return count;
+	}
+};
+#endif
+
+template<typename Queue>
+double ItemsPerUs(uint32_t Pairs, uint32_t PerProducer, uint32_t Batch)
+{
+	Queue queue;
+	std::atomic<uint32_t> started = 0;
+	std::atomic<uint64_t> remaining = (uint64_t)Pairs * PerProducer;
+	std::vector<std::thread> threads;
+
+	for (uint32_t p = 0; p < Pairs; p++)
+	{
+		threads.emplace_back([&]()
+		{
+			void *items[64];
+
+			for (uint32_t i = 0; i < Batch; i++)
+				items[i] = (void *)(uintptr_t)(i + 1);
+
+			started++;
+			while (started != Pairs * 2)
+				std::this_thread::yield();
+
+			for (uint32_t i = 0; i < PerProducer; i += Batch)
+			{
+				while (!queue.TryPush(items, Batch))
+					std::this_thread::yield();
+			}
+		});
+
+		threads.emplace_back([&]()
+		{
+			void *items[64];
+
+			started++;
+			while (started != Pairs * 2)
+				std::this_thread::yield();
+
+			while (remaining.load(std::memory_order_relaxed) > 0)
+			{
+				if (uint32_t count = queue.TryPop(items, Batch); count != 0)
+					remaining -= count;
+				else
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	const auto start = BenchClock::now();
+
+	for (auto& thread : threads)
+		thread.join();
+
+	const double us = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+	return ((double)Pairs * PerProducer) / us;
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t perProducer = (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) / 64 * 64 : 1 << 20;
+
+	printf("%u items per producer, %u hardware threads, million items/s\n", perProducer, std::thread::hardware_concurrency());
+	printf("%-8s %-6s %14s %14s %14s\n", "pairs", "batch", "BSTLockless", "mutex+deque", "tbb");
+
+	for (uint32_t pairs = 1; pairs <= 8; pairs *= 2)
+	{
+		for (uint32_t batch : { 1u, 16u, 64u })
+		{
+			printf("%-8u %-6u %14.2f %14.2f", pairs, batch, ItemsPerUs<BSTQueue>(pairs, perProducer, batch), ItemsPerUs<MutexQueue>(pairs, perProducer, batch));
+
+#if HAVE_TBB
+			printf(" %14.2f\n", ItemsPerUs<TBBQueue>(pairs, perProducer, batch));
+#else
+			printf(" %14s\n", "-");
+#endif
+		}
+	}
+
+	return 0;
+}
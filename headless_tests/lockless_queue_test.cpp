@@ -0,0 +1,378 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <random>
+#include <unordered_set>
+#include "test_common.h"
+#include "BSTLocklessQueue.h"
+
+//
+// BSTLocklessQueue::PtrMultiProdCons is checked three ways:
+//
+// - Short concurrent histories of TryPush/TryPop on a tiny queue are recorded with real-time call/return stamps and
+//   searched for a legal sequential FIFO order (Wing & Gong). Full and empty failures count as observations too.
+// - A long run of blocking Push/Pop with more threads than cores: every item arrives exactly once, each consumer sees
+//   every producer's items in order, and nobody sleeps through a wakeup (the test would hang).
+// - All-or-nothing batches from several producers come out contiguous when there's a single consumer.
+//
+std::atomic<uint64_t> g_Clock;
+
+struct Operation
+{
+	bool Push;
+	bool Success;
+	uintptr_t Value;
+	uint64_t Call;
+	uint64_t Return;
+};
+
+// Values are the pointers themselves, nothing is dereferenced
+using Item = void;
+
+template<uint32_t Capacity>
+class LinearizabilityChecker
+{
+public:
+	LinearizabilityChecker(const std::vector<Operation>& History) : m_History(History)
+	{
+	}
+
+	bool Check()
+	{
+		std::deque<uintptr_t> queue;
+		return Search(0, queue);
+	}
+
+private:
+	const std::vector<Operation>& m_History;
+	std::unordered_set<uint64_t> m_Dead;
+
+	uint64_t StateKey(uint32_t Done, const std::deque<uintptr_t>& Queue) const
+	{
+		// Values are unique and small, so the set of finished operations plus the queue contents pins the state
+		uint64_t key = Done;
+
+		for (uintptr_t value : Queue)
+			key = (key * 0x100000001B3ull) ^ value;
+
+		return key;
+	}
+
+	bool Search(uint32_t Done, std::deque<uintptr_t>& Queue)
+	{
+		if (Done == (1u << m_History.size()) - 1)
+			return true;
+
+		if (m_Dead.count(StateKey(Done, Queue)))
+			return false;
+
+		// Only operations that were called before every pending operation returned can go next
+		uint64_t minReturn = UINT64_MAX;
+
+		for (uint32_t i = 0; i < m_History.size(); i++)
+		{
+			if (!(Done & (1u << i)) && m_History[i].Return < minReturn)
+				minReturn = m_History[i].Return;
+		}
+
+		for (uint32_t i = 0; i < m_History.size(); i++)
+		{
+			const Operation& op = m_History[i];
+
+			if ((Done & (1u << i)) || op.Call > minReturn)
+				continue;
+
+			if (op.Push)
+			{
+				if (op.Success != (Queue.size() < Capacity))
+					continue;
+
+				if (op.Success)
+					Queue.push_back(op.Value);
+
+				if (Search(Done | (1u << i), Queue))
+					return true;
+
+				if (op.Success)
+					Queue.pop_back();
+			}
+			else
+			{
+				if (op.Success != !Queue.empty() || (op.Success && Queue.front() != op.Value))
+					continue;
+
+				if (op.Success)
+					Queue.pop_front();
+
+				if (Search(Done | (1u << i), Queue))
+					return true;
+
+				if (op.Success)
+					Queue.push_front(op.Value);
+			}
+		}
+
+		m_Dead.insert(StateKey(Done, Queue));
+		return false;
+	}
+};
+
+void TestLinearizability()
+{
+	constexpr uint32_t threadCount = 3;
+	constexpr uint32_t opsPerThread = 5;
+	constexpr uint32_t rounds = 20000;
+
+	uint32_t failures = 0;
+
+	for (uint32_t round = 0; round < rounds && failures < 4; round++)
+	{
+		BSTLocklessQueue::PtrMultiProdCons<Item, 4, 0> queue;
+		std::vector<Operation> history[threadCount];
+		std::atomic<uint32_t> ready = 0;
+		std::thread threads[threadCount];
+
+		for (uint32_t t = 0; t < threadCount; t++)
+		{
+			threads[t] = std::thread([&, t]()
+			{
+				std::mt19937 rng(round * threadCount + t);
+
+				// Yield rather than spin so the start lines up on machines with fewer cores than threads
+				ready++;
+				while (ready != threadCount)
+					std::this_thread::yield();
+
+				for (uint32_t i = 0; i < opsPerThread; i++)
+				{
+					Operation op;
+					op.Push = (rng() % 2) == 0;
+					op.Value = op.Push ? (t * opsPerThread + i + 1) : 0;
+					op.Call = g_Clock++;
+
+					if (op.Push)
+					{
+						op.Success = queue.TryPush((Item *)op.Value);
+					}
+					else
+					{
+						Item *value = nullptr;
+						op.Success = queue.TryPop(value);
+						op.Value = (uintptr_t)value;
+					}
+
+					op.Return = g_Clock++;
+					history[t].push_back(op);
+				}
+			});
+		}
+
+		std::vector<Operation> merged;
+
+		for (uint32_t t = 0; t < threadCount; t++)
+		{
+			threads[t].join();
+			merged.insert(merged.end(), history[t].begin(), history[t].end());
+		}
+
+		if (!LinearizabilityChecker<4>(merged).Check())
+		{
+			failures++;
+			fprintf(stderr, "Round %u has no linearization:\n", round);
+
+			for (auto& op : merged)
+				fprintf(stderr, "  [%llu, %llu] %s %zu -> %d\n", (unsigned long long)op.Call, (unsigned long long)op.Return, op.Push ? "push" : "pop", (size_t)op.Value, op.Success);
+		}
+	}
+
+	TEST_CHECK(failures == 0);
+}
+
+void TestBlockingStress()
+{
+	constexpr uint32_t producerCount = 4;
+	constexpr uint32_t consumerCount = 4;
+	constexpr uint32_t perProducer = 200000;
+
+	// Small enough that producers block on full as often as consumers block on empty
+	BSTLocklessQueue::PtrMultiProdCons<Item, 16, 0> queue;
+	std::vector<std::atomic<uint8_t>> seen(producerCount * perProducer);
+	std::atomic<uint32_t> duplicates = 0;
+	std::atomic<uint32_t> reordered = 0;
+	std::vector<std::thread> threads;
+
+	for (uint32_t p = 0; p < producerCount; p++)
+	{
+		threads.emplace_back([&, p]()
+		{
+			std::mt19937 rng(p);
+
+			for (uint32_t i = 0; i < perProducer;)
+			{
+				// Value 0 would be a null pointer, so items are offset by one
+				uintptr_t batch[8];
+				const uint32_t count = std::min<uint32_t>(1 + rng() % 8, perProducer - i);
+
+				for (uint32_t j = 0; j < count; j++)
+					batch[j] = (uintptr_t)p * perProducer + i + j + 1;
+
+				if (count == 1)
+					queue.Push((Item *)batch[0]);
+				else
+					queue.PushBatch((Item *const *)batch, count);
+
+				i += count;
+			}
+		});
+	}
+
+	const uint32_t total = producerCount * perProducer;
+	std::atomic<uint32_t> consumed = 0;
+
+	for (uint32_t c = 0; c < consumerCount; c++)
+	{
+		threads.emplace_back([&]()
+		{
+			uint32_t last[producerCount] = {};
+			Item *batch[8];
+
+			while (true)
+			{
+				// Each consumer stops once the remaining items are spoken for, so none of them blocks forever
+				uint32_t claimed = consumed.load();
+
+				if (claimed >= total)
+					break;
+
+				const uint32_t want = std::min<uint32_t>(8, total - claimed);
+
+				if (!consumed.compare_exchange_weak(claimed, claimed + want))
+					continue;
+
+				for (uint32_t got = 0; got < want;)
+				{
+					const uint32_t count = queue.PopBatch(&batch[got], want - got);
+
+					for (uint32_t j = got; j < got + count; j++)
+					{
+						const uint32_t value = (uint32_t)(uintptr_t)batch[j] - 1;
+						const uint32_t producer = value / perProducer;
+						const uint32_t index = value % perProducer;
+
+						if (seen[value].fetch_add(1) != 0)
+							duplicates++;
+
+						if (index + 1 <= last[producer])
+							reordered++;
+
+						last[producer] = index + 1;
+					}
+
+					got += count;
+				}
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	uint32_t missing = 0;
+
+	for (auto& count : seen)
+		missing += (count == 0);
+
+	TEST_CHECK_MSG(duplicates == 0, "%u", duplicates.load());
+	TEST_CHECK_MSG(reordered == 0, "%u", reordered.load());
+	TEST_CHECK_MSG(missing == 0, "%u", missing);
+	TEST_CHECK(queue.QEmpty());
+}
+
+void TestBatchesAreContiguous()
+{
+	constexpr uint32_t producerCount = 3;
+	constexpr uint32_t batchSize = 5;
+	constexpr uint32_t batchesPerProducer = 50000;
+
+	BSTLocklessQueue::PtrMultiProdCons<Item, 64, 0> queue;
+	std::vector<std::thread> threads;
+
+	for (uint32_t p = 0; p < producerCount; p++)
+	{
+		threads.emplace_back([&, p]()
+		{
+			for (uint32_t b = 0; b < batchesPerProducer; b++)
+			{
+				uintptr_t batch[batchSize];
+
+				for (uint32_t j = 0; j < batchSize; j++)
+					batch[j] = (((uintptr_t)p * batchesPerProducer + b) * batchSize) + j + 1;
+
+				while (queue.TryPushBatch((Item *const *)batch, batchSize, true) == 0)
+					_mm_pause();
+			}
+		});
+	}
+
+	uint32_t broken = 0;
+	uintptr_t previous = 0;
+
+	for (uint32_t received = 0; received < producerCount * batchesPerProducer * batchSize;)
+	{
+		Item *items[32];
+		const uint32_t count = queue.PopBatch(items, 32);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uintptr_t value = (uintptr_t)items[i] - 1;
+
+			// Anything but the first item of a batch has to follow its predecessor directly
+			if ((value % batchSize) != 0 && value != previous + 1)
+				broken++;
+
+			previous = value;
+		}
+
+		received += count;
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	TEST_CHECK_MSG(broken == 0, "%u", broken);
+}
+
+void TestObjectQueue()
+{
+	struct Payload
+	{
+		uint32_t A;
+		uint32_t B;
+	};
+
+	static BSTLocklessQueue::ObjMultiProdCons<Payload, 8, 0> queue;
+	Payload value;
+
+	for (uint32_t i = 0; i < 8; i++)
+		TEST_CHECK(queue.TryPush({ i, i * 2 }));
+
+	// Every pool object is in use
+	TEST_CHECK(!queue.TryPush({ 0, 0 }));
+	TEST_CHECK(queue.QSize() == 8);
+
+	for (uint32_t i = 0; i < 8; i++)
+		TEST_CHECK(queue.TryPop(value) && value.A == i && value.B == i * 2);
+
+	TEST_CHECK(!queue.TryPop(value));
+}
+
+int main()
+{
+	TestObjectQueue();
+	TestBatchesAreContiguous();
+	TestLinearizability();
+	TestBlockingStress();
+
+	return TestResult("lockless_queue_test");
+}
@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "MemoryManager.h"
+#include "memory_stub.h"
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+//
+// The engine heap isn't available off-target. Containers that allocate through MemoryManager get the CRT instead,
+// zeroed like MemAlloc(..., Zeroed = true) in the game.
+//
+void *MemoryManager::Allocate(MemoryManager *Manager, size_t Size, uint32_t Alignment, bool Aligned)
+{
+	const size_t alignment = (Aligned && Alignment > sizeof(void *)) ? Alignment : sizeof(void *);
+	const size_t size = (Size + alignment - 1) & ~(alignment - 1);
+
+#ifdef _MSC_VER
+	void *memory = _aligned_malloc(size, alignment);
+#else
+	void *memory = aligned_alloc(alignment, size);
+#endif
+
+	if (memory)
+	{
+		memset(memory, 0, size);
+		g_StubAllocations++;
+	}
+
+	return memory;
+}
+
+void MemoryManager::Deallocate(MemoryManager *Manager, void *Memory, bool Aligned)
+{
+	if (Memory)
+		g_StubAllocations--;
+
+#ifdef _MSC_VER
+	_aligned_free(Memory);
+#else
+	free(Memory);
+#endif
+}
+
+size_t MemoryManager::Size(MemoryManager *Manager, void *Memory)
+{
+	return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Live MemoryManager allocations made through memory_stub.cpp, for leak and ownership checks
+inline std::atomic<int64_t> g_StubAllocations;
@@ -0,0 +1,311 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "test_common.h"
+#include "MOC_MeshBuild.h"
+
+//
+// MOC_MeshBuild::QuantizeVerts round trip: every decoded position (Offset + Quantized * Scale) has to be within half
+// a quantization step of the source and inside the mesh bounds, for different vertex strides, mesh sizes and
+// distances from the origin. Flat axes must decode exactly.
+//
+// BuildLods with stand-in simplifiers (meshoptimizer isn't part of this build): offsets, triangle counts decreasing
+// per level, LOD 0 never empty and the target index count never below one triangle. SelectLod thresholds.
+//
+struct SourceMesh
+{
+	std::vector<float> Data;
+	uint32_t Count;
+	uint32_t Stride;						// In floats
+
+	const float *Position(uint32_t Index) const
+	{
+		return &Data[Index * Stride];
+	}
+};
+
+SourceMesh MakeMesh(std::mt19937& Rng, uint32_t Count, uint32_t StrideBytes, const float (&Center)[3], const float (&Extent)[3])
+{
+	SourceMesh mesh;
+	mesh.Count = Count;
+	mesh.Stride = StrideBytes / sizeof(float);
+	mesh.Data.resize(Count * mesh.Stride);
+
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		float *vertex = &mesh.Data[i * mesh.Stride];
+
+		for (uint32_t axis = 0; axis < 3; axis++)
+			vertex[axis] = Center[axis] + unit(Rng) * Extent[axis];
+
+		// Normals/UVs/etc. after the position must not leak into the result
+		for (uint32_t j = 3; j < mesh.Stride; j++)
+			vertex[j] = 1e30f;
+	}
+
+	return mesh;
+}
+
+void CheckRoundTrip(const char *Name, const SourceMesh& Mesh)
+{
+	float scale[3];
+	float offset[3];
+	uint16_t *quantized = MOC_MeshBuild::QuantizeVerts(Mesh.Data.data(), Mesh.Count, Mesh.Stride * sizeof(float), scale, offset);
+
+	float mins[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxs[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (uint32_t i = 0; i < Mesh.Count; i++)
+	{
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			mins[axis] = fminf(mins[axis], Mesh.Position(i)[axis]);
+			maxs[axis] = fmaxf(maxs[axis], Mesh.Position(i)[axis]);
+		}
+	}
+
+	// (x, y, 0, z) layout
+	const uint32_t lanes[3] = { 0, 1, 3 };
+	const int failuresBefore = g_TestFailures;
+
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		const float extent = maxs[axis] - mins[axis];
+
+		// Half a step, plus float rounding in the subtraction and the decode at this distance from the origin
+		const float tolerance = (extent / 131070.0f) * 1.001f + 4.0f * FLT_EPSILON * fmaxf(fabsf(mins[axis]), fabsf(maxs[axis]));
+		uint32_t lowest = 0xFFFF;
+		uint32_t highest = 0;
+
+		TEST_CHECK_MSG(offset[axis] == mins[axis], "%s axis %u: offset %f, min %f", Name, axis, offset[axis], mins[axis]);
+
+		if (extent == 0.0f)
+			TEST_CHECK_MSG(scale[axis] == 0.0f, "%s axis %u: %g", Name, axis, scale[axis]);
+
+		for (uint32_t i = 0; i < Mesh.Count; i++)
+		{
+			const uint16_t q = quantized[i * 4 + lanes[axis]];
+			const float source = Mesh.Position(i)[axis];
+			const float decoded = offset[axis] + q * scale[axis];
+
+			lowest = std::min<uint32_t>(lowest, q);
+			highest = std::max<uint32_t>(highest, q);
+
+			TEST_CHECK_MSG(fabsf(decoded - source) <= tolerance, "%s axis %u vertex %u: %f vs %f (%g allowed)", Name, axis, i, decoded, source, tolerance);
+			TEST_CHECK_MSG(decoded >= mins[axis] - tolerance && decoded <= maxs[axis] + tolerance, "%s axis %u vertex %u: %f outside [%f, %f]", Name, axis, i, decoded, mins[axis], maxs[axis]);
+
+			if (extent == 0.0f)
+				TEST_CHECK_MSG(q == 0 && decoded == source, "%s axis %u vertex %u: %u", Name, axis, i, q);
+
+			if (g_TestFailures - failuresBefore > 16)
+				break;
+		}
+
+		// The whole 16-bit range is used
+		if (extent > 0.0f)
+			TEST_CHECK_MSG(lowest == 0 && highest == 0xFFFF, "%s axis %u: %u-%u", Name, axis, lowest, highest);
+	}
+
+	// MOC ignores the third lane, but it's documented to be 0
+	for (uint32_t i = 0; i < Mesh.Count; i++)
+		TEST_CHECK_MSG(quantized[i * 4 + 2] == 0, "%s vertex %u", Name, i);
+
+	delete[] quantized;
+}
+
+using namespace MOC_MeshBuild;
+
+size_t g_MinTargetIndices;
+
+// Keeps the first TargetIndexCount indices, like a simplifier that always hits its target
+size_t TruncateSimplify(uint32_t *Destination, const uint32_t *Indices, size_t IndexCount, const float *, size_t, size_t, size_t TargetIndexCount, float)
+{
+	g_MinTargetIndices = std::min(g_MinTargetIndices, TargetIndexCount);
+
+	const size_t count = std::min(IndexCount, TargetIndexCount - (TargetIndexCount % 3));
+	std::copy(Indices, Indices + count, Destination);
+	return count;
+}
+
+// Collapses everything at any error limit
+size_t EmptySimplify(uint32_t *, const uint32_t *, size_t, const float *, size_t, size_t, size_t TargetIndexCount, float)
+{
+	g_MinTargetIndices = std::min(g_MinTargetIndices, TargetIndexCount);
+	return 0;
+}
+
+// Can't remove anything without going over the error limit
+size_t StuckSimplify(uint32_t *Destination, const uint32_t *Indices, size_t IndexCount, const float *, size_t, size_t, size_t TargetIndexCount, float)
+{
+	g_MinTargetIndices = std::min(g_MinTargetIndices, TargetIndexCount);
+
+	std::copy(Indices, Indices + IndexCount, Destination);
+	return IndexCount;
+}
+
+void CheckLods(const char *Name, SimplifyFunc Simplify, uint32_t TriangleCount, uint32_t Budget)
+{
+	std::mt19937 rng(TriangleCount);
+	const uint32_t vertexCount = std::max(TriangleCount, 3u);
+	const uint32_t indexCount = TriangleCount * 3;
+
+	std::vector<float> vertices(vertexCount * 4, 0.0f);
+	std::vector<uint16_t> indices(indexCount);
+
+	for (uint16_t& index : indices)
+		index = (uint16_t)(rng() % vertexCount);
+
+	uint32_t offsets[MaxLods + 1];
+	uint32_t lodCount = 0;
+
+	g_MinTargetIndices = SIZE_MAX;
+	uint16_t *lods = BuildLods(indices.data(), indexCount, vertices.data(), vertexCount, 16, Budget, Simplify, offsets, &lodCount);
+
+	TEST_CHECK_MSG(lodCount >= 1 && lodCount <= MaxLods, "%s: %u LODs", Name, lodCount);
+	TEST_CHECK_MSG(offsets[0] == 0, "%s: %u", Name, offsets[0]);
+
+	if (g_MinTargetIndices != SIZE_MAX)
+		TEST_CHECK_MSG(g_MinTargetIndices >= 3, "%s: asked for %zu indices", Name, g_MinTargetIndices);
+
+	for (uint32_t lod = 0; lod < lodCount && lod <= MaxLods; lod++)
+	{
+		const uint32_t count = offsets[lod + 1] - offsets[lod];
+
+		TEST_CHECK_MSG(offsets[lod + 1] >= offsets[lod] && count % 3 == 0, "%s LOD %u: [%u, %u)", Name, lod, offsets[lod], offsets[lod + 1]);
+
+		if (TriangleCount > 0)
+			TEST_CHECK_MSG(count >= 3, "%s: LOD %u is empty", Name, lod);
+
+		if (lod > 0)
+			TEST_CHECK_MSG(count < offsets[lod] - offsets[lod - 1], "%s LOD %u: %u indices after %u", Name, lod, count, offsets[lod] - offsets[lod - 1]);
+
+		for (uint32_t i = offsets[lod]; i < offsets[lod + 1]; i++)
+			TEST_CHECK_MSG(lods[i] < vertexCount, "%s LOD %u index %u: %u", Name, lod, i, lods[i]);
+	}
+
+	// LOD 0 is the whole mesh when it fits the budget or simplifying would leave too little, otherwise the budget
+	const uint32_t lod0 = offsets[1] - offsets[0];
+	const bool fallback = memcmp(lods, indices.data(), std::min(lod0, indexCount) * sizeof(uint16_t)) == 0 && lod0 == indexCount;
+
+	if (TriangleCount <= Budget || Simplify == &EmptySimplify)
+		TEST_CHECK_MSG(fallback, "%s: LOD 0 has %u of %u indices", Name, lod0, indexCount);
+	else
+		TEST_CHECK_MSG(fallback || (lod0 / 3 <= Budget && lod0 / 3 >= LodMinTriangles), "%s: LOD 0 has %u indices, budget %u triangles", Name, lod0, Budget);
+
+	delete[] lods;
+}
+
+void TestBuildLods()
+{
+	CheckLods("within budget", &TruncateSimplify, 500, 1024);
+	CheckLods("chain", &TruncateSimplify, 5000, 1024);
+	CheckLods("budget of 1", &TruncateSimplify, 5000, 1);
+	CheckLods("budget under the minimum", &TruncateSimplify, 5000, LodMinTriangles - 1);
+	CheckLods("single triangle", &TruncateSimplify, 1, 1);
+	CheckLods("collapses", &EmptySimplify, 5000, 1024);
+	CheckLods("collapses, small mesh", &EmptySimplify, 40, 8);
+	CheckLods("stuck", &StuckSimplify, 5000, 1024);
+
+	// A stray pair of indices gives a budget of 0 triangles, which still has to ask for at least one
+	uint32_t offsets[MaxLods + 1];
+	uint32_t lodCount = 0;
+	const uint16_t stray[] = { 0, 1 };
+	const float strayVertices[8] = {};
+
+	g_MinTargetIndices = SIZE_MAX;
+	delete[] BuildLods(stray, 2, strayVertices, 2, 16, 1024, &TruncateSimplify, offsets, &lodCount);
+
+	TEST_CHECK_MSG(g_MinTargetIndices >= 3 && g_MinTargetIndices != SIZE_MAX, "%zu", g_MinTargetIndices);
+
+	// A chain that stops on its own: each level asks for a quarter of the last one until LodMinTriangles
+	std::vector<uint16_t> indices(3000 * 3);
+	std::vector<float> vertices(3 * 4, 0.0f);
+
+	for (size_t i = 0; i < indices.size(); i++)
+		indices[i] = (uint16_t)(i % 3);
+
+	delete[] BuildLods(indices.data(), (uint32_t)indices.size(), vertices.data(), 3, 16, 1024, &TruncateSimplify, offsets, &lodCount);
+
+	const uint32_t expected[] = { 1024, 256, 64, 16 };
+	TEST_CHECK_MSG(lodCount == MaxLods, "%u", lodCount);
+
+	for (uint32_t lod = 0; lod < lodCount && lod < MaxLods; lod++)
+		TEST_CHECK_MSG(offsets[lod + 1] - offsets[lod] == expected[lod] * 3, "LOD %u: %u indices", lod, offsets[lod + 1] - offsets[lod]);
+}
+
+void TestSelectLod()
+{
+	// Half the screen height and up is full detail, then one level per halving
+	TEST_CHECK(SelectLod(2.0f, MaxLods) == 0);
+	TEST_CHECK(SelectLod(0.5f, MaxLods) == 0);
+	TEST_CHECK(SelectLod(0.49f, MaxLods) == 1);
+	TEST_CHECK(SelectLod(0.25f, MaxLods) == 1);
+	TEST_CHECK(SelectLod(0.24f, MaxLods) == 2);
+	TEST_CHECK(SelectLod(0.125f, MaxLods) == 2);
+	TEST_CHECK(SelectLod(0.1f, MaxLods) == 3);
+	TEST_CHECK(SelectLod(0.0f, MaxLods) == MaxLods - 1);
+
+	// Never past the last LOD the mesh has
+	for (uint32_t lodCount = 1; lodCount <= MaxLods; lodCount++)
+	{
+		uint32_t previous = lodCount - 1;
+
+		for (float size = 0.0f; size < 1.0f; size += 0.001f)
+		{
+			const uint32_t lod = SelectLod(size, lodCount);
+
+			TEST_CHECK_MSG(lod < lodCount, "%.3f with %u LODs: %u", size, lodCount, lod);
+			TEST_CHECK_MSG(lod <= previous, "%.3f with %u LODs: %u after %u", size, lodCount, lod, previous);
+			previous = lod;
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(42);
+
+	const struct
+	{
+		const char *Name;
+		uint32_t Count;
+		uint32_t StrideBytes;
+		float Center[3];
+		float Extent[3];
+	} cases[] =
+	{
+		{ "small", 100, 16, { 0.0f, 0.0f, 0.0f }, { 1.0f, 2.0f, 0.5f } },
+		{ "building", 5000, 28, { 120.0f, -300.0f, 40.0f }, { 800.0f, 600.0f, 1200.0f } },
+		{ "landscape", 4225, 32, { 0.0f, 0.0f, 0.0f }, { 4096.0f, 4096.0f, 200.0f } },
+		{ "far from origin", 2000, 36, { 150000.0f, -200000.0f, 5000.0f }, { 500.0f, 500.0f, 300.0f } },
+		{ "flat", 500, 20, { 10.0f, 20.0f, 30.0f }, { 100.0f, 100.0f, 0.0f } },
+		{ "single vertex", 1, 16, { 5.0f, 6.0f, 7.0f }, { 0.0f, 0.0f, 0.0f } },
+	};
+
+	for (const auto& c : cases)
+	{
+		SourceMesh mesh = MakeMesh(rng, c.Count, c.StrideBytes, c.Center, c.Extent);
+
+		// Always hit the exact corners of the box so the step size is known
+		if (c.Count > 2)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				mesh.Data[0 * mesh.Stride + axis] = c.Center[axis] - c.Extent[axis];
+				mesh.Data[1 * mesh.Stride + axis] = c.Center[axis] + c.Extent[axis];
+			}
+		}
+
+		CheckRoundTrip(c.Name, mesh);
+	}
+
+	TestBuildLods();
+	TestSelectLod();
+
+	return TestResult("mesh_build_test");
+}
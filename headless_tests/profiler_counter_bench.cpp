@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "profiler.h"
+
+//
+// Cost of one ProfileCounterInc(), ProfileTimer() and ProfileTimerHistogram() scope with 1 to 32 threads hitting the same counter, against
+// a single interlocked add on one shared cache line (what every counter did before they were sharded per thread).
+// Also checks that the sharded totals are exact.
+//
+//   profiler_counter_bench [increments per thread]
+//
+using BenchClock = std::chrono::steady_clock;
+
+alignas(64) std::atomic<int64_t> SharedCounter;
+
+template<typename Func>
+double NsPerOp(uint32_t Threads, uint32_t PerThread, Func&& Op)
+{
+	std::atomic<uint32_t> started = 0;
+	std::vector<std::thread> threads;
+
+	for (uint32_t t = 0; t < Threads; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			started++;
+			while (started != Threads)
+				std::this_thread::yield();
+
+			for (uint32_t i = 0; i < PerThread; i++)
+				Op();
+		});
+	}
+
+	const auto start = BenchClock::now();
+
+	for (auto& thread : threads)
+		thread.join();
+
+	// Per operation per busy core. A row that doesn't grow with the thread count means no contention, and
+	// oversubscribed runs aren't penalized for time slicing.
+	const uint32_t cores = std::min(Threads, std::max(std::thread::hardware_concurrency(), 1u));
+	const double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+	return (ns * cores) / ((double)Threads * PerThread);
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t perThread = (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1 << 22;
+	bool exact = true;
+
+	Profiler::Clock::Initialize();
+
+	printf("%u increments per thread, %u hardware threads, ns per operation per core\n", perThread, std::thread::hardware_concurrency());
+	printf("%-8s %14s %14s %14s %14s\n", "threads", "interlocked", "sharded", "timer", "histogram");
+
+	for (uint32_t threads = 1; threads <= 32; threads *= 2)
+	{
+		const int64_t before = ProfilePeekValue("Bench Counter");
+
+		double interlocked = NsPerOp(threads, perThread, []() { SharedCounter.fetch_add(1); });
+		double sharded = NsPerOp(threads, perThread, []() { ProfileCounterInc("Bench Counter"); });
+		double timer = NsPerOp(threads, perThread, []() { ProfileTimer("Bench Timer"); });
+		double histogram = NsPerOp(threads, perThread, []() { ProfileTimerHistogram("Bench Histogram"); });
+
+		const int64_t counted = ProfilePeekValue("Bench Counter") - before;
+
+		printf("%-8u %14.2f %14.2f %14.2f %14.2f\n", threads, interlocked, sharded, timer, histogram);
+
+		if (counted != (int64_t)threads * perThread)
+		{
+			printf("  sharded total is %lld, expected %lld\n", (long long)counted, (long long)threads * perThread);
+			exact = false;
+		}
+	}
+
+	return exact ? 0 : 1;
+}
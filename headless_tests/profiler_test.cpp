@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include "test_common.h"
+#include "profiler.h"
+
+//
+// Profiler counters, timers and LatencyHistogram under concurrency: first use of a scope from many threads at once
+// (entry setup and histogram attachment), exact merged totals across per-thread shards, and writers beyond
+// LatencyHistogram::MaxWriters.
+//
+using Profiler::LatencyHistogram;
+
+// Releases every thread at the same time so they all hit first-use paths together
+template<typename Func>
+void RunTogether(uint32_t Threads, Func&& Body)
+{
+	std::atomic<uint32_t> started = 0;
+	std::vector<std::thread> threads;
+
+	for (uint32_t t = 0; t < Threads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			started++;
+			while (started != Threads)
+				std::this_thread::yield();
+
+			Body(t);
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void TestHistogramMerge()
+{
+	constexpr uint32_t threadCount = 8;
+	constexpr uint32_t perThread = 50000;
+
+	static LatencyHistogram histogram;
+	std::vector<uint64_t> values[threadCount];
+
+	for (uint32_t t = 0; t < threadCount; t++)
+	{
+		std::mt19937_64 rng(t);
+
+		for (uint32_t i = 0; i < perThread; i++)
+			values[t].push_back(rng() % 1000000);
+	}
+
+	RunTogether(threadCount, [&](uint32_t Thread)
+	{
+		for (uint64_t value : values[Thread])
+			histogram.Record(value);
+	});
+
+	std::vector<uint64_t> all;
+
+	for (auto& v : values)
+		all.insert(all.end(), v.begin(), v.end());
+
+	std::sort(all.begin(), all.end());
+
+	auto window = histogram.ConsumeWindow();
+	TEST_CHECK_MSG(window.Count == all.size(), "%llu", (unsigned long long)window.Count);
+	TEST_CHECK_MSG(window.Max == all.back(), "%llu", (unsigned long long)window.Max);
+
+	// Reported percentiles are bucket upper bounds, at most ~3% above the exact value
+	auto checkRank = [&](uint64_t Reported, uint32_t Percent)
+	{
+		const uint64_t exact = all[(all.size() * Percent + 99) / 100 - 1];
+		TEST_CHECK_MSG(Reported >= exact && Reported <= exact + exact / 32 + 1, "p%u: %llu vs %llu", Percent, (unsigned long long)Reported, (unsigned long long)exact);
+	};
+
+	checkRank(window.P50, 50);
+	checkRank(window.P95, 95);
+	checkRank(window.P99, 99);
+
+	// Nothing new since the last window
+	window = histogram.ConsumeWindow();
+	TEST_CHECK(window.Count == 0 && window.Max == 0);
+
+	histogram.Record(7);
+	window = histogram.ConsumeWindow();
+	TEST_CHECK(window.Count == 1 && window.P50 == 7 && window.Max == 7);
+}
+
+void TestHistogramSharedShard()
+{
+	// Every new thread takes a new writer index, so this walks past MaxWriters into the interlocked shared shard
+	constexpr uint32_t threadCount = LatencyHistogram::MaxWriters + 16;
+	static LatencyHistogram histogram;
+
+	for (uint32_t t = 0; t < threadCount; t++)
+	{
+		std::thread([t]()
+		{
+			for (uint32_t i = 0; i < 100; i++)
+				histogram.Record(t);
+		}).join();
+	}
+
+	auto window = histogram.ConsumeWindow();
+	TEST_CHECK_MSG(window.Count == threadCount * 100ull, "%llu", (unsigned long long)window.Count);
+	TEST_CHECK(window.Max == threadCount - 1);
+}
+
+void TestFirstUseRace()
+{
+	constexpr uint32_t threadCount = 16;
+	constexpr uint32_t perThread = 2000;
+
+	RunTogether(threadCount, [](uint32_t)
+	{
+		for (uint32_t i = 0; i < perThread; i++)
+		{
+			ProfileCounterInc("Test FirstUse Counter");
+			ProfileTimerHistogram("Test FirstUse Timer");
+		}
+	});
+
+	TEST_CHECK(ProfilePeekValue("Test FirstUse Counter") == threadCount * perThread);
+
+	// An entry reset by a late initializer would have dropped its histogram along with the samples in it
+	auto percentiles = ProfileGetPercentiles("Test FirstUse Timer");
+	TEST_CHECK_MSG(percentiles.Count == threadCount * perThread, "%llu", (unsigned long long)percentiles.Count);
+
+	// Registered exactly once, with its name
+	Profiler::TimerTotal totals[Profiler::Internal::MaxTimers];
+	const uint32_t count = ProfileGetTimerTotals(totals, Profiler::Internal::MaxTimers);
+	uint32_t matches = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (totals[i].Name && strcmp(totals[i].Name, "Test FirstUse Timer") == 0)
+			matches++;
+	}
+
+	TEST_CHECK(matches == 1);
+}
+
+int main()
+{
+	Profiler::Clock::Initialize();
+
+	TestHistogramMerge();
+	TestFirstUseRace();
+	TestHistogramSharedShard();
+
+	return TestResult("profiler_test");
+}
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "BSTSwissScatterTable.h"
+
+//
+// Lookup (hit and miss), insert and erase cost of BSTSwissScatterTable vs std::unordered_map at a fixed capacity and
+// several load factors. Both tables are pre-sized so nothing rehashes while timing.
+//
+//   swiss_table_bench [capacity]
+//
+using BenchClock = std::chrono::steady_clock;
+
+volatile uint64_t g_Sink;
+
+template<typename Func>
+double NsPerOp(size_t Count, Func Callback)
+{
+	// Best of 3 to filter out scheduler noise
+	double best = 1e30;
+
+	for (int run = 0; run < 3; run++)
+	{
+		const auto start = BenchClock::now();
+		Callback();
+		const double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / Count;
+
+		if (ns < best)
+			best = ns;
+	}
+
+	return best;
+}
+
+struct Result
+{
+	double Insert;
+	double Hit;
+	double Miss;
+	double Erase;
+};
+
+Result BenchSwiss(uint32_t Capacity, const std::vector<uint32_t>& Keys, const std::vector<uint32_t>& Missing)
+{
+	Result result;
+	BSTSwissScatterTable<uint32_t, uint64_t> map;
+
+	result.Insert = NsPerOp(Keys.size(), [&]()
+	{
+		map.clear();
+		map.reserve(Capacity - Capacity / 8);
+
+		for (uint32_t key : Keys)
+			map.insert(key, key);
+	});
+
+	result.Hit = NsPerOp(Keys.size(), [&]()
+	{
+		uint64_t sum = 0;
+
+		for (uint32_t key : Keys)
+			sum += *map.lookup(key);
+
+		g_Sink = sum;
+	});
+
+	result.Miss = NsPerOp(Missing.size(), [&]()
+	{
+		uint64_t found = 0;
+
+		for (uint32_t key : Missing)
+			found += map.contains(key);
+
+		g_Sink = found;
+	});
+
+	result.Erase = NsPerOp(Keys.size(), [&]()
+	{
+		for (uint32_t key : Keys)
+			map.erase(key);
+
+		// Every run has to start from the full table, so the reinsert is timed too
+		for (uint32_t key : Keys)
+			map.insert(key, key);
+	});
+
+	return result;
+}
+
+Result BenchStd(uint32_t Capacity, const std::vector<uint32_t>& Keys, const std::vector<uint32_t>& Missing)
+{
+	Result result;
+	std::unordered_map<uint32_t, uint64_t> map;
+
+	result.Insert = NsPerOp(Keys.size(), [&]()
+	{
+		map.clear();
+		map.reserve(Capacity);
+
+		for (uint32_t key : Keys)
+			map.emplace(key, key);
+	});
+
+	result.Hit = NsPerOp(Keys.size(), [&]()
+	{
+		uint64_t sum = 0;
+
+		for (uint32_t key : Keys)
+			sum += map.find(key)->second;
+
+		g_Sink = sum;
+	});
+
+	result.Miss = NsPerOp(Missing.size(), [&]()
+	{
+		uint64_t found = 0;
+
+		for (uint32_t key : Missing)
+			found += map.count(key);
+
+		g_Sink = found;
+	});
+
+	result.Erase = NsPerOp(Keys.size(), [&]()
+	{
+		for (uint32_t key : Keys)
+			map.erase(key);
+
+		for (uint32_t key : Keys)
+			map.emplace(key, key);
+	});
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t capacity = (argc > 1) ? (uint32_t)atoi(argv[1]) : (1u << 20);
+	const double loadFactors[] = { 0.25, 0.5, 0.75, 0.875 };
+
+	printf("Capacity %u, ns per operation (erase includes reinserting the key)\n\n", capacity);
+	printf("%-6s %-20s %9s %9s %9s %9s\n", "Load", "Table", "Insert", "Hit", "Miss", "Erase");
+
+	for (double loadFactor : loadFactors)
+	{
+		const uint32_t count = (uint32_t)(capacity * loadFactor);
+
+		// Form ID-like keys: random plugin index in the top byte, shuffled base IDs below
+		std::mt19937 rng(42);
+		std::vector<uint32_t> keys(count);
+		std::vector<uint32_t> missing(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			keys[i] = ((rng() % 64) << 24) | (i * 2);
+			missing[i] = keys[i] | 1;
+		}
+
+		std::shuffle(keys.begin(), keys.end(), rng);
+
+		const Result swiss = BenchSwiss(capacity, keys, missing);
+		const Result stl = BenchStd(capacity, keys, missing);
+
+		printf("%-6.3f %-20s %9.2f %9.2f %9.2f %9.2f\n", loadFactor, "BSTSwissScatterTable", swiss.Insert, swiss.Hit, swiss.Miss, swiss.Erase);
+		printf("%-6.3f %-20s %9.2f %9.2f %9.2f %9.2f\n", loadFactor, "std::unordered_map", stl.Insert, stl.Hit, stl.Miss, stl.Erase);
+	}
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+#include <string>
+#include <random>
+#include <unordered_map>
+#include "test_common.h"
+#include "BSTSwissScatterTable.h"
+
+//
+// Differential test of BSTSwissScatterTable against std::unordered_map, plus the cases a random workload rarely hits:
+// long probe chains, tombstone reuse and in-place rehashes.
+//
+template<typename Key>
+struct CollidingHashPolicy
+{
+	size_t operator()(const Key& Value) const
+	{
+		// Every key lands in the same group with the same tag
+		return 0;
+	}
+};
+
+struct Tracked
+{
+	inline static int64_t Live;
+
+	std::string Text;
+
+	Tracked(const char *Value = "") : Text(Value) { Live++; }
+	Tracked(const Tracked& Other) : Text(Other.Text) { Live++; }
+	Tracked(Tracked&& Other) : Text(std::move(Other.Text)) { Live++; }
+	~Tracked() { Live--; }
+
+	Tracked& operator=(const Tracked& Other) = default;
+	Tracked& operator=(Tracked&& Other) = default;
+};
+
+template<typename Table>
+bool MatchesReference(const Table& Map, const std::unordered_map<uint32_t, uint64_t>& Reference)
+{
+	if (Map.size() != Reference.size())
+		return false;
+
+	uint32_t visited = 0;
+
+	for (auto itr = Map.begin(); itr != Map.end(); ++itr)
+	{
+		auto ref = Reference.find(itr.key());
+
+		if (ref == Reference.end() || ref->second != *itr)
+			return false;
+
+		visited++;
+	}
+
+	return visited == Reference.size();
+}
+
+void TestRandomOperations()
+{
+	BSTSwissScatterTable<uint32_t, uint64_t> map;
+	std::unordered_map<uint32_t, uint64_t> reference;
+	std::mt19937 rng(1234);
+
+	for (uint32_t i = 0; i < 2000000; i++)
+	{
+		const uint32_t key = rng() % 50000;
+		const uint64_t value = rng();
+
+		switch (rng() % 5)
+		{
+		case 0:
+			TEST_CHECK(map.insert(key, value) == reference.emplace(key, value).second);
+			break;
+
+		case 1:
+		{
+			const bool created = reference.find(key) == reference.end();
+			reference[key] = value;
+			TEST_CHECK(map.insert_or_assign(key, value) == created);
+			break;
+		}
+
+		case 2:
+			TEST_CHECK(map.erase(key) == (reference.erase(key) != 0));
+			break;
+
+		default:
+		{
+			const uint64_t *found = map.lookup(key);
+			auto ref = reference.find(key);
+
+			TEST_CHECK((found != nullptr) == (ref != reference.end()));
+			TEST_CHECK(!found || *found == ref->second);
+			TEST_CHECK(map.contains(key) == (found != nullptr));
+			break;
+		}
+		}
+
+		TEST_CHECK(map.size() == reference.size());
+
+		if (g_TestFailures > 0)
+			return;
+	}
+
+	TEST_CHECK(MatchesReference(map, reference));
+	TEST_CHECK(map.size() <= map.capacity() - map.capacity() / 8);
+}
+
+void TestCollisions()
+{
+	// All keys share one probe sequence, so lookups have to walk past full groups and tombstones
+	BSTSwissScatterTable<uint32_t, uint64_t, CollidingHashPolicy<uint32_t>> map;
+	std::unordered_map<uint32_t, uint64_t> reference;
+
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		TEST_CHECK(map.insert(i, i * 3));
+		reference[i] = i * 3;
+	}
+
+	for (uint32_t i = 0; i < 200; i += 3)
+	{
+		TEST_CHECK(map.erase(i));
+		reference.erase(i);
+	}
+
+	TEST_CHECK(MatchesReference(map, reference));
+
+	for (uint32_t i = 0; i < 200; i++)
+		TEST_CHECK(map.contains(i) == (i % 3 != 0));
+
+	// Reinserting erased keys reuses tombstones and must not duplicate survivors
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		TEST_CHECK(map.insert(i, i * 5) == (i % 3 == 0));
+		reference.emplace(i, i * 5);
+	}
+
+	TEST_CHECK(MatchesReference(map, reference));
+}
+
+void TestTombstoneChurn()
+{
+	// Constant size with a sliding key window. Tombstones pile up and have to be reclaimed by same-size rehashes
+	// instead of growing the table forever. A table above 7/16 load may double once before that kicks in.
+	BSTSwissScatterTable<uint32_t, uint64_t> map;
+	map.reserve(1000);
+
+	const uint32_t capacity = map.capacity();
+
+	for (uint32_t i = 0; i < 1000; i++)
+		map.insert(i, i);
+
+	for (uint32_t i = 1000; i < 1000000; i++)
+	{
+		TEST_CHECK(map.erase(i - 1000));
+		TEST_CHECK(map.insert(i, i));
+		TEST_CHECK(map.capacity() <= capacity * 2);
+
+		if (g_TestFailures > 0)
+			return;
+	}
+
+	TEST_CHECK(map.size() == 1000);
+
+	for (uint32_t i = 999000; i < 1000000; i++)
+		TEST_CHECK(map.get(i) == i);
+}
+
+void TestNonTrivialValues()
+{
+	{
+		BSTSwissScatterTable<uint32_t, Tracked> map;
+
+		for (uint32_t i = 0; i < 5000; i++)
+			map.insert(i, Tracked(std::to_string(i).c_str()));
+
+		for (uint32_t i = 0; i < 5000; i += 2)
+			map.erase(i);
+
+		Tracked out;
+		TEST_CHECK(map.erase(1, out) && out.Text == "1");
+		TEST_CHECK(map.lookup(4999) && map.lookup(4999)->Text == "4999");
+		TEST_CHECK(Tracked::Live == (int64_t)map.size() + 1);
+
+		map.clear();
+		TEST_CHECK(map.empty());
+		TEST_CHECK(Tracked::Live == 1);
+
+		map.insert(7, Tracked("seven"));
+	}
+
+	// Destructor releases whatever is left
+	TEST_CHECK(Tracked::Live == 0);
+}
+
+void TestReserve()
+{
+	BSTSwissScatterTable<uint32_t, uint32_t> map;
+
+	TEST_CHECK(!map.contains(0));
+	TEST_CHECK(map.find(0) == map.end());
+	TEST_CHECK(map.begin() == map.end());
+
+	map.reserve(10000);
+	const uint32_t capacity = map.capacity();
+
+	TEST_CHECK(capacity >= 10000 + 10000 / 7);
+	TEST_CHECK((capacity & (capacity - 1)) == 0);
+
+	for (uint32_t i = 0; i < 10000; i++)
+		map.insert(i * 7919, i);
+
+	// No rehash while filling up to the reserved count
+	TEST_CHECK(map.capacity() == capacity);
+
+	uint32_t sum = 0;
+	map.for_each([&](uint32_t, uint32_t& Value) { sum += Value; });
+	TEST_CHECK(sum == 10000u * 9999u / 2);
+}
+
+int main()
+{
+	TestRandomOperations();
+	TestCollisions();
+	TestTombstoneChurn();
+	TestNonTrivialValues();
+	TestReserve();
+
+	return TestResult("swiss_table_test");
+}
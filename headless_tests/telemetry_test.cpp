@@ -0,0 +1,265 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test_common.h"
+#include "profiler_telemetry.h"
+
+//
+// FrameTelemetry and FrameTelemetryLog: Read() racing a writer that laps the ring must only return whole frames in
+// order, Summarize() on a distribution with known lows, and CSV parts rolling over with the oldest deleted past
+// MaxParts.
+//
+using namespace Profiler;
+
+// Every field is derived from the frame number, so a torn copy doesn't match
+FrameSample MakeSample(uint64_t Frame)
+{
+	FrameSample sample = {};
+	sample.FrameTimeMs = (float)(Frame & 0xFFFF);
+	sample.GpuTimeMs = (float)((Frame >> 16) & 0xFFFF);
+
+	for (int64_t& counter : sample.Counters)
+		counter = (int64_t)(Frame * 0x9E3779B97F4A7C15ull);
+
+	return sample;
+}
+
+bool IsWhole(const FrameSample& Sample)
+{
+	const FrameSample expected = MakeSample(Sample.Frame);
+
+	if (Sample.FrameTimeMs != expected.FrameTimeMs || Sample.GpuTimeMs != expected.GpuTimeMs)
+		return false;
+
+	for (uint32_t i = 0; i < MaxTelemetryCounters; i++)
+	{
+		if (Sample.Counters[i] != expected.Counters[i])
+			return false;
+	}
+
+	return true;
+}
+
+void TestConcurrentRead()
+{
+	auto telemetry = std::make_unique<FrameTelemetry>(nullptr, 0);
+	auto frames = std::make_unique<FrameSample[]>(FrameTelemetry::Capacity);
+
+	constexpr uint64_t frameCount = 20000000;
+	std::atomic_bool finished = false;
+
+	std::thread writer([&]()
+	{
+		for (uint64_t i = 0; i < frameCount; i++)
+			telemetry->Record(MakeSample(i));
+
+		finished = true;
+	});
+
+	uint64_t reads = 0;
+	uint64_t readFrames = 0;
+	uint64_t skippedAhead = 0;
+	const int failuresBefore = g_TestFailures;
+
+	// Keep reading until the writer is done, so reads overlap with writes even on a single core. The writer laps the
+	// ring constantly, so most reads start behind the oldest frame and a preempted one loses everything past it.
+	while (!finished && g_TestFailures - failuresBefore <= 16)
+	{
+		const uint64_t head = telemetry->GetHead();
+		uint64_t first = ((reads & 1) || head < FrameTelemetry::Capacity / 2) ? 0 : head - (FrameTelemetry::Capacity / 2);
+		const uint64_t requested = first;
+		const uint32_t count = telemetry->Read(first, frames.get(), FrameTelemetry::Capacity);
+
+		TEST_CHECK_MSG(first >= requested, "%llu < %llu", (unsigned long long)first, (unsigned long long)requested);
+		skippedAhead += (first > requested) ? 1 : 0;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			TEST_CHECK_MSG(frames[i].Frame == first + i, "read %llu: %llu at %u, expected %llu", (unsigned long long)reads,
+				(unsigned long long)frames[i].Frame, i, (unsigned long long)(first + i));
+			TEST_CHECK_MSG(IsWhole(frames[i]), "read %llu: frame %llu is torn", (unsigned long long)reads, (unsigned long long)frames[i].Frame);
+
+			if (g_TestFailures - failuresBefore > 16)
+				break;
+		}
+
+		reads++;
+		readFrames += count;
+	}
+
+	writer.join();
+
+	// Once the writer stops, everything but the oldest slot (the next one it would write) is still there
+	uint64_t first = 0;
+	const uint32_t count = telemetry->Read(first, frames.get(), FrameTelemetry::Capacity);
+
+	TEST_CHECK_MSG(count == FrameTelemetry::Capacity - 1 && first == frameCount - FrameTelemetry::Capacity + 1, "%u from %llu", count, (unsigned long long)first);
+	TEST_CHECK(frames[count - 1].Frame == frameCount - 1 && IsWhole(frames[count - 1]));
+
+	printf("%llu reads, %llu frames, %llu started behind the ring\n", (unsigned long long)reads, (unsigned long long)readFrames, (unsigned long long)skippedAhead);
+}
+
+void TestSummary()
+{
+	auto telemetry = std::make_unique<FrameTelemetry>(nullptr, 0);
+
+	TEST_CHECK(telemetry->Summarize(100).Count == 0);
+
+	// 990 frames at 10ms, 9 at 50ms and one at 100ms, shuffled
+	std::vector<float> frameTimes(990, 10.0f);
+	frameTimes.insert(frameTimes.end(), 9, 50.0f);
+	frameTimes.push_back(100.0f);
+
+	for (size_t i = 0; i < frameTimes.size(); i++)
+		std::swap(frameTimes[i], frameTimes[(i * 7919) % frameTimes.size()]);
+
+	for (float frameTime : frameTimes)
+	{
+		FrameSample sample = {};
+		sample.FrameTimeMs = frameTime;
+		telemetry->Record(sample);
+	}
+
+	const FrameTelemetry::Summary summary = telemetry->Summarize(1000);
+
+	// The slowest 1% are the 9 + 1 outliers: 10 frames in 550ms. The slowest 0.1% is the single 100ms frame.
+	const double mean = (990 * 10.0 + 9 * 50.0 + 100.0) / 1000.0;
+	double variance = 0.0;
+
+	for (float frameTime : frameTimes)
+		variance += (frameTime - mean) * (frameTime - mean);
+
+	const double stdev = sqrt(variance / 999.0);
+
+	TEST_CHECK_MSG(summary.Count == 1000, "%u", summary.Count);
+	TEST_CHECK_MSG(fabs(summary.MeanMs - mean) < 1e-9, "%f", summary.MeanMs);
+	TEST_CHECK_MSG(fabs(summary.StdevMs - stdev) < 1e-9, "%f vs %f", summary.StdevMs, stdev);
+	TEST_CHECK_MSG(summary.MaxMs == 100.0, "%f", summary.MaxMs);
+	TEST_CHECK_MSG(fabs(summary.MeanFps - 1000.0 / mean) < 1e-9, "%f", summary.MeanFps);
+	TEST_CHECK_MSG(fabs(summary.OnePercentLowFps - (1000.0 * 10 / 550.0)) < 1e-9, "%f", summary.OnePercentLowFps);
+	TEST_CHECK_MSG(fabs(summary.PointOnePercentLowFps - 10.0) < 1e-9, "%f", summary.PointOnePercentLowFps);
+
+	// Only the newest frames are summarized. Fewer than 100 still counts the single slowest one.
+	for (uint32_t i = 0; i < 50; i++)
+	{
+		FrameSample sample = {};
+		sample.FrameTimeMs = (i == 20) ? 40.0f : 20.0f;
+		telemetry->Record(sample);
+	}
+
+	const FrameTelemetry::Summary recent = telemetry->Summarize(50);
+
+	TEST_CHECK_MSG(recent.Count == 50 && recent.MaxMs == 40.0, "%u %f", recent.Count, recent.MaxMs);
+	TEST_CHECK_MSG(fabs(recent.OnePercentLowFps - 25.0) < 1e-9 && fabs(recent.PointOnePercentLowFps - 25.0) < 1e-9, "%f %f",
+		recent.OnePercentLowFps, recent.PointOnePercentLowFps);
+
+	// Asking for more than the ring has covers what's there
+	TEST_CHECK(telemetry->Summarize(FrameTelemetry::Capacity * 2).Count == 1050);
+}
+
+std::vector<std::string> ReadLines(const std::filesystem::path& Path)
+{
+	std::vector<std::string> lines;
+	FILE *f = fopen(Path.string().c_str(), "r");
+
+	if (!f)
+		return lines;
+
+	char line[1024];
+
+	while (fgets(line, sizeof(line), f))
+		lines.emplace_back(line);
+
+	fclose(f);
+	return lines;
+}
+
+void TestLogRollover()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "telemetry_test";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	const std::string basePath = (directory / "frames").string();
+	const char *counterNames[] = { "Draws", "Dispatches" };
+
+	constexpr uint64_t partBytes = 4096;
+	constexpr uint32_t maxParts = 3;
+	constexpr uint64_t frameCount = 2000;
+
+	auto telemetry = std::make_unique<FrameTelemetry>(counterNames, 2);
+
+	for (uint64_t i = 0; i < frameCount; i++)
+		telemetry->Record(MakeSample(i));
+
+	FrameTelemetryLog log(*telemetry, partBytes, maxParts);
+	TEST_CHECK(log.Start(basePath.c_str()));
+	log.Stop();
+
+	// Only the newest maxParts parts are left
+	uint32_t lastPart = 0;
+
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+	{
+		const std::string name = entry.path().filename().string();
+		lastPart = std::max<uint32_t>(lastPart, (uint32_t)strtoul(name.c_str() + strlen("frames_"), nullptr, 10));
+	}
+
+	TEST_CHECK_MSG(lastPart + 1 > maxParts, "%u parts", lastPart + 1);
+
+	uint64_t nextFrame = 0;
+	bool firstKept = true;
+
+	for (uint32_t part = 0; part <= lastPart; part++)
+	{
+		const std::filesystem::path path = basePath + "_" + std::to_string(part) + ".csv";
+		const bool kept = part + maxParts > lastPart;
+
+		TEST_CHECK_MSG(std::filesystem::exists(path) == kept, "part %u %s", part, kept ? "missing" : "not deleted");
+
+		if (!kept)
+			continue;
+
+		const std::vector<std::string> lines = ReadLines(path);
+		const uint64_t size = std::filesystem::file_size(path);
+
+		// Rolls over on the first line that reaches the limit
+		TEST_CHECK_MSG(size < partBytes + 256 && (part == lastPart || size >= partBytes), "part %u: %llu bytes", part, (unsigned long long)size);
+		TEST_CHECK_MSG(!lines.empty() && lines[0] == "Frame,FrameTimeMs,GpuTimeMs,CpuPercent,ThreadPercent,Gpu0Percent,Gpu1Percent,Draws,Dispatches\n",
+			"part %u: %s", part, lines.empty() ? "empty" : lines[0].c_str());
+
+		// Frames carry on from one part to the next without gaps
+		for (size_t i = 1; i < lines.size(); i++)
+		{
+			const uint64_t frame = strtoull(lines[i].c_str(), nullptr, 10);
+
+			if (firstKept)
+			{
+				nextFrame = frame;
+				firstKept = false;
+			}
+
+			TEST_CHECK_MSG(frame == nextFrame, "part %u line %zu: frame %llu, expected %llu", part, i, (unsigned long long)frame, (unsigned long long)nextFrame);
+			nextFrame = frame + 1;
+		}
+	}
+
+	TEST_CHECK_MSG(nextFrame == frameCount, "last frame %llu", (unsigned long long)nextFrame);
+
+	std::filesystem::remove_all(directory);
+}
+
+int main()
+{
+	TestConcurrentRead();
+	TestSummary();
+	TestLogRollover();
+
+	return TestResult("telemetry_test");
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+//
+// Minimal assertion helpers. Every test is a plain executable that returns nonzero when a check fails, so CTest is
+// the only dependency.
+//
+inline int g_TestFailures;
+
+#define TEST_CHECK(Cond) \
+	do \
+	{ \
+		if (!(Cond)) \
+		{ \
+			fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #Cond); \
+			g_TestFailures++; \
+		} \
+	} while (0)
+
+#define TEST_CHECK_MSG(Cond, Format, ...) \
+	do \
+	{ \
+		if (!(Cond)) \
+		{ \
+			fprintf(stderr, "%s(%d): check failed: %s (" Format ")\n", __FILE__, __LINE__, #Cond, __VA_ARGS__); \
+			g_TestFailures++; \
+		} \
+	} while (0)
+
+inline int TestResult(const char *Name)
+{
+	if (g_TestFailures > 0)
+	{
+		printf("%s: %d check(s) failed\n", Name, g_TestFailures);
+		return EXIT_FAILURE;
+	}
+
+	printf("%s: passed\n", Name);
+	return EXIT_SUCCESS;
+}
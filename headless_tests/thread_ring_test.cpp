@@ -0,0 +1,171 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include "test_common.h"
+#include "profiler_thread_ring.h"
+
+//
+// The per-thread event rings behind the zone and flight recorders: a reader copying rings while their owners keep
+// wrapping them must only ever see whole events in order, plus thread naming and the overflow ring past MaxThreads.
+//
+struct TestEvent
+{
+	uint64_t Sequence;
+	uint64_t Check;				// Derived from Sequence, so a torn copy doesn't match
+	uint64_t Padding[2];
+};
+
+constexpr uint64_t CheckOf(uint64_t Sequence)
+{
+	return ~Sequence * 0x9E3779B97F4A7C15ull;
+}
+
+using TestRings = Profiler::ThreadRingSet<TestEvent, 256, 8>;
+TestRings Rings;
+
+void TestConcurrentCopy()
+{
+	constexpr uint32_t writerCount = 4;
+	constexpr uint64_t perWriter = 2000000;
+
+	std::atomic_uint32_t attached = 0;
+	std::atomic_uint32_t finished = 0;
+	std::vector<std::thread> writers;
+
+	for (uint32_t t = 0; t < writerCount; t++)
+	{
+		writers.emplace_back([&]()
+		{
+			Rings.Record({ 0, CheckOf(0), {} });
+			attached++;
+
+			for (uint64_t i = 1; i < perWriter; i++)
+				Rings.Record({ i, CheckOf(i), {} });
+
+			finished++;
+		});
+	}
+
+	while (attached != writerCount)
+		std::this_thread::yield();
+
+	TestEvent events[256];
+	uint64_t copies = 0;
+	uint64_t copiedEvents = 0;
+
+	// Keep copying until every writer is done, so copies overlap with writes even on a single core
+	while (finished != writerCount)
+	{
+		for (uint32_t i = 0; i < Rings.GetThreadCount(); i++)
+		{
+			const TestRings::Buffer *buffer = Rings.GetThread(i);
+
+			if (!buffer)
+				continue;
+
+			const uint32_t count = TestRings::CopyEvents(buffer, events);
+			TEST_CHECK(count <= 256);
+
+			for (uint32_t j = 0; j < count; j++)
+			{
+				TEST_CHECK_MSG(events[j].Check == CheckOf(events[j].Sequence), "torn event %llu", (unsigned long long)events[j].Sequence);
+
+				if (j > 0)
+					TEST_CHECK_MSG(events[j].Sequence == events[j - 1].Sequence + 1, "%llu after %llu", (unsigned long long)events[j].Sequence, (unsigned long long)events[j - 1].Sequence);
+			}
+
+			copies++;
+			copiedEvents += count;
+		}
+	}
+
+	for (auto& writer : writers)
+		writer.join();
+
+	TEST_CHECK(copies > 0 && copiedEvents > 0);
+
+	// Quiet rings end with the last event each writer recorded. The oldest slot of a full ring is always dropped since
+	// the reader can't tell whether the owner was about to overwrite it.
+	for (uint32_t i = 0; i < Rings.GetThreadCount(); i++)
+	{
+		const TestRings::Buffer *buffer = Rings.GetThread(i);
+		const uint64_t head = buffer->Head.load();
+		const uint32_t count = TestRings::CopyEvents(buffer, events);
+
+		TEST_CHECK_MSG(count == std::min<uint64_t>(head, 255), "%u of %llu", count, (unsigned long long)head);
+		TEST_CHECK(count == 0 || events[count - 1].Sequence == head - 1);
+	}
+}
+
+void TestNamesAndOverflow()
+{
+	// The first four threads are still attached from the previous test
+	std::vector<std::thread> threads;
+
+	for (uint32_t t = 0; t < 8; t++)
+	{
+		std::thread([t]()
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "Test Thread %u with a name longer than the buffer", t);
+
+			// Naming attaches the thread before it records anything
+			Rings.SetThreadName(TestRings::CurrentThreadId(), name);
+			Rings.Record({ t, CheckOf(t), {} });
+		}).join();
+	}
+
+	TEST_CHECK(Rings.GetThreadCount() == 8);
+
+	for (uint32_t i = 4; i < 8; i++)
+	{
+		const TestRings::Buffer *buffer = Rings.GetThread(i);
+		char expected[64];
+		snprintf(expected, sizeof(expected), "Test Thread %u with a name longer than the buffer", i - 4);
+
+		// SetThreadName() keeps as much as fits
+		expected[sizeof(TestRings::Buffer::Name) - 1] = '\0';
+
+		TEST_CHECK_MSG(strcmp(buffer->Name, expected) == 0, "%s", buffer->Name);
+		TEST_CHECK(buffer->Head.load() == 1 && buffer->Events[0].Sequence == i - 4);
+	}
+}
+
+void TestCopySince()
+{
+	// Its own instantiation so the thread counts above aren't disturbed
+	using SmallRings = Profiler::ThreadRingSet<TestEvent, 256, 2>;
+	static SmallRings rings;
+
+	std::thread([]()
+	{
+		for (uint64_t i = 0; i < 1000; i++)
+			rings.Record({ i, CheckOf(i), {} });
+	}).join();
+
+	TestEvent events[256];
+	const SmallRings::Buffer *buffer = rings.GetThread(0);
+
+	for (uint64_t cutoff : { 0ull, 700ull, 744ull, 745ull, 900ull, 999ull, 1000ull })
+	{
+		const uint32_t count = SmallRings::CopyEventsSince(buffer, events, [cutoff](const TestEvent& Value)
+		{
+			return Value.Sequence < cutoff;
+		});
+
+		// Never more than CopyEvents() would return (745 is the oldest event it keeps)
+		const uint64_t expected = 1000 - std::max<uint64_t>(cutoff, 745);
+		TEST_CHECK_MSG(count == expected, "cutoff %llu: %u", (unsigned long long)cutoff, count);
+		TEST_CHECK(count == 0 || (events[0].Sequence == 1000 - count && events[count - 1].Sequence == 999));
+	}
+}
+
+int main()
+{
+	TestConcurrentCopy();
+	TestNamesAndOverflow();
+	TestCopySince();
+
+	return TestResult("thread_ring_test");
+}
@@ -0,0 +1,6 @@
+#include "batch_cull_kernels.h"
+
+BatchCullKernels GetBatchCullKernelsAVX2()
+{
+	return { "AVX2", &MOC_BatchCull::ProjectSpheresKernel<MOC_BatchCull::IsaAVX2>, &MOC_BatchCull::ProjectAABBsKernel<MOC_BatchCull::IsaAVX2> };
+}
@@ -0,0 +1,6 @@
+#include "batch_cull_kernels.h"
+
+BatchCullKernels GetBatchCullKernelsAVX512()
+{
+	return { "AVX-512", &MOC_BatchCull::ProjectSpheresKernel<MOC_BatchCull::IsaAVX512>, &MOC_BatchCull::ProjectAABBsKernel<MOC_BatchCull::IsaAVX512> };
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "MOC_BatchCullKernels.h"
+
+//
+// MOC_BatchCull projection kernels for every instruction set. Each one lives in its own file so it can be built with
+// matching compiler flags; only call the ones the CPU supports.
+//
+struct BatchCullKernels
+{
+	using ProjectSpheresFunc = void(*)(const MOC_BatchCull::Camera&, const float *, const float *, const float *, const float *, uint32_t, const MOC_BatchCull::Rects&, uint64_t *);
+	using ProjectAABBsFunc = void(*)(const MOC_BatchCull::Camera&, const float *, const float *, const float *, const float *, const float *, const float *, uint32_t, const MOC_BatchCull::Rects&, uint64_t *);
+
+	const char *Name;
+	ProjectSpheresFunc ProjectSpheres;
+	ProjectAABBsFunc ProjectAABBs;
+};
+
+BatchCullKernels GetBatchCullKernelsScalar();
+BatchCullKernels GetBatchCullKernelsSSE();
+BatchCullKernels GetBatchCullKernelsAVX2();
+BatchCullKernels GetBatchCullKernelsAVX512();
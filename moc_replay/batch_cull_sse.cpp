@@ -0,0 +1,11 @@
+#include "batch_cull_kernels.h"
+
+BatchCullKernels GetBatchCullKernelsScalar()
+{
+	return { "Scalar", &MOC_BatchCull::ProjectSpheresKernel<MOC_BatchCull::IsaScalar>, &MOC_BatchCull::ProjectAABBsKernel<MOC_BatchCull::IsaScalar> };
+}
+
+BatchCullKernels GetBatchCullKernelsSSE()
+{
+	return { "SSE2", &MOC_BatchCull::ProjectSpheresKernel<MOC_BatchCull::IsaSSE>, &MOC_BatchCull::ProjectAABBsKernel<MOC_BatchCull::IsaSSE> };
+}
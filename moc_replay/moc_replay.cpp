@@ -0,0 +1,465 @@
+//
+// Replays a MOC frame capture written by skyrim64_test (MOC_FrameCapture) and times occluder rasterization and
+// occludee queries for every MOC implementation the CPU supports, both single threaded and through
+// CullingThreadpool with varying thread counts. Version 2 captures also time the MOC_BatchCull projection kernels
+// over the captured occludee bounds. Version 3 captures hold the game's quantized meshes and are rasterized through
+// the same 16-bit path as the game.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <bitset>
+#include <math.h>
+#include <MaskedOcclusionCulling.h>
+#include <CullingThreadpool.h>
+#include "MOC_FrameCaptureFormat.h"
+#include "batch_cull_kernels.h"
+#include "profiler.h"
+
+struct CapturedDraw
+{
+	MOC_FrameCaptureFormat::Draw Header;
+	std::vector<float> Vertices;				// Version 1-2
+	std::vector<unsigned int> Indices;
+	std::vector<uint16_t> QuantizedVertices;	// Version 3+
+	std::vector<uint16_t> QuantizedIndices;
+};
+
+struct Capture
+{
+	MOC_FrameCaptureFormat::Header Header;
+	std::vector<CapturedDraw> Draws;
+	std::vector<MOC_FrameCaptureFormat::Query> Queries;
+	MOC_FrameCaptureFormat::BoundsHeader BoundsHeader;
+	std::vector<MOC_FrameCaptureFormat::Bounds> Bounds;
+	uint64_t TriangleCount;
+};
+
+bool ReadExact(FILE *File, void *Buffer, size_t Size)
+{
+	return Size == 0 || fread(Buffer, Size, 1, File) == 1;
+}
+
+bool LoadCapture(const char *FilePath, Capture& Out)
+{
+	FILE *f = fopen(FilePath, "rb");
+
+	if (!f)
+	{
+		printf("Unable to open %s\n", FilePath);
+		return false;
+	}
+
+	bool valid = ReadExact(f, &Out.Header, sizeof(Out.Header));
+
+	if (valid && (Out.Header.Magic != MOC_FrameCaptureFormat::Magic || Out.Header.Version < 1 || Out.Header.Version > MOC_FrameCaptureFormat::Version))
+	{
+		printf("%s is not a version 1-%u MOC frame capture\n", FilePath, MOC_FrameCaptureFormat::Version);
+		valid = false;
+	}
+
+	Out.TriangleCount = 0;
+
+	for (uint32_t i = 0; valid && i < Out.Header.DrawCount; i++)
+	{
+		CapturedDraw& draw = Out.Draws.emplace_back();
+
+		valid = ReadExact(f, &draw.Header, sizeof(draw.Header));
+
+		if (valid && Out.Header.Version >= 3)
+		{
+			draw.QuantizedVertices.resize(draw.Header.VertexCount * 4);
+			draw.QuantizedIndices.resize(draw.Header.TriangleCount * 3);
+
+			valid = ReadExact(f, draw.QuantizedVertices.data(), draw.QuantizedVertices.size() * sizeof(uint16_t)) &&
+				ReadExact(f, draw.QuantizedIndices.data(), draw.QuantizedIndices.size() * sizeof(uint16_t));
+		}
+		else if (valid)
+		{
+			draw.Vertices.resize(draw.Header.VertexCount * 4);
+			draw.Indices.resize(draw.Header.TriangleCount * 3);
+
+			valid = ReadExact(f, draw.Vertices.data(), draw.Vertices.size() * sizeof(float)) &&
+				ReadExact(f, draw.Indices.data(), draw.Indices.size() * sizeof(unsigned int));
+		}
+
+		Out.TriangleCount += draw.Header.TriangleCount;
+	}
+
+	if (valid)
+	{
+		Out.Queries.resize(Out.Header.QueryCount);
+		valid = ReadExact(f, Out.Queries.data(), Out.Queries.size() * sizeof(MOC_FrameCaptureFormat::Query));
+	}
+
+	memset(&Out.BoundsHeader, 0, sizeof(Out.BoundsHeader));
+
+	if (valid && Out.Header.Version >= 2)
+	{
+		valid = ReadExact(f, &Out.BoundsHeader, sizeof(Out.BoundsHeader));
+
+		if (valid)
+		{
+			Out.Bounds.resize(Out.BoundsHeader.BoundsCount);
+			valid = ReadExact(f, Out.Bounds.data(), Out.Bounds.size() * sizeof(MOC_FrameCaptureFormat::Bounds));
+		}
+	}
+
+	if (!valid)
+		printf("%s is truncated or corrupt\n", FilePath);
+
+	fclose(f);
+	return valid;
+}
+
+struct LoopTimes
+{
+	double MeanMs;
+	double P99Ms;
+};
+
+template<typename T>
+LoopTimes TimeLoops(uint32_t Loops, T&& Func)
+{
+	// One untimed pass to warm caches and page in the buffers
+	Func();
+
+	const uint64_t start = Profiler::Clock::Now();
+
+	for (uint32_t i = 0; i < Loops; i++)
+	{
+		ProfileTimerHistogram("moc_replay Loop");
+		Func();
+	}
+
+	const double totalMs = Profiler::Clock::TicksToMs(Profiler::Clock::Now() - start);
+	return { totalMs / Loops, ProfileGetPercentiles("moc_replay Loop").P99 };
+}
+
+void RenderCapture(const Capture& Frame, MaskedOcclusionCulling *Buffer)
+{
+	Buffer->ClearBuffer();
+
+	for (const CapturedDraw& draw : Frame.Draws)
+	{
+		const auto winding = (MaskedOcclusionCulling::BackfaceWinding)draw.Header.Winding;
+
+		if (!draw.QuantizedVertices.empty())
+			Buffer->RenderTrianglesQuantized(draw.QuantizedVertices.data(), draw.QuantizedIndices.data(), (int)draw.Header.TriangleCount, draw.Header.ModelToClip, winding, MaskedOcclusionCulling::CLIP_PLANE_SIDES);
+		else
+			Buffer->RenderTriangles(draw.Vertices.data(), draw.Indices.data(), (int)draw.Header.TriangleCount, draw.Header.ModelToClip, winding, MaskedOcclusionCulling::CLIP_PLANE_SIDES);
+	}
+}
+
+void RenderCapture(const Capture& Frame, CullingThreadpool *Pool)
+{
+	Pool->ClearBuffer();
+
+	for (const CapturedDraw& draw : Frame.Draws)
+	{
+		const auto winding = (MaskedOcclusionCulling::BackfaceWinding)draw.Header.Winding;
+
+		Pool->SetMatrix(draw.Header.ModelToClip);
+
+		if (!draw.QuantizedVertices.empty())
+			Pool->RenderTrianglesQuantized(draw.QuantizedVertices.data(), draw.QuantizedIndices.data(), (int)draw.Header.TriangleCount, winding, MaskedOcclusionCulling::CLIP_PLANE_SIDES);
+		else
+			Pool->RenderTriangles(draw.Vertices.data(), draw.Indices.data(), (int)draw.Header.TriangleCount, winding, MaskedOcclusionCulling::CLIP_PLANE_SIDES);
+	}
+
+	Pool->Flush();
+}
+
+uint32_t TestQueries(const Capture& Frame, MaskedOcclusionCulling *Buffer, uint32_t *Mismatches)
+{
+	uint32_t visible = 0;
+	uint32_t mismatches = 0;
+
+	for (const MOC_FrameCaptureFormat::Query& query : Frame.Queries)
+	{
+		auto result = Buffer->TestRect(query.XMin, query.YMin, query.XMax, query.YMax, query.WMin);
+
+		if (result == MaskedOcclusionCulling::VISIBLE)
+			visible++;
+
+		if (query.Result != MOC_FrameCaptureFormat::ResultNotTested && query.Result != (uint32_t)result)
+			mismatches++;
+	}
+
+	if (Mismatches)
+		*Mismatches = mismatches;
+
+	return visible;
+}
+
+//
+// Captured bounds split into the structure-of-arrays layout MOC::TestSpheres/TestAABBs receive
+//
+struct BoundsSoA
+{
+	std::vector<float> X, Y, Z;
+	std::vector<float> EX, EY, EZ;
+
+	void Add(const MOC_FrameCaptureFormat::Bounds& B)
+	{
+		X.push_back(B.Center[0]);
+		Y.push_back(B.Center[1]);
+		Z.push_back(B.Center[2]);
+		EX.push_back(B.Extent[0]);
+		EY.push_back(B.Extent[1]);
+		EZ.push_back(B.Extent[2]);
+	}
+
+	uint32_t Count() const
+	{
+		return (uint32_t)X.size();
+	}
+};
+
+struct ProjectedBounds
+{
+	std::vector<float> XMin, YMin, XMax, YMax, WMin;
+	std::vector<uint64_t> Unknown;
+
+	ProjectedBounds(uint32_t Count) : XMin(Count), YMin(Count), XMax(Count), YMax(Count), WMin(Count), Unknown((Count + 63) / 64)
+	{
+	}
+};
+
+void ProjectBounds(const BatchCullKernels& Kernels, const MOC_BatchCull::Camera& Cam, const BoundsSoA& Spheres, const BoundsSoA& Boxes, ProjectedBounds& SphereOut, ProjectedBounds& BoxOut)
+{
+	// Chunks of 64 like MOC::TestBatch, one mask word each
+	for (uint32_t base = 0; base < Spheres.Count(); base += 64)
+	{
+		const uint32_t count = std::min<uint32_t>(Spheres.Count() - base, 64);
+		const MOC_BatchCull::Rects rects { &SphereOut.XMin[base], &SphereOut.YMin[base], &SphereOut.XMax[base], &SphereOut.YMax[base], &SphereOut.WMin[base] };
+
+		SphereOut.Unknown[base / 64] = 0;
+		Kernels.ProjectSpheres(Cam, &Spheres.X[base], &Spheres.Y[base], &Spheres.Z[base], &Spheres.EX[base], count, rects, &SphereOut.Unknown[base / 64]);
+	}
+
+	for (uint32_t base = 0; base < Boxes.Count(); base += 64)
+	{
+		const uint32_t count = std::min<uint32_t>(Boxes.Count() - base, 64);
+		const MOC_BatchCull::Rects rects { &BoxOut.XMin[base], &BoxOut.YMin[base], &BoxOut.XMax[base], &BoxOut.YMax[base], &BoxOut.WMin[base] };
+
+		BoxOut.Unknown[base / 64] = 0;
+		Kernels.ProjectAABBs(Cam, &Boxes.X[base], &Boxes.Y[base], &Boxes.Z[base], &Boxes.EX[base], &Boxes.EY[base], &Boxes.EZ[base], count, rects, &BoxOut.Unknown[base / 64]);
+	}
+}
+
+uint32_t CountMismatches(const ProjectedBounds& A, const ProjectedBounds& B, uint32_t Count)
+{
+	// FMA kernels round differently from the scalar reference, so rects only have to agree closely
+	auto differs = [](float X, float Y)
+	{
+		return fabsf(X - Y) > 0.0001f * std::max(1.0f, std::max(fabsf(X), fabsf(Y)));
+	};
+
+	uint32_t mismatches = 0;
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		const bool unknownA = (A.Unknown[i / 64] >> (i % 64)) & 1;
+		const bool unknownB = (B.Unknown[i / 64] >> (i % 64)) & 1;
+
+		if (unknownA != unknownB)
+			mismatches++;
+		else if (!unknownA && (differs(A.XMin[i], B.XMin[i]) || differs(A.YMin[i], B.YMin[i]) || differs(A.XMax[i], B.XMax[i]) ||
+			differs(A.YMax[i], B.YMax[i]) || differs(A.WMin[i], B.WMin[i])))
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+bool IsSupported(MaskedOcclusionCulling::Implementation Impl)
+{
+	// Create() silently falls back to the best supported implementation
+	MaskedOcclusionCulling *buffer = MaskedOcclusionCulling::Create(Impl);
+	const bool supported = buffer->GetImplementation() == Impl;
+
+	MaskedOcclusionCulling::Destroy(buffer);
+	return supported;
+}
+
+void ReplayBatchCull(const Capture& Frame, uint32_t Loops)
+{
+	BoundsSoA spheres;
+	BoundsSoA boxes;
+
+	for (const auto& bounds : Frame.Bounds)
+		(bounds.Type == MOC_FrameCaptureFormat::BoundsSphere ? spheres : boxes).Add(bounds);
+
+	printf("\nBatch projection: %u spheres, %u boxes\n", spheres.Count(), boxes.Count());
+
+	if (Frame.Bounds.empty())
+	{
+		printf("No captured bounds (version 1 capture or batched queries disabled)\n");
+		return;
+	}
+
+	MOC_BatchCull::Camera cam;
+	memcpy(cam.View, Frame.BoundsHeader.View, sizeof(cam.View));
+	memcpy(cam.ViewProj, Frame.Header.ViewProj, sizeof(cam.ViewProj));
+	memcpy(cam.Position, Frame.Header.Position, sizeof(cam.Position));
+
+	printf("%-8s %14s %12s %12s %12s\n", "Kernel", "ns/object", "P99 (ms)", "Unknown", "Mismatches");
+
+	const BatchCullKernels scalar = GetBatchCullKernelsScalar();
+	ProjectedBounds referenceSpheres(spheres.Count());
+	ProjectedBounds referenceBoxes(boxes.Count());
+	ProjectBounds(scalar, cam, spheres, boxes, referenceSpheres, referenceBoxes);
+
+	const std::pair<BatchCullKernels, bool> kernels[] =
+	{
+		{ scalar, true },
+		{ GetBatchCullKernelsSSE(), true },
+		{ GetBatchCullKernelsAVX2(), IsSupported(MaskedOcclusionCulling::AVX2) },
+		{ GetBatchCullKernelsAVX512(), IsSupported(MaskedOcclusionCulling::AVX512) },
+	};
+
+	for (const auto& [impl, supported] : kernels)
+	{
+		if (!supported)
+		{
+			printf("%-8s not supported by this CPU or build\n", impl.Name);
+			continue;
+		}
+
+		ProjectedBounds sphereOut(spheres.Count());
+		ProjectedBounds boxOut(boxes.Count());
+
+		LoopTimes project = TimeLoops(Loops, [&]() { ProjectBounds(impl, cam, spheres, boxes, sphereOut, boxOut); });
+
+		uint32_t unknown = 0;
+
+		for (uint64_t word : sphereOut.Unknown)
+			unknown += (uint32_t)std::bitset<64>(word).count();
+
+		for (uint64_t word : boxOut.Unknown)
+			unknown += (uint32_t)std::bitset<64>(word).count();
+
+		const uint32_t mismatches = CountMismatches(sphereOut, referenceSpheres, spheres.Count()) + CountMismatches(boxOut, referenceBoxes, boxes.Count());
+
+		printf("%-8s %14.2f %12.3f %12u %12u\n", impl.Name, (project.MeanMs * 1000000.0) / Frame.Bounds.size(), project.P99Ms, unknown, mismatches);
+	}
+}
+
+const char *GetImplementationName(MaskedOcclusionCulling::Implementation Impl)
+{
+	switch (Impl)
+	{
+	case MaskedOcclusionCulling::SSE2: return "SSE2";
+	case MaskedOcclusionCulling::SSE41: return "SSE4.1";
+	case MaskedOcclusionCulling::AVX2: return "AVX2";
+	case MaskedOcclusionCulling::AVX512: return "AVX-512";
+	}
+
+	return "Unknown";
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <capture.mocframe> [loops]\n", argv[0]);
+		return 1;
+	}
+
+	const uint32_t loops = (argc >= 3) ? std::max(atoi(argv[2]), 1) : 100;
+	Capture frame;
+
+	Profiler::Clock::Initialize();
+
+	if (!LoadCapture(argv[1], frame))
+		return 1;
+
+	uint32_t testedQueries = 0;
+
+	for (const auto& query : frame.Queries)
+	{
+		if (query.Result != MOC_FrameCaptureFormat::ResultNotTested)
+			testedQueries++;
+	}
+
+	printf("Clock: %s at %.3f MHz (invariant TSC: %s)\n", Profiler::Clock::GetSourceName(Profiler::Clock::ActiveSource),
+		Profiler::Clock::GetFrequency() / 1000000.0, Profiler::Clock::InvariantTSC ? "yes" : "no");
+
+	printf("%s: %ux%u, %zu draws, %llu triangles, %zu queries (%u tested in game), %u loops\n\n", argv[1],
+		frame.Header.Width, frame.Header.Height, frame.Draws.size(), (unsigned long long)frame.TriangleCount, frame.Queries.size(), testedQueries, loops);
+
+	printf("%-8s %-10s %12s %12s %12s %14s %12s %12s\n", "Backend", "Threads", "Render (ms)", "P99 (ms)", "MTris/s", "Query (ns)", "Visible", "Mismatches");
+
+	const MaskedOcclusionCulling::Implementation implementations[] =
+	{
+		MaskedOcclusionCulling::SSE41,
+		MaskedOcclusionCulling::AVX2,
+		MaskedOcclusionCulling::AVX512,
+	};
+
+	const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<uint32_t> threadCounts;
+
+	for (uint32_t threads = 1; threads <= hardwareThreads && threads <= 16; threads *= 2)
+		threadCounts.push_back(threads);
+
+	if (hardwareThreads <= 16 && threadCounts.back() != hardwareThreads)
+		threadCounts.push_back(hardwareThreads);
+
+	for (MaskedOcclusionCulling::Implementation impl : implementations)
+	{
+		MaskedOcclusionCulling *buffer = MaskedOcclusionCulling::Create(impl);
+
+		// Create() silently falls back to the best supported implementation
+		if (buffer->GetImplementation() != impl)
+		{
+			printf("%-8s not supported by this CPU or build\n", GetImplementationName(impl));
+			MaskedOcclusionCulling::Destroy(buffer);
+			continue;
+		}
+
+		buffer->SetResolution(frame.Header.Width, frame.Header.Height);
+
+		// Single threaded, straight into the buffer (MOC_ThreadedMerger's per-thread path)
+		LoopTimes render = TimeLoops(loops, [&]() { RenderCapture(frame, buffer); });
+
+		uint32_t mismatches = 0;
+		uint32_t visible = TestQueries(frame, buffer, &mismatches);
+		double queryMs = TimeLoops(loops, [&]() { TestQueries(frame, buffer, nullptr); }).MeanMs;
+		double queryNs = frame.Queries.empty() ? 0.0 : (queryMs * 1000000.0) / frame.Queries.size();
+
+		printf("%-8s %-10s %12.3f %12.3f %12.1f %14.1f %12u %12u\n", GetImplementationName(impl), "direct", render.MeanMs, render.P99Ms,
+			(frame.TriangleCount / 1000000.0) / (render.MeanMs / 1000.0), queryNs, visible, mismatches);
+
+		// Binned through the thread pool (MOC_BinnedRenderer's path)
+		for (uint32_t threads : threadCounts)
+		{
+			// Same bin layout as MOC_BinnedRenderer
+			CullingThreadpool pool(threads, 4, 4);
+			pool.SetBuffer(buffer);
+			pool.WakeThreads();
+
+			render = TimeLoops(loops, [&]() { RenderCapture(frame, &pool); });
+
+			pool.SuspendThreads();
+
+			visible = TestQueries(frame, buffer, &mismatches);
+
+			char label[32];
+			snprintf(label, sizeof(label), "pool x%u", threads);
+
+			printf("%-8s %-10s %12.3f %12.3f %12.1f %14s %12u %12u\n", GetImplementationName(impl), label, render.MeanMs, render.P99Ms,
+				(frame.TriangleCount / 1000000.0) / (render.MeanMs / 1000.0), "-", visible, mismatches);
+		}
+
+		MaskedOcclusionCulling::Destroy(buffer);
+	}
+
+	ReplayBatchCull(frame, loops);
+	return 0;
+}
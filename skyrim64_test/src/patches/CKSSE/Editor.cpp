@@ -240,53 +240,7 @@ bool BSGameDataSystemUtility__IsCCFile(const char *Name)
 
 uint32_t sub_1414974E0(BSTArray<void *>& Array, const void *&Target, uint32_t StartIndex, __int64 Unused)
 {
-	for (uint32_t i = StartIndex; i < Array.QSize(); i++)
-	{
-		if (Array[i] == Target)
-			return i;
-	}
-
-	return 0xFFFFFFFF;
-}
-
-uint32_t sub_1414974E0_SSE41(BSTArray<void *>& Array, const void *&Target, uint32_t StartIndex, __int64 Unused)
-{
-	uint32_t index = StartIndex;
-	__int64 *data = (__int64 *)Array.QBuffer();
-
-	const uint32_t comparesPerIter = 4;
-	const uint32_t vectorizedIterations = (Array.QSize() - index) / comparesPerIter;
-
-	//
-	// Compare 4 pointers per iteration - use SIMD instructions to generate a bit mask. Set
-	// bit 0 if 'array[i + 0]'=='target', set bit 1 if 'array[i + 1]'=='target', set bit X...
-	//
-	// AVX: mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(targets, _mm256_loadu_si256((__m256i *)&data[i]))));
-	//
-	const __m128i targets = _mm_set1_epi64x((__int64)Target);
-
-	for (uint32_t iter = 0; iter < vectorizedIterations; iter++)
-	{
-		__m128i test1 = _mm_cmpeq_epi64(targets, _mm_loadu_si128((__m128i *)&data[index + 0]));
-		__m128i test2 = _mm_cmpeq_epi64(targets, _mm_loadu_si128((__m128i *)&data[index + 2]));
-
-		int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(test1, test2)));
-
-		// if (target pointer found) { break into the remainder loop to get the index }
-		if (mask != 0)
-			break;
-
-		index += comparesPerIter;
-	}
-
-	// Scan the rest 1-by-1
-	for (; index < Array.QSize(); index++)
-	{
-		if (data[index] == (__int64)Target)
-			return index;
-	}
-
-	return 0xFFFFFFFF;
+	return Array.find(const_cast<void *>(Target), StartIndex);
 }
 
 bool sub_1415D5640(__int64 a1, uint32_t *a2)
@@ -40,7 +40,6 @@ const char *BSGameDataSystemUtility__GetCCFile(uint32_t Index);
 bool BSGameDataSystemUtility__IsCCFile(const char *Name);
 
 uint32_t sub_1414974E0(BSTArray<void *>& Array, const void *&Target, uint32_t StartIndex, __int64 Unused);
-uint32_t sub_1414974E0_SSE41(BSTArray<void *>& Array, const void *&Target, uint32_t StartIndex, __int64 Unused);
 bool sub_1415D5640(__int64 a1, uint32_t *a2);
 void UpdateLoadProgressBar();
 void SortDialogueInfo(__int64 TESDataHandler, uint32_t FormType, int(*SortFunction)(const void *, const void *));
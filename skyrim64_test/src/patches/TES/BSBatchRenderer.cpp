@@ -375,6 +375,8 @@ void BSBatchRenderer::RenderPassImmediately(BSRenderPass *Pass, uint32_t Techniq
 	uint64_t& qword_1432A8218 = *(uint64_t *)((uintptr_t)GraphicsGlobals + 0x3018);// LastShader
 	BSShaderMaterial*& qword_1434B5220 = *(BSShaderMaterial **)((uintptr_t)GraphicsGlobals + 0x3500);// LastMaterial
 
+	Profiler::FlightRecorder::Record(Profiler::FlightRecorder::EVENT_RENDER_PASS, (uintptr_t)Pass->m_Geometry, (uintptr_t)Pass->m_Shader, Technique);
+
 	bool techniqueIsSetup = false;
 
 	// BeginPass doesn't need to be called again if we used this shader previously
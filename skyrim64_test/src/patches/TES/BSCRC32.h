@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <intrin.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+//
+// Inlined replacement for the engine's 4-byte key CRC (sub_140C06030, see CRC32_Lazy). Bethesda's version is a
+// plain table-driven reflected CRC-32 (polynomial 0xEDB88320) with a zero seed and no final XOR.
+//
+// SSE4.2's crc32 instruction is hardwired to the Castagnoli polynomial and can't reproduce those values, so the
+// hardware path uses a PCLMULQDQ Barrett reduction instead: two carry-less multiplies per key, no memory loads.
+// CPUs without PCLMULQDQ fall back to slicing-by-4 tables.
+//
+namespace BSCRC32Detail
+{
+	using SliceTable = std::array<std::array<uint32_t, 256>, 4>;
+
+	constexpr SliceTable GenerateTables()
+	{
+		SliceTable tables = {};
+
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t crc = i;
+
+			for (int bit = 0; bit < 8; bit++)
+				crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+
+			tables[0][i] = crc;
+		}
+
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			for (int slice = 1; slice < 4; slice++)
+				tables[slice][i] = (tables[slice - 1][i] >> 8) ^ tables[0][tables[slice - 1][i] & 0xFF];
+		}
+
+		return tables;
+	}
+}
+
+class BSCRC32
+{
+private:
+	static bool DetectCLMUL()
+	{
+		int cpuinfo[4];
+		__cpuid(cpuinfo, 1);
+
+		return (cpuinfo[2] & (1 << 1)) != 0;
+	}
+
+	alignas(64) static constexpr BSCRC32Detail::SliceTable Tables = BSCRC32Detail::GenerateTables();
+
+public:
+	inline static const bool HasCLMUL = DetectCLMUL();
+
+	__forceinline static uint32_t HashTable(uint32_t Key)
+	{
+		return
+			Tables[3][Key & 0xFF] ^
+			Tables[2][(Key >> 8) & 0xFF] ^
+			Tables[1][(Key >> 16) & 0xFF] ^
+			Tables[0][Key >> 24];
+	}
+
+	__forceinline static uint32_t HashCLMUL(uint32_t Key)
+	{
+		// Low qword: P' (bit-reflected polynomial, x^32 included). High qword: mu (floor(x^64 / P), reflected).
+		const __m128i constants = _mm_set_epi64x(0x1F7011641, 0x1DB710641);
+
+		__m128i t = _mm_clmulepi64_si128(_mm_cvtsi32_si128(Key), constants, 0x10);	// T1 = Key * mu
+		t = _mm_and_si128(t, _mm_cvtsi32_si128(-1));									// Keep the low 32 bits of T1
+		t = _mm_clmulepi64_si128(t, constants, 0x00);									// T2 = T1 * P'
+
+		// Remainder lands in bits [32, 64)
+		return (uint32_t)(_mm_cvtsi128_si64(t) >> 32);
+	}
+
+	__forceinline static uint32_t Hash(uint32_t Key)
+	{
+		// Always the same result for the lifetime of the process; the branch is free after the first few calls
+		if (HasCLMUL)
+			return HashCLMUL(Key);
+
+		return HashTable(Key);
+	}
+
+	template<typename OutType>
+	static void HashBatch(const uint32_t *Keys, OutType *Hashes, size_t Count)
+	{
+		//
+		// Bulk variant for plugin load: the CPU check is hoisted out of the loop and 4 keys are hashed per
+		// iteration so the independent multiply (or table lookup) chains overlap.
+		//
+		size_t i = 0;
+
+		if (HasCLMUL)
+		{
+			for (; i + 4 <= Count; i += 4)
+			{
+				Hashes[i + 0] = HashCLMUL(Keys[i + 0]);
+				Hashes[i + 1] = HashCLMUL(Keys[i + 1]);
+				Hashes[i + 2] = HashCLMUL(Keys[i + 2]);
+				Hashes[i + 3] = HashCLMUL(Keys[i + 3]);
+			}
+
+			for (; i < Count; i++)
+				Hashes[i] = HashCLMUL(Keys[i]);
+		}
+		else
+		{
+			for (; i + 4 <= Count; i += 4)
+			{
+				Hashes[i + 0] = HashTable(Keys[i + 0]);
+				Hashes[i + 1] = HashTable(Keys[i + 1]);
+				Hashes[i + 2] = HashTable(Keys[i + 2]);
+				Hashes[i + 3] = HashTable(Keys[i + 3]);
+			}
+
+			for (; i < Count; i++)
+				Hashes[i] = HashTable(Keys[i]);
+		}
+	}
+};
@@ -1,6 +1,10 @@
 #include "../../../common.h"
 #include <mutex>
+#include <d3d11_4.h>
 #include "../../rendering/GpuCircularBuffer.h"
+#include "../../rendering/DynamicBufferRing.h"
+#include "../../rendering/FramePacer.h"
+#include "../../rendering/d3d11_proxy.h"
 #include "../NiMain/BSGeometry.h"
 #include "BSGraphicsRenderer.h"
 #include "BSGraphicsRenderTargetManager.h"
@@ -24,6 +28,124 @@ namespace BSGraphics
 
 	GpuCircularBuffer *ShaderConstantBuffer;
 
+	const uint32_t DynamicVertexBufferSize = 0x400000;
+
+	//
+	// The first three slots are the game's own dynamic vertex buffers and event queries, any extra slots get identical
+	// copies. D3D11.4 runtimes wait on a fence event. Older ones poll the event queries with short high resolution
+	// sleeps instead of Sleep(1).
+	//
+	// The proxies only expose D3D11.2, so the fence interfaces are queried from the real device and immediate context
+	// behind them and never handed to anyone else. The context proxy forwards every call to that same immediate
+	// context, so a Signal() issued on it directly still lands after the draws that read the buffer.
+	//
+	class D3D11DynamicBufferDevice : public DynamicBufferDevice
+	{
+	public:
+		ID3D11Buffer *m_Buffers[DynamicBufferRing::MaxSlots] = {};
+
+	private:
+		ID3D11Device *m_Device;
+		ID3D11DeviceContext *m_Context;
+		ID3D11Query *m_Queries[DynamicBufferRing::MaxSlots] = {};
+
+		ComPtr<ID3D11Fence> m_Fence;
+		ComPtr<ID3D11DeviceContext4> m_FenceContext;
+		HANDLE m_FenceEvent = nullptr;
+		uint64_t m_FenceValue = 0;
+		uint64_t m_SlotFenceValues[DynamicBufferRing::MaxSlots] = {};
+
+	public:
+		D3D11DynamicBufferDevice(D3D11DeviceProxy *Device, D3D11DeviceContextProxy *Context) : m_Device(Device), m_Context(Context)
+		{
+			ComPtr<ID3D11Device5> device5;
+			ComPtr<ID3D11DeviceContext4> context4;
+
+			if (SUCCEEDED(Device->m_Device->QueryInterface(IID_PPV_ARGS(&device5))) &&
+				SUCCEEDED(Context->m_Context->QueryInterface(IID_PPV_ARGS(&context4))) &&
+				SUCCEEDED(device5->CreateFence(0, D3D11_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_Fence))))
+			{
+				m_FenceContext = context4;
+				m_FenceEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+			}
+		}
+
+		bool CreateSlot(uint32_t Slot) override
+		{
+			if (Slot < ARRAYSIZE(Renderer::Globals.m_DynamicVertexBuffers))
+			{
+				m_Buffers[Slot] = Renderer::Globals.m_DynamicVertexBuffers[Slot];
+				m_Queries[Slot] = Renderer::Globals.m_DynamicVertexBufferAvailQuery[Slot];
+				return true;
+			}
+
+			D3D11_BUFFER_DESC bufferDesc;
+			m_Buffers[0]->GetDesc(&bufferDesc);
+
+			if (FAILED(m_Device->CreateBuffer(&bufferDesc, nullptr, &m_Buffers[Slot])))
+				return false;
+
+			if (!m_Fence)
+			{
+				D3D11_QUERY_DESC queryDesc;
+				queryDesc.Query = D3D11_QUERY_EVENT;
+				queryDesc.MiscFlags = 0;
+
+				if (FAILED(m_Device->CreateQuery(&queryDesc, &m_Queries[Slot])))
+				{
+					m_Buffers[Slot]->Release();
+					m_Buffers[Slot] = nullptr;
+					return false;
+				}
+			}
+
+			Renderer::QInstance()->SetResourceName(m_Buffers[Slot], "Dynamic Vertex Buffer %u", Slot);
+			return true;
+		}
+
+		void Signal(uint32_t Slot) override
+		{
+			if (m_Fence)
+			{
+				m_SlotFenceValues[Slot] = ++m_FenceValue;
+				m_FenceContext->Signal(m_Fence.Get(), m_FenceValue);
+			}
+			else
+			{
+				m_Context->End(m_Queries[Slot]);
+			}
+		}
+
+		bool IsComplete(uint32_t Slot) override
+		{
+			if (m_Fence)
+				return m_Fence->GetCompletedValue() >= m_SlotFenceValues[Slot];
+
+			BOOL data = FALSE;
+			return m_Context->GetData(m_Queries[Slot], &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK && data == TRUE;
+		}
+
+		void Wait(uint32_t Slot) override
+		{
+			ProfileZone("Dynamic Vertex Buffer Wait");
+
+			// The signal could still be sitting in the command buffer
+			m_Context->Flush();
+
+			if (m_Fence && m_FenceEvent && SUCCEEDED(m_Fence->SetEventOnCompletion(m_SlotFenceValues[Slot], m_FenceEvent)))
+			{
+				WaitForSingleObject(m_FenceEvent, INFINITE);
+				return;
+			}
+
+			while (!IsComplete(Slot))
+				FramePacer::SleepFor(100 * 1000);
+		}
+	};
+
+	D3D11DynamicBufferDevice *DynamicVertexBufferDevice;
+	DynamicBufferRing *DynamicVertexBuffers;
+
 	void BeginEvent(const wchar_t *Name)
 	{
 	}
@@ -61,6 +183,12 @@ namespace BSGraphics
 
 		ShaderConstantBuffer->SwapFrame(CurrentFrameIndex);
 
+		if (DynamicVertexBuffers)
+		{
+			DynamicVertexBuffers->EndFrame();
+			ProfileCounterAdd("Dynamic VB Stall Us", DynamicVertexBuffers->GetLastFrameStats().StallNs / 1000);
+		}
+
 		// "Pop" the query from the oldest rendered frame
 		int prevQueryIndex = CurrentFrameIndex - (RingBufferMaxFrames - 1);
 
@@ -1531,53 +1659,32 @@ namespace BSGraphics
 	void *Renderer::AllocateAndMapDynamicVertexBuffer(uint32_t Size, uint32_t *OutOffset)
 	{
 		AssertMsg(Size > 0, "Size must be > 0");
+		AssertMsg(Size <= DynamicVertexBufferSize, "Dynamic geometry buffer overflow.");
 
-		uint32_t frameDataOffset = Globals.m_CurrentDynamicVertexBufferOffset;
-		uint32_t frameBufferIndex = Globals.m_CurrentDynamicVertexBuffer;
-		uint32_t newFrameDataSzie = Globals.m_CurrentDynamicVertexBufferOffset + Size;
-
-		//
-		// Check if this request would exceed the allocated buffer size for the currently executing command list. If it does,
-		// we end the current query and move on to the next buffer.
-		//
-		if (newFrameDataSzie > 0x400000)
+		// The game creates its buffers after Initialize() runs
+		if (!DynamicVertexBuffers)
 		{
-			AssertMsg(Size <= 0x400000, "Dynamic geometry buffer overflow.");
-
-			newFrameDataSzie = Size;
-			frameDataOffset = 0;
-
-			Globals.m_DynamicEventQueryFinished[Globals.m_CurrentDynamicVertexBuffer] = false;
-			Data.pContext->End(Globals.m_DynamicVertexBufferAvailQuery[Globals.m_CurrentDynamicVertexBuffer]);
-
-			frameBufferIndex++;
-
-			if (frameBufferIndex >= ARRAYSIZE(Globals.m_DynamicVertexBufferAvailQuery))
-				frameBufferIndex = 0;
+			// d3d11.cpp always hands the game proxies
+			DynamicVertexBufferDevice = new D3D11DynamicBufferDevice(static_cast<D3D11DeviceProxy *>(Data.pDevice), static_cast<D3D11DeviceContextProxy *>(Data.pContext));
+			DynamicVertexBuffers = new DynamicBufferRing(DynamicVertexBufferDevice, DynamicVertexBufferSize, ARRAYSIZE(Globals.m_DynamicVertexBuffers));
 		}
 
 		//
-		// This will suspend execution until the buffer we want is no longer in use. The query waits on a list of commands
-		// using said buffer.
+		// Moves on to the next buffer when this one is full. If the GPU is still reading from that one the ring grows
+		// (sized by how far behind the GPU runs) or, when it can't, blocks on a fence instead of polling with Sleep(1).
 		//
-		if (!Globals.m_DynamicEventQueryFinished[frameBufferIndex])
-		{
-			ID3D11Query *query = Globals.m_DynamicVertexBufferAvailQuery[frameBufferIndex];
-			BOOL data;
+		uint32_t frameDataOffset;
+		uint32_t slot = DynamicVertexBuffers->Allocate(Size, &frameDataOffset);
 
-			HRESULT hr = Data.pContext->GetData(query, &data, sizeof(data), 0);
-
-			for (; FAILED(hr) || data == FALSE; hr = Data.pContext->GetData(query, &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH))
-				Sleep(1);
-
-			Globals.m_DynamicEventQueryFinished[frameBufferIndex] = (data == TRUE);
-		}
+		// Keep the game's view of the current buffer in sync. Extra slots borrow one of its three entries.
+		uint32_t frameBufferIndex = slot % ARRAYSIZE(Globals.m_DynamicVertexBuffers);
+		Globals.m_DynamicVertexBuffers[frameBufferIndex] = DynamicVertexBufferDevice->m_Buffers[slot];
 
 		D3D11_MAPPED_SUBRESOURCE resource;
 		Data.pContext->Map(Globals.m_DynamicVertexBuffers[frameBufferIndex], 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &resource);
 
 		Globals.m_CurrentDynamicVertexBuffer = frameBufferIndex;
-		Globals.m_CurrentDynamicVertexBufferOffset = newFrameDataSzie;
+		Globals.m_CurrentDynamicVertexBufferOffset = frameDataOffset + Size;
 		*OutOffset = frameDataOffset;
 
 		return (void *)((uintptr_t)resource.pData + frameDataOffset);
@@ -28,7 +28,8 @@ namespace BSGraphics
 		//
 		// These are pools for efficient data uploads to the GPU. Each frame can use any buffer as long as there
 		// is sufficient space. If there's no space left, delay execution until m_DynamicVertexBufferAvailQuery[] says a buffer
-		// is no longer in use.
+		// is no longer in use. Our AllocateAndMapDynamicVertexBuffer() replaces this with a deeper DynamicBufferRing and
+		// swaps its extra buffers in and out of these three entries.
 		//
 		ID3D11Buffer		*m_DynamicVertexBuffers[3];			// DYNAMIC (VERTEX | INDEX) CPU_ACCESS_WRITE
 		uint32_t			m_CurrentDynamicVertexBuffer;
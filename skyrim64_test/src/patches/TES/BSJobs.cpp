@@ -1,4 +1,5 @@
 #include "../../common.h"
+#include "../../profiler_zone_categories.h"
 #include "BSJobs.h"
 
 const std::unordered_map<uintptr_t, std::string> BSJobs::JobNameMap =
@@ -119,7 +120,10 @@ const std::unordered_map<uintptr_t, std::string> BSJobs::JobNameMap =
 };
 
 std::unordered_map<uintptr_t, BSJobs::TrackingInfo> BSJobs::JobTracker;
-#if SKYRIM64_USE_TRACY
+#if SKYRIM64_ZONES_JOBS
+std::unordered_map<uintptr_t, Profiler::ZoneSite> ZoneSiteMap;
+#endif
+#if SKYRIM64_USE_TRACY && SKYRIM64_ZONES_JOBS
 std::unordered_map<uintptr_t, tracy::SourceLocationData> TracySourceMap;
 #endif
 
@@ -130,7 +134,11 @@ void BSJobs::DispatchJobCallback(void *Parameter, void(*Function)(void *))
 	{
 		for (auto& nameEntry : BSJobs::JobNameMap)
 		{
-#if SKYRIM64_USE_TRACY
+#if SKYRIM64_ZONES_JOBS
+			ZoneSiteMap.insert_or_assign(nameEntry.first, Profiler::ZoneSite{ __FILE__, "BSJobs::DispatchJobCallback", nameEntry.second.c_str() });
+#endif
+
+#if SKYRIM64_USE_TRACY && SKYRIM64_ZONES_JOBS
 			tracy::SourceLocationData srcLocation{ nameEntry.second.c_str(), nameEntry.second.c_str(), "<unknown>", 0, 0 };
 			TracySourceMap.insert_or_assign(nameEntry.first, srcLocation);
 #endif
@@ -153,12 +161,29 @@ void BSJobs::DispatchJobCallback(void *Parameter, void(*Function)(void *))
 
 	AssertMsgVa(counterEntry != JobTracker.end(), "Unknown job callback 0x%p", offset);
 
-	counterEntry->second.TotalCount++;
-	counterEntry->second.ActiveCount++;
+	if (counterEntry != JobTracker.end())
+	{
+		counterEntry->second.TotalCount++;
+		counterEntry->second.ActiveCount++;
+	}
+
+	// Every job thread reads these maps at once, so lookups must never insert. Unknown callbacks share one entry.
+#if SKYRIM64_ZONES_JOBS
+	// Job names are only known at runtime, so this can't use ProfileZoneCat()
+	static constexpr Profiler::ZoneSite unknownSite { __FILE__, "BSJobs::DispatchJobCallback", "Unknown Job" };
+
+	auto siteEntry = ZoneSiteMap.find(offset);
+	Profiler::ScopedZone zone((siteEntry != ZoneSiteMap.end()) ? &siteEntry->second : &unknownSite);
+#endif
+
+#if SKYRIM64_USE_TRACY && SKYRIM64_ZONES_JOBS
+	static const tracy::SourceLocationData unknownSource { "Unknown Job", "Unknown Job", "<unknown>", 0, 0 };
 
-#if SKYRIM64_USE_TRACY
-	tracy::ScopedZone ___tracy_scoped_zone(&TracySourceMap[offset]);
+	auto sourceEntry = TracySourceMap.find(offset);
+	tracy::ScopedZone ___tracy_scoped_zone((sourceEntry != TracySourceMap.end()) ? &sourceEntry->second : &unknownSource);
 #endif
 
+	Profiler::FlightRecorder::Record(Profiler::FlightRecorder::EVENT_JOB_BEGIN, offset, (uintptr_t)Parameter);
 	Function(Parameter);
+	Profiler::FlightRecorder::Record(Profiler::FlightRecorder::EVENT_JOB_END, offset);
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "../../common.h"
+#include "../../profiler_zone_categories.h"
 #include "BSReadWriteLock.h"
 
 BSReadWriteLock::~BSReadWriteLock()
@@ -8,7 +9,13 @@ BSReadWriteLock::~BSReadWriteLock()
 
 void BSReadWriteLock::LockForRead()
 {
-	ProfileTimer("Read Lock Time");
+	ProfileTimerHistogram("Read Lock Time");
+
+	if (TryLockForRead())
+		return;
+
+	Profiler::FlightRecorder::ScopedLockWait wait(this, m_ThreadId.load(std::memory_order_relaxed));
+	ProfileZoneCat(LOCKS, "BSReadWriteLock Read Wait");
 
 	for (uint32_t count = 0; !TryLockForRead();)
 	{
@@ -45,7 +52,13 @@ bool BSReadWriteLock::TryLockForRead()
 
 void BSReadWriteLock::LockForWrite()
 {
-	ProfileTimer("Write Lock Time");
+	ProfileTimerHistogram("Write Lock Time");
+
+	if (TryLockForWrite())
+		return;
+
+	Profiler::FlightRecorder::ScopedLockWait wait(this, m_ThreadId.load(std::memory_order_relaxed));
+	ProfileZoneCat(LOCKS, "BSReadWriteLock Write Wait");
 
 	for (uint32_t count = 0; !TryLockForWrite();)
 	{
@@ -166,7 +166,7 @@ bool BSShaderAccumulator::RegisterObject_ShadowMapOrMask(BSShaderAccumulator *Ac
 
 void BSShaderAccumulator::FinishAccumulating_Standard(BSShaderAccumulator *Accumulator, uint32_t RenderFlags)
 {
-	ZoneScopedN("FinishAccumulating_Standard");
+	ProfileZone("FinishAccumulating_Standard");
 	BSGraphics::BeginEvent(L"FinishAccumulating_Standard");
 	FinishAccumulating_Standard_PreResolveDepth(Accumulator, RenderFlags);
 	FinishAccumulating_Standard_PostResolveDepth(Accumulator, RenderFlags);
@@ -190,7 +190,7 @@ void BSShaderAccumulator::FinishAccumulating_Standard_PreResolveDepth(BSShaderAc
 	auto renderer = BSGraphics::Renderer::QInstance();
 
 	renderer->BeginEvent(L"BSShaderAccumulator: Draw1");
-	ZoneScopedN("FinishAccumulating_Standard_PreResolveDepth");
+	ProfileZone("FinishAccumulating_Standard_PreResolveDepth");
 
 	if (*(BYTE *)(a1 + 92) && !BSGraphics::gState.bUseEarlyZ)
 		renderer->DepthStencilStateSetDepthMode(BSGraphics::DEPTH_STENCIL_DEPTH_MODE_TESTEQUAL);
@@ -386,7 +386,7 @@ void BSShaderAccumulator::FinishAccumulating_Standard_PreResolveDepth(BSShaderAc
 
 void BSShaderAccumulator::FinishAccumulating_Standard_PostResolveDepth(BSShaderAccumulator *Accumulator, uint32_t RenderFlags)
 {
-	ZoneScopedN("FinishAccumulating_Standard_PostResolveDepth");
+	ProfileZone("FinishAccumulating_Standard_PostResolveDepth");
 	((FINISHACCUMULATINGFUNC)(g_ModuleBase + 0x12E1F70))(Accumulator, RenderFlags);
 }
 
@@ -395,7 +395,7 @@ void BSShaderAccumulator::FinishAccumulating_ShadowMapOrMask(BSShaderAccumulator
 	if (!Accumulator->m_pkCamera)
 		return;
 
-	ZoneScopedN("FinishAccumulating_ShadowMapOrMask");
+	ProfileZone("FinishAccumulating_ShadowMapOrMask");
 	BSGraphics::BeginEvent(L"FinishAccumulating_ShadowMapOrMask");
 
 	if ((RenderFlags & 0x22) == 0x20)
@@ -436,7 +436,7 @@ void BSShaderAccumulator::FinishAccumulating_ShadowMapOrMask(BSShaderAccumulator
 
 void BSShaderAccumulator::FinishAccumulating_InterfaceElements(BSShaderAccumulator *Accumulator, uint32_t RenderFlags)
 {
-	ZoneScopedN("FinishAccumulating_InterfaceElements");
+	ProfileZone("FinishAccumulating_InterfaceElements");
 	BSGraphics::BeginEvent(L"FinishAccumulating_InterfaceElements");
 	((FINISHACCUMULATINGFUNC)(g_ModuleBase + 0x12E2FE0))(Accumulator, RenderFlags);
 	BSGraphics::EndEvent();
@@ -444,7 +444,7 @@ void BSShaderAccumulator::FinishAccumulating_InterfaceElements(BSShaderAccumulat
 
 void BSShaderAccumulator::FinishAccumulating_FirstPerson(BSShaderAccumulator *Accumulator, uint32_t RenderFlags)
 {
-	ZoneScopedN("FinishAccumulating_FirstPerson");
+	ProfileZone("FinishAccumulating_FirstPerson");
 	BSGraphics::BeginEvent(L"FinishAccumulating_FirstPerson");
 	((FINISHACCUMULATINGFUNC)(g_ModuleBase + 0x12E2B20))(Accumulator, RenderFlags);
 	BSGraphics::EndEvent();
@@ -459,7 +459,7 @@ void BSShaderAccumulator::FinishAccumulating_LODOnly(BSShaderAccumulator *Accumu
 
 	BSGraphics::BeginEvent(L"FinishAccumulating_LODOnly");
 	{
-		ZoneScopedN("FinishAccumulating_LODOnly");
+		ProfileZone("FinishAccumulating_LODOnly");
 
 		BSGraphics::BeginEvent(L"RenderLODLand");
 		Accumulator->RenderGeometryGroup(1, BSSM_BLOOD_SPLATTER, RenderFlags, 0);
@@ -479,7 +479,7 @@ void BSShaderAccumulator::FinishAccumulating_Unknown1(BSShaderAccumulator *Accum
 	if (!Accumulator->m_pkCamera)
 		return;
 
-	ZoneScopedN("FinishAccumulating_Unknown1");
+	ProfileZone("FinishAccumulating_Unknown1");
 	BSGraphics::BeginEvent(L"FinishAccumulating_Unknown1");
 
 	Accumulator->RenderGeometryGroup(1, BSSM_BLOOD_SPLATTER, RenderFlags, 14);
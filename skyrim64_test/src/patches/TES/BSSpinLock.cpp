@@ -1,4 +1,5 @@
 #include "../../common.h"
+#include "../../profiler_zone_categories.h"
 #include "BSSpinLock.h"
 
 BSSpinLock::~BSSpinLock()
@@ -18,6 +19,9 @@ void BSSpinLock::Acquire(int InitialAttempts)
 	// First test (no waits/pauses, fast path)
 	if (InterlockedCompareExchange(&m_LockCount, 1, 0) != 0)
 	{
+		Profiler::FlightRecorder::ScopedLockWait wait(this, m_OwningThread);
+		ProfileZoneCat(LOCKS, "BSSpinLock Wait");
+
 		uint32_t counter = 0;
 		bool locked = false;
 
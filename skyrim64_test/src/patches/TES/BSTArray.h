@@ -1,7 +1,25 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "MemoryManager.h"
+#include "BSTArraySearch.h"
 
+//
+// Allocator policies share one small interface used by BSTArray:
+//
+// QBuffer()/QAllocSize()                     - current storage and capacity (in elements)
+// Allocate(Count, ElementSize, Alignment)    - returns storage for Count elements, doesn't touch the current buffer
+// Deallocate(Buffer)                         - releases storage previously returned by Allocate()
+// SetBuffer(Buffer, Count)                   - installs new storage
+// QInlineBuffer()                            - true if the current storage can't be handed to another array
+// InlineBytes                                - size of the storage embedded in the array object, if any
+//
+// Everything goes through MemoryManager so the engine can free buffers that we allocated and vice versa.
+//
 class BSTArrayHeapAllocator
 {
 	friend class __BSTArrayCheckOffsets;
@@ -11,6 +29,8 @@ private:
 	uint32_t m_AllocSize;
 
 public:
+	constexpr static uint32_t InlineBytes = 0;
+
 	BSTArrayHeapAllocator() : m_Buffer(nullptr), m_AllocSize(0)
 	{
 	}
@@ -24,6 +44,107 @@ public:
 	{
 		return m_AllocSize;
 	}
+
+	bool QInlineBuffer() const
+	{
+		return false;
+	}
+
+protected:
+	void *Allocate(uint32_t Count, uint32_t ElementSize, uint32_t Alignment)
+	{
+		return MemoryManager::Allocate(nullptr, (size_t)Count * ElementSize, Alignment, true);
+	}
+
+	void Deallocate(void *Buffer)
+	{
+		if (Buffer)
+			MemoryManager::Deallocate(nullptr, Buffer, true);
+	}
+
+	void SetBuffer(void *Buffer, uint32_t Count)
+	{
+		m_Buffer = Buffer;
+		m_AllocSize = Count;
+	}
+};
+
+//
+// Same layout as the engine's BSTSmallArrayHeapAllocator: up to LocalSize bytes are stored inside the array object
+// itself and the heap is only touched once the array outgrows that.
+//
+template<uint32_t LocalSize>
+class BSTSmallArrayHeapAllocator
+{
+	friend class __BSTArrayCheckOffsets;
+
+	static_assert(LocalSize >= sizeof(void *), "Inline storage must be able to hold at least the heap pointer");
+
+private:
+	uint32_t m_AllocSize : 31;
+	uint32_t m_Local : 1;
+
+	union
+	{
+		void *m_Buffer;
+		char m_Data[LocalSize];
+	};
+
+public:
+	constexpr static uint32_t InlineBytes = LocalSize;
+
+	BSTSmallArrayHeapAllocator() : m_AllocSize(0), m_Local(0), m_Buffer(nullptr)
+	{
+	}
+
+	void *QBuffer() const
+	{
+		return m_Local ? (void *)&m_Data[0] : m_Buffer;
+	}
+
+	uint32_t QAllocSize() const
+	{
+		return m_AllocSize;
+	}
+
+	bool QInlineBuffer() const
+	{
+		return m_Local != 0;
+	}
+
+protected:
+	void *Allocate(uint32_t Count, uint32_t ElementSize, uint32_t Alignment)
+	{
+		//
+		// The inline buffer is only handed out while it's unused. m_Buffer shares the same bytes, but BSTArray
+		// grabs the old pointer before writing anything to the new storage.
+		//
+		if (!m_Local && ((size_t)Count * ElementSize) <= LocalSize && Alignment <= alignof(void *))
+			return &m_Data[0];
+
+		return MemoryManager::Allocate(nullptr, (size_t)Count * ElementSize, Alignment, true);
+	}
+
+	void Deallocate(void *Buffer)
+	{
+		if (Buffer && Buffer != &m_Data[0])
+			MemoryManager::Deallocate(nullptr, Buffer, true);
+	}
+
+	void SetBuffer(void *Buffer, uint32_t Count)
+	{
+		if (Buffer == &m_Data[0])
+		{
+			m_Local = 1;
+		}
+		else
+		{
+			m_Local = 0;
+			m_Buffer = Buffer;
+		}
+
+		m_AllocSize = Count;
+	}
 };
 
 class BSTArrayBase
@@ -47,6 +168,12 @@ public:
 	{
 		return m_Size == 0;
 	}
+
+protected:
+	void SetSize(uint32_t Size)
+	{
+		m_Size = Size;
+	}
 };
 
 template <class _Ty, class _Alloc = BSTArrayHeapAllocator>
@@ -59,12 +186,26 @@ public:
 	using allocator_type = _Alloc;
 	using reference = _Ty&;
 	using const_reference = const _Ty&;
+	using pointer = _Ty *;
+	using const_pointer = const _Ty *;
+	using iterator = _Ty *;
+	using const_iterator = const _Ty *;
 	using size_type = uint32_t;
 
+	constexpr static size_type npos = 0xFFFFFFFF;
+
 	BSTArray()
 	{
 	}
 
+	//
+	// Engine objects embed this type directly, so it never frees anything when it goes away and can't be copied or
+	// moved: either would free or relocate storage the engine still owns. Use BSTOwnedArray for arrays this DLL
+	// creates itself.
+	//
+	BSTArray(const BSTArray&) = delete;
+	BSTArray& operator=(const BSTArray&) = delete;
+
 	reference operator[](const size_type Pos)
 	{
 		return (this->_Myfirst()[Pos]);
@@ -88,7 +229,7 @@ public:
 
 		return (this->_Myfirst()[Pos]);
 	}
-	
+
 	reference front()
 	{
 		return (*this->_Myfirst());
@@ -109,18 +250,478 @@ public:
 		return (this->_Mylast()[-1]);
 	}
 
+	pointer data()
+	{
+		return _Myfirst();
+	}
+
+	const_pointer data() const
+	{
+		return _Myfirst();
+	}
+
+	iterator begin()
+	{
+		return _Myfirst();
+	}
+
+	const_iterator begin() const
+	{
+		return _Myfirst();
+	}
+
+	iterator end()
+	{
+		return _Mylast();
+	}
+
+	const_iterator end() const
+	{
+		return _Mylast();
+	}
+
+	size_type size() const
+	{
+		return QSize();
+	}
+
+	size_type capacity() const
+	{
+		return _Alloc::QAllocSize();
+	}
+
+	bool empty() const
+	{
+		return QEmpty();
+	}
+
+	void reserve(size_type Count)
+	{
+		if (Count > capacity())
+			Reallocate(Count);
+	}
+
+	void shrink_to_fit()
+	{
+		// Inline storage is already as small as it gets
+		if (QSize() < capacity() && !_Alloc::QInlineBuffer())
+			Reallocate(QSize());
+	}
+
+	void clear()
+	{
+		Destroy(_Myfirst(), QSize());
+		SetSize(0);
+	}
+
+	void resize(size_type Count)
+	{
+		ResizeImpl(Count);
+	}
+
+	void resize(size_type Count, const_reference Value)
+	{
+		ResizeImpl(Count, Value);
+	}
+
+	void push_back(const_reference Value)
+	{
+		emplace_back(Value);
+	}
+
+	void push_back(_Ty&& Value)
+	{
+		emplace_back(std::move(Value));
+	}
+
+	template<typename... Args>
+	reference emplace_back(Args&&... Arguments)
+	{
+		const size_type size = QSize();
+
+		if (size < capacity())
+		{
+			new (&_Myfirst()[size]) _Ty(std::forward<Args>(Arguments)...);
+		}
+		else
+		{
+			//
+			// Construct the new element before relocating anything. The arguments are allowed to reference
+			// elements of this array (push_back(Array[0])) and those die with the old buffer.
+			//
+			const size_type newCapacity = GrowCapacity(size + 1);
+			_Ty *oldBuffer = _Myfirst();
+			_Ty *newBuffer = AllocateBuffer(newCapacity);
+
+			new (&newBuffer[size]) _Ty(std::forward<Args>(Arguments)...);
+			ReplaceBuffer(oldBuffer, newBuffer, newCapacity);
+		}
+
+		SetSize(size + 1);
+		return back();
+	}
+
+	void pop_back()
+	{
+		AssertMsg(!QEmpty(), "pop_back() on an empty array");
+
+		SetSize(QSize() - 1);
+		_Mylast()->~_Ty();
+	}
+
+	template<typename... Args>
+	reference emplace(size_type Pos, Args&&... Arguments)
+	{
+		AssertMsg(Pos <= QSize(), "Exceeded array bounds");
+
+		if (Pos == QSize())
+			return emplace_back(std::forward<Args>(Arguments)...);
+
+		// Build the value first so inserting an element of this array into itself is safe
+		_Ty temp(std::forward<Args>(Arguments)...);
+
+		if (QSize() == capacity())
+			Reallocate(GrowCapacity(QSize() + 1));
+
+		_Ty *data = _Myfirst();
+		const size_type size = QSize();
+
+		new (&data[size]) _Ty(std::move(data[size - 1]));
+		MoveBackward(&data[Pos], &data[size - 1], &data[size]);
+
+		data[Pos] = std::move(temp);
+		SetSize(size + 1);
+
+		return data[Pos];
+	}
+
+	void insert(size_type Pos, const_reference Value)
+	{
+		emplace(Pos, Value);
+	}
+
+	void insert(size_type Pos, _Ty&& Value)
+	{
+		emplace(Pos, std::move(Value));
+	}
+
+	void erase(size_type Pos)
+	{
+		erase(Pos, Pos + 1);
+	}
+
+	// Removes [First, Last) and keeps the order of the remaining elements
+	void erase(size_type First, size_type Last)
+	{
+		AssertMsg(First <= Last && Last <= QSize(), "Exceeded array bounds");
+
+		if (First == Last)
+			return;
+
+		_Ty *data = _Myfirst();
+		const size_type size = QSize();
+
+		for (size_type i = Last; i < size; i++)
+			data[First + (i - Last)] = std::move(data[i]);
+
+		Destroy(&data[size - (Last - First)], Last - First);
+		SetSize(size - (Last - First));
+	}
+
+	// Returns the index of the first element equal to Value at or after StartIndex, or npos
+	size_type find(const_reference Value, size_type StartIndex = 0) const
+	{
+		if (StartIndex >= QSize())
+			return npos;
+
+		if constexpr (BSTArraySearch::IsSupportedType<_Ty>)
+		{
+			size_type index = BSTArraySearch::Find(&_Myfirst()[StartIndex], QSize() - StartIndex, Value);
+
+			return (index != BSTArraySearch::NotFound) ? StartIndex + index : npos;
+		}
+		else
+		{
+			for (size_type i = StartIndex; i < QSize(); i++)
+			{
+				if (_Myfirst()[i] == Value)
+					return i;
+			}
+
+			return npos;
+		}
+	}
+
+	size_type count(const_reference Value) const
+	{
+		if constexpr (BSTArraySearch::IsSupportedType<_Ty>)
+		{
+			return BSTArraySearch::Count(_Myfirst(), QSize(), Value);
+		}
+		else
+		{
+			size_type count = 0;
+
+			for (size_type i = 0; i < QSize(); i++)
+			{
+				if (_Myfirst()[i] == Value)
+					count++;
+			}
+
+			return count;
+		}
+	}
+
+	bool contains(const_reference Value) const
+	{
+		return find(Value) != npos;
+	}
+
+	// Removes one element by swapping the last element into its place. O(1), doesn't keep order.
+	void erase_unordered(size_type Pos)
+	{
+		AssertMsg(Pos < QSize(), "Exceeded array bounds");
+
+		if (Pos != QSize() - 1)
+			_Myfirst()[Pos] = std::move(back());
+
+		pop_back();
+	}
+
+protected:
+	void CopyFrom(const BSTArray& Other)
+	{
+		clear();
+		reserve(Other.QSize());
+		CopyConstruct(_Myfirst(), Other._Myfirst(), Other.QSize());
+		SetSize(Other.QSize());
+	}
+
+	void MoveFrom(BSTArray&& Other)
+	{
+		clear();
+
+		// Only heap buffers can be stolen, inline storage has to be moved element by element
+		if (!Other.QInlineBuffer() && !_Alloc::QInlineBuffer())
+		{
+			_Alloc::Deallocate(_Alloc::QBuffer());
+			_Alloc::SetBuffer(Other.QBuffer(), Other.QAllocSize());
+			SetSize(Other.QSize());
+
+			Other.SetBuffer(nullptr, 0);
+			Other.SetSize(0);
+		}
+		else
+		{
+			reserve(Other.QSize());
+			Relocate(_Myfirst(), Other._Myfirst(), Other.QSize());
+			SetSize(Other.QSize());
+
+			Other.SetSize(0);
+		}
+	}
+
+	void Free()
+	{
+		clear();
+		_Alloc::Deallocate(_Alloc::QBuffer());
+		_Alloc::SetBuffer(nullptr, 0);
+	}
+
 private:
+	constexpr static bool RelocateWithMemcpy = std::is_trivially_copyable_v<_Ty>;
+
 	_Ty *_Myfirst()
 	{
 		return (_Ty *)_Alloc::QBuffer();
 	}
 
+	const _Ty *_Myfirst() const
+	{
+		return (const _Ty *)_Alloc::QBuffer();
+	}
+
 	_Ty *_Mylast()
 	{
 		return ((_Ty *)_Alloc::QBuffer()) + QSize();
 	}
+
+	const _Ty *_Mylast() const
+	{
+		return ((const _Ty *)_Alloc::QBuffer()) + QSize();
+	}
+
+	size_type GrowCapacity(size_type Required) const
+	{
+		// Fill the inline buffer before going to the heap
+		if (capacity() == 0 && (Required * sizeof(_Ty)) <= _Alloc::InlineBytes)
+			return _Alloc::InlineBytes / sizeof(_Ty);
+
+		// Geometric growth keeps push_back amortized O(1)
+		size_type newCapacity = capacity() + (capacity() / 2);
+
+		if (newCapacity < 4)
+			newCapacity = 4;
+
+		return (newCapacity < Required) ? Required : newCapacity;
+	}
+
+	_Ty *AllocateBuffer(size_type Count)
+	{
+		constexpr uint32_t alignment = (alignof(_Ty) > 4) ? alignof(_Ty) : 4;
+
+		return (_Ty *)_Alloc::Allocate(Count, sizeof(_Ty), alignment);
+	}
+
+	void Reallocate(size_type Count)
+	{
+		_Ty *oldBuffer = _Myfirst();
+
+		ReplaceBuffer(oldBuffer, (Count > 0) ? AllocateBuffer(Count) : nullptr, Count);
+	}
+
+	//
+	// Moves the current elements into NewBuffer, releases the old buffer, and installs the new one. OldBuffer must be
+	// read before NewBuffer is written to: with inline storage the heap pointer and the inline bytes share memory.
+	//
+	void ReplaceBuffer(_Ty *OldBuffer, _Ty *NewBuffer, size_type NewCapacity)
+	{
+		if (OldBuffer != NewBuffer)
+		{
+			Relocate(NewBuffer, OldBuffer, QSize());
+			_Alloc::Deallocate(OldBuffer);
+		}
+
+		_Alloc::SetBuffer(NewBuffer, NewCapacity);
+	}
+
+	template<typename... Args>
+	void ResizeImpl(size_type Count, const Args&... Value)
+	{
+		const size_type size = QSize();
+
+		if (Count < size)
+		{
+			Destroy(&_Myfirst()[Count], size - Count);
+		}
+		else if (Count > size)
+		{
+			reserve(Count);
+
+			for (size_type i = size; i < Count; i++)
+				new (&_Myfirst()[i]) _Ty(Value...);
+		}
+
+		SetSize(Count);
+	}
+
+	static void Relocate(_Ty *Dest, _Ty *Source, size_type Count)
+	{
+		if constexpr (RelocateWithMemcpy)
+		{
+			if (Count > 0)
+				memcpy(Dest, Source, sizeof(_Ty) * Count);
+		}
+		else
+		{
+			for (size_type i = 0; i < Count; i++)
+			{
+				new (&Dest[i]) _Ty(std::move_if_noexcept(Source[i]));
+				Source[i].~_Ty();
+			}
+		}
+	}
+
+	static void MoveBackward(_Ty *First, _Ty *Last, _Ty *DestLast)
+	{
+		if constexpr (RelocateWithMemcpy)
+		{
+			memmove(DestLast - (Last - First), First, sizeof(_Ty) * (Last - First));
+		}
+		else
+		{
+			while (First != Last)
+				*(--DestLast) = std::move(*(--Last));
+		}
+	}
+
+	static void CopyConstruct(_Ty *Dest, const _Ty *Source, size_type Count)
+	{
+		if constexpr (RelocateWithMemcpy)
+		{
+			if (Count > 0)
+				memcpy(Dest, Source, sizeof(_Ty) * Count);
+		}
+		else
+		{
+			for (size_type i = 0; i < Count; i++)
+				new (&Dest[i]) _Ty(Source[i]);
+		}
+	}
+
+	static void Destroy(_Ty *First, size_type Count)
+	{
+		if constexpr (!std::is_trivially_destructible_v<_Ty>)
+		{
+			for (size_type i = 0; i < Count; i++)
+				First[i].~_Ty();
+		}
+	}
 };
 
+//
+// BSTArray that owns its elements and storage: destroys and frees them when it goes away, and copies or moves like
+// std::vector. Storage still comes from MemoryManager. Never use this for a member of an engine object.
+//
+template <class _Ty, class _Alloc = BSTArrayHeapAllocator>
+class BSTOwnedArray : public BSTArray<_Ty, _Alloc>
+{
+public:
+	BSTOwnedArray()
+	{
+	}
+
+	BSTOwnedArray(const BSTOwnedArray& Other)
+	{
+		this->CopyFrom(Other);
+	}
+
+	BSTOwnedArray(BSTOwnedArray&& Other) noexcept
+	{
+		this->MoveFrom(std::move(Other));
+	}
+
+	~BSTOwnedArray()
+	{
+		this->Free();
+	}
+
+	BSTOwnedArray& operator=(const BSTOwnedArray& Other)
+	{
+		if (this != &Other)
+			this->CopyFrom(Other);
+
+		return *this;
+	}
+
+	BSTOwnedArray& operator=(BSTOwnedArray&& Other) noexcept
+	{
+		if (this != &Other)
+			this->MoveFrom(std::move(Other));
+
+		return *this;
+	}
+};
+
+template<class _Ty, uint32_t LocalCount>
+using BSTSmallArrayAllocatorFor = BSTSmallArrayHeapAllocator<(sizeof(_Ty) * LocalCount > sizeof(void *)) ? sizeof(_Ty) * LocalCount : sizeof(void *)>;
+
+template<class _Ty, uint32_t LocalCount = 1>
+using BSTSmallArray = BSTArray<_Ty, BSTSmallArrayAllocatorFor<_Ty, LocalCount>>;
+
+template<class _Ty, uint32_t LocalCount = 1>
+using BSTOwnedSmallArray = BSTOwnedArray<_Ty, BSTSmallArrayAllocatorFor<_Ty, LocalCount>>;
+
 class __BSTArrayCheckOffsets
 {
 	static_assert_offset(BSTArrayHeapAllocator, m_Buffer, 0x0);
@@ -131,4 +732,11 @@ class __BSTArrayCheckOffsets
 	static_assert_offset(BSTArray<int>, m_Buffer, 0x0);
 	static_assert_offset(BSTArray<int>, m_AllocSize, 0x8);
 	static_assert_offset(BSTArray<int>, m_Size, 0x10);
-};
\ No newline at end of file
+
+	static_assert_offset(BSTSmallArrayHeapAllocator<8>, m_Buffer, 0x8);
+	static_assert_offset(BSTSmallArrayHeapAllocator<8>, m_Data, 0x8);
+
+	// Mirrors must stay trivially destructible and non-copyable, see BSTArray
+	static_assert(std::is_trivially_destructible_v<BSTArray<int>> && !std::is_copy_constructible_v<BSTArray<int>>);
+	static_assert(std::is_trivially_destructible_v<BSTSmallArray<int, 4>> && !std::is_move_constructible_v<BSTSmallArray<int, 4>>);
+};
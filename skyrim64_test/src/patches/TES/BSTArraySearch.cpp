@@ -0,0 +1,210 @@
+#include "BSTArraySearchKernels.h"
+
+namespace BSTArraySearch
+{
+	struct IsaSSE2
+	{
+		using Vec = __m128i;
+		constexpr static uint32_t Bytes = 16;
+
+		static Vec Load(const void *Data)
+		{
+			return _mm_loadu_si128((const __m128i *)Data);
+		}
+
+		static Vec Set1(uint32_t Value)
+		{
+			return _mm_set1_epi32(Value);
+		}
+
+		static Vec Set1(uint64_t Value)
+		{
+			return _mm_set1_epi64x(Value);
+		}
+
+		template<typename T>
+		static uint32_t Match(Vec A, Vec B)
+		{
+			if constexpr (sizeof(T) == 4)
+				return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(A, B)));
+
+			// No 64-bit compare until SSE4.1: both 32-bit halves must match
+			__m128i cmp = _mm_cmpeq_epi32(A, B);
+			cmp = _mm_and_si128(cmp, _mm_shuffle_epi32(cmp, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			return _mm_movemask_pd(_mm_castsi128_pd(cmp));
+		}
+
+		static uint32_t Popcount(uint64_t Mask)
+		{
+			// POPCNT isn't guaranteed on CPUs that end up here
+			uint32_t count = 0;
+
+			for (; Mask != 0; Mask &= Mask - 1)
+				count++;
+
+			return count;
+		}
+	};
+
+	struct IsaSSE41 : IsaSSE2
+	{
+		template<typename T>
+		static uint32_t Match(Vec A, Vec B)
+		{
+			if constexpr (sizeof(T) == 4)
+				return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(A, B)));
+
+			return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(A, B)));
+		}
+	};
+
+	enum class Kernel
+	{
+		SSE2,
+		SSE41,
+		AVX2,
+		AVX512,
+	};
+
+	Kernel DetectKernel()
+	{
+		int cpuinfo[4];
+		__cpuid(cpuinfo, 0);
+
+		const int maxLeaf = cpuinfo[0];
+
+		__cpuid(cpuinfo, 1);
+
+		const bool hasSSE41 = (cpuinfo[2] & (1 << 19)) != 0;
+		const bool hasOSXSAVE = (cpuinfo[2] & (1 << 27)) != 0;
+		const bool hasAVX = (cpuinfo[2] & (1 << 28)) != 0;
+
+		bool hasAVX2 = false;
+		bool hasAVX512F = false;
+
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(cpuinfo, 7, 0);
+
+			hasAVX2 = (cpuinfo[1] & (1 << 5)) != 0;
+			hasAVX512F = (cpuinfo[1] & (1 << 16)) != 0;
+		}
+
+		// The OS also has to save the wider registers on context switches (XCR0: SSE/AVX, then opmask/ZMM)
+		const uint64_t xcr0 = hasOSXSAVE ? _xgetbv(0) : 0;
+
+		if (hasAVX512F && (xcr0 & 0xE6) == 0xE6)
+			return Kernel::AVX512;
+
+		if (hasAVX2 && hasAVX && (xcr0 & 0x6) == 0x6)
+			return Kernel::AVX2;
+
+		if (hasSSE41)
+			return Kernel::SSE41;
+
+		return Kernel::SSE2;
+	}
+
+	const KernelSet KernelsSSE2 =
+	{
+		"SSE2",
+		&FindKernel<IsaSSE2, uint32_t>,
+		&FindKernel<IsaSSE2, uint64_t>,
+		&CountKernel<IsaSSE2, uint32_t>,
+		&CountKernel<IsaSSE2, uint64_t>,
+	};
+
+	const KernelSet KernelsSSE41 =
+	{
+		"SSE4.1",
+		&FindKernel<IsaSSE41, uint32_t>,
+		&FindKernel<IsaSSE41, uint64_t>,
+		&CountKernel<IsaSSE41, uint32_t>,
+		&CountKernel<IsaSSE41, uint64_t>,
+	};
+
+	Kernel GetSupportedKernel()
+	{
+		// Function local static initialization is thread safe
+		static const Kernel supported = DetectKernel();
+		return supported;
+	}
+
+	bool IsSupported(const KernelSet& Kernels)
+	{
+		const Kernel supported = GetSupportedKernel();
+
+		if (&Kernels == &KernelsAVX512)
+			return supported >= Kernel::AVX512;
+
+		if (&Kernels == &KernelsAVX2)
+			return supported >= Kernel::AVX2;
+
+		if (&Kernels == &KernelsSSE41)
+			return supported >= Kernel::SSE41;
+
+		return true;
+	}
+
+	const KernelSet& GetBestKernels()
+	{
+		switch (GetSupportedKernel())
+		{
+		case Kernel::AVX512: return KernelsAVX512;
+		case Kernel::AVX2: return KernelsAVX2;
+		case Kernel::SSE41: return KernelsSSE41;
+		}
+
+		return KernelsSSE2;
+	}
+
+	void SelectKernels()
+	{
+		// Any number of threads can get here at once. They all store the same pointers.
+		const KernelSet& best = GetBestKernels();
+
+		Find32.store(best.Find32, std::memory_order_relaxed);
+		Find64.store(best.Find64, std::memory_order_relaxed);
+		Count32.store(best.Count32, std::memory_order_relaxed);
+		Count64.store(best.Count64, std::memory_order_relaxed);
+	}
+
+	//
+	// The pointers start out at resolver stubs so they're usable during static initialization of other translation
+	// units. The first call through any of them patches all four.
+	//
+	uint32_t ResolveFind32(const uint32_t *Data, uint32_t Count, uint32_t Value)
+	{
+		SelectKernels();
+		return GetBestKernels().Find32(Data, Count, Value);
+	}
+
+	uint32_t ResolveFind64(const uint64_t *Data, uint32_t Count, uint64_t Value)
+	{
+		SelectKernels();
+		return GetBestKernels().Find64(Data, Count, Value);
+	}
+
+	uint32_t ResolveCount32(const uint32_t *Data, uint32_t Count, uint32_t Value)
+	{
+		SelectKernels();
+		return GetBestKernels().Count32(Data, Count, Value);
+	}
+
+	uint32_t ResolveCount64(const uint64_t *Data, uint32_t Count, uint64_t Value)
+	{
+		SelectKernels();
+		return GetBestKernels().Count64(Data, Count, Value);
+	}
+
+	std::atomic<Find32Func> Find32 = &ResolveFind32;
+	std::atomic<Find64Func> Find64 = &ResolveFind64;
+	std::atomic<Count32Func> Count32 = &ResolveCount32;
+	std::atomic<Count64Func> Count64 = &ResolveCount64;
+
+	const char *GetKernelName()
+	{
+		return GetBestKernels().Name;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+//
+// Linear search kernels for arrays of 4 or 8 byte elements (form IDs, form/ref pointers, handles). The best
+// instruction set (SSE2, SSE4.1, AVX2, AVX-512) is picked on the first call. Results are element indices or
+// BSTArraySearch::NotFound.
+//
+// The AVX2 and AVX-512 kernels live in their own translation units so GCC and Clang builds can compile just those
+// with the wider instruction sets (see headless_tests).
+//
+namespace BSTArraySearch
+{
+	constexpr uint32_t NotFound = 0xFFFFFFFF;
+
+	using Find32Func = uint32_t(*)(const uint32_t *Data, uint32_t Count, uint32_t Value);
+	using Find64Func = uint32_t(*)(const uint64_t *Data, uint32_t Count, uint64_t Value);
+	using Count32Func = uint32_t(*)(const uint32_t *Data, uint32_t Count, uint32_t Value);
+	using Count64Func = uint32_t(*)(const uint64_t *Data, uint32_t Count, uint64_t Value);
+
+	// Written once when the kernels are picked, relaxed loads are plain moves
+	extern std::atomic<Find32Func> Find32;
+	extern std::atomic<Find64Func> Find64;
+	extern std::atomic<Count32Func> Count32;
+	extern std::atomic<Count64Func> Count64;
+
+	struct KernelSet
+	{
+		const char *Name;
+		Find32Func Find32;
+		Find64Func Find64;
+		Count32Func Count32;
+		Count64Func Count64;
+	};
+
+	// Every kernel set is always linked in. Tests and benchmarks call the ones the CPU supports directly.
+	extern const KernelSet KernelsSSE2;
+	extern const KernelSet KernelsSSE41;
+	extern const KernelSet KernelsAVX2;
+	extern const KernelSet KernelsAVX512;
+
+	bool IsSupported(const KernelSet& Kernels);
+	const char *GetKernelName();
+
+	// Plain bit-for-bit equality only. Floats are excluded on purpose (NaN != NaN, -0 == +0).
+	template<typename T>
+	constexpr bool IsSupportedType = (sizeof(T) == 4 || sizeof(T) == 8) &&
+		(std::is_integral_v<T> || std::is_pointer_v<T> || std::is_enum_v<T>);
+
+	template<typename T>
+	uint32_t Find(const T *Data, uint32_t Count, const T& Value)
+	{
+		static_assert(IsSupportedType<T>);
+
+		if constexpr (sizeof(T) == 4)
+		{
+			uint32_t value;
+			memcpy(&value, &Value, sizeof(T));
+
+			return Find32.load(std::memory_order_relaxed)(reinterpret_cast<const uint32_t *>(Data), Count, value);
+		}
+		else
+		{
+			uint64_t value;
+			memcpy(&value, &Value, sizeof(T));
+
+			return Find64.load(std::memory_order_relaxed)(reinterpret_cast<const uint64_t *>(Data), Count, value);
+		}
+	}
+
+	template<typename T>
+	uint32_t Count(const T *Data, uint32_t Count, const T& Value)
+	{
+		static_assert(IsSupportedType<T>);
+
+		if constexpr (sizeof(T) == 4)
+		{
+			uint32_t value;
+			memcpy(&value, &Value, sizeof(T));
+
+			return Count32.load(std::memory_order_relaxed)(reinterpret_cast<const uint32_t *>(Data), Count, value);
+		}
+		else
+		{
+			uint64_t value;
+			memcpy(&value, &Value, sizeof(T));
+
+			return Count64.load(std::memory_order_relaxed)(reinterpret_cast<const uint64_t *>(Data), Count, value);
+		}
+	}
+}
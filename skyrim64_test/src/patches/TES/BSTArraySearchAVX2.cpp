@@ -0,0 +1,48 @@
+#include "BSTArraySearchKernels.h"
+
+namespace BSTArraySearch
+{
+	struct IsaAVX2
+	{
+		using Vec = __m256i;
+		constexpr static uint32_t Bytes = 32;
+
+		static Vec Load(const void *Data)
+		{
+			return _mm256_loadu_si256((const __m256i *)Data);
+		}
+
+		static Vec Set1(uint32_t Value)
+		{
+			return _mm256_set1_epi32(Value);
+		}
+
+		static Vec Set1(uint64_t Value)
+		{
+			return _mm256_set1_epi64x(Value);
+		}
+
+		template<typename T>
+		static uint32_t Match(Vec A, Vec B)
+		{
+			if constexpr (sizeof(T) == 4)
+				return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(A, B)));
+
+			return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(A, B)));
+		}
+
+		static uint32_t Popcount(uint64_t Mask)
+		{
+			return (uint32_t)_mm_popcnt_u64(Mask);
+		}
+	};
+
+	const KernelSet KernelsAVX2 =
+	{
+		"AVX2",
+		&FindAVX<IsaAVX2, uint32_t>,
+		&FindAVX<IsaAVX2, uint64_t>,
+		&CountAVX<IsaAVX2, uint32_t>,
+		&CountAVX<IsaAVX2, uint64_t>,
+	};
+}
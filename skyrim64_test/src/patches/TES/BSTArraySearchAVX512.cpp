@@ -0,0 +1,48 @@
+#include "BSTArraySearchKernels.h"
+
+namespace BSTArraySearch
+{
+	struct IsaAVX512
+	{
+		using Vec = __m512i;
+		constexpr static uint32_t Bytes = 64;
+
+		static Vec Load(const void *Data)
+		{
+			return _mm512_loadu_si512(Data);
+		}
+
+		static Vec Set1(uint32_t Value)
+		{
+			return _mm512_set1_epi32(Value);
+		}
+
+		static Vec Set1(uint64_t Value)
+		{
+			return _mm512_set1_epi64(Value);
+		}
+
+		template<typename T>
+		static uint32_t Match(Vec A, Vec B)
+		{
+			if constexpr (sizeof(T) == 4)
+				return _mm512_cmpeq_epi32_mask(A, B);
+
+			return _mm512_cmpeq_epi64_mask(A, B);
+		}
+
+		static uint32_t Popcount(uint64_t Mask)
+		{
+			return (uint32_t)_mm_popcnt_u64(Mask);
+		}
+	};
+
+	const KernelSet KernelsAVX512 =
+	{
+		"AVX-512",
+		&FindAVX<IsaAVX512, uint32_t>,
+		&FindAVX<IsaAVX512, uint64_t>,
+		&CountAVX<IsaAVX512, uint32_t>,
+		&CountAVX<IsaAVX512, uint64_t>,
+	};
+}
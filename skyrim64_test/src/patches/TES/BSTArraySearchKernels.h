@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <intrin.h>
+#include <immintrin.h>
+#include "BSTArraySearch.h"
+
+namespace BSTArraySearch
+{
+	//
+	// Each instruction set provides Set1/Load/Match/Popcount. Match() returns one bit per element and the kernels
+	// below are shared. Four vectors are tested per loop iteration and OR'd into a single mask so the loop only has
+	// one (almost never taken) branch.
+	//
+	template<class Isa, typename T>
+	uint32_t FindKernel(const T *Data, uint32_t Count, T Value)
+	{
+		constexpr uint32_t lanes = Isa::Bytes / sizeof(T);
+		const auto target = Isa::Set1(Value);
+
+		uint32_t i = 0;
+
+		for (; i + (lanes * 4) <= Count; i += lanes * 4)
+		{
+			uint64_t mask =
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 0)])) << (lanes * 0)) |
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 1)])) << (lanes * 1)) |
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 2)])) << (lanes * 2)) |
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 3)])) << (lanes * 3));
+
+			if (mask != 0)
+			{
+				unsigned long index;
+				_BitScanForward64(&index, mask);
+
+				return i + index;
+			}
+		}
+
+		for (; i + lanes <= Count; i += lanes)
+		{
+			uint32_t mask = Isa::template Match<T>(target, Isa::Load(&Data[i]));
+
+			if (mask != 0)
+			{
+				unsigned long index;
+				_BitScanForward(&index, mask);
+
+				return i + index;
+			}
+		}
+
+		for (; i < Count; i++)
+		{
+			if (Data[i] == Value)
+				return i;
+		}
+
+		return NotFound;
+	}
+
+	template<class Isa, typename T>
+	uint32_t CountKernel(const T *Data, uint32_t Count, T Value)
+	{
+		constexpr uint32_t lanes = Isa::Bytes / sizeof(T);
+		const auto target = Isa::Set1(Value);
+
+		uint32_t i = 0;
+		uint32_t count = 0;
+
+		for (; i + (lanes * 4) <= Count; i += lanes * 4)
+		{
+			uint64_t mask =
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 0)])) << (lanes * 0)) |
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 1)])) << (lanes * 1)) |
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 2)])) << (lanes * 2)) |
+				((uint64_t)Isa::template Match<T>(target, Isa::Load(&Data[i + (lanes * 3)])) << (lanes * 3));
+
+			count += Isa::Popcount(mask);
+		}
+
+		for (; i < Count; i++)
+		{
+			if (Data[i] == Value)
+				count++;
+		}
+
+		return count;
+	}
+
+	// AVX kernels are only ever called through the dispatch pointers, so the upper register halves can be cleared on
+	// the way out
+	template<class Isa, typename T>
+	uint32_t FindAVX(const T *Data, uint32_t Count, T Value)
+	{
+		uint32_t result = FindKernel<Isa, T>(Data, Count, Value);
+		_mm256_zeroupper();
+
+		return result;
+	}
+
+	template<class Isa, typename T>
+	uint32_t CountAVX(const T *Data, uint32_t Count, T Value)
+	{
+		uint32_t result = CountKernel<Isa, T>(Data, Count, Value);
+		_mm256_zeroupper();
+
+		return result;
+	}
+}
@@ -1,27 +1,271 @@
 #pragma once
 
+#include <windows.h>
+#include <intrin.h>
+#include <stdint.h>
+
+//
+// Bounded multi-producer/multi-consumer ring buffers. Only use the member functions on queues that this DLL owns:
+// the engine's own implementation isn't known and may use these counters differently.
+//
+// The four counters are free-running sequence numbers (DPDK rte_ring style) and a cell index is (sequence & (Count - 1)):
+//
+// Producers claim cells by bumping uiQueueAlloced with a CAS, write the pointers, then publish them by moving
+// uiQueueEnd forward in claim order. Consumers do the same with uiQueueFetched and uiQueueStart. A cell is only
+// readable once its sequence number is below uiQueueEnd and only writable again once it's below uiQueueStart,
+// so every push/pop takes effect at a single point (the tail store) and batches are contiguous.
+//
 struct BSTLocklessQueue
 {
 	template<typename T, size_t Count, size_t Unknown>
 	struct PtrMultiProdCons
 	{
+		static_assert(Count > 0 && (Count & (Count - 1)) == 0, "Queue size must be a power of 2");
+
 		T *QueueA[Count];
-		volatile unsigned int uiQueueStart;		// Assumed
-		volatile unsigned int uiQueueFetched;	// Assumed
-		volatile unsigned int uiQueueEnd;		// Assumed
-		volatile unsigned int uiQueueAlloced;	// Assumed
+		volatile unsigned int uiQueueStart;		// Consumer tail (cells released back to producers)
+		volatile unsigned int uiQueueFetched;	// Consumer head (cells claimed by consumers)
+		volatile unsigned int uiQueueEnd;		// Producer tail (cells readable by consumers)
+		volatile unsigned int uiQueueAlloced;	// Producer head (cells claimed by producers)
+
+		PtrMultiProdCons() : uiQueueStart(0), uiQueueFetched(0), uiQueueEnd(0), uiQueueAlloced(0)
+		{
+		}
+
+		uint32_t QSize() const
+		{
+			// Approximate when other threads are active
+			return uiQueueEnd - uiQueueStart;
+		}
+
+		bool QEmpty() const
+		{
+			return QSize() == 0;
+		}
+
+		constexpr static uint32_t QCapacity()
+		{
+			return Count;
+		}
+
+		// Pushes up to ItemCount pointers. Returns the number pushed, or 0 if AllOrNothing and not all fit.
+		uint32_t TryPushBatch(T *const *Items, uint32_t ItemCount, bool AllOrNothing = false)
+		{
+			uint32_t head;
+			uint32_t count;
+
+			do
+			{
+				head = uiQueueAlloced;
+				count = Count + uiQueueStart - head;
+
+				if (count > ItemCount)
+					count = ItemCount;
+
+				if (count == 0 || (AllOrNothing && count != ItemCount))
+					return 0;
+			} while (InterlockedCompareExchange((volatile LONG *)&uiQueueAlloced, head + count, head) != (LONG)head);
+
+			for (uint32_t i = 0; i < count; i++)
+				QueueA[(head + i) & (Count - 1)] = Items[i];
+
+			Publish(uiQueueEnd, head, head + count);
+			return count;
+		}
+
+		// Pops up to MaxCount pointers. Returns the number popped, or 0 if AllOrNothing and fewer were available.
+		uint32_t TryPopBatch(T **Items, uint32_t MaxCount, bool AllOrNothing = false)
+		{
+			uint32_t head;
+			uint32_t count;
+
+			do
+			{
+				head = uiQueueFetched;
+				count = uiQueueEnd - head;
+
+				if (count > MaxCount)
+					count = MaxCount;
+
+				if (count == 0 || (AllOrNothing && count != MaxCount))
+					return 0;
+			} while (InterlockedCompareExchange((volatile LONG *)&uiQueueFetched, head + count, head) != (LONG)head);
+
+			for (uint32_t i = 0; i < count; i++)
+				Items[i] = QueueA[(head + i) & (Count - 1)];
+
+			Publish(uiQueueStart, head, head + count);
+			return count;
+		}
+
+		bool TryPush(T *Item)
+		{
+			return TryPushBatch(&Item, 1, true) == 1;
+		}
+
+		bool TryPop(T *&Item)
+		{
+			return TryPopBatch(&Item, 1, true) == 1;
+		}
+
+		// Blocks while the queue is full. Batches larger than the free space are pushed in several pieces.
+		void PushBatch(T *const *Items, uint32_t ItemCount)
+		{
+			while (ItemCount > 0)
+			{
+				uint32_t pushed = TryPushBatch(Items, ItemCount);
+
+				if (pushed == 0)
+				{
+					WaitForChange(uiQueueStart, [this](uint32_t Start) { return (uiQueueAlloced - Start) >= Count; });
+					continue;
+				}
+
+				Items += pushed;
+				ItemCount -= pushed;
+			}
+		}
+
+		// Blocks until at least one pointer is available
+		uint32_t PopBatch(T **Items, uint32_t MaxCount)
+		{
+			while (true)
+			{
+				if (uint32_t popped = TryPopBatch(Items, MaxCount); popped != 0)
+					return popped;
+
+				WaitForChange(uiQueueEnd, [this](uint32_t End) { return End == uiQueueFetched; });
+			}
+		}
+
+		void Push(T *Item)
+		{
+			PushBatch(&Item, 1);
+		}
+
+		T *Pop()
+		{
+			T *item;
+			PopBatch(&item, 1);
+
+			return item;
+		}
+
+	private:
+		//
+		// Sleeping threads across EVERY queue of this instantiation (same T/Count/Unknown). The queue layout mirrors
+		// the engine's so there's no room for a per-queue counter. A waiter on one queue makes publishes on all of
+		// its siblings issue a (spurious, cheap) WakeByAddressAll until it wakes up; nothing is ever missed.
+		//
+		inline static volatile LONG WaiterCount = 0;
+
+		static void Publish(volatile unsigned int& Tail, uint32_t Expected, uint32_t NewTail)
+		{
+			// Claims are published in order. Wait for threads that claimed earlier cells to finish their copies.
+			for (uint32_t spins = 0; Tail != Expected; spins++)
+			{
+				if (spins < 64)
+					_mm_pause();
+				else
+					SwitchToThread();
+			}
+
+			// Full barrier: the cell copies must be visible before the tail, and the tail must be visible before
+			// WaiterCount is checked
+			InterlockedExchange((volatile LONG *)&Tail, NewTail);
+
+			if (WaiterCount != 0)
+				WakeByAddressAll((PVOID)&Tail);
+		}
+
+		template<typename Func>
+		static void WaitForChange(volatile unsigned int& Counter, Func ShouldWait)
+		{
+			// Spin briefly before going to sleep in the kernel
+			for (uint32_t spins = 0; spins < 64; spins++)
+			{
+				if (!ShouldWait(Counter))
+					return;
+
+				_mm_pause();
+			}
+
+			InterlockedIncrement(&WaiterCount);
+
+			unsigned int observed = Counter;
+
+			if (ShouldWait(observed))
+				WaitOnAddress(&Counter, &observed, sizeof(observed), INFINITE);
+
+			InterlockedDecrement(&WaiterCount);
+		}
 	};
 
+	//
+	// Fixed pool of Count objects. Pointers to unused objects sit in Free and pointers to pending objects in
+	// Queued, so values are copied in and out while the queues themselves only move pointers.
+	//
 	template<typename QueueContainer, typename T, size_t Count, size_t Unknown>
 	struct ObjQueueBase
 	{
 		T ObjectA[Count];
 		QueueContainer Queued;
 		QueueContainer Free;
+
+		ObjQueueBase()
+		{
+			for (uint32_t i = 0; i < Count; i++)
+				Free.TryPush(&ObjectA[i]);
+		}
+
+		uint32_t QSize() const
+		{
+			return Queued.QSize();
+		}
+
+		bool TryPush(const T& Value)
+		{
+			T *object;
+
+			if (!Free.TryPop(object))
+				return false;
+
+			*object = Value;
+			Queued.Push(object);
+			return true;
+		}
+
+		bool TryPop(T& Value)
+		{
+			T *object;
+
+			if (!Queued.TryPop(object))
+				return false;
+
+			Value = *object;
+			Free.Push(object);
+			return true;
+		}
+
+		void Push(const T& Value)
+		{
+			T *object = Free.Pop();
+
+			*object = Value;
+			Queued.Push(object);
+		}
+
+		void Pop(T& Value)
+		{
+			T *object = Queued.Pop();
+
+			Value = *object;
+			Free.Push(object);
+		}
 	};
 
 	template<typename T, size_t Count, size_t Unknown>
 	struct ObjMultiProdCons : ObjQueueBase<PtrMultiProdCons<T, Count * 2, Unknown>, T, Count, Unknown>
 	{
 	};
-};
\ No newline at end of file
+};
@@ -1,128 +1,10 @@
 #pragma once
 
+#include "BSTScatterTableTraits.h"
+
 // Special thanks to himika (https://github.com/himika/libSkyrim/blob/2559175f7f30189b7d3681d01b3e055505c3e0d7/Skyrim/include/Skyrim/BSCore/BSTScatterTable.h)
 // for providing most of this (iterators) as a reference.
 
-template<typename Key, typename T>
-struct BSTScatterTableDefaultKVStorage
-{
-private:
-	Key m_Key;
-
-public:
-	T m_Value;
-
-	const Key& GetKey()
-	{
-		return m_Key;
-	}
-};
-
-template<typename Key, typename T, class Storage = BSTScatterTableDefaultKVStorage<Key, T>>
-struct BSTScatterTableEntry : public Storage
-{
-	using key_type = Key;
-	using value_type = T;
-
-	BSTScatterTableEntry *m_Next;
-
-	bool IsEmpty()
-	{
-		return m_Next == nullptr;
-	}
-};
-
-// struct BSTScatterTableHeapAllocator<
-//		struct BSTScatterTableEntry<unsigned int, class BSTArray<struct SetEventData, class BSTArrayHeapAllocator> const *, struct BSTScatterTableDefaultKVStorage>
-//		>
-template<typename T>
-struct BSTScatterTableHeapAllocator
-{
-	using value_type = typename T::value_type;
-	using pointer = typename T::value_type *;
-	using const_pointer = const typename T::value_type *;
-	using table_entry = T;
-
-	T *Allocate(size_t Count)
-	{
-		throw;
-	}
-};
-
-template<typename T, size_t MaxEntries>
-struct BSTFixedSizeScatterTableAllocator
-{
-	// Doesn't allow any kind of dynamic allocation
-	T m_StaticBuffer[MaxEntries];
-
-	T *Allocate(size_t Count)
-	{
-		if (Count > MaxEntries)
-			throw "FixedSizeScatterTableAllocator: Not enough static memory for map";
-
-		return m_StaticBuffer;
-	}
-};
-
-// struct BSTScatterTableDefaultHashPolicy<
-//		unsigned int
-//		>
-template<typename Key>
-struct BSTScatterTableDefaultHashPolicy
-{
-	size_t operator()(const Key& Value) const
-	{
-		return Value;
-	}
-};
-
-void CRC32_Lazy(int *out, int idIn);
-
-template<typename Key>
-struct BSTScatterTableCRCHashPolicy
-{
-	size_t operator()(const Key& Value) const
-	{
-		Key keyHash;
-		CRC32_Lazy((int *)&keyHash, Value);
-
-		return keyHash;
-	}
-};
-
-// struct BSTScatterTableTraits<
-//		unsigned int,
-//		class BSTArray<struct SetEventData, class BSTArrayHeapAllocator> const *,
-//		struct BSTScatterTableDefaultKVStorage,
-//		struct BSTScatterTableDefaultHashPolicy<unsigned int>,
-//		struct BSTScatterTableHeapAllocator<struct BSTScatterTableEntry<unsigned int, class BSTArray<struct SetEventData, class BSTArrayHeapAllocator> const *, struct BSTScatterTableDefaultKVStorage>>,
-//		8>
-template<
-	typename Key,
-	typename T,
-	class Storage = BSTScatterTableDefaultKVStorage<Key, T>,
-	class Hash = BSTScatterTableDefaultHashPolicy<Key>,
-	class Allocator = BSTScatterTableHeapAllocator<T>,
-	size_t InitialSize = 8
-	>
-struct BSTScatterTableTraits
-{
-	using key_type = Key;
-	using mapped_type = T;
-	using value_type = std::pair<Key, T>;
-	using size_type = size_t;
-	using difference_type = ptrdiff_t;
-	using hasher = Hash;
-	using key_equal = std::equal_to<Key>;
-	using allocator_type = Allocator;
-	using reference = value_type&;
-	using const_reference = const value_type&;
-	using pointer = typename Allocator::pointer;
-	using const_pointer = typename Allocator::const_pointer;
-
-	using table_entry = typename Allocator::table_entry;
-};
-
 template<class Traits>
 class BSTScatterTableKernel : public Traits, public Traits::hasher
 {
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <functional>
+#include "BSCRC32.h"
+
+//
+// Entry, allocator, hash and traits types shared by the engine's chained BSTScatterTable and the DLL-only
+// BSTSwissScatterTable. Kept apart from the engine layout mirror so the open addressing table builds off-target.
+//
+template<typename Key, typename T>
+struct BSTScatterTableDefaultKVStorage
+{
+private:
+	Key m_Key;
+
+public:
+	T m_Value;
+
+	const Key& GetKey()
+	{
+		return m_Key;
+	}
+};
+
+template<typename Key, typename T, class Storage = BSTScatterTableDefaultKVStorage<Key, T>>
+struct BSTScatterTableEntry : public Storage
+{
+	using key_type = Key;
+	using value_type = T;
+
+	BSTScatterTableEntry *m_Next;
+
+	bool IsEmpty()
+	{
+		return m_Next == nullptr;
+	}
+};
+
+// struct BSTScatterTableHeapAllocator<
+//		struct BSTScatterTableEntry<unsigned int, class BSTArray<struct SetEventData, class BSTArrayHeapAllocator> const *, struct BSTScatterTableDefaultKVStorage>
+//		>
+template<typename T>
+struct BSTScatterTableHeapAllocator
+{
+	using value_type = typename T::value_type;
+	using pointer = typename T::value_type *;
+	using const_pointer = const typename T::value_type *;
+	using table_entry = T;
+
+	T *Allocate(size_t Count)
+	{
+		throw;
+	}
+};
+
+template<typename T, size_t MaxEntries>
+struct BSTFixedSizeScatterTableAllocator
+{
+	// Doesn't allow any kind of dynamic allocation
+	T m_StaticBuffer[MaxEntries];
+
+	T *Allocate(size_t Count)
+	{
+		if (Count > MaxEntries)
+			throw "FixedSizeScatterTableAllocator: Not enough static memory for map";
+
+		return m_StaticBuffer;
+	}
+};
+
+// struct BSTScatterTableDefaultHashPolicy<
+//		unsigned int
+//		>
+template<typename Key>
+struct BSTScatterTableDefaultHashPolicy
+{
+	size_t operator()(const Key& Value) const
+	{
+		return Value;
+	}
+};
+
+void CRC32_Lazy(int *out, int idIn);
+
+template<typename Key>
+struct BSTScatterTableCRCHashPolicy
+{
+	static_assert(sizeof(Key) == sizeof(uint32_t), "Only 4-byte keys match the engine's CRC");
+
+	size_t operator()(const Key& Value) const
+	{
+		// Bit-identical to CRC32_Lazy() without the call into the EXE
+		return BSCRC32::Hash((uint32_t)Value);
+	}
+
+	void operator()(const Key *Values, size_t *Hashes, size_t Count) const
+	{
+		BSCRC32::HashBatch(reinterpret_cast<const uint32_t *>(Values), Hashes, Count);
+	}
+};
+
+// struct BSTScatterTableTraits<
+//		unsigned int,
+//		class BSTArray<struct SetEventData, class BSTArrayHeapAllocator> const *,
+//		struct BSTScatterTableDefaultKVStorage,
+//		struct BSTScatterTableDefaultHashPolicy<unsigned int>,
+//		struct BSTScatterTableHeapAllocator<struct BSTScatterTableEntry<unsigned int, class BSTArray<struct SetEventData, class BSTArrayHeapAllocator> const *, struct BSTScatterTableDefaultKVStorage>>,
+//		8>
+template<
+	typename Key,
+	typename T,
+	class Storage = BSTScatterTableDefaultKVStorage<Key, T>,
+	class Hash = BSTScatterTableDefaultHashPolicy<Key>,
+	class Allocator = BSTScatterTableHeapAllocator<T>,
+	size_t InitialSize = 8
+	>
+struct BSTScatterTableTraits
+{
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<Key, T>;
+	using size_type = size_t;
+	using difference_type = ptrdiff_t;
+	using hasher = Hash;
+	using key_equal = std::equal_to<Key>;
+	using allocator_type = Allocator;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using pointer = typename Allocator::pointer;
+	using const_pointer = typename Allocator::const_pointer;
+
+	using table_entry = typename Allocator::table_entry;
+};
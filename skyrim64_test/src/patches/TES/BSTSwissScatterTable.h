@@ -0,0 +1,517 @@
+#pragma once
+
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <emmintrin.h>
+#include <intrin.h>
+#include "BSTScatterTableTraits.h"
+#include "MemoryManager.h"
+
+//
+// Open addressing alternative to BSTScatterTableBase for tables that are owned by this DLL only. Anything shared with
+// the engine must keep the vanilla chained layout (BSTScatterTable).
+//
+// Layout is the same idea as Abseil's SwissTable: one control byte per slot holding either a state (empty/deleted)
+// or the low 7 bits of the key hash. Slots are split into 16-wide groups and a probe compares a whole group of control
+// bytes with a single SSE2 compare + movemask. Key compares only happen on tag matches (~1/128 false positive rate)
+// and no pointer is chased until the key itself is loaded.
+//
+// 16-byte groups are used on every CPU. SSE2 is baseline on x64 and a group already fills a quarter of a cache line,
+// so wider AVX2 groups only add tail waste on small tables.
+//
+template<typename Key, typename T>
+struct BSTSwissScatterTableEntry
+{
+	using key_type = Key;
+	using value_type = T;
+
+	Key m_Key;
+	T m_Value;
+
+	const Key& GetKey() const
+	{
+		return m_Key;
+	}
+};
+
+template<typename Entry>
+struct BSTScatterTableSwissAllocator
+{
+	using value_type = typename Entry::value_type;
+	using pointer = typename Entry::value_type *;
+	using const_pointer = const typename Entry::value_type *;
+	using table_entry = Entry;
+
+	constexpr static uint32_t GroupWidth = 16;
+
+	int8_t *m_Control = nullptr;	// Capacity bytes, 16 byte aligned
+	table_entry *m_Slots = nullptr;	// Capacity entries, directly after the control bytes
+	uint32_t m_Capacity = 0;		// Power of 2, multiple of GroupWidth
+
+	// Both arrays come from a single allocation so a rehash is one alloc/free pair
+	void Allocate(uint32_t Capacity)
+	{
+		size_t controlSize = (Capacity + 63) & ~63ull;
+		size_t totalSize = controlSize + (sizeof(table_entry) * Capacity);
+
+		m_Control = (int8_t *)MemoryManager::Allocate(nullptr, totalSize, 64, true);
+		m_Slots = (table_entry *)(m_Control + controlSize);
+		m_Capacity = Capacity;
+	}
+
+	void Deallocate()
+	{
+		if (m_Control)
+			MemoryManager::Deallocate(nullptr, m_Control, true);
+
+		m_Control = nullptr;
+		m_Slots = nullptr;
+		m_Capacity = 0;
+	}
+};
+
+template<class Traits>
+class BSTSwissScatterTableBase : public Traits, public Traits::hasher, public Traits::allocator_type
+{
+protected:
+	using allocator = typename Traits::allocator_type;
+	using key_type = typename Traits::key_type;
+	using mapped_type = typename Traits::mapped_type;
+	using hasher = typename Traits::hasher;
+	using table_entry = typename Traits::table_entry;
+
+	constexpr static uint32_t GroupWidth = allocator::GroupWidth;
+	constexpr static uint32_t MinimumCapacity = 16;
+
+	// Anything >= 0 is a full slot (7-bit hash tag). Both states have the sign bit set.
+	constexpr static int8_t CtrlEmpty = -128;
+	constexpr static int8_t CtrlDeleted = -2;
+
+	uint32_t m_Size = 0;		// Live entries
+	uint32_t m_GrowthLeft = 0;	// Inserts into empty slots left before a rehash (7/8 max load)
+
+public:
+	BSTSwissScatterTableBase()
+	{
+		static_assert(std::is_trivially_copyable_v<key_type>, "Keys are moved around with memcpy semantics");
+	}
+
+	BSTSwissScatterTableBase(const BSTSwissScatterTableBase&) = delete;
+	BSTSwissScatterTableBase& operator=(const BSTSwissScatterTableBase&) = delete;
+
+	~BSTSwissScatterTableBase()
+	{
+		clear();
+		allocator::Deallocate();
+	}
+
+	class const_iterator
+	{
+		friend class BSTSwissScatterTableBase;
+
+	private:
+		const BSTSwissScatterTableBase *m_Table;
+		uint32_t m_Index;
+
+		const_iterator(const BSTSwissScatterTableBase *Table, uint32_t Index) : m_Table(Table), m_Index(Index)
+		{
+			SkipEmpty();
+		}
+
+		void SkipEmpty()
+		{
+			while (m_Index < m_Table->m_Capacity && m_Table->m_Control[m_Index] < 0)
+				m_Index++;
+		}
+
+	public:
+		const_iterator& operator++()
+		{
+			m_Index++;
+			SkipEmpty();
+
+			return *this;
+		}
+
+		const key_type& key() const
+		{
+			return m_Table->m_Slots[m_Index].GetKey();
+		}
+
+		const mapped_type& operator*() const
+		{
+			return m_Table->m_Slots[m_Index].m_Value;
+		}
+
+		const mapped_type *operator->() const
+		{
+			return &m_Table->m_Slots[m_Index].m_Value;
+		}
+
+		bool operator==(const const_iterator& Rhs) const
+		{
+			return m_Index == Rhs.m_Index;
+		}
+
+		bool operator!=(const const_iterator& Rhs) const
+		{
+			return m_Index != Rhs.m_Index;
+		}
+	};
+
+	const_iterator begin() const noexcept
+	{
+		return const_iterator(this, 0);
+	}
+
+	const_iterator end() const noexcept
+	{
+		return const_iterator(this, allocator::m_Capacity);
+	}
+
+	uint32_t size() const
+	{
+		return m_Size;
+	}
+
+	bool empty() const
+	{
+		return m_Size == 0;
+	}
+
+	uint32_t capacity() const
+	{
+		return allocator::m_Capacity;
+	}
+
+	const_iterator find(const key_type& Key) const
+	{
+		uint32_t index = FindIndex(Key, Hash(Key));
+
+		if (index == UINT32_MAX)
+			return end();
+
+		return const_iterator(this, index);
+	}
+
+	bool get(const key_type& Key, mapped_type& Out) const
+	{
+		uint32_t index = FindIndex(Key, Hash(Key));
+
+		if (index == UINT32_MAX)
+			return false;
+
+		Out = allocator::m_Slots[index].m_Value;
+		return true;
+	}
+
+	mapped_type get(const key_type& Key) const
+	{
+		// Return a default-constructed T if not found
+		mapped_type temp = mapped_type();
+
+		get(Key, temp);
+		return temp;
+	}
+
+	mapped_type *lookup(const key_type& Key)
+	{
+		uint32_t index = FindIndex(Key, Hash(Key));
+
+		if (index == UINT32_MAX)
+			return nullptr;
+
+		return &allocator::m_Slots[index].m_Value;
+	}
+
+	bool contains(const key_type& Key) const
+	{
+		return FindIndex(Key, Hash(Key)) != UINT32_MAX;
+	}
+
+	// Returns false (and leaves the old value alone) if the key already exists
+	bool insert(const key_type& Key, const mapped_type& Value)
+	{
+		return Emplace(Key, Value, false);
+	}
+
+	bool insert(const key_type& Key, mapped_type&& Value)
+	{
+		return Emplace(Key, std::move(Value), false);
+	}
+
+	// Returns true if a new entry was created
+	bool insert_or_assign(const key_type& Key, const mapped_type& Value)
+	{
+		return Emplace(Key, Value, true);
+	}
+
+	bool insert_or_assign(const key_type& Key, mapped_type&& Value)
+	{
+		return Emplace(Key, std::move(Value), true);
+	}
+
+	bool erase(const key_type& Key)
+	{
+		uint32_t index = FindIndex(Key, Hash(Key));
+
+		if (index == UINT32_MAX)
+			return false;
+
+		EraseIndex(index);
+		return true;
+	}
+
+	bool erase(const key_type& Key, mapped_type& Out)
+	{
+		uint32_t index = FindIndex(Key, Hash(Key));
+
+		if (index == UINT32_MAX)
+			return false;
+
+		Out = std::move(allocator::m_Slots[index].m_Value);
+		EraseIndex(index);
+		return true;
+	}
+
+	void clear()
+	{
+		if (!allocator::m_Control)
+			return;
+
+		for (uint32_t i = 0; i < allocator::m_Capacity; i++)
+		{
+			if (allocator::m_Control[i] >= 0)
+				allocator::m_Slots[i].~table_entry();
+		}
+
+		memset(allocator::m_Control, CtrlEmpty, allocator::m_Capacity);
+		m_Size = 0;
+		m_GrowthLeft = MaxLoad(allocator::m_Capacity);
+	}
+
+	void reserve(uint32_t Count)
+	{
+		uint32_t capacity = MinimumCapacity;
+
+		// Smallest power of 2 that keeps Count under the max load factor
+		while (MaxLoad(capacity) < Count)
+			capacity *= 2;
+
+		if (capacity > allocator::m_Capacity)
+			Rehash(capacity);
+	}
+
+	template<typename Func>
+	void for_each(Func Callback)
+	{
+		for (uint32_t i = 0; i < allocator::m_Capacity; i++)
+		{
+			if (allocator::m_Control[i] >= 0)
+				Callback(allocator::m_Slots[i].m_Key, allocator::m_Slots[i].m_Value);
+		}
+	}
+
+private:
+	constexpr static uint32_t MaxLoad(uint32_t Capacity)
+	{
+		return Capacity - (Capacity / 8);
+	}
+
+	__forceinline size_t Hash(const key_type& Key) const
+	{
+		// Mix the user hash. BSTScatterTableDefaultHashPolicy is the identity function and sequential form
+		// IDs would otherwise pile up in the same few groups and share the same tag.
+		uint64_t h = (uint64_t)hasher::operator()(Key);
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ull;
+		h ^= h >> 33;
+
+		return (size_t)h;
+	}
+
+	__forceinline static int8_t H2(size_t Hash)
+	{
+		return (int8_t)(Hash & 0x7F);
+	}
+
+	__forceinline static uint32_t H1(size_t Hash)
+	{
+		return (uint32_t)(Hash >> 7);
+	}
+
+	__forceinline uint32_t GroupCount() const
+	{
+		return allocator::m_Capacity / GroupWidth;
+	}
+
+	__forceinline __m128i LoadGroup(uint32_t Group) const
+	{
+		return _mm_load_si128((const __m128i *)&allocator::m_Control[Group * GroupWidth]);
+	}
+
+	__forceinline static uint32_t MatchTag(__m128i Ctrl, int8_t Tag)
+	{
+		return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Ctrl, _mm_set1_epi8(Tag)));
+	}
+
+	__forceinline static uint32_t MatchEmpty(__m128i Ctrl)
+	{
+		return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Ctrl, _mm_set1_epi8(CtrlEmpty)));
+	}
+
+	__forceinline static uint32_t MatchEmptyOrDeleted(__m128i Ctrl)
+	{
+		// Sign bit is only set for the two special states
+		return (uint32_t)_mm_movemask_epi8(Ctrl);
+	}
+
+	uint32_t FindIndex(const key_type& Key, size_t Hash) const
+	{
+		if (!allocator::m_Control)
+			return UINT32_MAX;
+
+		const int8_t tag = H2(Hash);
+		const uint32_t groupMask = GroupCount() - 1;
+		uint32_t group = H1(Hash) & groupMask;
+
+		// Triangular probing visits every group exactly once when the group count is a power of 2
+		for (uint32_t step = 1; step <= GroupCount(); step++)
+		{
+			const __m128i ctrl = LoadGroup(group);
+
+			for (uint32_t mask = MatchTag(ctrl, tag); mask != 0; mask &= mask - 1)
+			{
+				uint32_t index = (group * GroupWidth) + _tzcnt_u32(mask);
+
+				if (allocator::m_Slots[index].GetKey() == Key)
+					return index;
+			}
+
+			// An empty slot terminates the chain: the key was never pushed past this group
+			if (MatchEmpty(ctrl) != 0)
+				break;
+
+			group = (group + step) & groupMask;
+		}
+
+		return UINT32_MAX;
+	}
+
+	uint32_t FindInsertSlot(size_t Hash) const
+	{
+		const uint32_t groupMask = GroupCount() - 1;
+		uint32_t group = H1(Hash) & groupMask;
+
+		for (uint32_t step = 1;; step++)
+		{
+			uint32_t mask = MatchEmptyOrDeleted(LoadGroup(group));
+
+			if (mask != 0)
+				return (group * GroupWidth) + _tzcnt_u32(mask);
+
+			group = (group + step) & groupMask;
+		}
+	}
+
+	template<typename ValueType>
+	bool Emplace(const key_type& Key, ValueType&& Value, bool Assign)
+	{
+		const size_t hash = Hash(Key);
+
+		if (uint32_t index = FindIndex(Key, hash); index != UINT32_MAX)
+		{
+			if (Assign)
+				allocator::m_Slots[index].m_Value = std::forward<ValueType>(Value);
+
+			return false;
+		}
+
+		if (!allocator::m_Control)
+			Rehash(MinimumCapacity);
+
+		uint32_t index = FindInsertSlot(hash);
+
+		// Reusing a tombstone doesn't consume growth. Taking a real empty slot does.
+		if (allocator::m_Control[index] == CtrlEmpty)
+		{
+			if (m_GrowthLeft == 0)
+			{
+				// Mostly tombstones? Rehash in place at the same size. Otherwise double.
+				Rehash((m_Size * 2 < MaxLoad(allocator::m_Capacity)) ? allocator::m_Capacity : allocator::m_Capacity * 2);
+				index = FindInsertSlot(hash);
+			}
+
+			m_GrowthLeft--;
+		}
+
+		new (&allocator::m_Slots[index]) table_entry { Key, std::forward<ValueType>(Value) };
+		allocator::m_Control[index] = H2(hash);
+		m_Size++;
+
+		return true;
+	}
+
+	void EraseIndex(uint32_t Index)
+	{
+		allocator::m_Slots[Index].~table_entry();
+		m_Size--;
+
+		//
+		// A group that still has an empty slot was never full, so no probe sequence ever continued past it and
+		// the slot can go straight back to empty. Otherwise leave a tombstone to keep later chains reachable.
+		//
+		if (MatchEmpty(LoadGroup(Index / GroupWidth)) != 0)
+		{
+			allocator::m_Control[Index] = CtrlEmpty;
+			m_GrowthLeft++;
+		}
+		else
+		{
+			allocator::m_Control[Index] = CtrlDeleted;
+		}
+	}
+
+	void Rehash(uint32_t NewCapacity)
+	{
+		allocator oldStorage = *static_cast<allocator *>(this);
+
+		allocator::Allocate(NewCapacity);
+		memset(allocator::m_Control, CtrlEmpty, NewCapacity);
+
+		m_GrowthLeft = MaxLoad(NewCapacity) - m_Size;
+
+		for (uint32_t i = 0; i < oldStorage.m_Capacity; i++)
+		{
+			if (oldStorage.m_Control[i] < 0)
+				continue;
+
+			table_entry& entry = oldStorage.m_Slots[i];
+			const size_t hash = Hash(entry.GetKey());
+			const uint32_t index = FindInsertSlot(hash);
+
+			new (&allocator::m_Slots[index]) table_entry(std::move(entry));
+			allocator::m_Control[index] = H2(hash);
+			entry.~table_entry();
+		}
+
+		oldStorage.Deallocate();
+	}
+};
+
+template<
+	typename Key,
+	typename T,
+	class Hash = BSTScatterTableDefaultHashPolicy<Key>
+	>
+class BSTSwissScatterTable : public BSTSwissScatterTableBase<BSTScatterTableTraits<
+	Key,
+	T,
+	BSTScatterTableDefaultKVStorage<Key, T>,
+	Hash,
+	BSTScatterTableSwissAllocator<BSTSwissScatterTableEntry<Key, T>>>>
+{
+};
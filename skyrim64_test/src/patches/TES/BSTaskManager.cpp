@@ -1,6 +1,7 @@
 #include <map>
 #include <mutex>
 #include "../../common.h"
+#include "../../profiler_zone_categories.h"
 #include "BSTaskManager.h"
 
 SRWLOCK BSTask::TaskListLock = SRWLOCK_INIT;
@@ -80,6 +81,8 @@ bool BSTask::GetName_QueuedPromoteReferencesTask(char *Buffer, size_t BufferSize
 
 bool IOManager::QueueTask(BSTask *Task)
 {
+	ProfileZoneCat(TASKS, "IOManager::QueueTask");
+
 	AcquireSRWLockExclusive(&BSTask::TaskListLock);
 
 	// Loop through the current list and check if any were finished or canceled
@@ -14,10 +14,25 @@
 using namespace DirectX;
 
 #include "MOC_ThreadedMerger.h"
+#include "MOC_BinnedRenderer.h"
+#include "MOC_MeshCache.h"
+#include "MOC_MeshBuild.h"
+#include "MOC_Reprojection.h"
+#include "MOC_BatchCull.h"
+#include "MOC_FrameCapture.h"
+#include "MOC_BudgetController.h"
 #include <meshoptimizer/src/meshoptimizer.h>
 
-const int MOC_WIDTH = 1280;
-const int MOC_HEIGHT = 720;
+// The adaptive budget steps down through these. Everything is allocated for the first one.
+const MOC_BudgetController::Resolution MOC_RESOLUTIONS[] =
+{
+	{ 1280, 720 },
+	{ 1152, 648 },
+	{ 1024, 576 },
+	{ 896, 504 },
+	{ 768, 432 },
+	{ 640, 360 },
+};
 
 extern ID3D11Texture2D *g_OcclusionTexture;
 extern ID3D11ShaderResourceView *g_OcclusionTextureSRV;
@@ -27,180 +42,164 @@ namespace MOC
 	AutoPtr(NiNode *, WorldScenegraph, 0x2F4CE30);
 
 	MOC_ThreadedMerger *ThreadedMOC;
+	MOC_BinnedRenderer *BinnedMOC;
+	MOC_Renderer *ActiveMOC;		// Latched once per frame in SendTraverseCommand()
+	MOC_MeshCache *MeshCache;
+	MOC_Reprojection *Reprojection;
+	MOC_FrameCapture *FrameCapture;
+	std::atomic_bool FrameCaptureRequested;
+	MOC_BudgetController *Budget;
+	MOC_ThreadTicks QueryTicks;				// Time spent in occludee tests since the last budget update
+	uint32_t LastOccluderCount;				// Before the occluder budget was applied
+
+	MaskedOcclusionCulling *LastFlushedBuffer;
+	std::atomic_bool FlushPending;
+	SRWLOCK FlushLock = SRWLOCK_INIT;
+
+	const float ReprojectionMaxCameraDistance = 512.0f;
 
-	struct IndexPair
-	{
-		uint32_t *Data;
-		uint32_t Count;
-	};
-
-	std::unordered_map<void *, float *> m_VertMap;
-	std::unordered_map<void *, IndexPair> m_IndexMap;
-
-	uint32_t *ConvertIndices(const void *Input, uint32_t Count, uint32_t MaxVertexCount)
-	{
-		const uint16_t *in = (uint16_t *)Input;
-		uint32_t *out = new uint32_t[Count];
-
-		for (uint32_t i = 0; i < Count; i++)
-			out[i] = in[i];
-
-		return out;
-	}
+	XMMATRIX MyView;
+	XMMATRIX MyProj;
+	XMMATRIX MyViewProj;
+	NiPoint3 MyPosAdjust;
 
-	float *ConvertVerts(const void *Input, uint32_t Count, uint32_t ByteStride)
+	// meshopt_simplify() may have trailing defaulted parameters depending on the version, so it can't be passed to
+	// MOC_MeshBuild directly
+	size_t SimplifyMesh(uint32_t *Destination, const uint32_t *Indices, size_t IndexCount, const float *Vertices, size_t VertexCount, size_t VertexStride, size_t TargetIndexCount, float TargetError)
 	{
-		float *in = (float *)Input;
-		float *out = new float[Count * 4];
-		float *base = out;
-
-		for (uint32_t i = 0; i < Count; i++)
-		{
-			//
-			// X -> X
-			// Y -> Y
-			// Z -> 1.0f
-			// W -> Z
-			// Remaining data discarded
-			//
-			out[0] = in[0];
-			out[1] = in[1];
-			out[2] = 1.0f;
-			out[3] = in[2];
-
-			in = (float *)((uintptr_t)in + ByteStride);
-			out += 4;
-		}
-
-		return base;
+		return meshopt_simplify(Destination, Indices, IndexCount, Vertices, VertexCount, VertexStride, TargetIndexCount, TargetError);
 	}
 
-	SRWLOCK vertLock = SRWLOCK_INIT;
-	void GetCachedVerticesAndIndices(BSGeometry *Geometry, IndexPair *Indices, float **Vertices)
+	MOC_MeshCache::Mesh GetCachedMesh(BSGeometry *Geometry)
 	{
-		void *dataPtr;
+		AssertMsg(Geometry->QType() != GEOMETRY_TYPE_DYNAMIC_TRISHAPE, "BSGraphics::DynamicTriShape -> indices are always a nullptr");
+		Assert(Geometry->QType() == GEOMETRY_TYPE_TRISHAPE);
 
-		const void *indexData;
-		uint32_t indexCount;
+		auto triShape = static_cast<BSTriShape *>(Geometry);
+		auto rendererData = reinterpret_cast<BSGraphics::TriShape *>(triShape->QRendererData());
 
-		const void *vertexData;
-		uint32_t vertexCount;
-		uint32_t vertexStride;
+		MOC_MeshCache::Mesh mesh;
 
-		AcquireSRWLockExclusive(&vertLock);
-
-		if (Geometry->QType() == GEOMETRY_TYPE_TRISHAPE)
+		// If one wasn't found, it needs conversion. This happens outside of any lock.
+		if (!MeshCache->Lookup(rendererData, &mesh))
 		{
-			auto triShape = static_cast<BSTriShape *>(Geometry);
-			auto rendererData = reinterpret_cast<BSGraphics::TriShape *>(triShape->QRendererData());
-			dataPtr = rendererData;
+			ProfileTimer("MOC BuildLods");
 
-			auto itrI = m_IndexMap.find(rendererData);
-			auto itrV = m_VertMap.find(rendererData);
+			const void *indexData = rendererData->m_RawIndexData;
+			uint32_t indexCount = triShape->m_TriangleCount * 3;
 
-			if (itrI != m_IndexMap.end())
-				*Indices = itrI->second;
-			else
-				Indices->Data = nullptr;
+			const void *vertexData = rendererData->m_RawVertexData;
+			uint32_t vertexCount = triShape->m_VertexCount;
+			uint32_t vertexStride = BSGeometry::CalculateVertexSize(rendererData->m_VertexDesc);
 
-			if (itrV != m_VertMap.end())
-				*Vertices = itrV->second;
-			else
-				*Vertices = nullptr;
+			// Source meshes can't have more than 65536 vertices, so the LODs can keep 16-bit indices
+			static_assert(sizeof(BSTriShape::m_VertexCount) == sizeof(uint16_t));
 
-			indexData = rendererData->m_RawIndexData;
-			indexCount = triShape->m_TriangleCount * 3;
+			mesh.Indices = MOC_MeshBuild::BuildLods((const uint16_t *)indexData, indexCount, vertexData, vertexCount, vertexStride, (uint32_t)std::max(ui::opt::OccluderTriangleBudget, 1), SimplifyMesh, mesh.LodOffsets, &mesh.LodCount);
+			mesh.Vertices = MOC_MeshBuild::QuantizeVerts(vertexData, vertexCount, vertexStride, mesh.Scale, mesh.Offset);
+			mesh.VertexCount = vertexCount;
 
-			vertexData = rendererData->m_RawVertexData;
-			vertexCount = triShape->m_VertexCount;
-			vertexStride = BSGeometry::CalculateVertexSize(rendererData->m_VertexDesc);
-		}
-		else if (Geometry->QType() == GEOMETRY_TYPE_DYNAMIC_TRISHAPE)
-		{
-			AssertMsg(false, "BSGraphics::DynamicTriShape -> indices are always a nullptr");
-		}
-		else
-		{
-			Assert(false);
+			mesh = MeshCache->Insert(rendererData, mesh);
 		}
 
-		// If one wasn't found, it needs conversion
-		if (!Indices->Data)
-		{
-			IndexPair p;
-			p.Data = ConvertIndices(indexData, indexCount, vertexCount);
-			p.Count = indexCount;
+		return mesh;
+	}
 
-			if (indexCount > 300)
-				p.Count = meshopt_simplify(p.Data, p.Data, indexCount, (const float *)vertexData, vertexCount, vertexStride, (size_t)(indexCount * .50f), 1e-3f);// Target 33% of original triangles
+	uint32_t SelectLod(const BSGeometry *Geometry, uint32_t LodCount)
+	{
+		// Projected radius relative to half the screen height. The camera can be inside the bounds.
+		const float radius = Geometry->m_kWorldBound.m_fRadius;
+		const float distance = XMVector3Length(_mm_sub_ps(Geometry->m_kWorldBound.m_kCenter.AsXmm(), MyPosAdjust.AsXmm())).m128_f32[0];
 
-			m_IndexMap.insert_or_assign(dataPtr, p);
-			*Indices = p;
-		}
+		if (distance <= radius)
+			return 0;
 
-		if (!*Vertices)
-		{
-			*Vertices = ConvertVerts(vertexData, vertexCount, vertexStride);
-			m_VertMap.insert_or_assign(dataPtr, *Vertices);
-		}
+		const float screenSize = (radius * MyProj.r[1].m128_f32[1] / distance) * ui::opt::OccluderLodScale;
 
-		ReleaseSRWLockExclusive(&vertLock);
+		return MOC_MeshBuild::SelectLod(screenSize, LodCount);
 	}
 
 	void RemoveCachedVerticesAndIndices(void *RendererData)
 	{
-		uint32_t *indices = nullptr;
-		float *verts = nullptr;
-
-		AcquireSRWLockExclusive(&vertLock);
-
-		if (auto itr = m_IndexMap.find(RendererData); itr != m_IndexMap.end())
-		{
-			indices = itr->second.Data;
-			m_IndexMap.erase(itr);
-		}
-
-		if (auto itr = m_VertMap.find(RendererData); itr != m_VertMap.end())
-		{
-			verts = itr->second;
-			m_VertMap.erase(itr);
-		}
+		// Buffers aren't freed immediately. Workers might still be rasterizing them (cell_unload() + moc_render()).
+		MeshCache->Remove(RendererData);
+	}
 
-		ReleaseSRWLockExclusive(&vertLock);
+	uint64_t GetMeshCacheMemoryUsage()
+	{
+		return MeshCache ? MeshCache->GetMemoryUsage() : 0;
+	}
 
-		// Both buffers might be used outside the lock - I don't care right now (cell_unload() + moc_render() => BOOM)
-		if (indices)
-			delete[] indices;
+	uint32_t GetMeshCacheEntryCount()
+	{
+		return MeshCache ? MeshCache->GetEntryCount() : 0;
+	}
 
-		if (verts)
-			delete[] verts;
+	const MOC_BudgetController *GetBudgetController()
+	{
+		return Budget;
 	}
 
 	void UpdateDepthViewTexture()
 	{
-		ZoneScopedN("MOC UpdateDepthView");
-		ThreadedMOC->UpdateDepthViewTexture(BSGraphics::Renderer::QInstance()->Data.pContext, g_OcclusionTexture);
+		ProfileZone("MOC UpdateDepthView");
+		ActiveMOC->UpdateDepthViewTexture(BSGraphics::Renderer::QInstance()->Data.pContext, g_OcclusionTexture);
 	}
 
-	void ForceFlush()
+	void FlushNow()
 	{
 		ProfileTimer("MOC WaitForRender");
-		ThreadedMOC->Flush();
+		ActiveMOC->Flush();
+
+		LastFlushedBuffer = ActiveMOC->GetMOC();
 	}
 
-	XMMATRIX MyView;
-	XMMATRIX MyProj;
-	XMMATRIX MyViewProj;
-	NiPoint3 MyPosAdjust;
+	void ForceFlush()
+	{
+		// With a warped buffer available, occludees only wait for the new buffer when the warped one can't decide
+		if (ui::opt::EnableDepthReprojection && Reprojection->IsReady())
+		{
+			FlushPending.store(true, std::memory_order_release);
+			return;
+		}
+
+		FlushNow();
+	}
+
+	void WaitForPendingFlush()
+	{
+		if (!FlushPending.load(std::memory_order_acquire))
+			return;
+
+		AcquireSRWLockExclusive(&FlushLock);
+
+		if (FlushPending.load(std::memory_order_acquire))
+		{
+			FlushNow();
+			FlushPending.store(false, std::memory_order_release);
+		}
+
+		ReleaseSRWLockExclusive(&FlushLock);
+	}
 
 	bool mocInit = false;
 
 	void Init()
 	{
-		ThreadedMOC = new MOC_ThreadedMerger(MOC_WIDTH, MOC_HEIGHT, 4, true);
-
-		ThreadedMOC->SetTraverseSceneCallback(TraverseSceneGraphCallback);
-		ThreadedMOC->SetRenderGeometryCallback(RenderGeometryCallback);
+		Budget = new MOC_BudgetController(MOC_RESOLUTIONS, ARRAYSIZE(MOC_RESOLUTIONS));
+		ThreadedMOC = new MOC_ThreadedMerger(Budget->GetWidth(), Budget->GetHeight(), 4, true);
+		BinnedMOC = new MOC_BinnedRenderer(Budget->GetWidth(), Budget->GetHeight(), 4, 4, 4, true);
+		ActiveMOC = ThreadedMOC;
+		MeshCache = new MOC_MeshCache();
+		Reprojection = new MOC_Reprojection(Budget->GetWidth(), Budget->GetHeight());
+		FrameCapture = new MOC_FrameCapture();
+		fplanes::SelectKernels();
+
+		for (MOC_Renderer *renderer : { (MOC_Renderer *)ThreadedMOC, (MOC_Renderer *)BinnedMOC })
+		{
+			renderer->SetTraverseSceneCallback(TraverseSceneGraphCallback);
+			renderer->SetPrepareGeometryCallback(PrepareGeometryCallback);
+		}
 
 		mocInit = true;
 	}
@@ -221,6 +220,34 @@ namespace MOC
 		return nullptr;
 	}
 
+	bool IsRectVisible(float XMin, float YMin, float XMax, float YMax, float WMin)
+	{
+		if (ui::opt::EnableDepthReprojection && Reprojection->IsReady())
+		{
+			if (Reprojection->IsOccluded(XMin, YMin, XMax, YMax, WMin, ui::opt::ReprojectionConfidence))
+			{
+				ProfileCounterInc("MOC CullDecidedEarly");
+
+				if (FrameCapture->IsActive())
+					FrameCapture->AddQuery(XMin, YMin, XMax, YMax, WMin, MOC_FrameCaptureFormat::ResultNotTested);
+
+				return false;
+			}
+
+			// Only counted when reprojection got a say, so early + late is the number of rects it tried
+			ProfileCounterInc("MOC CullDecidedLate");
+		}
+
+		WaitForPendingFlush();
+
+		auto result = ActiveMOC->GetMOC()->TestRect(XMin, YMin, XMax, YMax, WMin);
+
+		if (FrameCapture->IsActive())
+			FrameCapture->AddQuery(XMin, YMin, XMax, YMax, WMin, result);
+
+		return result == MaskedOcclusionCulling::VISIBLE;
+	}
+
 	bool TestSphere(NiAVObject *Object);
 	bool TestAABB(BSMultiBoundAABB *Object);
 
@@ -233,7 +260,8 @@ namespace MOC
 			return true;
 
 		ProfileCounterInc("MOC CullObjectCount");
-		ProfileTimer("MOC CullTest");
+		ProfileTimerHistogram("MOC CullTest");
+		MOC_ScopedTicks ticks { QueryTicks.Local() };
 
 		BSMultiBoundAABB *aabb = GetAABBNode(Object);
 		bool visible = false;
@@ -327,9 +355,7 @@ namespace MOC
 		XMVECTOR xyMins = _mm_min_ps(vCorner0NDC, _mm_min_ps(vCorner1NDC, _mm_min_ps(vCorner2NDC, vCorner3NDC)));// zw discarded
 		XMVECTOR xyMaxs = _mm_max_ps(vCorner0NDC, _mm_max_ps(vCorner1NDC, _mm_max_ps(vCorner2NDC, vCorner3NDC)));// zw discarded
 
-		auto r = ThreadedMOC->GetMOC()->TestRect(xyMins.m128_f32[0], xyMins.m128_f32[1], xyMaxs.m128_f32[0], xyMaxs.m128_f32[1], closestSpherePointW);
-
-		if (r != MaskedOcclusionCulling::VISIBLE)
+		if (!IsRectVisible(xyMins.m128_f32[0], xyMins.m128_f32[1], xyMaxs.m128_f32[0], xyMaxs.m128_f32[1], closestSpherePointW))
 		{
 #define CONVERT_X(x) ((x) + 1.0) * 2560 * 0.5 + 0
 #define CONVERT_Y(y) (1.0 - (y)) * 1440 * 0.5 + 0
@@ -402,9 +428,7 @@ namespace MOC
 			screenMax = _mm_max_ps(screenMax, xformedPos);
 		}
 
-		MaskedOcclusionCulling::CullingResult r = ThreadedMOC->GetMOC()->TestRect(screenMin.m128_f32[0], screenMin.m128_f32[1], screenMax.m128_f32[0], screenMax.m128_f32[1], minW);
-
-		if (r != MaskedOcclusionCulling::VISIBLE)
+		if (!IsRectVisible(screenMin.m128_f32[0], screenMin.m128_f32[1], screenMax.m128_f32[0], screenMax.m128_f32[1], minW))
 		{
 #define CONVERT_X(x) ((x) + 1.0) * 2560 * 0.5 + 0
 #define CONVERT_Y(y) (1.0 - (y)) * 1440 * 0.5 + 0
@@ -423,6 +447,82 @@ namespace MOC
 		return true;
 	}
 
+	template<typename ProjectFunc>
+	void TestBatch(uint32_t Count, uint64_t *VisibleMask, ProjectFunc Project)
+	{
+		const uint32_t wordCount = (Count + 63) / 64;
+
+		if (!mocInit || !ui::opt::EnableOcclusionTesting)
+		{
+			for (uint32_t i = 0; i < wordCount; i++)
+				VisibleMask[i] = ~0ull;
+
+			return;
+		}
+
+		// One sample per batch, kept apart from the per-object latencies in "MOC CullTest"
+		ProfileCounterAdd("MOC CullObjectCount", Count);
+		ProfileTimerHistogram("MOC CullTestBatch");
+		MOC_ScopedTicks ticks { QueryTicks.Local() };
+
+		const MOC_BatchCull::Camera camera = MOC_BatchCull::MakeCamera(MyView, MyViewProj, MyPosAdjust.AsXmm());
+
+		// Project in chunks of 64 so the rects stay on the stack and line up with one mask word
+		for (uint32_t base = 0; base < Count; base += 64)
+		{
+			alignas(64) float xMin[64], yMin[64], xMax[64], yMax[64], wMin[64];
+			const MOC_BatchCull::Rects rects { xMin, yMin, xMax, yMax, wMin };
+
+			const uint32_t count = std::min<uint32_t>(Count - base, 64);
+			uint64_t unknown = 0;
+
+			Project(camera, base, count, rects, &unknown);
+
+			uint64_t visible = unknown;
+
+			for (uint64_t remaining = ~unknown & ((count == 64) ? ~0ull : ((1ull << count) - 1)); remaining; remaining &= remaining - 1)
+			{
+				unsigned long i;
+				_BitScanForward64(&i, remaining);
+
+				if (IsRectVisible(xMin[i], yMin[i], xMax[i], yMax[i], wMin[i]))
+					visible |= 1ull << i;
+			}
+
+			ProfileCounterAdd("MOC CullObjectPassed", __popcnt64(visible));
+			VisibleMask[base / 64] = visible;
+		}
+	}
+
+	void TestSpheres(const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count, uint64_t *VisibleMask)
+	{
+		if (mocInit && FrameCapture->IsActive())
+			FrameCapture->AddSpheres(X, Y, Z, Radius, Count);
+
+		TestBatch(Count, VisibleMask, [&](const MOC_BatchCull::Camera& Camera, uint32_t Base, uint32_t ChunkCount, const MOC_BatchCull::Rects& Out, uint64_t *Unknown)
+		{
+			MOC_BatchCull::ProjectSpheres(Camera, X + Base, Y + Base, Z + Base, Radius + Base, ChunkCount, Out, Unknown);
+
+			// Same as TestSphere(): tiny objects aren't worth testing
+			for (uint32_t i = 0; i < ChunkCount; i++)
+			{
+				if (Radius[Base + i] <= 5.0f)
+					*Unknown |= 1ull << i;
+			}
+		});
+	}
+
+	void TestAABBs(const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count, uint64_t *VisibleMask)
+	{
+		if (mocInit && FrameCapture->IsActive())
+			FrameCapture->AddAABBs(CenterX, CenterY, CenterZ, HalfX, HalfY, HalfZ, Count);
+
+		TestBatch(Count, VisibleMask, [&](const MOC_BatchCull::Camera& Camera, uint32_t Base, uint32_t ChunkCount, const MOC_BatchCull::Rects& Out, uint64_t *Unknown)
+		{
+			MOC_BatchCull::ProjectAABBs(Camera, CenterX + Base, CenterY + Base, CenterZ + Base, HalfX + Base, HalfY + Base, HalfZ + Base, ChunkCount, Out, Unknown);
+		});
+	}
+
 	struct GeometryDistEntry
 	{
 		BSGeometry *Geometry;
@@ -467,10 +567,9 @@ namespace MOC
 		}
 	}
 
-	void RenderGeometryCallback(MaskedOcclusionCulling *MOC, void *UserData)
+	bool PrepareGeometryCallback(void *UserData, MOC_OccluderDraw *Draw)
 	{
-		ProfileTimer("MOC RenderGeometry");
-		ZoneScopedN("MOC RenderGeometry");
+		ProfileZone("MOC PrepareGeometry");
 
 		BSGeometry *geometry = (BSGeometry *)UserData;
 
@@ -481,26 +580,36 @@ namespace MOC
 			winding = MaskedOcclusionCulling::BACKFACE_NONE;
 
 		// Grab LOD-ified mesh out
-		IndexPair indexRawData;
-		float *vertexRawData;
-		GetCachedVerticesAndIndices(geometry, &indexRawData, &vertexRawData);
+		MOC_MeshCache::Mesh mesh = GetCachedMesh(geometry);
+		uint32_t lod = SelectLod(geometry, mesh.LodCount);
+		uint32_t indexCount = mesh.GetIndexCount(lod);
+
+		// MOC reads the cached 16-bit vertices and indices directly. Quantized -> model space happens as part of the
+		// transform.
+		XMMATRIX dequantize = XMMatrixMultiply(
+			XMMatrixScaling(mesh.Scale[0], mesh.Scale[1], mesh.Scale[2]),
+			XMMatrixTranslation(mesh.Offset[0], mesh.Offset[1], mesh.Offset[2]));
 
 		XMMATRIX worldProj = BSShaderUtil::GetXMFromNiPosAdjust(geometry->GetWorldTransform(), MyPosAdjust);
-		XMMATRIX worldViewProj = XMMatrixMultiply(worldProj, MyViewProj);
+		XMMATRIX worldViewProj = XMMatrixMultiply(XMMatrixMultiply(dequantize, worldProj), MyViewProj);
 
-		MOC->RenderTriangles(
-			vertexRawData,
-			indexRawData.Data,
-			indexRawData.Count / 3,
-			(float *)&worldViewProj,
-			winding,
-			MaskedOcclusionCulling::CLIP_PLANE_SIDES);
+		memcpy(Draw->ModelToClip, &worldViewProj, sizeof(Draw->ModelToClip));
+		Draw->Vertices = mesh.Vertices;
+		Draw->Indices = mesh.GetIndices(lod);
+		Draw->TriangleCount = indexCount / 3;
+		Draw->Winding = winding;
 
 		ProfileCounterInc("MOC ObjectsRendered");
-		ProfileCounterAdd("MOC TrianglesRendered", indexRawData.Count / 3);
+		ProfileCounterAdd("MOC TrianglesRendered", indexCount / 3);
+		ProfileCounterAdd("MOC TrianglesSource", static_cast<BSTriShape *>(geometry)->m_TriangleCount);
+
+		if (FrameCapture->IsActive())
+			FrameCapture->AddDraw(*Draw);
+
+		return true;
 	}
 
-	bool CullObject(const NiAVObject *Object, fplanes& Frustum)
+	bool CullObjectFlags(const NiAVObject *Object)
 	{
 		if (!Object)
 			return true;
@@ -522,20 +631,134 @@ namespace MOC
 		if (name && name[0] == 'L' && name[1] == '2' && name[2] == '_')
 			return true;
 
+		return false;
+	}
+
+	uint32_t fplanes::SpheresInFrustumSSE(const fplanes& Frustum, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t PlaneMask, uint32_t *ChildMasks)
+	{
+		uint32_t inside = 0;
+
+		// Two halves of 4 spheres
+		for (uint32_t base = 0; base < SphereBatchSize; base += 4)
+		{
+			const __m128 x = _mm_load_ps(&X[base]);
+			const __m128 y = _mm_load_ps(&Y[base]);
+			const __m128 z = _mm_load_ps(&Z[base]);
+			const __m128 r = _mm_load_ps(&Radius[base]);
+			const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+			__m128 outside = _mm_setzero_ps();
+			__m128i straddling = _mm_setzero_si128();
+
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				// Parent was fully inside this plane
+				if ((PlaneMask & (1u << i)) == 0)
+					continue;
+
+				// dot(p.n, s.center) + p.d
+				__m128 dist = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(Frustum.SpherePlanes[i][0])), _mm_set1_ps(Frustum.SpherePlanes[i][3]));
+				dist = _mm_add_ps(_mm_mul_ps(y, _mm_set1_ps(Frustum.SpherePlanes[i][1])), dist);
+				dist = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(Frustum.SpherePlanes[i][2])), dist);
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negR));
+
+				__m128i crosses = _mm_castps_si128(_mm_cmplt_ps(dist, r));
+				straddling = _mm_or_si128(straddling, _mm_and_si128(crosses, _mm_set1_epi32(1 << i)));
+			}
+
+			_mm_store_si128((__m128i *)&ChildMasks[base], straddling);
+			inside |= (~_mm_movemask_ps(outside) & 0xF) << base;
+		}
+
+		return inside;
+	}
+
+	// Non-inlined so the upper register halves can be cleared on the way out
+	__declspec(noinline) uint32_t fplanes::SpheresInFrustumAVX2(const fplanes& Frustum, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t PlaneMask, uint32_t *ChildMasks)
+	{
+		const __m256 x = _mm256_load_ps(X);
+		const __m256 y = _mm256_load_ps(Y);
+		const __m256 z = _mm256_load_ps(Z);
+		const __m256 r = _mm256_load_ps(Radius);
+		const __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), r);
+
+		__m256 outside = _mm256_setzero_ps();
+		__m256i straddling = _mm256_setzero_si256();
+
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			// Parent was fully inside this plane
+			if ((PlaneMask & (1u << i)) == 0)
+				continue;
+
+			// dot(p.n, s.center) + p.d
+			__m256 dist = _mm256_fmadd_ps(x, _mm256_broadcast_ss(&Frustum.SpherePlanes[i][0]), _mm256_broadcast_ss(&Frustum.SpherePlanes[i][3]));
+			dist = _mm256_fmadd_ps(y, _mm256_broadcast_ss(&Frustum.SpherePlanes[i][1]), dist);
+			dist = _mm256_fmadd_ps(z, _mm256_broadcast_ss(&Frustum.SpherePlanes[i][2]), dist);
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, negR, _CMP_LT_OQ));
+
+			__m256i crosses = _mm256_castps_si256(_mm256_cmp_ps(dist, r, _CMP_LT_OQ));
+			straddling = _mm256_or_si256(straddling, _mm256_and_si256(crosses, _mm256_set1_epi32(1 << i)));
+		}
+
+		_mm256_store_si256((__m256i *)ChildMasks, straddling);
+		const uint32_t inside = ~_mm256_movemask_ps(outside) & ((1u << SphereBatchSize) - 1);
+
+		_mm256_zeroupper();
+		return inside;
+	}
+
+	void fplanes::SelectKernels()
+	{
+		int cpuinfo[4];
+		__cpuid(cpuinfo, 0);
+
+		if (cpuinfo[0] < 7)
+			return;
+
+		__cpuid(cpuinfo, 1);
+
+		const bool hasFMA = (cpuinfo[2] & (1 << 12)) != 0;
+		const bool hasOSXSAVE = (cpuinfo[2] & (1 << 27)) != 0;
+		const bool hasAVX = (cpuinfo[2] & (1 << 28)) != 0;
+
+		__cpuidex(cpuinfo, 7, 0);
+		const bool hasAVX2 = (cpuinfo[1] & (1 << 5)) != 0;
+
+		// The OS has to save the YMM registers too
+		if (hasAVX2 && hasAVX && hasFMA && hasOSXSAVE && (_xgetbv(0) & 0x6) == 0x6)
+			SpheresInFrustumKernel = &SpheresInFrustumAVX2;
+	}
+
+	bool CullObjectAABB(const BSMultiBoundAABB *AABBNode, fplanes& Frustum)
+	{
+		// Not all objects have valid boundaries (certain global cells)
+		if (AABBNode->m_kHalfExtents.z > 1.0f)
+		{
+			__m128 center = _mm_sub_ps(AABBNode->m_kCenter.AsXmm(), MyPosAdjust.AsXmm());
+			__m128 halfExtents = AABBNode->m_kHalfExtents.AsXmm();
+
+			if (!Frustum.AABBInFrustum(center, halfExtents))
+				return true;
+		}
+
+		return false;
+	}
+
+	bool CullObject(const NiAVObject *Object, fplanes& Frustum)
+	{
+		if (CullObjectFlags(Object))
+			return true;
+
 		//
 		// Frustum tests
 		//
 		if (auto aabbNode = GetAABBNode(Object))
 		{
-			// Not all objects have valid boundaries (certain global cells)
-			if (aabbNode->m_kHalfExtents.z > 1.0f)
-			{
-				__m128 center = _mm_sub_ps(aabbNode->m_kCenter.AsXmm(), MyPosAdjust.AsXmm());
-				__m128 halfExtents = aabbNode->m_kHalfExtents.AsXmm();
-
-				if (!Frustum.AABBInFrustum(center, halfExtents))
-					return true;
-			}
+			if (CullObjectAABB(aabbNode, Frustum))
+				return true;
 		}
 		else if (Object->m_kWorldBound.m_fRadius > 10.0f)
 		{
@@ -553,11 +776,88 @@ namespace MOC
 		return false;
 	}
 
-	void RenderRecursive(fplanes& f, const NiAVObject *Object, bool FirstLevel)
+	void RenderRecursive(fplanes& f, const NiAVObject *Object, bool FirstLevel, uint32_t PlaneMask);
+
+	//
+	// Frustum culls a node's children SphereBatchSize at a time, then recurses into the survivors. PlaneMask holds the
+	// planes the parent's bound straddles. Planes it was fully inside of are skipped for the whole subtree, and once
+	// the mask reaches 0 no frustum tests are done at all.
+	//
+	void RenderChildren(fplanes& f, const NiNode *Node, bool FirstLevel, uint32_t PlaneMask)
 	{
-		if (CullObject(Object, f))
-			return;
+		const uint32_t childCount = Node->GetArrayCount();
+
+		for (uint32_t base = 0; base < childCount; base += fplanes::SphereBatchSize)
+		{
+			alignas(32) float centerX[fplanes::SphereBatchSize] = {};
+			alignas(32) float centerY[fplanes::SphereBatchSize] = {};
+			alignas(32) float centerZ[fplanes::SphereBatchSize] = {};
+			alignas(32) float radius[fplanes::SphereBatchSize] = {};
+			alignas(32) uint32_t sphereMasks[fplanes::SphereBatchSize];
+
+			const NiAVObject *children[fplanes::SphereBatchSize];
+			uint32_t childMasks[fplanes::SphereBatchSize];
+
+			const uint32_t count = std::min<uint32_t>(childCount - base, fplanes::SphereBatchSize);
+			uint32_t passed = 0;
+			uint32_t sphereLanes = 0;
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const NiAVObject *child = Node->GetAt(base + i);
+
+				children[i] = child;
+				childMasks[i] = PlaneMask;
+
+				if (CullObjectFlags(child))
+					continue;
+
+				if (PlaneMask == 0)
+				{
+					ProfileCounterInc("MOC FrustumTestsSkipped");
+					passed |= 1u << i;
+				}
+				else if (auto aabbNode = GetAABBNode(child))
+				{
+					if (!CullObjectAABB(aabbNode, f))
+						passed |= 1u << i;
+				}
+				else if (child->m_kWorldBound.m_fRadius > 10.0f)
+				{
+					centerX[i] = child->m_kWorldBound.m_kCenter.x - MyPosAdjust.x;
+					centerY[i] = child->m_kWorldBound.m_kCenter.y - MyPosAdjust.y;
+					centerZ[i] = child->m_kWorldBound.m_kCenter.z - MyPosAdjust.z;
+					radius[i] = child->m_kWorldBound.m_fRadius;
+					sphereLanes |= 1u << i;
+				}
+				else
+				{
+					passed |= 1u << i;
+				}
+			}
+
+			if (sphereLanes)
+			{
+				ProfileCounterAdd("MOC FrustumSphereTests", __popcnt(sphereLanes));
+				passed |= f.SpheresInFrustum(centerX, centerY, centerZ, radius, PlaneMask, sphereMasks) & sphereLanes;
+
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (sphereLanes & (1u << i))
+						childMasks[i] = sphereMasks[i];
+				}
+			}
 
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (passed & (1u << i))
+					RenderRecursive(f, children[i], FirstLevel, childMasks[i]);
+			}
+		}
+	}
+
+	void RenderRecursive(fplanes& f, const NiAVObject *Object, bool FirstLevel, uint32_t PlaneMask)
+	{
 		bool validBounds = Object->m_kWorldBound.m_fRadius > 1.0f;
 
 		if (FirstLevel)
@@ -575,8 +875,7 @@ namespace MOC
 			if (!node->IsExactKindOf(NiRTTI::ms_BSLeafAnimNode))
 			{
 				// Enumerate children, but don't render this node specifically
-				for (uint32_t i = 0; i < node->GetArrayCount(); i++)
-					RenderRecursive(f, node->GetAt(i), false);
+				RenderChildren(f, node, false, PlaneMask);
 			}
 		}
 		else if (geometry)
@@ -593,20 +892,72 @@ namespace MOC
 		}
 	}
 
+	void RequestFrameCapture()
+	{
+		FrameCaptureRequested.store(true);
+	}
+
+	void WriteFrameCapture()
+	{
+		// Put it next to the exe, same as crash dumps
+		char exePath[MAX_PATH];
+		char fileName[MAX_PATH];
+		GetModuleFileNameA(GetModuleHandle(nullptr), exePath, ARRAYSIZE(exePath));
+
+		SYSTEMTIME sysTime;
+		GetSystemTime(&sysTime);
+		sprintf_s(fileName, "%s_%4d%02d%02d_%02d%02d%02d.mocframe", exePath, sysTime.wYear, sysTime.wMonth, sysTime.wDay, sysTime.wHour, sysTime.wMinute, sysTime.wSecond);
+
+		if (FrameCapture->End(fileName))
+			ui::log::Add("Wrote MOC frame capture (%u draws, %u queries) to %s\n", FrameCapture->GetDrawCount(), FrameCapture->GetQueryCount(), fileName);
+		else
+			ui::log::Add("Failed to write MOC frame capture to %s\n", fileName);
+	}
+
+	void UpdateBudget()
+	{
+		const uint64_t rasterTicks = ThreadedMOC->ConsumeRasterTicks() + BinnedMOC->ConsumeRasterTicks();
+
+		if (!Budget->Update(ui::opt::EnableAdaptiveOcclusionBudget, ui::opt::OcclusionBudgetMs, rasterTicks, QueryTicks.Consume(), LastOccluderCount))
+			return;
+
+		// Both backends are idle here. The old buffer can't be warped into the new size, so skip one reprojection.
+		for (MOC_Renderer *renderer : { (MOC_Renderer *)ThreadedMOC, (MOC_Renderer *)BinnedMOC })
+			renderer->Resize(Budget->GetWidth(), Budget->GetHeight());
+
+		Reprojection->Resize(Budget->GetWidth(), Budget->GetHeight());
+		LastFlushedBuffer = nullptr;
+	}
+
 	void SendTraverseCommand(NiCamera *Camera)
 	{
-		if (!mocInit || !ui::opt::EnableOccluderRendering)
+		if (!mocInit)
 			return;
 
-		ThreadedMOC->NotifyPreWork();
-		ThreadedMOC->SubmitSceneRender(Camera);
-		ThreadedMOC->ClearPreWorkNotify();
+		// Last frame's rasterization must be complete before anything is cleared or freed
+		WaitForPendingFlush();
+
+		// Every query against last frame's buffer has been made by now
+		if (FrameCapture->IsActive())
+			WriteFrameCapture();
+
+		UpdateBudget();
+
+		if (!ui::opt::EnableOccluderRendering)
+			return;
+
+		// Switching only takes effect between frames. ForceFlush() and the occludee tests use the same backend.
+		ActiveMOC = ui::opt::EnableBinnedOccluderRendering ? (MOC_Renderer *)BinnedMOC : (MOC_Renderer *)ThreadedMOC;
+
+		ActiveMOC->NotifyPreWork();
+		ActiveMOC->SubmitSceneRender(Camera);
+		ActiveMOC->ClearPreWorkNotify();
 	}
 
 	void TraverseSceneGraph(NiCamera *Camera)
 	{
 		ProfileTimer("MOC TraverseSceneGraph");
-		ZoneScopedN("MOC TraverseSceneGraph");
+		ProfileZone("MOC TraverseSceneGraph");
 
 		//
 		// Scene graph hierarchy:
@@ -642,14 +993,28 @@ namespace MOC
 		if (!Camera)
 			Camera = static_cast<NiCamera *>(WorldScenegraph->GetAt(0)->IsNode()->GetAt(0));
 
-		GeoList.clear();
+		// Warp last frame's buffer before it's cleared. MyViewProj/MyPosAdjust still hold last frame's camera here.
+		Reprojection->Invalidate();
+
+		if (ui::opt::EnableDepthReprojection)
+			Reprojection->Capture(LastFlushedBuffer, MyViewProj, MyPosAdjust.AsXmm());
 
-		ThreadedMOC->Clear();
-		ThreadedMOC->NotifyPreWork();
+		// Clearing waits for any outstanding rasterization, so it has to happen before old meshes are freed
+		ActiveMOC->Clear();
+		ActiveMOC->NotifyPreWork();
+
+		GeoList.clear();
+		MeshCache->NextFrame((uint64_t)ui::opt::OccluderCacheBudgetMB * 1024 * 1024);
 
 		MyPosAdjust = Camera->GetWorldTranslate();
 		Camera->CalculateViewProjection(MyView, MyProj, MyViewProj);
 
+		if (ui::opt::EnableDepthReprojection)
+			Reprojection->Reproject(MyViewProj, MyPosAdjust.AsXmm(), ReprojectionMaxCameraDistance);
+
+		if (FrameCaptureRequested.exchange(false))
+			FrameCapture->Begin(Budget->GetWidth(), Budget->GetHeight(), (const float *)&MyView, (const float *)&MyViewProj, &MyPosAdjust.x);
+
 		float fov = atan(1.0f / MyProj.r[0].m128_f32[0]) * 2.0f * (180.0f / 3.14159265359f);
 		float aspect = MyProj.r[1].m128_f32[1] / MyProj.r[0].m128_f32[0];
 
@@ -684,16 +1049,10 @@ namespace MOC
 
 			// Everything in these loops will be some kind of node
 			if (!CullObject(landNode, p))
-			{
-				for (uint32_t i = 0; i < landNode->GetArrayCount(); i++)
-					RenderRecursive(p, landNode->GetAt(i), true);
-			}
+				RenderChildren(p, landNode, true, fplanes::AllPlanes);
 
 			if (!CullObject(staticNode, p))
-			{
-				for (uint32_t i = 0; i < staticNode->GetArrayCount(); i++)
-					RenderRecursive(p, staticNode->GetAt(i), true);
-			}
+				RenderChildren(p, staticNode, true, fplanes::AllPlanes);
 		}
 
 		// Sort front to back (approx)
@@ -703,13 +1062,19 @@ namespace MOC
 			return a.DistanceSquared < b.DistanceSquared;
 		});
 
-		for (GeometryDistEntry& entry : GeoList)
-			ThreadedMOC->SubmitGeometry(entry.Geometry);
+		// Over budget occluders are the farthest ones
+		const size_t occluderCount = std::min<size_t>(GeoList.size(), Budget->GetOccluderBudget());
+
+		LastOccluderCount = (uint32_t)GeoList.size();
+		ProfileCounterAdd("MOC OccludersOverBudget", GeoList.size() - occluderCount);
+
+		for (size_t i = 0; i < occluderCount; i++)
+			ActiveMOC->SubmitGeometry(GeoList[i].Geometry);
 
-		ThreadedMOC->ClearPreWorkNotify();
+		ActiveMOC->ClearPreWorkNotify();
 	}
 
-	void TraverseSceneGraphCallback(MaskedOcclusionCulling *MOC, void *UserData)
+	void TraverseSceneGraphCallback(void *UserData)
 	{
 		NiCamera *camera = (NiCamera *)UserData;
 		TraverseSceneGraph(camera);
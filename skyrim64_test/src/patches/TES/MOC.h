@@ -5,6 +5,8 @@
 #include <DirectXMath.h>
 
 class MaskedOcclusionCulling;
+class MOC_BudgetController;
+struct MOC_OccluderDraw;
 
 namespace MOC
 {
@@ -13,14 +15,23 @@ namespace MOC
 	void SendTraverseCommand(NiCamera *Camera);
 	void TraverseSceneGraph(NiCamera *Camera);
 	void RemoveCachedVerticesAndIndices(void *RendererData);
+	uint64_t GetMeshCacheMemoryUsage();
+	uint32_t GetMeshCacheEntryCount();
+	const MOC_BudgetController *GetBudgetController();
 	void UpdateDepthViewTexture();
 	void ForceFlush();
+	void RequestFrameCapture();
 
-	void RenderGeometryCallback(MaskedOcclusionCulling *MOC, void *UserData);
-	void TraverseSceneGraphCallback(MaskedOcclusionCulling *MOC, void *UserData);
+	bool PrepareGeometryCallback(void *UserData, MOC_OccluderDraw *Draw);
+	void TraverseSceneGraphCallback(void *UserData);
 
 	bool TestObject(class NiAVObject *Object);
 
+	// Batched TestSphere/TestAABB on structure-of-arrays bounds (world space). Bit i of VisibleMask is set if object i
+	// might be visible. VisibleMask holds (Count + 63) / 64 words.
+	void TestSpheres(const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count, uint64_t *VisibleMask);
+	void TestAABBs(const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count, uint64_t *VisibleMask);
+
 	using namespace DirectX;
 
 	struct fplanes
@@ -35,8 +46,12 @@ namespace MOC
 			Far,
 		};
 
+		constexpr static uint32_t SphereBatchSize = 8;
+		constexpr static uint32_t AllPlanes = (1 << 6) - 1;
+
 		alignas(64) __m128 PlaneComponents[8];
 		alignas(64) float mPlanes[32];
+		alignas(64) float SpherePlanes[6][4];	// Same planes as PlaneComponents, not negated: inside when dot(n, p) + d >= 0
 
 		void InitializeFrustumAABB(float nearClipDistance, float farClipDistance, float aspectRatio, float fov, XMVECTOR position, XMVECTOR look, XMVECTOR up)
 		{
@@ -145,6 +160,9 @@ namespace MOC
 			PlaneComponents[5] = _mm_setr_ps(-planes[4][1], -planes[5][1], -planes[4][1], -planes[5][1]);
 			PlaneComponents[6] = _mm_setr_ps(-planes[4][2], -planes[5][2], -planes[4][2], -planes[5][2]);
 			PlaneComponents[7] = _mm_setr_ps(-planes[4][3], -planes[5][3], -planes[4][3], -planes[5][3]);
+
+			for (int i = 0; i < 6; i++)
+				_mm_store_ps(SpherePlanes[i], Planes[i]);
 		}
 
 		bool SphereInFrustum(float Center[3], float Radius)
@@ -205,6 +223,26 @@ namespace MOC
 			return _mm_test_all_ones(*reinterpret_cast<__m128i *>(&r)) == 0;
 		}
 
+		//
+		// Tests SphereBatchSize spheres (SoA, 32 byte aligned) against the planes set in PlaneMask. Returns a bit for
+		// each sphere that's at least partially inside. ChildMasks receives the planes each sphere still straddles;
+		// 0 means the sphere is fully inside, and so is anything it bounds.
+		//
+		using SpheresInFrustumFunc = uint32_t(*)(const fplanes& Frustum, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t PlaneMask, uint32_t *ChildMasks);
+
+		static uint32_t SpheresInFrustumSSE(const fplanes& Frustum, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t PlaneMask, uint32_t *ChildMasks);
+		static uint32_t SpheresInFrustumAVX2(const fplanes& Frustum, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t PlaneMask, uint32_t *ChildMasks);
+
+		// SSE until SelectKernels() (MOC::Init) finds AVX2 and FMA
+		inline static SpheresInFrustumFunc SpheresInFrustumKernel = &SpheresInFrustumSSE;
+
+		static void SelectKernels();
+
+		uint32_t SpheresInFrustum(const float *X, const float *Y, const float *Z, const float *Radius, uint32_t PlaneMask, uint32_t *ChildMasks) const
+		{
+			return SpheresInFrustumKernel(*this, X, Y, Z, Radius, PlaneMask, ChildMasks);
+		}
+
 		bool AABBInFrustum(XMVECTOR Center, XMVECTOR HalfExtents)
 		{
 			const __m128 centerX = XMVectorSplatX(Center);
@@ -252,8 +290,8 @@ namespace MOC
 
 		__forceinline __m128 simd_madd(__m128 a, __m128 b, __m128 c)
 		{
-			return _mm_fmadd_ps(a, b, c);
-			//return _mm_add_ps(_mm_mul_ps(a, b), c);
+			// No FMA: this runs before (and regardless of) any instruction set checks
+			return _mm_add_ps(_mm_mul_ps(a, b), c);
 		}
 	};
 }
\ No newline at end of file
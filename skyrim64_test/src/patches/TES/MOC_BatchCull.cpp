@@ -0,0 +1,131 @@
+#include "../../common.h"
+#include <immintrin.h>
+#include "MOC_BatchCull.h"
+
+namespace MOC_BatchCull
+{
+	// AVX kernels get their own (non-inlined) functions so the upper register halves can be cleared on the way out
+	template<class Isa>
+	__declspec(noinline) void ProjectSpheresAVX(const Camera& Cam, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count, const Rects& Out, uint64_t *Unknown)
+	{
+		ProjectSpheresKernel<Isa>(Cam, X, Y, Z, Radius, Count, Out, Unknown);
+		_mm256_zeroupper();
+	}
+
+	template<class Isa>
+	__declspec(noinline) void ProjectAABBsAVX(const Camera& Cam, const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count, const Rects& Out, uint64_t *Unknown)
+	{
+		ProjectAABBsKernel<Isa>(Cam, CenterX, CenterY, CenterZ, HalfX, HalfY, HalfZ, Count, Out, Unknown);
+		_mm256_zeroupper();
+	}
+
+	enum class Kernel
+	{
+		SSE,
+		AVX2,
+		AVX512,
+	};
+
+	Kernel DetectKernel()
+	{
+		int cpuinfo[4];
+		__cpuid(cpuinfo, 0);
+
+		const int maxLeaf = cpuinfo[0];
+
+		__cpuid(cpuinfo, 1);
+
+		const bool hasFMA = (cpuinfo[2] & (1 << 12)) != 0;
+		const bool hasOSXSAVE = (cpuinfo[2] & (1 << 27)) != 0;
+		const bool hasAVX = (cpuinfo[2] & (1 << 28)) != 0;
+
+		bool hasAVX2 = false;
+		bool hasAVX512F = false;
+
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(cpuinfo, 7, 0);
+
+			hasAVX2 = (cpuinfo[1] & (1 << 5)) != 0;
+			hasAVX512F = (cpuinfo[1] & (1 << 16)) != 0;
+		}
+
+		// The OS also has to save the wider registers on context switches (XCR0: SSE/AVX, then opmask/ZMM)
+		const uint64_t xcr0 = hasOSXSAVE ? _xgetbv(0) : 0;
+
+		if (hasAVX512F && (xcr0 & 0xE6) == 0xE6)
+			return Kernel::AVX512;
+
+		if (hasAVX2 && hasAVX && hasFMA && (xcr0 & 0x6) == 0x6)
+			return Kernel::AVX2;
+
+		return Kernel::SSE;
+	}
+
+	using ProjectSpheresFunc = void(*)(const Camera&, const float *, const float *, const float *, const float *, uint32_t, const Rects&, uint64_t *);
+	using ProjectAABBsFunc = void(*)(const Camera&, const float *, const float *, const float *, const float *, const float *, const float *, uint32_t, const Rects&, uint64_t *);
+
+	ProjectSpheresFunc ActiveProjectSpheres;
+	ProjectAABBsFunc ActiveProjectAABBs;
+	Kernel ActiveKernel;
+
+	void SelectKernels()
+	{
+		// Function local static initialization is thread safe
+		static const bool selected = []()
+		{
+			ActiveKernel = DetectKernel();
+
+			switch (ActiveKernel)
+			{
+			case Kernel::AVX512:
+				ActiveProjectSpheres = &ProjectSpheresAVX<IsaAVX512>;
+				ActiveProjectAABBs = &ProjectAABBsAVX<IsaAVX512>;
+				break;
+
+			case Kernel::AVX2:
+				ActiveProjectSpheres = &ProjectSpheresAVX<IsaAVX2>;
+				ActiveProjectAABBs = &ProjectAABBsAVX<IsaAVX2>;
+				break;
+
+			default:
+				ActiveProjectSpheres = &ProjectSpheresKernel<IsaSSE>;
+				ActiveProjectAABBs = &ProjectAABBsKernel<IsaSSE>;
+				break;
+			}
+
+			return true;
+		}();
+
+		(void)selected;
+	}
+
+	void ProjectSpheres(const Camera& Cam, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count, const Rects& Out, uint64_t *Unknown)
+	{
+		SelectKernels();
+		memset(Unknown, 0, ((Count + 63) / 64) * sizeof(uint64_t));
+
+		ActiveProjectSpheres(Cam, X, Y, Z, Radius, Count, Out, Unknown);
+	}
+
+	void ProjectAABBs(const Camera& Cam, const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count, const Rects& Out, uint64_t *Unknown)
+	{
+		SelectKernels();
+		memset(Unknown, 0, ((Count + 63) / 64) * sizeof(uint64_t));
+
+		ActiveProjectAABBs(Cam, CenterX, CenterY, CenterZ, HalfX, HalfY, HalfZ, Count, Out, Unknown);
+	}
+
+	const char *GetKernelName()
+	{
+		SelectKernels();
+
+		switch (ActiveKernel)
+		{
+		case Kernel::AVX512: return "AVX-512";
+		case Kernel::AVX2: return "AVX2";
+		}
+
+		return "SSE2";
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <DirectXMath.h>
+
+#include "MOC_BatchCullKernels.h"
+
+//
+// Structure-of-arrays versions of the projection half of MOC::TestSphere/MOC::TestAABB. 4 (SSE), 8 (AVX2) or 16
+// (AVX-512) objects are projected at once into screen rectangles and a nearest clip w, ready for TestRect(). The
+// instruction set is picked on the first call.
+//
+namespace MOC_BatchCull
+{
+	inline Camera MakeCamera(const DirectX::XMMATRIX& View, const DirectX::XMMATRIX& ViewProj, DirectX::FXMVECTOR Position)
+	{
+		Camera cam;
+		DirectX::XMStoreFloat4x4((DirectX::XMFLOAT4X4 *)cam.View, View);
+		DirectX::XMStoreFloat4x4((DirectX::XMFLOAT4X4 *)cam.ViewProj, ViewProj);
+		DirectX::XMStoreFloat3((DirectX::XMFLOAT3 *)cam.Position, Position);
+
+		return cam;
+	}
+
+	// Objects that can't be tested (camera inside, crossing the near plane) get their bit set in Unknown. Unknown
+	// holds (Count + 63) / 64 words.
+	void ProjectSpheres(const Camera& Cam, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count, const Rects& Out, uint64_t *Unknown);
+	void ProjectAABBs(const Camera& Cam, const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count, const Rects& Out, uint64_t *Unknown);
+
+	const char *GetKernelName();
+}
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <immintrin.h>
+
+//
+// Projection kernels behind MOC_BatchCull, written once against the instruction set wrappers below. Shared with
+// moc_replay and headless_tests, so this header must not depend on anything from the game, Windows or DirectXMath.
+//
+// The AVX2 and AVX-512 wrappers only exist when the compiler is allowed to emit those instructions: always on MSVC,
+// elsewhere only in files built with the matching flags. Callers pick a kernel at runtime.
+//
+namespace MOC_BatchCull
+{
+	// Row major like XMMATRIX. Position is subtracted from object coordinates before ViewProj is applied.
+	struct Camera
+	{
+		float View[4][4];
+		float ViewProj[4][4];
+		float Position[3];
+	};
+
+	// NDC rectangles and the nearest clip space w of each object
+	struct Rects
+	{
+		float *XMin;
+		float *YMin;
+		float *XMax;
+		float *YMax;
+		float *WMin;
+	};
+
+	// One object per "vector". Never selected at runtime (SSE2 is baseline on x64), it's the reference the SIMD
+	// kernels are tested against.
+	struct IsaScalar
+	{
+		using Vec = float;
+		constexpr static uint32_t Lanes = 1;
+
+		static Vec Set1(float Value) { return Value; }
+		static Vec Load(const float *Data) { return *Data; }
+		static void Store(float *Data, Vec A) { *Data = A; }
+		static Vec Add(Vec A, Vec B) { return A + B; }
+		static Vec Sub(Vec A, Vec B) { return A - B; }
+		static Vec Mul(Vec A, Vec B) { return A * B; }
+		static Vec Div(Vec A, Vec B) { return A / B; }
+		static Vec MulAdd(Vec A, Vec B, Vec C) { return (A * B) + C; }
+		static Vec Sqrt(Vec A) { return sqrtf(A); }
+		static Vec Min(Vec A, Vec B) { return (A < B) ? A : B; }	// Same NaN handling as minps/maxps
+		static Vec Max(Vec A, Vec B) { return (A > B) ? A : B; }
+		static uint32_t LessEqual(Vec A, Vec B) { return A <= B; }
+		static uint32_t Less(Vec A, Vec B) { return A < B; }
+	};
+
+	// Baseline for CPUs without AVX2/FMA. No FMA here, so MulAdd is two instructions.
+	struct IsaSSE
+	{
+		using Vec = __m128;
+		constexpr static uint32_t Lanes = 4;
+
+		static Vec Set1(float Value) { return _mm_set1_ps(Value); }
+		static Vec Load(const float *Data) { return _mm_loadu_ps(Data); }
+		static void Store(float *Data, Vec A) { _mm_storeu_ps(Data, A); }
+		static Vec Add(Vec A, Vec B) { return _mm_add_ps(A, B); }
+		static Vec Sub(Vec A, Vec B) { return _mm_sub_ps(A, B); }
+		static Vec Mul(Vec A, Vec B) { return _mm_mul_ps(A, B); }
+		static Vec Div(Vec A, Vec B) { return _mm_div_ps(A, B); }
+		static Vec MulAdd(Vec A, Vec B, Vec C) { return _mm_add_ps(_mm_mul_ps(A, B), C); }
+		static Vec Sqrt(Vec A) { return _mm_sqrt_ps(A); }
+		static Vec Min(Vec A, Vec B) { return _mm_min_ps(A, B); }
+		static Vec Max(Vec A, Vec B) { return _mm_max_ps(A, B); }
+		static uint32_t LessEqual(Vec A, Vec B) { return _mm_movemask_ps(_mm_cmple_ps(A, B)); }
+		static uint32_t Less(Vec A, Vec B) { return _mm_movemask_ps(_mm_cmplt_ps(A, B)); }
+	};
+
+#if defined(_MSC_VER) || (defined(__AVX2__) && defined(__FMA__))
+	struct IsaAVX2
+	{
+		using Vec = __m256;
+		constexpr static uint32_t Lanes = 8;
+
+		static Vec Set1(float Value) { return _mm256_set1_ps(Value); }
+		static Vec Load(const float *Data) { return _mm256_loadu_ps(Data); }
+		static void Store(float *Data, Vec A) { _mm256_storeu_ps(Data, A); }
+		static Vec Add(Vec A, Vec B) { return _mm256_add_ps(A, B); }
+		static Vec Sub(Vec A, Vec B) { return _mm256_sub_ps(A, B); }
+		static Vec Mul(Vec A, Vec B) { return _mm256_mul_ps(A, B); }
+		static Vec Div(Vec A, Vec B) { return _mm256_div_ps(A, B); }
+		static Vec MulAdd(Vec A, Vec B, Vec C) { return _mm256_fmadd_ps(A, B, C); }
+		static Vec Sqrt(Vec A) { return _mm256_sqrt_ps(A); }
+		static Vec Min(Vec A, Vec B) { return _mm256_min_ps(A, B); }
+		static Vec Max(Vec A, Vec B) { return _mm256_max_ps(A, B); }
+		static uint32_t LessEqual(Vec A, Vec B) { return _mm256_movemask_ps(_mm256_cmp_ps(A, B, _CMP_LE_OQ)); }
+		static uint32_t Less(Vec A, Vec B) { return _mm256_movemask_ps(_mm256_cmp_ps(A, B, _CMP_LT_OQ)); }
+	};
+#endif
+
+#if defined(_MSC_VER) || defined(__AVX512F__)
+	struct IsaAVX512
+	{
+		using Vec = __m512;
+		constexpr static uint32_t Lanes = 16;
+
+		static Vec Set1(float Value) { return _mm512_set1_ps(Value); }
+		static Vec Load(const float *Data) { return _mm512_loadu_ps(Data); }
+		static void Store(float *Data, Vec A) { _mm512_storeu_ps(Data, A); }
+		static Vec Add(Vec A, Vec B) { return _mm512_add_ps(A, B); }
+		static Vec Sub(Vec A, Vec B) { return _mm512_sub_ps(A, B); }
+		static Vec Mul(Vec A, Vec B) { return _mm512_mul_ps(A, B); }
+		static Vec Div(Vec A, Vec B) { return _mm512_div_ps(A, B); }
+		static Vec MulAdd(Vec A, Vec B, Vec C) { return _mm512_fmadd_ps(A, B, C); }
+		static Vec Sqrt(Vec A) { return _mm512_sqrt_ps(A); }
+		static Vec Min(Vec A, Vec B) { return _mm512_min_ps(A, B); }
+		static Vec Max(Vec A, Vec B) { return _mm512_max_ps(A, B); }
+		static uint32_t LessEqual(Vec A, Vec B) { return _mm512_cmp_ps_mask(A, B, _CMP_LE_OQ); }
+		static uint32_t Less(Vec A, Vec B) { return _mm512_cmp_ps_mask(A, B, _CMP_LT_OQ); }
+	};
+#endif
+
+	// Loads Lanes floats, or zero pads a partial vector at the end of the arrays
+	template<class Isa>
+	typename Isa::Vec LoadLanes(const float *Data, uint32_t Index, uint32_t Count)
+	{
+		if (Index + Isa::Lanes <= Count)
+			return Isa::Load(&Data[Index]);
+
+		alignas(64) float temp[Isa::Lanes] = {};
+		memcpy(temp, &Data[Index], (Count - Index) * sizeof(float));
+
+		return Isa::Load(temp);
+	}
+
+	template<class Isa>
+	void StoreLanes(float *Data, uint32_t Index, uint32_t Count, typename Isa::Vec Value)
+	{
+		if (Index + Isa::Lanes <= Count)
+			return Isa::Store(&Data[Index], Value);
+
+		alignas(64) float temp[Isa::Lanes];
+		Isa::Store(temp, Value);
+
+		memcpy(&Data[Index], temp, (Count - Index) * sizeof(float));
+	}
+
+	template<class Isa>
+	void SetUnknownBits(uint64_t *Unknown, uint32_t Index, uint32_t Count, uint32_t Mask)
+	{
+		// Lanes divides 64, so a vector never straddles two words
+		if (Index + Isa::Lanes > Count)
+			Mask &= (1u << (Count - Index)) - 1;
+
+		Unknown[Index / 64] |= (uint64_t)Mask << (Index % 64);
+	}
+
+	// Splatted matrix rows, only the x/y/w columns are needed for a screen rectangle
+	template<class Isa>
+	struct ProjectionRows
+	{
+		typename Isa::Vec X[4];
+		typename Isa::Vec Y[4];
+		typename Isa::Vec W[4];
+
+		ProjectionRows(const float (&M)[4][4])
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				X[i] = Isa::Set1(M[i][0]);
+				Y[i] = Isa::Set1(M[i][1]);
+				W[i] = Isa::Set1(M[i][3]);
+			}
+		}
+	};
+
+	template<class Isa>
+	void ProjectSpheresKernel(const Camera& Cam, const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count, const Rects& Out, uint64_t *Unknown)
+	{
+		using Vec = typename Isa::Vec;
+
+		const ProjectionRows<Isa> vp(Cam.ViewProj);
+		const Vec posX = Isa::Set1(Cam.Position[0]);
+		const Vec posY = Isa::Set1(Cam.Position[1]);
+		const Vec posZ = Isa::Set1(Cam.Position[2]);
+
+		// Same (non-orthonormalized) camera basis as MOC::TestSphere
+		const Vec eyeX = Isa::Set1(-Cam.View[0][3]);
+		const Vec eyeY = Isa::Set1(-Cam.View[1][3]);
+		const Vec eyeZ = Isa::Set1(-Cam.View[2][3]);
+		const Vec upX = Isa::Set1(Cam.View[0][1]);
+		const Vec upY = Isa::Set1(Cam.View[1][1]);
+		const Vec upZ = Isa::Set1(Cam.View[2][1]);
+
+		const Vec one = Isa::Set1(1.0f);
+		const Vec tiny = Isa::Set1(0.000001f);
+
+		for (uint32_t i = 0; i < Count; i += Isa::Lanes)
+		{
+			const Vec r = LoadLanes<Isa>(Radius, i, Count);
+			const Vec bx = Isa::Sub(LoadLanes<Isa>(X, i, Count), posX);
+			const Vec by = Isa::Sub(LoadLanes<Isa>(Y, i, Count), posY);
+			const Vec bz = Isa::Sub(LoadLanes<Isa>(Z, i, Count), posZ);
+
+			// Never cull a sphere the camera is inside of
+			const Vec dist = Isa::Sqrt(Isa::MulAdd(bx, bx, Isa::MulAdd(by, by, Isa::Mul(bz, bz))));
+			uint32_t unknown = Isa::LessEqual(dist, r);
+
+			// Early depth: closest point on the sphere to the camera
+			const Vec scale = Isa::Sub(one, Isa::Div(r, Isa::Max(dist, tiny)));
+			const Vec closestW = Isa::MulAdd(Isa::Mul(bx, scale), vp.W[0], Isa::MulAdd(Isa::Mul(by, scale), vp.W[1], Isa::MulAdd(Isa::Mul(bz, scale), vp.W[2], vp.W[3])));
+			unknown |= Isa::Less(closestW, tiny);
+
+			// Perspective corrected radius: d * tan(asin(r / d)) == r * d / sqrt(d^2 - r^2)
+			const Vec dx = Isa::Sub(eyeX, bx);
+			const Vec dy = Isa::Sub(eyeY, by);
+			const Vec dz = Isa::Sub(eyeZ, bz);
+			const Vec camDistSq = Isa::MulAdd(dx, dx, Isa::MulAdd(dy, dy, Isa::Mul(dz, dz)));
+			const Vec camDist = Isa::Sqrt(camDistSq);
+			const Vec fRadius = Isa::Div(Isa::Mul(r, camDist), Isa::Sqrt(Isa::Max(Isa::Sub(camDistSq, Isa::Mul(r, r)), tiny)));
+
+			// right = normalize(cross(d, up))
+			Vec rightX = Isa::Sub(Isa::Mul(dy, upZ), Isa::Mul(dz, upY));
+			Vec rightY = Isa::Sub(Isa::Mul(dz, upX), Isa::Mul(dx, upZ));
+			Vec rightZ = Isa::Sub(Isa::Mul(dx, upY), Isa::Mul(dy, upX));
+			const Vec rightScale = Isa::Div(fRadius, Isa::Max(Isa::Sqrt(Isa::MulAdd(rightX, rightX, Isa::MulAdd(rightY, rightY, Isa::Mul(rightZ, rightZ)))), tiny));
+
+			rightX = Isa::Mul(rightX, rightScale);
+			rightY = Isa::Mul(rightY, rightScale);
+			rightZ = Isa::Mul(rightZ, rightScale);
+
+			const Vec upRX = Isa::Mul(upX, fRadius);
+			const Vec upRY = Isa::Mul(upY, fRadius);
+			const Vec upRZ = Isa::Mul(upZ, fRadius);
+
+			// Project the center once, then add the projected offsets for the 4 corners (the transform is linear)
+			const Vec cX = Isa::MulAdd(bx, vp.X[0], Isa::MulAdd(by, vp.X[1], Isa::MulAdd(bz, vp.X[2], vp.X[3])));
+			const Vec cY = Isa::MulAdd(bx, vp.Y[0], Isa::MulAdd(by, vp.Y[1], Isa::MulAdd(bz, vp.Y[2], vp.Y[3])));
+			const Vec cW = Isa::MulAdd(bx, vp.W[0], Isa::MulAdd(by, vp.W[1], Isa::MulAdd(bz, vp.W[2], vp.W[3])));
+
+			const Vec uX = Isa::MulAdd(upRX, vp.X[0], Isa::MulAdd(upRY, vp.X[1], Isa::Mul(upRZ, vp.X[2])));
+			const Vec uY = Isa::MulAdd(upRX, vp.Y[0], Isa::MulAdd(upRY, vp.Y[1], Isa::Mul(upRZ, vp.Y[2])));
+			const Vec uW = Isa::MulAdd(upRX, vp.W[0], Isa::MulAdd(upRY, vp.W[1], Isa::Mul(upRZ, vp.W[2])));
+
+			const Vec rX = Isa::MulAdd(rightX, vp.X[0], Isa::MulAdd(rightY, vp.X[1], Isa::Mul(rightZ, vp.X[2])));
+			const Vec rY = Isa::MulAdd(rightX, vp.Y[0], Isa::MulAdd(rightY, vp.Y[1], Isa::Mul(rightZ, vp.Y[2])));
+			const Vec rW = Isa::MulAdd(rightX, vp.W[0], Isa::MulAdd(rightY, vp.W[1], Isa::Mul(rightZ, vp.W[2])));
+
+			Vec minX = Isa::Set1(FLT_MAX);
+			Vec minY = Isa::Set1(FLT_MAX);
+			Vec maxX = Isa::Set1(-FLT_MAX);
+			Vec maxY = Isa::Set1(-FLT_MAX);
+
+			for (int corner = 0; corner < 4; corner++)
+			{
+				const Vec us = Isa::Set1((corner & 2) ? -1.0f : 1.0f);
+				const Vec rs = Isa::Set1((corner & 1) ? 1.0f : -1.0f);
+
+				const Vec px = Isa::MulAdd(rX, rs, Isa::MulAdd(uX, us, cX));
+				const Vec py = Isa::MulAdd(rY, rs, Isa::MulAdd(uY, us, cY));
+				const Vec pw = Isa::MulAdd(rW, rs, Isa::MulAdd(uW, us, cW));
+
+				const Vec ndcX = Isa::Div(px, pw);
+				const Vec ndcY = Isa::Div(py, pw);
+
+				minX = Isa::Min(minX, ndcX);
+				minY = Isa::Min(minY, ndcY);
+				maxX = Isa::Max(maxX, ndcX);
+				maxY = Isa::Max(maxY, ndcY);
+			}
+
+			StoreLanes<Isa>(Out.XMin, i, Count, minX);
+			StoreLanes<Isa>(Out.YMin, i, Count, minY);
+			StoreLanes<Isa>(Out.XMax, i, Count, maxX);
+			StoreLanes<Isa>(Out.YMax, i, Count, maxY);
+			StoreLanes<Isa>(Out.WMin, i, Count, closestW);
+			SetUnknownBits<Isa>(Unknown, i, Count, unknown);
+		}
+	}
+
+	template<class Isa>
+	void ProjectAABBsKernel(const Camera& Cam, const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count, const Rects& Out, uint64_t *Unknown)
+	{
+		using Vec = typename Isa::Vec;
+
+		const ProjectionRows<Isa> vp(Cam.ViewProj);
+		const Vec posX = Isa::Set1(Cam.Position[0]);
+		const Vec posY = Isa::Set1(Cam.Position[1]);
+		const Vec posZ = Isa::Set1(Cam.Position[2]);
+
+		for (uint32_t i = 0; i < Count; i += Isa::Lanes)
+		{
+			const Vec cx = Isa::Sub(LoadLanes<Isa>(CenterX, i, Count), posX);
+			const Vec cy = Isa::Sub(LoadLanes<Isa>(CenterY, i, Count), posY);
+			const Vec cz = Isa::Sub(LoadLanes<Isa>(CenterZ, i, Count), posZ);
+			const Vec hx = LoadLanes<Isa>(HalfX, i, Count);
+			const Vec hy = LoadLanes<Isa>(HalfY, i, Count);
+			const Vec hz = LoadLanes<Isa>(HalfZ, i, Count);
+
+			// Per axis contributions of the min [0] and max [1] corner coordinates, like MOC::TestAABB
+			Vec xTerm[3][2], yTerm[3][2], zTerm[3][2];	// [x/y/w][min/max]
+			const Vec axisMin[3] = { Isa::Sub(cx, hx), Isa::Sub(cy, hy), Isa::Sub(cz, hz) };
+			const Vec axisMax[3] = { Isa::Add(cx, hx), Isa::Add(cy, hy), Isa::Add(cz, hz) };
+
+			for (int j = 0; j < 2; j++)
+			{
+				const Vec *axis = (j == 0) ? axisMin : axisMax;
+
+				xTerm[0][j] = Isa::Mul(axis[0], vp.X[0]);
+				xTerm[1][j] = Isa::Mul(axis[0], vp.Y[0]);
+				xTerm[2][j] = Isa::Mul(axis[0], vp.W[0]);
+				yTerm[0][j] = Isa::Mul(axis[1], vp.X[1]);
+				yTerm[1][j] = Isa::Mul(axis[1], vp.Y[1]);
+				yTerm[2][j] = Isa::Mul(axis[1], vp.W[1]);
+				zTerm[0][j] = Isa::Mul(axis[2], vp.X[2]);
+				zTerm[1][j] = Isa::Mul(axis[2], vp.Y[2]);
+				zTerm[2][j] = Isa::Mul(axis[2], vp.W[2]);
+			}
+
+			const Vec minW = Isa::Add(vp.W[3], Isa::Add(Isa::Add(Isa::Min(xTerm[2][0], xTerm[2][1]), Isa::Min(yTerm[2][0], yTerm[2][1])), Isa::Min(zTerm[2][0], zTerm[2][1])));
+			const uint32_t unknown = Isa::Less(minW, Isa::Set1(0.00000001f));
+
+			Vec minX = Isa::Set1(FLT_MAX);
+			Vec minY = Isa::Set1(FLT_MAX);
+			Vec maxX = Isa::Set1(-FLT_MAX);
+			Vec maxY = Isa::Set1(-FLT_MAX);
+
+			for (int corner = 0; corner < 8; corner++)
+			{
+				const int ix = (corner >> 0) & 1;
+				const int iy = (corner >> 1) & 1;
+				const int iz = (corner >> 2) & 1;
+
+				const Vec px = Isa::Add(vp.X[3], Isa::Add(xTerm[0][ix], Isa::Add(yTerm[0][iy], zTerm[0][iz])));
+				const Vec py = Isa::Add(vp.Y[3], Isa::Add(xTerm[1][ix], Isa::Add(yTerm[1][iy], zTerm[1][iz])));
+				const Vec pw = Isa::Add(vp.W[3], Isa::Add(xTerm[2][ix], Isa::Add(yTerm[2][iy], zTerm[2][iz])));
+
+				const Vec ndcX = Isa::Div(px, pw);
+				const Vec ndcY = Isa::Div(py, pw);
+
+				minX = Isa::Min(minX, ndcX);
+				minY = Isa::Min(minY, ndcY);
+				maxX = Isa::Max(maxX, ndcX);
+				maxY = Isa::Max(maxY, ndcY);
+			}
+
+			StoreLanes<Isa>(Out.XMin, i, Count, minX);
+			StoreLanes<Isa>(Out.YMin, i, Count, minY);
+			StoreLanes<Isa>(Out.XMax, i, Count, maxX);
+			StoreLanes<Isa>(Out.YMax, i, Count, maxY);
+			StoreLanes<Isa>(Out.WMin, i, Count, minW);
+			SetUnknownBits<Isa>(Unknown, i, Count, unknown);
+		}
+	}
+}
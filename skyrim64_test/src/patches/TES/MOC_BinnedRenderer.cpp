@@ -0,0 +1,127 @@
+#include <thread>
+#include "../../common.h"
+#include <MaskedOcclusionCulling/CullingThreadpool.h>
+#include "MOC_BinnedRenderer.h"
+
+MOC_BinnedRenderer::MOC_BinnedRenderer(uint32_t Width, uint32_t Height, uint32_t Threads, uint32_t BinsW, uint32_t BinsH, bool EnableCPUConservation)
+	: MOC_Renderer(Width, Height, EnableCPUConservation)
+{
+	AssertMsg(BinsW * BinsH >= Threads, "Need at least one bin per rasterizer thread");
+
+	m_Buffer = MaskedOcclusionCulling::Create();
+	m_Buffer->SetResolution(m_RenderWidth, m_RenderHeight);
+	m_Buffer->ClearBuffer();
+
+	m_Pool = new CullingThreadpool(Threads, BinsW, BinsH);
+	m_Pool->SetBuffer(m_Buffer);
+	m_PoolAwake = false;
+
+	m_ThreadExited.store(false);
+
+	std::thread submitThread(&MOC_BinnedRenderer::SubmitThread, this);
+	submitThread.detach();
+}
+
+MOC_BinnedRenderer::~MOC_BinnedRenderer()
+{
+	CullPacket p;
+	p.UserData = nullptr;
+	p.Type = CULL_TERMINATE_THREAD;
+
+	PushPacket(p);
+
+	while (!m_ThreadExited.load())
+		_mm_pause();
+
+	delete m_Pool;
+	MaskedOcclusionCulling::Destroy(m_Buffer);
+}
+
+void MOC_BinnedRenderer::Clear()
+{
+	// Rasterizer threads sleep between frames. Waking them takes ~100us, so do it before the traversal submits anything.
+	if (!m_PoolAwake)
+	{
+		m_Pool->WakeThreads();
+		m_PoolAwake = true;
+	}
+
+	m_Pool->ClearBuffer();
+}
+
+void MOC_BinnedRenderer::Resize(uint32_t Width, uint32_t Height)
+{
+	MOC_Renderer::Resize(Width, Height);
+
+	// Also rebuilds the bin scissors
+	m_Pool->SetResolution(Width, Height);
+	m_Buffer->ClearBuffer();
+}
+
+void MOC_BinnedRenderer::SubmitThread()
+{
+	XUtil::SetThreadName(GetCurrentThreadId(), "MOC_BinnedRenderer Submit");
+
+	CullPacket p;
+
+	while (true)
+	{
+		PopPacket(p);
+
+		switch (p.Type)
+		{
+		case CULL_TRAVERSE_SCENE:
+		{
+			if (m_TraverseSceneCallback)
+				m_TraverseSceneCallback(p.UserData);
+		}
+		break;
+
+		case CULL_RENDER_GEOMETRY:
+		{
+			ProfileTimerHistogram("MOC RenderGeometry");
+			MOC_ScopedTicks ticks { m_RasterTicks };
+			MOC_OccluderDraw draw;
+
+			// The matrix is copied into the pool's state ring. Vertex and index data must stay alive until the
+			// next Flush(), which the mesh cache guarantees by holding freed meshes back for a frame.
+			if (m_PrepareGeometryCallback && m_PrepareGeometryCallback(p.UserData, &draw))
+			{
+				m_Pool->SetMatrix(draw.ModelToClip);
+				m_Pool->RenderTrianglesQuantized(draw.Vertices, draw.Indices, draw.TriangleCount, draw.Winding, MaskedOcclusionCulling::CLIP_PLANE_SIDES);
+			}
+		}
+		break;
+
+		case CULL_FLUSH:
+		{
+			// Binning is timed above, this is waiting on the rasterizer threads
+			{
+				MOC_ScopedTicks ticks { m_RasterTicks };
+				m_Pool->Flush();
+			}
+
+			if (m_PoolAwake)
+			{
+				m_Pool->SuspendThreads();
+				m_PoolAwake = false;
+			}
+
+			// Notify whoever was waiting for this
+			PublishFinalBuffer(m_Buffer);
+		}
+		break;
+
+		case CULL_TERMINATE_THREAD:
+		{
+			// !!!!!!!!!!!!!!!!!!!!!!!!!!!
+			// !!!! THREAD EXITS HERE !!!!
+			// !!!!!!!!!!!!!!!!!!!!!!!!!!!
+			m_Pool->Flush();
+			m_ThreadExited.store(true);
+			return;
+		}
+		break;
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "MOC_Renderer.h"
+
+class CullingThreadpool;
+
+//
+// One shared buffer split into screen space bins. A single submit thread runs the callbacks and feeds Intel's
+// CullingThreadpool, which bins triangles and rasterizes each bin on its own worker. There's nothing to merge on
+// Flush() and memory doesn't grow with the thread count.
+//
+class MOC_BinnedRenderer : public MOC_Renderer
+{
+private:
+	MaskedOcclusionCulling *m_Buffer;
+	CullingThreadpool *m_Pool;
+	bool m_PoolAwake;						// Only touched by the submit thread
+	std::atomic_bool m_ThreadExited;
+
+public:
+	MOC_BinnedRenderer(uint32_t Width, uint32_t Height, uint32_t Threads, uint32_t BinsW, uint32_t BinsH, bool EnableCPUConservation = true);
+	virtual ~MOC_BinnedRenderer();
+
+	virtual void Clear() override;
+	virtual void Resize(uint32_t Width, uint32_t Height) override;
+
+private:
+	void SubmitThread();
+};
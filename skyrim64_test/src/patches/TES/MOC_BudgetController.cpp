@@ -0,0 +1,117 @@
+#include <assert.h>
+#include <algorithm>
+#include "../../profiler_clock.h"
+#include "MOC_BudgetController.h"
+
+MOC_BudgetController::MOC_BudgetController(const Resolution *Levels, uint32_t LevelCount)
+{
+	assert(LevelCount > 0);
+
+	m_Levels = Levels;
+	m_LevelCount = LevelCount;
+	m_Level = 0;
+
+	m_OccluderBudget = UnlimitedOccluders;
+	m_OverFrames = 0;
+	m_UnderFrames = 0;
+	m_Cooldown = 0;
+
+	m_RasterMs = 0.0f;
+	m_QueryMs = 0.0f;
+	m_TargetMs = 0.0f;
+	m_Enabled = false;
+}
+
+bool MOC_BudgetController::Update(bool Enabled, float TargetMs, uint64_t RasterTicks, uint64_t QueryTicks, uint32_t OccludersSubmitted)
+{
+	m_Enabled = Enabled;
+	m_TargetMs = TargetMs;
+
+	m_RasterMs += ((float)Profiler::Clock::TicksToMs(RasterTicks) - m_RasterMs) * Smoothing;
+	m_QueryMs += ((float)Profiler::Clock::TicksToMs(QueryTicks) - m_QueryMs) * Smoothing;
+
+	if (!Enabled)
+	{
+		m_OccluderBudget = UnlimitedOccluders;
+		m_OverFrames = 0;
+		m_UnderFrames = 0;
+		m_Cooldown = 0;
+
+		return SetLevel(0);
+	}
+
+	if (m_Cooldown > 0)
+		m_Cooldown--;
+
+	const float cost = m_RasterMs + m_QueryMs;
+	const float upper = TargetMs * (1.0f + Hysteresis);
+	const float lower = TargetMs * (1.0f - Hysteresis);
+
+	if (cost > upper)
+	{
+		m_UnderFrames = 0;
+		m_OverFrames++;
+
+		// Occluders are submitted nearest first, so this drops the farthest ones. Steps are small because the average
+		// lags a few frames behind.
+		uint32_t current = std::min(m_OccluderBudget, OccludersSubmitted);
+		m_OccluderBudget = std::max(current - (current / 32), MinOccluders);
+
+		// Trimming occluders wasn't enough
+		if (m_OverFrames >= ResizeFrames && m_Cooldown == 0 && (m_Level + 1) < m_LevelCount)
+			return SetLevel(m_Level + 1);
+	}
+	else if (cost < lower)
+	{
+		m_OverFrames = 0;
+
+		if (m_OccluderBudget != UnlimitedOccluders)
+		{
+			// Give occluders back before resolution
+			if (OccludersSubmitted < m_OccluderBudget)
+				m_OccluderBudget = UnlimitedOccluders;
+			else
+				m_OccluderBudget += std::max(m_OccluderBudget / 64, 1u);
+
+			m_UnderFrames = 0;
+		}
+		else if (m_Level > 0 && (m_RasterMs * GetAreaRatio(m_Level, m_Level - 1)) + m_QueryMs < lower)
+		{
+			// Only step up when the larger buffer is predicted to still be under the band
+			if (++m_UnderFrames >= ResizeFrames && m_Cooldown == 0)
+				return SetLevel(m_Level - 1);
+		}
+		else
+		{
+			m_UnderFrames = 0;
+		}
+	}
+	else
+	{
+		m_OverFrames = 0;
+		m_UnderFrames = 0;
+	}
+
+	return false;
+}
+
+float MOC_BudgetController::GetAreaRatio(uint32_t From, uint32_t To) const
+{
+	return (float)(m_Levels[To].Width * m_Levels[To].Height) / (float)(m_Levels[From].Width * m_Levels[From].Height);
+}
+
+bool MOC_BudgetController::SetLevel(uint32_t Level)
+{
+	if (Level == m_Level)
+		return false;
+
+	// Rasterization scales with the pixel count. Queries don't.
+	m_RasterMs *= GetAreaRatio(m_Level, Level);
+
+	m_Level = Level;
+	m_OverFrames = 0;
+	m_UnderFrames = 0;
+	m_Cooldown = ResizeCooldownFrames;
+
+	return true;
+}
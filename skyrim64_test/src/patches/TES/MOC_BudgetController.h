@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+
+//
+// Keeps the per-frame occlusion culling cost (occluder rasterization + occludee queries) near a millisecond target by
+// trading quality for time. The occluder budget (how many of the nearest occluders get drawn) moves a little every
+// frame. Resolution changes drop the warped buffer and reallocate everything, so they only happen after the cost has
+// been outside the hysteresis band for ResizeFrames in a row and never within ResizeCooldownFrames of the last one.
+//
+// Costs are measured in profiler clock ticks (Profiler::Clock::Now) by the callers and converted here. Nothing in here
+// depends on the game, so headless_tests can build it.
+//
+class MOC_BudgetController
+{
+public:
+	struct Resolution
+	{
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	constexpr static uint32_t UnlimitedOccluders = UINT32_MAX;
+	constexpr static uint32_t MinOccluders = 32;
+	constexpr static float Hysteresis = 0.1f;			// Dead band around the target, as a fraction of it
+	constexpr static float Smoothing = 0.1f;			// Weight of the newest frame in the moving averages
+	constexpr static uint32_t ResizeFrames = 30;
+	constexpr static uint32_t ResizeCooldownFrames = 120;
+
+private:
+	const Resolution *m_Levels;		// Largest first
+	uint32_t m_LevelCount;
+	uint32_t m_Level;
+
+	uint32_t m_OccluderBudget;
+	uint32_t m_OverFrames;
+	uint32_t m_UnderFrames;
+	uint32_t m_Cooldown;
+
+	float m_RasterMs;
+	float m_QueryMs;
+	float m_TargetMs;
+	bool m_Enabled;
+
+public:
+	MOC_BudgetController(const Resolution *Levels, uint32_t LevelCount);
+
+	// Called once per frame after the previous frame's rasterization and queries are complete. Returns true if the
+	// resolution changed.
+	bool Update(bool Enabled, float TargetMs, uint64_t RasterTicks, uint64_t QueryTicks, uint32_t OccludersSubmitted);
+
+	uint32_t GetWidth() const
+	{
+		return m_Levels[m_Level].Width;
+	}
+
+	uint32_t GetHeight() const
+	{
+		return m_Levels[m_Level].Height;
+	}
+
+	uint32_t GetLevel() const
+	{
+		return m_Level;
+	}
+
+	uint32_t GetLevelCount() const
+	{
+		return m_LevelCount;
+	}
+
+	const Resolution& GetResolution(uint32_t Level) const
+	{
+		return m_Levels[Level];
+	}
+
+	uint32_t GetOccluderBudget() const
+	{
+		return m_OccluderBudget;
+	}
+
+	uint32_t GetResizeCooldown() const
+	{
+		return m_Cooldown;
+	}
+
+	float GetRasterMs() const
+	{
+		return m_RasterMs;
+	}
+
+	float GetQueryMs() const
+	{
+		return m_QueryMs;
+	}
+
+	float GetTargetMs() const
+	{
+		return m_TargetMs;
+	}
+
+	bool IsEnabled() const
+	{
+		return m_Enabled;
+	}
+
+private:
+	float GetAreaRatio(uint32_t From, uint32_t To) const;
+	bool SetLevel(uint32_t Level);
+};
@@ -0,0 +1,145 @@
+#include "../../common.h"
+#include "MOC_FrameCapture.h"
+#include "MOC_Renderer.h"
+
+MOC_FrameCapture::MOC_FrameCapture()
+{
+	InitializeSRWLock(&m_Lock);
+	m_Active.store(false);
+	memset(&m_Header, 0, sizeof(m_Header));
+	memset(&m_BoundsHeader, 0, sizeof(m_BoundsHeader));
+}
+
+void MOC_FrameCapture::Begin(uint32_t Width, uint32_t Height, const float *View, const float *ViewProj, const float *Position)
+{
+	AcquireSRWLockExclusive(&m_Lock);
+
+	m_DrawData.clear();
+	m_Queries.clear();
+	m_Bounds.clear();
+
+	memset(&m_Header, 0, sizeof(m_Header));
+	m_Header.Magic = MOC_FrameCaptureFormat::Magic;
+	m_Header.Version = MOC_FrameCaptureFormat::Version;
+	m_Header.Width = Width;
+	m_Header.Height = Height;
+	memcpy(m_Header.ViewProj, ViewProj, sizeof(m_Header.ViewProj));
+	memcpy(m_Header.Position, Position, sizeof(m_Header.Position));
+
+	memset(&m_BoundsHeader, 0, sizeof(m_BoundsHeader));
+	memcpy(m_BoundsHeader.View, View, sizeof(m_BoundsHeader.View));
+
+	ReleaseSRWLockExclusive(&m_Lock);
+
+	m_Active.store(true, std::memory_order_release);
+}
+
+bool MOC_FrameCapture::End(const char *FilePath)
+{
+	m_Active.store(false, std::memory_order_release);
+
+	// Wait out anyone still appending
+	AcquireSRWLockExclusive(&m_Lock);
+
+	m_Header.QueryCount = (uint32_t)m_Queries.size();
+	m_BoundsHeader.BoundsCount = (uint32_t)m_Bounds.size();
+	bool written = false;
+
+	if (FILE *f; fopen_s(&f, FilePath, "wb") == 0)
+	{
+		written = fwrite(&m_Header, sizeof(m_Header), 1, f) == 1;
+
+		if (written && !m_DrawData.empty())
+			written = fwrite(m_DrawData.data(), m_DrawData.size(), 1, f) == 1;
+
+		if (written && !m_Queries.empty())
+			written = fwrite(m_Queries.data(), m_Queries.size() * sizeof(MOC_FrameCaptureFormat::Query), 1, f) == 1;
+
+		if (written)
+			written = fwrite(&m_BoundsHeader, sizeof(m_BoundsHeader), 1, f) == 1;
+
+		if (written && !m_Bounds.empty())
+			written = fwrite(m_Bounds.data(), m_Bounds.size() * sizeof(MOC_FrameCaptureFormat::Bounds), 1, f) == 1;
+
+		fclose(f);
+	}
+
+	// Don't hold on to a whole frame of geometry
+	m_DrawData = std::vector<uint8_t>();
+	m_Queries = std::vector<MOC_FrameCaptureFormat::Query>();
+	m_Bounds = std::vector<MOC_FrameCaptureFormat::Bounds>();
+
+	ReleaseSRWLockExclusive(&m_Lock);
+	return written;
+}
+
+void MOC_FrameCapture::AddDraw(const MOC_OccluderDraw& Draw)
+{
+	// Vertices are shared between LODs, so only keep the ones this draw can reach
+	uint32_t vertexCount = 0;
+
+	for (uint32_t i = 0; i < Draw.TriangleCount * 3; i++)
+		vertexCount = std::max<uint32_t>(vertexCount, Draw.Indices[i] + 1);
+
+	MOC_FrameCaptureFormat::Draw record;
+	memcpy(record.ModelToClip, Draw.ModelToClip, sizeof(record.ModelToClip));
+	record.Winding = (uint32_t)Draw.Winding;
+	record.VertexCount = vertexCount;
+	record.TriangleCount = Draw.TriangleCount;
+
+	const size_t vertexBytes = vertexCount * sizeof(uint16_t) * 4;
+	const size_t indexBytes = Draw.TriangleCount * sizeof(uint16_t) * 3;
+
+	AcquireSRWLockExclusive(&m_Lock);
+
+	if (IsActive())
+	{
+		size_t offset = m_DrawData.size();
+		m_DrawData.resize(offset + sizeof(record) + vertexBytes + indexBytes);
+
+		uint8_t *out = m_DrawData.data() + offset;
+		memcpy(out, &record, sizeof(record));
+		memcpy(out + sizeof(record), Draw.Vertices, vertexBytes);
+		memcpy(out + sizeof(record) + vertexBytes, Draw.Indices, indexBytes);
+
+		m_Header.DrawCount++;
+	}
+
+	ReleaseSRWLockExclusive(&m_Lock);
+}
+
+void MOC_FrameCapture::AddQuery(float XMin, float YMin, float XMax, float YMax, float WMin, uint32_t Result)
+{
+	AcquireSRWLockExclusive(&m_Lock);
+
+	if (IsActive())
+		m_Queries.push_back({ XMin, YMin, XMax, YMax, WMin, Result });
+
+	ReleaseSRWLockExclusive(&m_Lock);
+}
+
+void MOC_FrameCapture::AddSpheres(const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count)
+{
+	AcquireSRWLockExclusive(&m_Lock);
+
+	if (IsActive())
+	{
+		for (uint32_t i = 0; i < Count; i++)
+			m_Bounds.push_back({ MOC_FrameCaptureFormat::BoundsSphere, { X[i], Y[i], Z[i] }, { Radius[i], 0.0f, 0.0f } });
+	}
+
+	ReleaseSRWLockExclusive(&m_Lock);
+}
+
+void MOC_FrameCapture::AddAABBs(const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count)
+{
+	AcquireSRWLockExclusive(&m_Lock);
+
+	if (IsActive())
+	{
+		for (uint32_t i = 0; i < Count; i++)
+			m_Bounds.push_back({ MOC_FrameCaptureFormat::BoundsAABB, { CenterX[i], CenterY[i], CenterZ[i] }, { HalfX[i], HalfY[i], HalfZ[i] } });
+	}
+
+	ReleaseSRWLockExclusive(&m_Lock);
+}
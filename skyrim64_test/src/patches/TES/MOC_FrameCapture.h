@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "../../common.h"
+#include "MOC_FrameCaptureFormat.h"
+
+struct MOC_OccluderDraw;
+
+//
+// Records one frame of MOC work (camera, every prepared occluder draw, every occludee rect query and the bounds of
+// batched queries) so that it can be replayed outside of the game. Draws and queries may be added from any thread while a capture is active. Nothing is
+// written to disk until End().
+//
+class MOC_FrameCapture
+{
+private:
+	SRWLOCK m_Lock;
+	std::atomic_bool m_Active;
+
+	MOC_FrameCaptureFormat::Header m_Header;
+	MOC_FrameCaptureFormat::BoundsHeader m_BoundsHeader;
+	std::vector<uint8_t> m_DrawData;
+	std::vector<MOC_FrameCaptureFormat::Query> m_Queries;
+	std::vector<MOC_FrameCaptureFormat::Bounds> m_Bounds;
+
+public:
+	MOC_FrameCapture();
+
+	void Begin(uint32_t Width, uint32_t Height, const float *View, const float *ViewProj, const float *Position);
+	bool End(const char *FilePath);
+
+	void AddDraw(const MOC_OccluderDraw& Draw);
+	void AddQuery(float XMin, float YMin, float XMax, float YMax, float WMin, uint32_t Result);
+	void AddSpheres(const float *X, const float *Y, const float *Z, const float *Radius, uint32_t Count);
+	void AddAABBs(const float *CenterX, const float *CenterY, const float *CenterZ, const float *HalfX, const float *HalfY, const float *HalfZ, uint32_t Count);
+
+	bool IsActive() const
+	{
+		return m_Active.load(std::memory_order_acquire);
+	}
+
+	uint32_t GetDrawCount() const
+	{
+		return m_Header.DrawCount;
+	}
+
+	uint32_t GetQueryCount() const
+	{
+		return m_Header.QueryCount;
+	}
+};
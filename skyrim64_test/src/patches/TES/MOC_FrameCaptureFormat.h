@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+
+//
+// On-disk layout of a captured MOC frame (see MOC_FrameCapture). Shared with the standalone replayer, so this header
+// must not depend on anything from the game or Windows.
+//
+// File layout, little endian, tightly packed:
+//
+//   Header
+//   Header.DrawCount x { Draw, Vertices[Draw.VertexCount * 4], Indices[Draw.TriangleCount * 3] }
+//   Header.QueryCount x Query
+//   (version 2+) BoundsHeader
+//   (version 2+) BoundsHeader.BoundsCount x Bounds
+//
+// Version 3+ stores the mesh cache's data as-is: uint16_t vertices in MOC's (x, y, 0, w) layout, dequantized by
+// ModelToClip (MaskedOcclusionCulling::RenderTrianglesQuantized), and uint16_t indices. Older versions have float
+// vertices and uint32_t indices. Draws are in the order they were prepared, which isn't necessarily the order the
+// backend rasterized them.
+//
+// Bounds are the batched occludee queries (MOC::TestSpheres/TestAABBs) before projection, so the projection kernels
+// can be replayed as well. Version 1 files simply end after the queries.
+//
+namespace MOC_FrameCaptureFormat
+{
+	constexpr static uint32_t Magic = 0x46434F4D;	// 'MOCF'
+	constexpr static uint32_t Version = 3;
+
+	// Query.Result when the occludee was decided without touching the MOC buffer (depth reprojection)
+	constexpr static uint32_t ResultNotTested = 0xFFFFFFFF;
+
+#pragma pack(push, 1)
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t Width;
+		uint32_t Height;
+		float ViewProj[16];
+		float Position[3];
+		uint32_t DrawCount;
+		uint32_t QueryCount;
+	};
+
+	struct Draw
+	{
+		float ModelToClip[16];
+		uint32_t Winding;			// MaskedOcclusionCulling::BackfaceWinding
+		uint32_t VertexCount;
+		uint32_t TriangleCount;
+	};
+
+	struct Query
+	{
+		float XMin;
+		float YMin;
+		float XMax;
+		float YMax;
+		float WMin;
+		uint32_t Result;			// MaskedOcclusionCulling::CullingResult or ResultNotTested
+	};
+
+	struct BoundsHeader
+	{
+		float View[16];				// MOC_BatchCull::Camera::View, Header has the rest of the camera
+		uint32_t BoundsCount;
+	};
+
+	enum BoundsType : uint32_t
+	{
+		BoundsSphere = 0,
+		BoundsAABB = 1,
+	};
+
+	struct Bounds
+	{
+		uint32_t Type;				// BoundsType
+		float Center[3];
+		float Extent[3];			// Radius in [0] for spheres, half extents for boxes
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(Header) == 0x64);
+	static_assert(sizeof(Draw) == 0x4C);
+	static_assert(sizeof(Query) == 0x18);
+	static_assert(sizeof(BoundsHeader) == 0x44);
+	static_assert(sizeof(Bounds) == 0x1C);
+}
@@ -0,0 +1,154 @@
+#include <assert.h>
+#include <float.h>
+#include <string.h>
+#include <smmintrin.h>
+#include <algorithm>
+#include <vector>
+#include "MOC_MeshBuild.h"
+
+namespace MOC_MeshBuild
+{
+	uint16_t *QuantizeVerts(const void *Input, uint32_t Count, uint32_t ByteStride, float *Scale, float *Offset)
+	{
+		assert(ByteStride >= 16);
+
+		//
+		// Positions are the first 3 floats of each vertex. Lanes are swizzled to MOC's layout up front:
+		//
+		// X -> X
+		// Y -> Y
+		// 0 -> (unused by MOC)
+		// Z -> W
+		//
+		auto loadPosition = [&](uint32_t Index)
+		{
+			__m128 p = _mm_loadu_ps((const float *)((uintptr_t)Input + (Index * ByteStride)));
+			return _mm_blend_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 1, 0)), _mm_setzero_ps(), 0x4);
+		};
+
+		__m128 mins = _mm_set1_ps(FLT_MAX);
+		__m128 maxs = _mm_set1_ps(-FLT_MAX);
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			__m128 p = loadPosition(i);
+			mins = _mm_min_ps(mins, p);
+			maxs = _mm_max_ps(maxs, p);
+		}
+
+		// Flat axes get a scale of 0 and every vertex lands on the offset
+		__m128 extents = _mm_sub_ps(maxs, mins);
+		__m128 nonZero = _mm_cmpgt_ps(extents, _mm_setzero_ps());
+		__m128 quantScale = _mm_and_ps(_mm_div_ps(_mm_set1_ps(65535.0f), extents), nonZero);
+		__m128 dequantScale = _mm_mul_ps(extents, _mm_set1_ps(1.0f / 65535.0f));
+
+		alignas(16) float scale[4];
+		alignas(16) float offset[4];
+		_mm_store_ps(scale, dequantScale);
+		_mm_store_ps(offset, mins);
+
+		Scale[0] = scale[0];
+		Scale[1] = scale[1];
+		Scale[2] = scale[3];
+		Offset[0] = offset[0];
+		Offset[1] = offset[1];
+		Offset[2] = offset[3];
+
+		uint16_t *out = new uint16_t[Count * 4];
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			// Round to nearest, packus clamps to [0, 65535]
+			__m128 q = _mm_mul_ps(_mm_sub_ps(loadPosition(i), mins), quantScale);
+			__m128i qi = _mm_cvtps_epi32(q);
+
+			_mm_storel_epi64((__m128i *)&out[i * 4], _mm_packus_epi32(qi, qi));
+		}
+
+		return out;
+	}
+
+	//
+	// Occluders don't need full detail. LOD 0 is capped at the triangle budget and each following level has roughly
+	// a quarter of the previous one's triangles. The chain stops early once meshoptimizer can't remove enough
+	// triangles without exceeding the error limit.
+	//
+	const float LodTargetError[MaxLods] = { 0.01f, 0.02f, 0.05f, 0.10f };
+
+	uint16_t *BuildLods(const uint16_t *Indices, uint32_t IndexCount, const void *VertexData, uint32_t VertexCount, uint32_t VertexStride, uint32_t TriangleBudget, SimplifyFunc Simplify, uint32_t *LodOffsets, uint32_t *LodCount)
+	{
+		// meshoptimizer only takes 32-bit indices
+		const std::vector<uint32_t> fullIndices(Indices, Indices + IndexCount);
+		std::vector<uint32_t> lods[MaxLods];
+		uint32_t count = 0;
+		uint32_t totalIndices = 0;
+
+		uint32_t targetTriangles = std::min(IndexCount / 3, std::max(TriangleBudget, 1u));
+
+		for (; count < MaxLods; count++)
+		{
+			const uint32_t *source = (count == 0) ? fullIndices.data() : lods[count - 1].data();
+			uint32_t sourceCount = (count == 0) ? IndexCount : (uint32_t)lods[count - 1].size();
+
+			lods[count].resize(sourceCount);
+
+			if (count == 0 && targetTriangles * 3 >= sourceCount)
+			{
+				// Already within budget
+				memcpy(lods[count].data(), source, sourceCount * sizeof(uint32_t));
+			}
+			else
+			{
+				const uint32_t targetIndices = std::max(targetTriangles * 3, 3u);
+				size_t newCount = Simplify(lods[count].data(), source, sourceCount, (const float *)VertexData, VertexCount, VertexStride, targetIndices, LodTargetError[count]);
+
+				// Not worth another level if it barely changed or there's nothing left
+				if (count > 0 && (newCount == 0 || newCount > (sourceCount - (sourceCount / 4))))
+					break;
+
+				// A budget that leaves nothing recognizable (or nothing at all) would stop the mesh occluding. Draw it at
+				// full detail instead.
+				if (count == 0 && (newCount / 3) < LodMinTriangles)
+				{
+					memcpy(lods[count].data(), source, sourceCount * sizeof(uint32_t));
+					newCount = sourceCount;
+				}
+
+				lods[count].resize(newCount);
+			}
+
+			totalIndices += (uint32_t)lods[count].size();
+
+			if ((lods[count].size() / 3) <= LodMinTriangles)
+			{
+				count++;
+				break;
+			}
+
+			targetTriangles = std::max<uint32_t>((uint32_t)lods[count].size() / 3 / 4, LodMinTriangles / 2);
+		}
+
+		uint16_t *out = new uint16_t[totalIndices];
+		LodOffsets[0] = 0;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			std::copy(lods[i].begin(), lods[i].end(), &out[LodOffsets[i]]);
+			LodOffsets[i + 1] = LodOffsets[i] + (uint32_t)lods[i].size();
+		}
+
+		*LodCount = count;
+		return out;
+	}
+
+	uint32_t SelectLod(float ScreenSize, uint32_t LodCount)
+	{
+		uint32_t lod = 0;
+
+		// Each LOD has ~4x fewer triangles, so halve the screen size threshold per level
+		for (float threshold = 0.5f; lod + 1 < LodCount && ScreenSize < threshold; threshold *= 0.5f)
+			lod++;
+
+		return lod;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Occluder mesh conversion done once per mesh when it enters MOC_MeshCache. Shared with headless_tests, so this must
+// not depend on anything from the game or Windows.
+//
+namespace MOC_MeshBuild
+{
+	constexpr uint32_t MaxLods = 4;
+	constexpr uint32_t LodMinTriangles = 32;
+
+	// meshopt_simplify()'s signature. Passed in so the LOD chain can be tested without meshoptimizer.
+	using SimplifyFunc = size_t(*)(uint32_t *Destination, const uint32_t *Indices, size_t IndexCount, const float *Vertices, size_t VertexCount, size_t VertexStride, size_t TargetIndexCount, float TargetError);
+
+	// Quantizes the first 3 floats of each vertex to 16 bits inside the mesh's bounding box. Output is Count * 4 values
+	// in MOC's (x, y, 0, z) layout, position = Offset + Output * Scale. ByteStride must be at least 16 since positions
+	// are loaded 16 bytes at a time. Flat axes get a scale of 0.
+	uint16_t *QuantizeVerts(const void *Input, uint32_t Count, uint32_t ByteStride, float *Scale, float *Offset);
+
+	// Reduces a mesh to a chain of up to MaxLods LODs, all in the returned array. LOD N is Output[LodOffsets[N]] to
+	// Output[LodOffsets[N + 1]] and LodOffsets needs MaxLods + 1 entries. LOD 0 is never empty for a mesh with at
+	// least one triangle.
+	uint16_t *BuildLods(const uint16_t *Indices, uint32_t IndexCount, const void *VertexData, uint32_t VertexCount, uint32_t VertexStride, uint32_t TriangleBudget, SimplifyFunc Simplify, uint32_t *LodOffsets, uint32_t *LodCount);
+
+	// ScreenSize is the projected bounding sphere radius relative to half the screen height
+	uint32_t SelectLod(float ScreenSize, uint32_t LodCount);
+}
@@ -0,0 +1,219 @@
+#include "../../common.h"
+#include "MOC_MeshCache.h"
+
+MOC_MeshCache::MOC_MeshCache()
+{
+	m_MemoryUsage.store(0);
+	m_EntryCount.store(0);
+	m_CurrentFrame.store(0);
+
+	InitializeSRWLock(&m_RetireLock);
+}
+
+MOC_MeshCache::~MOC_MeshCache()
+{
+	for (Shard& shard : m_Shards)
+	{
+		for (auto& [key, entry] : shard.Map)
+			FreeEntry(entry);
+	}
+
+	for (Entry *entry : m_Retired)
+		FreeEntry(entry);
+}
+
+bool MOC_MeshCache::Lookup(const void *Key, Mesh *Data)
+{
+	Shard& shard = GetShard(Key);
+	const uint32_t frame = m_CurrentFrame.load(std::memory_order_relaxed);
+
+	AcquireSRWLockShared(&shard.Lock);
+
+	auto itr = shard.Map.find(Key);
+	bool found = itr != shard.Map.end();
+
+	if (found)
+	{
+		Entry *entry = itr->second;
+		*Data = entry->Data;
+
+		// Avoid dirtying the cache line on every hit
+		if (entry->LastUsedFrame.load(std::memory_order_relaxed) != frame)
+			entry->LastUsedFrame.store(frame, std::memory_order_relaxed);
+	}
+
+	ReleaseSRWLockShared(&shard.Lock);
+
+	if (found)
+		ProfileCounterInc("MOC CacheHits");
+	else
+		ProfileCounterInc("MOC CacheMisses");
+
+	return found;
+}
+
+MOC_MeshCache::Mesh MOC_MeshCache::Insert(const void *Key, const Mesh& Data)
+{
+	Entry *entry = new Entry;
+	entry->Data = Data;
+	entry->Bytes = (Data.LodOffsets[Data.LodCount] * sizeof(uint16_t)) + (Data.VertexCount * sizeof(uint16_t) * 4);
+	entry->LastUsedFrame.store(m_CurrentFrame.load(std::memory_order_relaxed));
+
+	Shard& shard = GetShard(Key);
+
+	AcquireSRWLockExclusive(&shard.Lock);
+
+	// Conversion happens outside of the lock, so another thread might have won the race. Keep the first copy.
+	auto [itr, inserted] = shard.Map.try_emplace(Key, entry);
+	Mesh result = itr->second->Data;
+
+	ReleaseSRWLockExclusive(&shard.Lock);
+
+	if (inserted)
+	{
+		m_MemoryUsage += entry->Bytes;
+		m_EntryCount++;
+	}
+	else
+	{
+		FreeEntry(entry);
+	}
+
+	return result;
+}
+
+void MOC_MeshCache::Remove(const void *Key)
+{
+	Shard& shard = GetShard(Key);
+	Entry *entry = nullptr;
+
+	AcquireSRWLockExclusive(&shard.Lock);
+
+	if (auto itr = shard.Map.find(Key); itr != shard.Map.end())
+	{
+		entry = itr->second;
+		shard.Map.erase(itr);
+	}
+
+	ReleaseSRWLockExclusive(&shard.Lock);
+
+	if (entry)
+		Retire(entry);
+}
+
+void MOC_MeshCache::NextFrame(uint64_t BudgetBytes)
+{
+	// Anything retired last frame can't be referenced by a worker anymore
+	std::vector<Entry *> retired;
+
+	AcquireSRWLockExclusive(&m_RetireLock);
+	retired.swap(m_Retired);
+	ReleaseSRWLockExclusive(&m_RetireLock);
+
+	for (Entry *entry : retired)
+		FreeEntry(entry);
+
+	m_CurrentFrame++;
+
+	// Evict down to 7/8 of the budget so that this doesn't run again every single frame
+	if (m_MemoryUsage.load() > BudgetBytes)
+		Evict(BudgetBytes - (BudgetBytes / 8));
+}
+
+uint64_t MOC_MeshCache::GetMemoryUsage() const
+{
+	return m_MemoryUsage.load();
+}
+
+uint32_t MOC_MeshCache::GetEntryCount() const
+{
+	return m_EntryCount.load();
+}
+
+MOC_MeshCache::Shard& MOC_MeshCache::GetShard(const void *Key)
+{
+	// Renderer data allocations are at least 16 byte aligned, so skip the low bits
+	uintptr_t hash = (uintptr_t)Key >> 4;
+	hash ^= hash >> 7;
+
+	return m_Shards[hash & (ShardCount - 1)];
+}
+
+void MOC_MeshCache::Evict(uint64_t TargetBytes)
+{
+	ProfileTimer("MOC CacheEvict");
+
+	struct Candidate
+	{
+		uint32_t LastUsedFrame;
+		uint32_t ShardIndex;
+		const void *Key;
+	};
+
+	const uint32_t frame = m_CurrentFrame.load();
+	std::vector<Candidate> candidates;
+
+	// Only entries that weren't touched last frame or this frame are safe to throw out
+	for (uint32_t i = 0; i < ShardCount; i++)
+	{
+		AcquireSRWLockShared(&m_Shards[i].Lock);
+
+		for (auto& [key, entry] : m_Shards[i].Map)
+		{
+			uint32_t lastUsed = entry->LastUsedFrame.load(std::memory_order_relaxed);
+
+			if ((frame - lastUsed) > 1)
+				candidates.push_back({ lastUsed, i, key });
+		}
+
+		ReleaseSRWLockShared(&m_Shards[i].Lock);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [frame](const Candidate& A, const Candidate& B)
+	{
+		return (frame - A.LastUsedFrame) > (frame - B.LastUsedFrame);
+	});
+
+	for (const Candidate& candidate : candidates)
+	{
+		if (m_MemoryUsage.load() <= TargetBytes)
+			break;
+
+		Shard& shard = m_Shards[candidate.ShardIndex];
+		Entry *entry = nullptr;
+
+		AcquireSRWLockExclusive(&shard.Lock);
+
+		// Recheck. It might have been used or removed in the meantime.
+		if (auto itr = shard.Map.find(candidate.Key); itr != shard.Map.end() && (frame - itr->second->LastUsedFrame.load()) > 1)
+		{
+			entry = itr->second;
+			shard.Map.erase(itr);
+		}
+
+		ReleaseSRWLockExclusive(&shard.Lock);
+
+		if (entry)
+		{
+			Retire(entry);
+			ProfileCounterInc("MOC CacheEvictions");
+		}
+	}
+}
+
+void MOC_MeshCache::Retire(Entry *Item)
+{
+	m_MemoryUsage -= Item->Bytes;
+	m_EntryCount--;
+
+	AcquireSRWLockExclusive(&m_RetireLock);
+	m_Retired.push_back(Item);
+	ReleaseSRWLockExclusive(&m_RetireLock);
+}
+
+void MOC_MeshCache::FreeEntry(Entry *Item)
+{
+	delete[] Item->Data.Indices;
+	delete[] Item->Data.Vertices;
+	delete Item;
+}
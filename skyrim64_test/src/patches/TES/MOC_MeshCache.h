@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include "../../common.h"
+#include "MOC_MeshBuild.h"
+
+//
+// Converted occluder meshes keyed by renderer data (BSGraphics::TriShape). Lookups only take a shared lock on one of
+// ShardCount shards. Entries that haven't been used for a frame are evicted oldest-first once the memory budget is
+// exceeded, and freed memory is held back for one more frame because workers may still be rasterizing from it.
+//
+class MOC_MeshCache
+{
+public:
+	constexpr static uint32_t MaxLods = MOC_MeshBuild::MaxLods;
+
+	// Positions are quantized to 16 bits inside the mesh's bounding box (position = Offset + Vertices * Scale) and
+	// stored as (x, y, 0, z), which MOC reads directly (RenderTrianglesQuantized). All LODs share one vertex buffer.
+	// LOD N's indices are Indices[LodOffsets[N]] to Indices[LodOffsets[N + 1]].
+	struct Mesh
+	{
+		uint16_t *Indices;
+		uint32_t LodOffsets[MaxLods + 1];
+		uint32_t LodCount;
+		uint16_t *Vertices;
+		uint32_t VertexCount;
+		float Scale[3];
+		float Offset[3];
+
+		uint32_t GetIndexCount(uint32_t Lod) const
+		{
+			return LodOffsets[Lod + 1] - LodOffsets[Lod];
+		}
+
+		const uint16_t *GetIndices(uint32_t Lod) const
+		{
+			return &Indices[LodOffsets[Lod]];
+		}
+	};
+
+private:
+	constexpr static uint32_t ShardCount = 16;
+
+	struct Entry
+	{
+		Mesh Data;
+		uint64_t Bytes;
+		std::atomic_uint32_t LastUsedFrame;
+	};
+
+	struct alignas(64) Shard
+	{
+		SRWLOCK Lock = SRWLOCK_INIT;
+		std::unordered_map<const void *, Entry *> Map;
+	};
+
+	Shard m_Shards[ShardCount];
+	std::atomic_uint64_t m_MemoryUsage;
+	std::atomic_uint32_t m_EntryCount;
+	std::atomic_uint32_t m_CurrentFrame;
+
+	SRWLOCK m_RetireLock;
+	std::vector<Entry *> m_Retired;		// Freed on the next NextFrame() call
+
+public:
+	MOC_MeshCache();
+	~MOC_MeshCache();
+
+	bool Lookup(const void *Key, Mesh *Data);
+	Mesh Insert(const void *Key, const Mesh& Data);
+	void Remove(const void *Key);
+	void NextFrame(uint64_t BudgetBytes);
+
+	uint64_t GetMemoryUsage() const;
+	uint32_t GetEntryCount() const;
+
+private:
+	Shard& GetShard(const void *Key);
+	void Evict(uint64_t TargetBytes);
+	void Retire(Entry *Item);
+	static void FreeEntry(Entry *Item);
+};
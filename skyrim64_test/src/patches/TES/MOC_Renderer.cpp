@@ -0,0 +1,213 @@
+#include <thread>
+#include "../../common.h"
+#include "MOC_Renderer.h"
+
+MOC_Renderer::MOC_Renderer(uint32_t Width, uint32_t Height, bool EnableCPUConservation)
+{
+	m_RenderWidth = Width;
+	m_RenderHeight = Height;
+	m_MaxPixels = Width * Height;
+	m_DepthViewPixels = nullptr;
+	m_RasterTicks.store(0);
+	m_ConserveCPU = EnableCPUConservation;
+
+	m_EarlySignalStack.store(0);
+	m_PendingCount.store(0);
+	m_WakeSequence.store(0);
+	m_SleepingWorkers.store(0);
+
+	m_TraverseSceneCallback = nullptr;
+	m_PrepareGeometryCallback = nullptr;
+
+	m_FinalBuffer.store(nullptr);
+}
+
+MOC_Renderer::~MOC_Renderer()
+{
+	delete[] m_DepthViewPixels;
+}
+
+void MOC_Renderer::SetTraverseSceneCallback(TraverseSceneFunc Callback)
+{
+	InterlockedExchangePointer((volatile PVOID *)&m_TraverseSceneCallback, Callback);
+}
+
+void MOC_Renderer::SetPrepareGeometryCallback(PrepareGeometryFunc Callback)
+{
+	InterlockedExchangePointer((volatile PVOID *)&m_PrepareGeometryCallback, Callback);
+}
+
+void MOC_Renderer::Flush()
+{
+	NotifyPreWork();
+
+	CullPacket p;
+	p.UserData = nullptr;
+	p.Type = CULL_FLUSH;
+
+	m_FinalBuffer.store(nullptr);
+	PushPacket(p);
+
+	// Sleep until a worker publishes the merged buffer
+	for (MaskedOcclusionCulling *observed = nullptr; !m_FinalBuffer.load();)
+		WaitOnAddress(&m_FinalBuffer, &observed, sizeof(observed), INFINITE);
+
+	ClearPreWorkNotify();
+}
+
+void MOC_Renderer::Resize(uint32_t Width, uint32_t Height)
+{
+	AssertMsg(Width * Height <= m_MaxPixels, "Buffers can only shrink below the initial resolution");
+
+	m_RenderWidth = Width;
+	m_RenderHeight = Height;
+}
+
+void MOC_Renderer::UpdateDepthViewTexture(ID3D11DeviceContext *Context, ID3D11Texture2D *Texture)
+{
+	MaskedOcclusionCulling *moc = GetMOC();
+
+	if (!moc)
+		return;
+
+	// Only allocate the buffer on demand
+	if (!m_DepthViewPixels)
+		m_DepthViewPixels = new float[m_MaxPixels];
+
+	moc->ComputePixelDepthBuffer(m_DepthViewPixels, false);
+
+	D3D11_MAPPED_SUBRESOURCE resource;
+	if (SUCCEEDED(Context->Map(Texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource)))
+	{
+		// Write directly to D3D11-allocated memory. The texture is sized for the initial resolution.
+		DepthColorize(m_DepthViewPixels, (uint8_t *)resource.pData, resource.RowPitch);
+		Context->Unmap(Texture, 0);
+	}
+}
+
+void MOC_Renderer::DepthColorize(const float *FloatData, uint8_t *OutColorArray, uint32_t RowPitch)
+{
+	int floatCount = m_RenderWidth * m_RenderHeight;
+
+	// Find min/max w coordinate (discard cleared pixels)
+	__m128 minsW = _mm_set1_ps(FLT_MAX);
+	__m128 maxsW = _mm_setzero_ps();
+
+	for (int i = 0; i < floatCount; i += 4)
+	{
+		__m128 data = _mm_loadu_ps(&FloatData[i]);
+
+		// Maximum is unconditionally calculated (always > 0.0f)
+		maxsW = _mm_max_ps(maxsW, data);
+
+		// if (FloatData[] > 0.0f) minW = min(minW, FloatData[]);
+		minsW = _mm_min_ps(minsW, _mm_blendv_ps(minsW, data, _mm_cmpgt_ps(data, _mm_setzero_ps())));
+	}
+
+	float tempMinW = std::min(minsW.m128_f32[0], std::min(minsW.m128_f32[1], std::min(minsW.m128_f32[2], minsW.m128_f32[3])));
+	float tempMaxW = std::max(maxsW.m128_f32[0], std::max(maxsW.m128_f32[1], std::max(maxsW.m128_f32[2], maxsW.m128_f32[3])));
+
+	minsW = _mm_set1_ps(tempMinW);
+	maxsW = _mm_set1_ps(tempMaxW);
+
+	const __m128 maxMinDifference = _mm_sub_ps(maxsW, minsW);
+	const __m128 multModifier = _mm_set1_ps(223.0f);
+	const __m128 addModifier = _mm_set1_ps(32.0f);
+	const __m128i intsToBytesMask = _mm_setr_epi8(0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12);
+
+	// Tone map depth values
+	for (int i = 0; i < floatCount; i += 4)
+	{
+		uint8_t *out = &OutColorArray[((i / m_RenderWidth) * RowPitch) + ((i % m_RenderWidth) * 4)];
+
+		// if (FloatData[] > 0.0f) intensity = (unsigned char)(223.0 * (FloatData[] - minW) / (maxW - minW) + 32.0);
+		__m128 data = _mm_loadu_ps(&FloatData[i]);
+
+		__m128 x;
+		x = _mm_mul_ps(_mm_sub_ps(data, minsW), multModifier);			// 223.0 * (FloatData[] - minW)
+		x = _mm_add_ps(_mm_div_ps(x, maxMinDifference), addModifier);	// 223.0 * (FloatData[] - minW) / (maxW - minW) + 32.0
+		x = _mm_blendv_ps(_mm_setzero_ps(), x, _mm_cmpgt_ps(data, _mm_setzero_ps()));
+
+		// Convert 4 RGB integers to 16 RGB bytes: 4 equal values each (x, y, z, w) -> (x, x, x, x, y, y, y, y, z, z, z, z, w, w, w, w)
+		_mm_storeu_si128((__m128i *)out, _mm_shuffle_epi8(_mm_cvttps_epi32(x), intsToBytesMask));
+	}
+}
+
+void MOC_Renderer::PushPacket(const CullPacket& Packet)
+{
+	m_PendingPackets.push(Packet);
+
+	// Full barrier: the count must be visible before m_SleepingWorkers is checked (PopPacket does the opposite)
+	m_PendingCount.fetch_add(1);
+
+	if (m_SleepingWorkers.load() != 0)
+		WakeWorkers(false);
+}
+
+bool MOC_Renderer::TryPopPacket(CullPacket& Packet)
+{
+	// Claim a packet first. Every claim is backed by a push that already happened, so the pop can't fail.
+	long count = m_PendingCount.load(std::memory_order_relaxed);
+
+	do
+	{
+		if (count <= 0)
+			return false;
+	} while (!m_PendingCount.compare_exchange_weak(count, count - 1));
+
+	while (!m_PendingPackets.try_pop(Packet))
+		_mm_pause();
+
+	return true;
+}
+
+void MOC_Renderer::PopPacket(CullPacket& Packet)
+{
+	for (uint32_t spins = 0;; spins++)
+	{
+		if (TryPopPacket(Packet))
+			return;
+
+		// Spin briefly, keep yielding while the caller says work is imminent, otherwise park in the kernel
+		if (spins < 64)
+		{
+			_mm_pause();
+		}
+		else if (!m_ConserveCPU || m_EarlySignalStack.load() != 0)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			ProfileCounterInc("MOC WorkerParks");
+
+			// The sequence is read before both checks. A push or NotifyPreWork() that lands after them bumps it and
+			// WaitOnAddress() returns right away.
+			m_SleepingWorkers++;
+
+			long observed = m_WakeSequence.load();
+
+			if (m_PendingCount.load() <= 0 && m_EarlySignalStack.load() == 0)
+				WaitOnAddress(&m_WakeSequence, &observed, sizeof(observed), INFINITE);
+
+			m_SleepingWorkers--;
+			spins = 0;
+		}
+	}
+}
+
+void MOC_Renderer::WakeWorkers(bool All)
+{
+	m_WakeSequence.fetch_add(1);
+
+	if (All)
+		WakeByAddressAll(&m_WakeSequence);
+	else
+		WakeByAddressSingle(&m_WakeSequence);
+}
+
+void MOC_Renderer::PublishFinalBuffer(MaskedOcclusionCulling *Buffer)
+{
+	m_FinalBuffer.store(Buffer);
+	WakeByAddressAll(&m_FinalBuffer);
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <tbb/concurrent_queue.h>
+#include <MaskedOcclusionCulling/MaskedOcclusionCulling.h>
+#include "../../common.h"
+
+//
+// Everything needed to rasterize one occluder. Filled in by the geometry callback, which only prepares data and
+// leaves the actual drawing to the backend.
+//
+struct MOC_OccluderDraw
+{
+	alignas(16) float ModelToClip[16];
+	const uint16_t *Vertices;		// Quantized (x, y, 0, z), dequantized by ModelToClip
+	const uint16_t *Indices;
+	uint32_t TriangleCount;
+	MaskedOcclusionCulling::BackfaceWinding Winding;
+};
+
+//
+// Adds the profiler clock ticks (Profiler::Clock::Now) spent in a scope to Sink
+//
+struct MOC_ScopedTicks
+{
+	std::atomic_uint64_t& Sink;
+	const uint64_t Start = Profiler::Clock::Now();
+
+	~MOC_ScopedTicks()
+	{
+		Sink.fetch_add(Profiler::Clock::Now() - Start, std::memory_order_relaxed);
+	}
+};
+
+//
+// Tick sum for code that runs on every thread for every object (occludee queries). Each thread adds to a sink on its
+// own cache line through Local() and Consume() collects them all, so the hot path never touches a shared line. Threads
+// past MaxThreads share one extra slot. The current thread's slot is a static thread_local, so there can only be one
+// instance.
+//
+class MOC_ThreadTicks
+{
+public:
+	constexpr static uint32_t MaxThreads = 64;
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic_uint64_t Ticks;
+	};
+
+	inline static thread_local Slot *CurrentSlot;
+
+	Slot m_Slots[MaxThreads + 1];
+	std::atomic_uint32_t m_SlotCount;
+
+public:
+	MOC_ThreadTicks()
+	{
+		for (Slot& slot : m_Slots)
+			slot.Ticks.store(0);
+
+		m_SlotCount.store(0);
+	}
+
+	std::atomic_uint64_t& Local()
+	{
+		if (!CurrentSlot)
+			CurrentSlot = &m_Slots[std::min(m_SlotCount.fetch_add(1), MaxThreads)];
+
+		return CurrentSlot->Ticks;
+	}
+
+	// Ticks added since the last call, summed over every thread
+	uint64_t Consume()
+	{
+		const uint32_t count = std::min(m_SlotCount.load(), MaxThreads + 1);
+		uint64_t total = 0;
+
+		for (uint32_t i = 0; i < count; i++)
+			total += m_Slots[i].Ticks.exchange(0, std::memory_order_relaxed);
+
+		return total;
+	}
+};
+
+//
+// Base for the occluder rasterization backends (MOC_ThreadedMerger, MOC_BinnedRenderer). A scene traversal packet is
+// submitted, the traversal submits geometry packets from a worker, and Flush() blocks until everything submitted so
+// far is in the buffer returned by GetMOC().
+//
+class MOC_Renderer
+{
+public:
+	using TraverseSceneFunc = void(*)(void *UserData);
+	using PrepareGeometryFunc = bool(*)(void *UserData, MOC_OccluderDraw *Draw);
+
+protected:
+	enum CullType
+	{
+		CULL_TRAVERSE_SCENE,
+		CULL_RENDER_GEOMETRY,
+		CULL_FLUSH,
+		CULL_TERMINATE_THREAD,
+	};
+
+	struct CullPacket
+	{
+		CullType Type;
+		void *UserData;
+	};
+
+	uint32_t m_RenderWidth;
+	uint32_t m_RenderHeight;
+	uint32_t m_MaxPixels;					// Resolution passed to the constructor. Resize() can't go above it.
+	float *m_DepthViewPixels;
+	std::atomic_uint64_t m_RasterTicks;		// Time spent rasterizing and merging, summed over every worker
+	bool m_ConserveCPU;						// Park idle workers in the kernel instead of spinning
+	std::atomic_uint m_EarlySignalStack;	// Non-zero while work is about to be submitted. Workers stay awake.
+
+	TraverseSceneFunc m_TraverseSceneCallback;
+	PrepareGeometryFunc m_PrepareGeometryCallback;
+
+	tbb::concurrent_queue<CullPacket> m_PendingPackets;		// Queue of packets that each thread accesses
+	std::atomic_long m_PendingCount;						// Packets pushed but not yet claimed
+	std::atomic_long m_WakeSequence;						// Bumped by anything that should wake parked workers. They wait on this.
+	std::atomic_long m_SleepingWorkers;
+	std::atomic<MaskedOcclusionCulling *> m_FinalBuffer;	// Final scene depth buffer after calling Flush()
+
+public:
+	MOC_Renderer(uint32_t Width, uint32_t Height, bool EnableCPUConservation);
+	virtual ~MOC_Renderer();
+
+	void SetTraverseSceneCallback(TraverseSceneFunc Callback);
+	void SetPrepareGeometryCallback(PrepareGeometryFunc Callback);
+
+	void Flush();
+	void UpdateDepthViewTexture(ID3D11DeviceContext *Context, ID3D11Texture2D *Texture);
+
+	// Must only be called from the traversal callback
+	virtual void Clear() = 0;
+
+	// Must only be called while the backend is idle: after Flush() and before the next SubmitSceneRender(). The
+	// buffer is cleared.
+	virtual void Resize(uint32_t Width, uint32_t Height);
+
+	uint64_t ConsumeRasterTicks()
+	{
+		return m_RasterTicks.exchange(0);
+	}
+
+	__forceinline void SubmitSceneRender(void *UserData)
+	{
+		CullPacket p;
+		p.UserData = UserData;
+		p.Type = CULL_TRAVERSE_SCENE;
+
+		PushPacket(p);
+	}
+
+	__forceinline void SubmitGeometry(void *UserData)
+	{
+		CullPacket p;
+		p.UserData = UserData;
+		p.Type = CULL_RENDER_GEOMETRY;
+
+		PushPacket(p);
+	}
+
+	__forceinline MaskedOcclusionCulling *GetMOC()
+	{
+		return m_FinalBuffer.load();
+	}
+
+	__forceinline void NotifyPreWork()
+	{
+		// Wake parked workers so they're spinning by the time packets arrive. The sequence has to change: a worker that
+		// saw the stack at zero may not be inside WaitOnAddress() yet.
+		if (m_EarlySignalStack++ == 0 && m_SleepingWorkers.load() != 0)
+			WakeWorkers(true);
+	}
+
+	__forceinline void ClearPreWorkNotify()
+	{
+		m_EarlySignalStack--;
+	}
+
+protected:
+	void PushPacket(const CullPacket& Packet);
+	bool TryPopPacket(CullPacket& Packet);
+	void PopPacket(CullPacket& Packet);
+	void WakeWorkers(bool All);
+	void PublishFinalBuffer(MaskedOcclusionCulling *Buffer);
+
+private:
+	void DepthColorize(const float *FloatData, uint8_t *OutColorArray, uint32_t RowPitch);
+};
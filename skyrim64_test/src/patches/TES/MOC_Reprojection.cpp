@@ -0,0 +1,240 @@
+#include "../../common.h"
+#include <MaskedOcclusionCulling/MaskedOcclusionCulling.h>
+#include "MOC_Reprojection.h"
+
+using namespace DirectX;
+
+MOC_Reprojection::MOC_Reprojection(uint32_t Width, uint32_t Height)
+{
+	Allocate(Width, Height);
+
+	m_SourcePosition = _mm_setzero_ps();
+	m_HasSource = false;
+	m_Ready.store(false);
+}
+
+MOC_Reprojection::~MOC_Reprojection()
+{
+	Free();
+}
+
+void MOC_Reprojection::Resize(uint32_t Width, uint32_t Height)
+{
+	Invalidate();
+	m_HasSource = false;
+
+	Free();
+	Allocate(Width, Height);
+}
+
+void MOC_Reprojection::Allocate(uint32_t Width, uint32_t Height)
+{
+	AssertMsg((Width % CellWidth) == 0 && (Height % CellHeight) == 0, "Resolution must be a multiple of the cell size");
+
+	m_Width = Width;
+	m_Height = Height;
+	m_CellsX = Width / CellWidth;
+	m_CellsY = Height / CellHeight;
+
+	m_PixelDepth = new float[m_Width * m_Height];
+	m_SourceDepth = new float[m_CellsX * m_CellsY];
+	m_Depth = new float[m_CellsX * m_CellsY];
+	m_Rays = new XMFLOAT3[(m_CellsX + 1) * (m_CellsY + 1)];
+	m_Corners = new XMVECTOR[(m_CellsX + 1) * (m_CellsY + 1)];
+}
+
+void MOC_Reprojection::Free()
+{
+	delete[] m_PixelDepth;
+	delete[] m_SourceDepth;
+	delete[] m_Depth;
+	delete[] m_Rays;
+	delete[] m_Corners;
+}
+
+void MOC_Reprojection::Capture(MaskedOcclusionCulling *Buffer, const XMMATRIX& ViewProj, XMVECTOR Position)
+{
+	ProfileTimer("MOC ReprojectCapture");
+
+	m_HasSource = false;
+
+	if (!Buffer)
+		return;
+
+	Buffer->ComputePixelDepthBuffer(m_PixelDepth, false);
+
+	// Keep the farthest depth in each cell. A single empty pixel makes the whole cell empty.
+	for (uint32_t cy = 0; cy < m_CellsY; cy++)
+	{
+		for (uint32_t cx = 0; cx < m_CellsX; cx++)
+		{
+			const float *row = &m_PixelDepth[(cy * CellHeight * m_Width) + (cx * CellWidth)];
+			__m128 z = _mm_set1_ps(FLT_MAX);
+
+			for (uint32_t y = 0; y < CellHeight; y++, row += m_Width)
+				z = _mm_min_ps(z, _mm_min_ps(_mm_loadu_ps(&row[0]), _mm_loadu_ps(&row[4])));
+
+			z = _mm_min_ps(z, _mm_movehl_ps(z, z));
+			z = _mm_min_ss(z, _mm_shuffle_ps(z, z, _MM_SHUFFLE(1, 1, 1, 1)));
+
+			m_SourceDepth[(cy * m_CellsX) + cx] = std::max(_mm_cvtss_f32(z), 0.0f);
+		}
+	}
+
+	BuildRays(ViewProj);
+	m_SourcePosition = Position;
+	m_HasSource = true;
+}
+
+bool MOC_Reprojection::Reproject(const XMMATRIX& ViewProj, XMVECTOR Position, float MaxCameraDistance)
+{
+	ProfileTimer("MOC Reproject");
+
+	if (!m_HasSource)
+		return false;
+
+	// Large jumps (teleports, load doors, camera switches) aren't worth warping
+	XMVECTOR delta = XMVectorSubtract(m_SourcePosition, Position);
+
+	if (XMVectorGetX(XMVector3Length(delta)) > MaxCameraDistance)
+		return false;
+
+	// Both matrices are relative to their own camera position. A point at ray * w in the old frame lands at
+	// clip = (ray * w + delta) * ViewProj = w * Corner + Offset in the new one.
+	const XMVECTOR offset = XMVector4Transform(XMVectorSetW(delta, 1.0f), ViewProj);
+	const uint32_t cornerCount = (m_CellsX + 1) * (m_CellsY + 1);
+
+	for (uint32_t i = 0; i < cornerCount; i++)
+		m_Corners[i] = XMVector4Transform(XMVectorSetW(XMLoadFloat3(&m_Rays[i]), 0.0f), ViewProj);
+
+	memset(m_Depth, 0, m_CellsX * m_CellsY * sizeof(float));
+
+	const XMVECTOR toPixels = _mm_setr_ps(m_Width * 0.5f, m_Height * -0.5f, 0.0f, 0.0f);
+	const XMVECTOR pixelCenter = _mm_setr_ps(m_Width * 0.5f, m_Height * 0.5f, 0.0f, 0.0f);
+	const float snap = 0.01f;
+
+	for (uint32_t cy = 0; cy < m_CellsY; cy++)
+	{
+		for (uint32_t cx = 0; cx < m_CellsX; cx++)
+		{
+			const float sourceZ = m_SourceDepth[(cy * m_CellsX) + cx];
+
+			if (sourceZ <= 0.0f)
+				continue;
+
+			const XMVECTOR w = _mm_set1_ps(1.0f / sourceZ);
+			const uint32_t corner = (cy * (m_CellsX + 1)) + cx;
+
+			XMVECTOR clip[4];
+			clip[0] = XMVectorMultiplyAdd(w, m_Corners[corner], offset);						// Top left
+			clip[1] = XMVectorMultiplyAdd(w, m_Corners[corner + 1], offset);					// Top right
+			clip[2] = XMVectorMultiplyAdd(w, m_Corners[corner + m_CellsX + 1], offset);		// Bottom left
+			clip[3] = XMVectorMultiplyAdd(w, m_Corners[corner + m_CellsX + 2], offset);		// Bottom right
+
+			float maxW = 0.0f;
+			float minW = FLT_MAX;
+			XMFLOAT2 pixel[4];
+
+			for (int i = 0; i < 4; i++)
+			{
+				float cw = XMVectorGetW(clip[i]);
+				maxW = std::max(maxW, cw);
+				minW = std::min(minW, cw);
+
+				if (cw > 0.0f)
+					XMStoreFloat2(&pixel[i], XMVectorMultiplyAdd(XMVectorDivide(clip[i], _mm_set1_ps(cw)), toPixels, pixelCenter));
+			}
+
+			// Crosses the camera plane
+			if (minW <= 0.0001f)
+				continue;
+
+			// Largest axis aligned rectangle that's still inside the warped quad, as long as it didn't rotate much.
+			// The depth is the farthest corner.
+			float left = std::max(pixel[0].x, pixel[2].x);
+			float right = std::min(pixel[1].x, pixel[3].x);
+			float top = std::max(pixel[0].y, pixel[1].y);
+			float bottom = std::min(pixel[2].y, pixel[3].y);
+
+			int tx0 = std::max((int)ceilf((left / CellWidth) - snap), 0);
+			int tx1 = std::min((int)floorf((right / CellWidth) + snap), (int)m_CellsX);
+			int ty0 = std::max((int)ceilf((top / CellHeight) - snap), 0);
+			int ty1 = std::min((int)floorf((bottom / CellHeight) + snap), (int)m_CellsY);
+
+			const float z = 1.0f / maxW;
+
+			for (int ty = ty0; ty < ty1; ty++)
+			{
+				for (int tx = tx0; tx < tx1; tx++)
+				{
+					float& target = m_Depth[(ty * m_CellsX) + tx];
+					target = std::max(target, z);
+				}
+			}
+		}
+	}
+
+	m_Ready.store(true, std::memory_order_release);
+	return true;
+}
+
+void MOC_Reprojection::Invalidate()
+{
+	m_Ready.store(false, std::memory_order_release);
+}
+
+bool MOC_Reprojection::IsOccluded(float XMin, float YMin, float XMax, float YMax, float WMin, float Confidence) const
+{
+	if (WMin <= 0.0f)
+		return false;
+
+	// NDC to cells (y points down in the buffer)
+	int cx0 = std::max((int)floorf((XMin + 1.0f) * 0.5f * m_Width / CellWidth), 0);
+	int cx1 = std::min((int)ceilf((XMax + 1.0f) * 0.5f * m_Width / CellWidth), (int)m_CellsX);
+	int cy0 = std::max((int)floorf((1.0f - YMax) * 0.5f * m_Height / CellHeight), 0);
+	int cy1 = std::min((int)ceilf((1.0f - YMin) * 0.5f * m_Height / CellHeight), (int)m_CellsY);
+
+	if (cx0 >= cx1 || cy0 >= cy1)
+		return false;
+
+	const float zMax = 1.0f / WMin;
+	const uint32_t total = (cx1 - cx0) * (cy1 - cy0);
+	const uint32_t allowedMisses = (uint32_t)(total * (1.0f - std::min(std::max(Confidence, 0.0f), 1.0f)));
+	uint32_t misses = 0;
+
+	for (int cy = cy0; cy < cy1; cy++)
+	{
+		const float *row = &m_Depth[cy * m_CellsX];
+
+		for (int cx = cx0; cx < cx1; cx++)
+		{
+			// Same test as MOC: the object is visible where its nearest depth is at or in front of the buffer
+			if (zMax >= row[cx] && ++misses > allowedMisses)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void MOC_Reprojection::BuildRays(const XMMATRIX& ViewProj)
+{
+	XMMATRIX inverse = XMMatrixInverse(nullptr, ViewProj);
+
+	for (uint32_t y = 0; y <= m_CellsY; y++)
+	{
+		for (uint32_t x = 0; x <= m_CellsX; x++)
+		{
+			float ndcX = ((float)(x * CellWidth) / m_Width) * 2.0f - 1.0f;
+			float ndcY = 1.0f - ((float)(y * CellHeight) / m_Height) * 2.0f;
+
+			// Any point on the pixel's ray, scaled so its clip w is 1. The matrix is camera relative so the ray
+			// starts at the origin and w scales linearly along it.
+			XMVECTOR point = XMVector4Transform(_mm_setr_ps(ndcX, ndcY, 0.5f, 1.0f), inverse);
+			point = XMVectorDivide(point, XMVectorSplatW(point));
+
+			float w = XMVectorGetW(XMVector4Transform(XMVectorSetW(point, 1.0f), ViewProj));
+			XMStoreFloat3(&m_Rays[(y * (m_CellsX + 1)) + x], XMVectorScale(point, 1.0f / w));
+		}
+	}
+}
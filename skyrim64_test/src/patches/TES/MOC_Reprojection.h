@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <DirectXMath.h>
+#include "../../common.h"
+
+class MaskedOcclusionCulling;
+
+//
+// Warps last frame's occlusion buffer into the current camera so occludees can be rejected before the new buffer is
+// finished. The buffer is reduced to one depth per 8x4 pixel cell (MOC's subtile size) keeping the farthest value.
+// Each cell is splatted as the largest screen rectangle that's guaranteed to lie inside its warped footprint, so
+// disocclusions and minification leave holes (no occluder) instead of inventing coverage.
+//
+// Depths use MOC's convention: z = 1 / w, 0 = nothing rendered.
+//
+class MOC_Reprojection
+{
+public:
+	constexpr static uint32_t CellWidth = 8;
+	constexpr static uint32_t CellHeight = 4;
+
+private:
+	uint32_t m_Width;
+	uint32_t m_Height;
+	uint32_t m_CellsX;
+	uint32_t m_CellsY;
+
+	float *m_PixelDepth;		// ComputePixelDepthBuffer() scratch
+	float *m_SourceDepth;		// Previous frame, one value per cell
+	float *m_Depth;				// Warped into the current camera
+	DirectX::XMFLOAT3 *m_Rays;		// Per cell corner: position with clip w == 1 in the previous camera
+	DirectX::XMVECTOR *m_Corners;	// Per cell corner: m_Rays transformed by the current camera (without translation)
+
+	DirectX::XMVECTOR m_SourcePosition;
+	bool m_HasSource;
+	std::atomic_bool m_Ready;
+
+public:
+	MOC_Reprojection(uint32_t Width, uint32_t Height);
+	~MOC_Reprojection();
+
+	void Capture(MaskedOcclusionCulling *Buffer, const DirectX::XMMATRIX& ViewProj, DirectX::XMVECTOR Position);
+	bool Reproject(const DirectX::XMMATRIX& ViewProj, DirectX::XMVECTOR Position, float MaxCameraDistance);
+	void Invalidate();
+
+	// Drops the captured frame
+	void Resize(uint32_t Width, uint32_t Height);
+
+	bool IsReady() const
+	{
+		return m_Ready.load(std::memory_order_acquire);
+	}
+
+	// True if at least Confidence (0 to 1) of the NDC rectangle's cells have a warped occluder in front of WMin.
+	// Confidence 1.0 requires every cell to be covered.
+	bool IsOccluded(float XMin, float YMin, float XMax, float YMax, float WMin, float Confidence) const;
+
+private:
+	void Allocate(uint32_t Width, uint32_t Height);
+	void Free();
+	void BuildRays(const DirectX::XMMATRIX& ViewProj);
+};
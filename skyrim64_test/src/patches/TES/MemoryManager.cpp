@@ -1,11 +1,13 @@
 #include "../../common.h"
+#include "../../profiler_zone_categories.h"
 #include "MemoryManager.h"
 
 void *MemAlloc(size_t Size, size_t Alignment = 0, bool Aligned = false, bool Zeroed = false)
 {
 	ProfileCounterInc("Alloc Count");
 	ProfileCounterAdd("Byte Count", Size);
-	ProfileTimer("Time Spent Allocating");
+	ProfileTimerHistogram("Time Spent Allocating");
+	ProfileZoneCat(MEMORY, "MemAlloc");
 
 #if SKYRIM64_USE_VTUNE
 	__itt_heap_allocate_begin(ITT_AllocateCallback, Size, Zeroed ? 1 : 0);
@@ -61,7 +63,8 @@ void *MemAlloc(size_t Size, size_t Alignment = 0, bool Aligned = false, bool Zer
 void MemFree(void *Memory, bool Aligned = false)
 {
 	ProfileCounterInc("Free Count");
-	ProfileTimer("Time Spent Freeing");
+	ProfileTimerHistogram("Time Spent Freeing");
+	ProfileZoneCat(MEMORY, "MemFree");
 
 	if (!Memory)
 		return;
@@ -1,5 +1,6 @@
 #include <tbb/concurrent_hash_map.h>
 #include "../../common.h"
+#include "../../profiler_zone_categories.h"
 #include "BSTScatterTable.h"
 #include "BSReadWriteLock.h"
 #include "TESForm.h"
@@ -47,7 +48,7 @@ bool GetFormCache(uint32_t FormId, TESForm *&Form)
 		return false;
 
 	ProfileCounterInc("Cache Lookups");
-	ProfileTimer("Cache Fetch Time");
+	ProfileTimerHistogram("Cache Fetch Time");
 
 	const unsigned char masterId = (FormId & 0xFF000000) >> 24;
 	const unsigned int baseId = (FormId & 0x00FFFFFF);
@@ -101,9 +102,13 @@ TESForm *TESForm::LookupFormById(uint32_t FormId)
 	TESForm *formPointer;
 
 	if (GetFormCache(FormId, formPointer))
+	{
+		Profiler::FlightRecorder::Record(Profiler::FlightRecorder::EVENT_FORM_LOOKUP, FormId, (uintptr_t)formPointer);
 		return formPointer;
+	}
 
 	// Try to use Bethesda's scatter table which is considerably slower
+	ProfileZoneCat(FORMS, "TESForm::LookupFormById Miss");
 	GlobalFormLock.LockForRead();
 
 	if (!GlobalFormList || !GlobalFormList->get(FormId, formPointer))
@@ -112,6 +117,8 @@ TESForm *TESForm::LookupFormById(uint32_t FormId)
 	GlobalFormLock.UnlockRead();
 
 	UpdateFormCache(FormId, formPointer, false);
+
+	Profiler::FlightRecorder::Record(Profiler::FlightRecorder::EVENT_FORM_LOOKUP, FormId, (uintptr_t)formPointer);
 	return formPointer;
 }
 
@@ -219,6 +226,19 @@ void UnknownFormFunction0(__int64 form, bool a2)
 
 void PatchTESForm()
 {
+#ifdef _DEBUG
+	// BSTScatterTableCRCHashPolicy no longer calls into the EXE. Make sure both inlined variants still agree with it.
+	// headless_tests/crc32_test checks them against a reference off-target, this is the only check against the game.
+	for (uint32_t baseId = 0; baseId < TES_FORM_INDEX_COUNT; baseId++)
+	{
+		int engineHash;
+		CRC32_Lazy(&engineHash, baseId);
+
+		AssertMsgVa((uint32_t)engineHash == BSCRC32::HashTable(baseId), "CRC table mismatch for base id %06X", baseId);
+		AssertMsgVa(!BSCRC32::HasCLMUL || (uint32_t)engineHash == BSCRC32::HashCLMUL(baseId), "CRC CLMUL mismatch for base id %06X", baseId);
+	}
+#endif
+
 	origFunc0 = Detours::X64::DetourFunctionClass(g_ModuleBase + 0x194970, &UnknownFormFunction0);
 	origFunc1 = Detours::X64::DetourFunctionClass(g_ModuleBase + 0x196070, &UnknownFormFunction1);
 	origFunc2 = Detours::X64::DetourFunctionClass(g_ModuleBase + 0x195DA0, &UnknownFormFunction2);
@@ -840,21 +840,13 @@ void Patch_TESVCreationKit()
 	// Plugin loading optimizations:
 	//
 	// - TESForm reference map rewrite (above)
-	// - Fix an unoptimized function bottleneck (sub_1414974E0) (Large ESP files only)
+	// - Fix an unoptimized function bottleneck (sub_1414974E0, SIMD search picked per CPU) (Large ESP files only)
 	// - Fix an unoptimized function bottleneck (sub_1415D5640)
 	// - Eliminate millions of calls to update the progress dialog, instead only updating 400 times (0% -> 100%)
 	// - Replace old zlib decompression code with optimized libdeflate
 	// - Cache results from FindFirstFile when GetFileAttributesExA is called immediately after (BSSystemDir__NextEntry, BSResource__LooseFileLocation__FileExists)
 	//
-	int cpuinfo[4];
-	__cpuid(cpuinfo, 1);
-
-	// Utilize SSE4.1 instructions if available
-	if ((cpuinfo[2] & (1 << 19)) != 0)
-		XUtil::DetourJump(OFFSET(0x14974E0, 1530), &sub_1414974E0_SSE41);
-	else
-		XUtil::DetourJump(OFFSET(0x14974E0, 1530), &sub_1414974E0);
-
+	XUtil::DetourJump(OFFSET(0x14974E0, 1530), &sub_1414974E0);
 	XUtil::DetourJump(OFFSET(0x15D5640, 1530), &sub_1415D5640);
 	XUtil::PatchMemory(OFFSET(0x163D56E, 1530), { 0xB9, 0x90, 0x01, 0x00, 0x00, 0x90 });
 	XUtil::DetourCall(OFFSET(0x1640FF3, 1530), &UpdateLoadProgressBar);
@@ -64,6 +64,15 @@ void test3()
 	test3_orig();
 }
 
+void(*exit_orig)(int);
+void hk_exit(int Code)
+{
+	// Last point where every thread is still alive and the loader lock isn't held. The game's own CRT import is
+	// called afterwards, this DLL's exit() would run a different atexit table.
+	Profiler::ZoneRecorder::Shutdown();
+	exit_orig(Code);
+}
+
 void Patch_TESV()
 {
 	MSRTTI::Initialize();
@@ -144,6 +153,11 @@ void Patch_TESV()
 	//
 	Detours::IATHook(g_ModuleBase, "dinput8.dll", "DirectInput8Create", (uintptr_t)hk_DirectInput8Create);
 
+	//
+	// Exit (profiler shutdown, before the CRT tears anything down)
+	//
+	*(uintptr_t *)&exit_orig = Detours::IATHook(g_ModuleBase, "API-MS-WIN-CRT-RUNTIME-L1-1-0.DLL", "exit", (uintptr_t)hk_exit);
+
 	//
 	// MemoryManager
 	//
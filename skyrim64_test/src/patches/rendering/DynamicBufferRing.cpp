@@ -0,0 +1,94 @@
+#include <string.h>
+#include <algorithm>
+#include "DynamicBufferRing.h"
+
+DynamicBufferRing::DynamicBufferRing(DynamicBufferDevice *Device, uint32_t SlotSize, uint32_t InitialSlotCount, uint32_t MaxSlotCount)
+{
+	m_Device = Device;
+	m_SlotSize = SlotSize;
+	m_MaxSlotCount = std::clamp<uint32_t>(MaxSlotCount, 1, MaxSlots);
+	m_SlotCount = 0;
+	m_Position = 0;
+	m_Offset = 0;
+
+	InitialSlotCount = std::clamp<uint32_t>(InitialSlotCount, 1, m_MaxSlotCount);
+
+	// Slot 0 is always used. The rest are optional and the ring tries to grow again whenever it would stall.
+	for (uint32_t i = 0; i < InitialSlotCount; i++)
+	{
+		if (!m_Device->CreateSlot(i) && i > 0)
+			break;
+
+		m_Order[m_SlotCount] = m_SlotCount;
+		m_Pending[m_SlotCount] = false;
+		m_SlotCount++;
+	}
+
+	m_ClockSource = Profiler::Clock::GetOSSource();
+	m_ClockTicksPerNs = (double)Profiler::Clock::GetSourceFrequency(m_ClockSource) / 1000000000.0;
+
+	m_Frame = {};
+	m_Frame.SlotCount = m_SlotCount;
+	m_LastFrame = m_Frame;
+}
+
+uint32_t DynamicBufferRing::Allocate(uint32_t Size, uint32_t *OutOffset)
+{
+	if (m_Offset + Size > m_SlotSize)
+		Rotate();
+
+	*OutOffset = m_Offset;
+	m_Offset += Size;
+
+	return GetCurrentSlot();
+}
+
+void DynamicBufferRing::EndFrame()
+{
+	m_LastFrame = m_Frame;
+
+	m_Frame = {};
+	m_Frame.SlotCount = m_SlotCount;
+}
+
+void DynamicBufferRing::Rotate()
+{
+	const uint32_t current = GetCurrentSlot();
+
+	m_Device->Signal(current);
+	m_Pending[current] = true;
+
+	uint32_t next = (m_Position + 1) % m_SlotCount;
+	uint32_t slot = m_Order[next];
+
+	if (m_Pending[slot] && !m_Device->IsComplete(slot))
+	{
+		if (m_SlotCount < m_MaxSlotCount && m_Device->CreateSlot(m_SlotCount))
+		{
+			// The GPU is further behind than the ring is deep. Put a fresh buffer right after the current one; everything
+			// else keeps its place in line so the oldest buffer is still the next one to be reused after this.
+			next = m_Position + 1;
+			slot = m_SlotCount;
+
+			memmove(&m_Order[next + 1], &m_Order[next], (m_SlotCount - next) * sizeof(uint32_t));
+			m_Order[next] = slot;
+			m_SlotCount++;
+		}
+		else
+		{
+			const uint64_t start = Profiler::Clock::ReadSource(m_ClockSource);
+			m_Device->Wait(slot);
+			const uint64_t end = Profiler::Clock::ReadSource(m_ClockSource);
+
+			m_Frame.Stalls++;
+			m_Frame.StallNs += (uint64_t)((end - start) / m_ClockTicksPerNs);
+		}
+	}
+
+	m_Pending[slot] = false;
+	m_Position = next;
+	m_Offset = 0;
+
+	m_Frame.Rotations++;
+	m_Frame.SlotCount = m_SlotCount;
+}
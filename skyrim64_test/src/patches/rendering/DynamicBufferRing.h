@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include "../../profiler_clock.h"
+
+//
+// Whatever owns the actual buffers and knows when the GPU is done with them. Slot IDs are handed out in order starting
+// at 0 and never reused.
+//
+class DynamicBufferDevice
+{
+public:
+	virtual ~DynamicBufferDevice() = default;
+
+	virtual bool CreateSlot(uint32_t Slot) = 0;		// Back a new slot with a buffer. False if that isn't possible.
+	virtual void Signal(uint32_t Slot) = 0;			// Queued after the last command that reads from Slot
+	virtual bool IsComplete(uint32_t Slot) = 0;		// Must not block or flush
+	virtual void Wait(uint32_t Slot) = 0;			// Blocks until IsComplete(Slot)
+};
+
+//
+// Rotation policy for dynamic upload buffers that are appended to with MAP_WRITE_NO_OVERWRITE. When the current buffer
+// fills up it gets a fence and the ring moves on to the next one. If the GPU still owns that buffer the ring adds
+// another one in front of it instead of waiting, so the depth settles at however far behind the GPU actually runs.
+// Waiting only happens once MaxSlotCount is reached and that time is charged to the current frame.
+//
+// Only one thread may use an instance.
+//
+class DynamicBufferRing
+{
+public:
+	constexpr static uint32_t MaxSlots = 8;
+
+	struct FrameStats
+	{
+		uint32_t Rotations;
+		uint32_t Stalls;
+		uint64_t StallNs;
+		uint32_t SlotCount;
+	};
+
+private:
+	DynamicBufferDevice *m_Device;
+	uint32_t m_SlotSize;
+	uint32_t m_MaxSlotCount;
+
+	uint32_t m_Order[MaxSlots];		// Slot IDs in rotation order
+	bool m_Pending[MaxSlots];		// Indexed by slot ID. Signaled and not known to be complete yet.
+	uint32_t m_SlotCount;
+	uint32_t m_Position;			// Index into m_Order
+	uint32_t m_Offset;				// Bytes used in the current slot
+
+	Profiler::Clock::Source m_ClockSource;
+	double m_ClockTicksPerNs;
+
+	FrameStats m_Frame;
+	FrameStats m_LastFrame;
+
+public:
+	DynamicBufferRing(DynamicBufferDevice *Device, uint32_t SlotSize, uint32_t InitialSlotCount, uint32_t MaxSlotCount = MaxSlots);
+
+	DynamicBufferRing(const DynamicBufferRing&) = delete;
+	DynamicBufferRing& operator=(const DynamicBufferRing&) = delete;
+
+	// Returns the slot ID that holds the allocation. Size must be <= GetSlotSize().
+	uint32_t Allocate(uint32_t Size, uint32_t *OutOffset);
+
+	// Latches this frame's stats into GetLastFrameStats() and starts a new frame
+	void EndFrame();
+
+	uint32_t GetCurrentSlot() const
+	{
+		return m_Order[m_Position];
+	}
+
+	uint32_t GetSlotCount() const
+	{
+		return m_SlotCount;
+	}
+
+	uint32_t GetSlotSize() const
+	{
+		return m_SlotSize;
+	}
+
+	const FrameStats& GetLastFrameStats() const
+	{
+		return m_LastFrame;
+	}
+
+private:
+	void Rotate();
+};
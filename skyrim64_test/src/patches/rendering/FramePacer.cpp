@@ -0,0 +1,167 @@
+#include <immintrin.h>
+#include <algorithm>
+#include "FramePacer.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <timeapi.h>
+
+#pragma comment(lib, "winmm.lib")
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+#if defined(_WIN32)
+HANDLE CreatePacingTimer()
+{
+	// Windows 10 1803+. Ignores the global timer resolution and wakes within ~0.5ms.
+	HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+	if (!timer)
+	{
+		// Older systems only get 1ms granularity after raising the global resolution
+		[[maybe_unused]] static bool periodSet = (timeBeginPeriod(1), true);
+		timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}
+
+	return timer;
+}
+
+void WaitOnTimer(HANDLE Timer, uint64_t Nanoseconds)
+{
+	// Negative means relative, in 100ns units
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -(int64_t)std::max<uint64_t>(Nanoseconds / 100, 1);
+
+	if (Timer && SetWaitableTimer(Timer, &dueTime, 0, nullptr, nullptr, FALSE))
+		WaitForSingleObject(Timer, INFINITE);
+	else
+		SleepEx((DWORD)std::max<uint64_t>(Nanoseconds / 1000000, 1), FALSE);
+}
+#else
+void WaitOnTimer([[maybe_unused]] void *Timer, uint64_t Nanoseconds)
+{
+	timespec remaining;
+	remaining.tv_sec = Nanoseconds / 1000000000;
+	remaining.tv_nsec = Nanoseconds % 1000000000;
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, 0, &remaining, &remaining) == EINTR)
+		;
+}
+#endif
+
+FramePacer g_FramePacer;
+
+FramePacer::FramePacer()
+{
+	m_Source = Profiler::Clock::GetOSSource();
+	m_TicksPerNs = (double)Profiler::Clock::GetSourceFrequency(m_Source) / 1000000000.0;
+
+#if defined(_WIN32)
+	m_Timer = CreatePacingTimer();
+#else
+	m_Timer = nullptr;
+#endif
+
+	m_SpinTicks = NsToTicks(MaxSpinNs);
+	m_OversleepHighWater = m_SpinTicks;
+	m_NextDeadline = 0;
+}
+
+FramePacer::~FramePacer()
+{
+#if defined(_WIN32)
+	if (m_Timer)
+		CloseHandle(m_Timer);
+#endif
+}
+
+void FramePacer::PaceFrame(double TargetIntervalMs)
+{
+	const uint64_t interval = NsToTicks((uint64_t)(TargetIntervalMs * 1000000.0));
+	const uint64_t now = Now();
+
+	// First frame, limiter was off, or this frame alone took longer than the target. Catching up by presenting
+	// several frames back to back would look worse than starting over.
+	if (m_NextDeadline == 0 || now >= m_NextDeadline || (m_NextDeadline - now) > interval)
+	{
+		m_NextDeadline = now + interval;
+		return;
+	}
+
+	WaitUntil(m_NextDeadline);
+	m_NextDeadline += interval;
+}
+
+void FramePacer::WaitUntil(uint64_t Deadline)
+{
+	uint64_t now = Now();
+
+	if (now + m_SpinTicks < Deadline)
+	{
+		const uint64_t wakeTarget = Deadline - m_SpinTicks;
+
+		TimerSleep((uint64_t)((wakeTarget - now) / m_TicksPerNs));
+
+		now = Now();
+		UpdateSpin((now > wakeTarget) ? now - wakeTarget : 0);
+	}
+
+	while (now < Deadline)
+	{
+		_mm_pause();
+		now = Now();
+	}
+
+	m_Errors.Record((uint64_t)((now - Deadline) / m_TicksPerNs));
+}
+
+FramePacer::ErrorWindow FramePacer::ConsumeErrorWindow()
+{
+	auto window = m_Errors.ConsumeWindow();
+
+	return { window.Count, window.P50 / 1000.0, window.P99 / 1000.0, window.Max / 1000.0, (m_SpinTicks / m_TicksPerNs) / 1000.0 };
+}
+
+void FramePacer::SleepFor(uint64_t Nanoseconds)
+{
+#if defined(_WIN32)
+	// One timer per thread, closed when the thread exits
+	thread_local struct ThreadTimer
+	{
+		HANDLE Handle = CreatePacingTimer();
+
+		~ThreadTimer()
+		{
+			if (Handle)
+				CloseHandle(Handle);
+		}
+	} timer;
+
+	WaitOnTimer(timer.Handle, Nanoseconds);
+#else
+	WaitOnTimer(nullptr, Nanoseconds);
+#endif
+}
+
+void FramePacer::TimerSleep(uint64_t Nanoseconds)
+{
+#if defined(_WIN32)
+	WaitOnTimer((HANDLE)m_Timer, Nanoseconds);
+#else
+	WaitOnTimer(m_Timer, Nanoseconds);
+#endif
+}
+
+void FramePacer::UpdateSpin(uint64_t OversleepTicks)
+{
+	// Jump up to any new worst case immediately, forget it over a few hundred frames
+	m_OversleepHighWater = std::max(OversleepTicks, m_OversleepHighWater - (m_OversleepHighWater / 128));
+	m_SpinTicks = std::clamp(m_OversleepHighWater + NsToTicks(SpinMarginNs), NsToTicks(MinSpinNs), NsToTicks(MaxSpinNs));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include "../../profiler_clock.h"
+#include "../../profiler_histogram.h"
+
+//
+// Precise waits for frame limiting. The OS timer does the bulk of the wait (a high resolution waitable timer on
+// Windows, clock_nanosleep elsewhere) and stops SpinTicks early, then the rest is spun out on the clock. The spin tail
+// tracks the worst recent timer oversleep so it stays as short as the machine allows.
+//
+// Deadlines are in ticks of the OS clock source (Profiler::Clock::GetOSSource()). Only one thread may use an instance.
+//
+class FramePacer
+{
+public:
+	constexpr static uint64_t MinSpinNs = 100 * 1000;
+	constexpr static uint64_t MaxSpinNs = 2 * 1000 * 1000;
+	constexpr static uint64_t SpinMarginNs = 50 * 1000;
+
+	struct ErrorWindow
+	{
+		uint64_t Count;
+		double P50Us;
+		double P99Us;
+		double MaxUs;
+		double SpinUs;		// Current spin tail
+	};
+
+private:
+	Profiler::Clock::Source m_Source;
+	double m_TicksPerNs;
+	void *m_Timer;					// Windows waitable timer
+
+	uint64_t m_SpinTicks;
+	uint64_t m_OversleepHighWater;	// Ticks, decays slowly
+	uint64_t m_NextDeadline;
+
+	Profiler::LatencyHistogram m_Errors;	// Nanoseconds past the deadline on wake
+
+public:
+	FramePacer();
+	~FramePacer();
+
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	// Call once per frame right before presenting. Waits until one interval after the previous frame's deadline, or
+	// restarts the schedule if the frame was already late.
+	void PaceFrame(double TargetIntervalMs);
+
+	void WaitUntil(uint64_t Deadline);
+	ErrorWindow ConsumeErrorWindow();
+
+	uint64_t Now() const
+	{
+		return Profiler::Clock::ReadSource(m_Source);
+	}
+
+	uint64_t NsToTicks(uint64_t Nanoseconds) const
+	{
+		return (uint64_t)(Nanoseconds * m_TicksPerNs);
+	}
+
+	// Timer-only sleep for the calling thread (no spin tail). Uses a per-thread high resolution timer on Windows.
+	static void SleepFor(uint64_t Nanoseconds);
+
+private:
+	void TimerSleep(uint64_t Nanoseconds);
+	void UpdateSpin(uint64_t OversleepTicks);
+};
+
+extern FramePacer g_FramePacer;
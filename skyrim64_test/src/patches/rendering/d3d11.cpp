@@ -4,6 +4,7 @@
 #include <xbyak/xbyak.h>
 #include "d3d11_proxy.h"
 #include "GpuTimer.h"
+#include "FramePacer.h"
 #include "../../ui/ui.h"
 #include "../TES/BSShader/BSShaderManager.h"
 #include "../TES/BSShader/BSShaderRenderTargets.h"
@@ -54,14 +55,21 @@ HRESULT WINAPI hk_IDXGISwapChain_Present(IDXGISwapChain *This, UINT SyncInterval
 	}
 
 	ui::EndFrame();
+
+	if (ui::opt::EnableFrameLimiter)
+	{
+		ProfileZone("Frame Limiter");
+		g_FramePacer.PaceFrame(1000.0 / std::max(ui::opt::FrameLimitFps, 1.0f));
+	}
+
 	HRESULT hr;
 	{
-		ZoneScopedNC("Present", tracy::Color::Red);
+		ProfileZoneC("Present", tracy::Color::Red);
 		hr = (This->*ptrPresent)(SyncInterval, Flags);
 	}
 
 	//TracyDx11Collect(g_DeviceContext);
-	FrameMark;
+	ProfileFrameMark();
 
 	ui::BeginFrame();
 	g_GPUTimers.BeginFrame(g_DeviceContext);
@@ -1,4 +1,5 @@
 #include "../common.h"
+#include "rendering/FramePacer.h"
 
 // Hooks that probably don't do anything
 
@@ -21,7 +22,11 @@ void WINAPI hk_Sleep(DWORD dwMilliseconds)
 	if (dwMilliseconds == 0)
 		return;
 
-	SleepEx(dwMilliseconds, FALSE);
+	// Plain Sleep() rounds up to the scheduler tick (15.6ms by default)
+	if (dwMilliseconds == INFINITE)
+		SleepEx(INFINITE, FALSE);
+	else
+		FramePacer::SleepFor(dwMilliseconds * 1000000ull);
 }
 
 void PatchThreading()
@@ -31,5 +36,4 @@ void PatchThreading()
 	PatchIAT(hk_Sleep, "kernel32.dll", "Sleep");
 
 	SetPriorityClass(GetCurrentProcess(), ABOVE_NORMAL_PRIORITY_CLASS);
-	//timeBeginPeriod(1);
 }
\ No newline at end of file
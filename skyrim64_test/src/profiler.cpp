@@ -1,4 +1,12 @@
+#if !SKYRIM64_PROFILER_STANDALONE
 #include "common.h"
+#else
+// Standalone tools (moc_replay) build the profiler core without the game
+#include <algorithm>
+#include "profiler.h"
+#endif
+
+#include <mutex>
 
 #if SKYRIM64_USE_VTUNE && SKYRIM64_USE_PROFILER
 #pragma message("Warning: Using the built-in profiler code with VTune may skew final results")
@@ -7,145 +15,204 @@
 #if SKYRIM64_USE_PROFILER
 namespace Profiler
 {
-    namespace Internal
-    {
-        std::array<Entry, MaxEntries> GlobalCounters;
-        std::unordered_map<uint32_t, Entry *> LookupMap;
-        int64_t QpcFrequency;
-		int64_t CpuFrequency;
-
-		void ReadCounters(int64_t& TSC, int64_t& QPC)
+	namespace Internal
+	{
+		std::array<Entry, MaxEntries> GlobalCounters;
+		std::unordered_map<uint32_t, Entry *> LookupMap;
+
+		std::array<std::atomic<ThreadShard *>, MaxShards> Shards;
+		std::atomic_uint32_t ShardCount;
+		thread_local ThreadShard *CurrentShard;
+		ThreadShard OverflowShard;
+
+		std::array<LatencyHistogram, MaxHistograms> Histograms;
+		std::atomic_uint32_t HistogramCount;
+		LatencyHistogram OverflowHistogram;
+
+		std::array<uint32_t, MaxTimers> TimerIndices;
+		std::atomic_uint32_t TimerCount;
+		std::mutex EntryLock;
+
+		void InitializeEntry(Entry& Counter, const char *File, const char *Function, const char *Name, bool Timer)
+		{
+			std::lock_guard<std::mutex> lock(EntryLock);
+
+			if (IsEntryInitialized(Counter))
+				return;
+
+			// Value and Histogram may already be in use and are left alone
+			Counter.File = File;
+			Counter.Function = Function;
+			Counter.Name = Name;
+
+			if (Timer)
+			{
+				const uint32_t index = (uint32_t)(&Counter - GlobalCounters.data());
+				const uint32_t count = TimerCount.load(std::memory_order_relaxed);
+
+				if (count < MaxTimers)
+				{
+					TimerIndices[count] = index;
+					TimerCount.store(count + 1, std::memory_order_release);
+				}
+			}
+
+			std::atomic_ref<bool>(Counter.Init).store(true, std::memory_order_release);
+		}
+
+		LatencyHistogram *AttachHistogram(Entry& Counter)
 		{
-			uint32_t unused;
-			TSC = __rdtscp(&unused);
+			// Histograms come out of a fixed pool, the first caller for an entry takes the next one
+			std::lock_guard<std::mutex> lock(EntryLock);
+			std::atomic_ref<LatencyHistogram *> histogram(Counter.Histogram);
+
+			if (!histogram.load(std::memory_order_relaxed))
+			{
+				const uint32_t index = HistogramCount.load(std::memory_order_relaxed);
+
+				if (index < MaxHistograms)
+					HistogramCount.store(index + 1, std::memory_order_relaxed);
 
-			LARGE_INTEGER p;
-			QueryPerformanceCounter(&p);
-			QPC = p.QuadPart;
+				histogram.store((index < MaxHistograms) ? &Histograms[index] : &OverflowHistogram, std::memory_order_release);
+			}
+
+			return histogram.load(std::memory_order_relaxed);
 		}
 
-		void CalibrateQPC()
+		ThreadShard *AttachThreadShard()
 		{
-			QueryPerformanceFrequency((LARGE_INTEGER *)&QpcFrequency);
+			// Shards outlive their threads. Counts from exited threads still have to show up in the totals.
+			uint32_t index = ShardCount.fetch_add(1);
+
+			if (index >= MaxShards)
+			{
+				CurrentShard = &OverflowShard;
+				return CurrentShard;
+			}
+
+			CurrentShard = new ThreadShard();
+			Shards[index].store(CurrentShard, std::memory_order_release);
+
+			return CurrentShard;
 		}
 
-		void CalibrateRDTSC()
+		ShardBlock *AllocateShardBlock(ThreadShard *Shard, uint32_t BlockIndex)
 		{
-			//
-			// Modified from: https://github.com/benvanik/xenia/issues/801#issuecomment-352202912
-			//
+			ShardBlock *block = new ShardBlock();
+			Shard->Blocks[BlockIndex].store(block, std::memory_order_release);
+
+			return block;
+		}
 
-			// Try to compute the RDTSC update frequency with the highest thread priority on a single core
-			DWORD_PTR oldAffinity = SetThreadAffinityMask(GetCurrentThread(), 1ull << GetCurrentProcessorNumber());
-			int oldPriority = GetThreadPriority(GetCurrentThread());
+		int64_t SumShards(const Entry *Counter)
+		{
+			const uint32_t index = (uint32_t)(Counter - GlobalCounters.data());
+			const uint32_t shardCount = std::min<uint32_t>(ShardCount.load(std::memory_order_acquire), MaxShards);
 
-			SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+			int64_t total = Counter->Value;
 
-			// Loop multiple times and average it. Discard any results where the interval is out of reasonable range.
+			for (uint32_t i = 0; i < shardCount; i++)
 			{
-				double perfCounterFactor = 1000000.0 / (double)QpcFrequency;
-				double frequency = 0.0;
+				// The slot is claimed before it's published
+				ThreadShard *shard = Shards[i].load(std::memory_order_acquire);
 
-				int64_t tscA;
-				int64_t pcA;
+				if (!shard)
+					continue;
 
-				int64_t tscB;
-				int64_t pcB;
+				if (ShardBlock *block = shard->Blocks[index / ShardBlockEntries].load(std::memory_order_acquire))
+					total += block->Values[index % ShardBlockEntries].load(std::memory_order_relaxed);
+			}
 
-				double interval;
+			return total;
+		}
 
-				int times = 64;
-				int retries = 10;
+		Entry *FindEntry(uint32_t CRC)
+		{
+			// Check if it's in the hashmap
+			auto entry = Internal::LookupMap[CRC];
 
-				for (int i = 0; i < times; i++)
-				{
-					for (int j = 0; j < retries; j++)
-					{
-						ReadCounters(tscA, pcA);
-
-						do
-						{
-							ReadCounters(tscB, pcB);
-							interval = double(pcB - pcA) * perfCounterFactor;
-						} while (interval < 1000.0);
-
-						if (interval < 1001.0)
-						{
-							frequency += double(tscB - tscA) / interval;
-							break;
-						}
-					}
-				}
+			if (entry)
+				return entry;
+
+			// Otherwise check the whole array, then add it to the map
+			for (auto &counter : Internal::GlobalCounters)
+			{
+				if (!counter.Init)
+					continue;
 
-				// Calculate average, then convert MHz to Hz
-				CpuFrequency = int64_t(ceil(frequency / double(times)));
-				CpuFrequency *= 1000000;
+				if (Internal::CRC32(counter.Name) != CRC)
+					continue;
+
+				Internal::LookupMap[CRC] = &counter;
+				return &counter;
 			}
 
-			SetThreadPriority(GetCurrentThread(), oldPriority);
-			SetThreadAffinityMask(GetCurrentThread(), oldAffinity);
+			return nullptr;
 		}
+	}
 
-		STATIC_CONSTRUCTOR(__profiler, []
+	int64_t GetValue(uint32_t CRC)
+	{
+		if (auto e = Internal::FindEntry(CRC); e)
 		{
-			CalibrateQPC();
-			CalibrateRDTSC();
-		});
-
-        Entry *FindEntry(uint32_t CRC)
-        {
-            // Check if it's in the hashmap
-            auto entry = Internal::LookupMap[CRC];
-
-            if (entry)
-                return entry;
-
-            // Otherwise check the whole array, then add it to the map
-            for (auto &counter : Internal::GlobalCounters)
-            {
-                if (!counter.Init)
-                    continue;
-
-                if (Internal::CRC32(counter.Name) != CRC)
-                    continue;
-
-                Internal::LookupMap[CRC] = &counter;
-                return &counter;
-            }
-
-            return nullptr;
-        }
-    }
-
-    int64_t GetValue(uint32_t CRC)
-    {
-        if (auto e = Internal::FindEntry(CRC); e)
-        {
-            // e->Value might be updated in the middle of this code
-            int64_t temp = e->Value;
-            e->OldValue  = temp;
-            return temp;
-        }
-
-        return 0;
-    }
+			// Shards might be updated in the middle of this code
+			int64_t temp = Internal::SumShards(e);
+			e->OldValue  = temp;
+			return temp;
+		}
+
+		return 0;
+	}
+
+	int64_t PeekValue(uint32_t CRC)
+	{
+		// Same as GetValue() without moving the baseline GetDeltaValue() uses
+		if (auto e = Internal::FindEntry(CRC); e)
+			return Internal::SumShards(e);
+
+		return 0;
+	}
 
 	int64_t GetDeltaValue(uint32_t CRC)
 	{
 		if (auto e = Internal::FindEntry(CRC); e)
-			return e->Value - e->OldValue;
+			return Internal::SumShards(e) - e->OldValue;
 
 		return 0;
 	}
 
-    double GetTime(uint32_t CRC)
-    {
-		return ((double)GetValue(CRC) / (double)Internal::CpuFrequency) * 1000.0;
-    }
+	double GetTime(uint32_t CRC)
+	{
+		return Clock::TicksToMs(GetValue(CRC));
+	}
 
 	double GetDeltaTime(uint32_t CRC)
 	{
-		return ((double)GetDeltaValue(CRC) / (double)Internal::CpuFrequency) * 1000.0;
+		return Clock::TicksToMs(GetDeltaValue(CRC));
+	}
+
+	Percentiles GetPercentiles(uint32_t CRC)
+	{
+		auto e = Internal::FindEntry(CRC);
+
+		if (!e || !e->Histogram || e->Histogram == &Internal::OverflowHistogram)
+			return {};
+
+		auto window = e->Histogram->ConsumeWindow();
+		return { window.Count, Clock::TicksToMs(window.P50), Clock::TicksToMs(window.P95), Clock::TicksToMs(window.P99), Clock::TicksToMs(window.Max) };
+	}
+
+	uint32_t GetTimerTotals(TimerTotal *Out, uint32_t MaxCount)
+	{
+		const uint32_t count = std::min(Internal::TimerCount.load(std::memory_order_acquire), MaxCount);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Internal::Entry& e = Internal::GlobalCounters[Internal::TimerIndices[i]];
+			Out[i] = { e.Name, Internal::SumShards(&e) };
+		}
+
+		return count;
 	}
 }
 #endif // SKYRIM64_USE_PROFILER
\ No newline at end of file
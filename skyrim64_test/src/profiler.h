@@ -1,30 +1,65 @@
 #pragma once
 
+#include <stdint.h>
+#include "profiler_clock.h"
+#include "profiler_zones.h"
+#include "profiler_flight.h"
+
+namespace Profiler
+{
+	// Individual scope durations (ProfileTimerHistogram) in milliseconds
+	struct Percentiles
+	{
+		uint64_t Count;
+		double P50;
+		double P95;
+		double P99;
+		double Max;
+	};
+
+	// Cumulative ProfileTimer() duration in clock ticks
+	struct TimerTotal
+	{
+		const char *Name;
+		int64_t Ticks;
+	};
+}
+
 #if !SKYRIM64_USE_PROFILER
 #define ProfileCounterInc(Name)			((void)0)
 #define ProfileCounterAdd(Name, Add)	((void)0)
 #define ProfileTimer(Name)				((void)0)
+#define ProfileTimerHistogram(Name)		((void)0)
 
 #define ProfileGetValue(Name)			(0)
+#define ProfilePeekValue(Name)			(0)
 #define ProfileGetDeltaValue(Name)		(0)
 #define ProfileGetTime(Name)			(0.0)
 #define ProfileGetDeltaTime(Name)		(0.0)
+#define ProfileGetPercentiles(Name)		(Profiler::Percentiles {})
+#define ProfileGetTimerTotals(Out, Max)	(0u)
 #else
-#include <intrin.h>
 #include <array>
+#include <atomic>
 #include <unordered_map>
+#include "profiler_histogram.h"
 
-#define EXPAND_MACRO(x) x
-#define LINEID EXPAND_MACRO(__z)__COUNTER__
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define LINEID PROFILE_CONCAT(__z, __COUNTER__)
 
 #define ProfileCounterInc(Name)			Profiler::ScopedCounter<COMPILE_TIME_CRC32_INDEX(Name)>(__FILE__, __FUNCTION__, Name)
 #define ProfileCounterAdd(Name, Add)	Profiler::ScopedCounter<COMPILE_TIME_CRC32_INDEX(Name)>(__FILE__, __FUNCTION__, Name, Add)
 #define ProfileTimer(Name)				Profiler::ScopedTimer<COMPILE_TIME_CRC32_INDEX(Name)> LINEID(__FILE__, __FUNCTION__, Name)
+#define ProfileTimerHistogram(Name)		Profiler::ScopedTimer<COMPILE_TIME_CRC32_INDEX(Name), true> LINEID(__FILE__, __FUNCTION__, Name)
 
 #define ProfileGetValue(Name)			Profiler::GetValue<COMPILE_TIME_CRC32_STR(Name)>()
+#define ProfilePeekValue(Name)			Profiler::PeekValue(Profiler::Internal::CRC32(Name))
 #define ProfileGetDeltaValue(Name)		Profiler::GetDeltaValue<COMPILE_TIME_CRC32_STR(Name)>()
 #define ProfileGetTime(Name)			Profiler::GetTime<COMPILE_TIME_CRC32_STR(Name)>()
 #define ProfileGetDeltaTime(Name)		Profiler::GetDeltaTime<COMPILE_TIME_CRC32_STR(Name)>()
+#define ProfileGetPercentiles(Name)		Profiler::GetPercentiles<COMPILE_TIME_CRC32_STR(Name)>()
+#define ProfileGetTimerTotals(Out, Max)	Profiler::GetTimerTotals(Out, Max)
 
 namespace Profiler
 {
@@ -45,25 +80,25 @@ namespace Profiler
 	public:
 		inline ScopedCounter(const char *File, const char *Function, const char *Name)
 		{
-			if (!m_Entry.Init)
-				m_Entry = { 0, 0, File, Function, Name, true };
+			if (!Internal::IsEntryInitialized(m_Entry))
+				Internal::InitializeEntry(m_Entry, File, Function, Name, false);
 
-			InterlockedIncrement64(&m_Entry.Value);
+			Internal::AddToCounter(UniqueIndex, m_Entry, 1);
 		}
 
 		inline ScopedCounter(const char *File, const char *Function, const char *Name, int64_t Add)
 		{
-			if (!m_Entry.Init)
-				m_Entry = { 0, 0, File, Function, Name, true };
+			if (!Internal::IsEntryInitialized(m_Entry))
+				Internal::InitializeEntry(m_Entry, File, Function, Name, false);
 
-			InterlockedAdd64(&m_Entry.Value, Add);
+			Internal::AddToCounter(UniqueIndex, m_Entry, Add);
 		}
 
 	private:
 		Internal::Entry& m_Entry = Internal::GlobalCounters[UniqueIndex];
 	};
 
-	template<uint32_t UniqueIndex>
+	template<uint32_t UniqueIndex, bool RecordHistogram = false>
 	class ScopedTimer
 	{
 	private:
@@ -72,42 +107,48 @@ namespace Profiler
 		ScopedTimer() = delete;
 		ScopedTimer(ScopedTimer&) = delete;
 
-		__forceinline void GetTime(LARGE_INTEGER *Counter)
-		{
-#if 1
-			uint32_t temp;
-			Counter->QuadPart = __rdtscp(&temp);
-#else
-			QueryPerformanceCounter(Counter);
-#endif
-		}
-
 	public:
 		__forceinline ScopedTimer(const char *File, const char *Function, const char *Name)
 		{
-			if (!m_Entry.Init)
-				m_Entry = { 0, 0, File, Function, Name, true };
+			if (!Internal::IsEntryInitialized(m_Entry))
+				Internal::InitializeEntry(m_Entry, File, Function, Name, true);
 
-			GetTime(&m_Start);
+			if constexpr (RecordHistogram)
+			{
+				m_Histogram = std::atomic_ref<LatencyHistogram *>(m_Entry.Histogram).load(std::memory_order_acquire);
+
+				if (!m_Histogram)
+					m_Histogram = Internal::AttachHistogram(m_Entry);
+			}
+
+			m_Start = Clock::Now();
 		}
 
 		__forceinline ~ScopedTimer()
 		{
-			LARGE_INTEGER endTime;
-			GetTime(&endTime);
+			const uint64_t elapsed = Clock::Now() - m_Start;
+
+			Internal::AddToCounter(UniqueIndex, m_Entry, (int64_t)elapsed);
 
-			InterlockedAdd64(&m_Entry.Value, endTime.QuadPart - m_Start.QuadPart);
+			if constexpr (RecordHistogram)
+				m_Histogram->Record(elapsed);
 		}
 
 	private:
 		Internal::Entry& m_Entry = Internal::GlobalCounters[UniqueIndex];
-		LARGE_INTEGER m_Start;
+		LatencyHistogram *m_Histogram;
+		uint64_t m_Start;
 	};
 
 	int64_t GetValue(uint32_t CRC);
+	int64_t PeekValue(uint32_t CRC);
 	int64_t GetDeltaValue(uint32_t CRC);
 	double GetTime(uint32_t CRC);
 	double GetDeltaTime(uint32_t CRC);
+	Percentiles GetPercentiles(uint32_t CRC);
+
+	// Every ProfileTimer() scope used so far in first-use order. New scopes are only ever appended.
+	uint32_t GetTimerTotals(TimerTotal *Out, uint32_t MaxCount);
 
 	template<uint32_t CRC>
 	int64_t GetValue()
@@ -133,6 +174,13 @@ namespace Profiler
 		return GetDeltaTime(CRC);
 	}
 
+	// Everything recorded since the previous call
+	template<uint32_t CRC>
+	Percentiles GetPercentiles()
+	{
+		return GetPercentiles(CRC);
+	}
+
 	float GetProcessorUsagePercent();
 	float GetThreadUsagePercent();
 	float GetGpuUsagePercent(int GpuIndex = 0);
@@ -0,0 +1,331 @@
+#include "profiler_clock.h"
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <cpuid.h>
+#endif
+
+namespace Profiler::Clock
+{
+	Source ActiveSource = Source::TSC;
+	std::atomic_uint64_t ActiveFrequency;
+	bool InvariantTSC;
+	std::atomic_bool Initialized;
+	std::atomic_bool CalibrationStarted;		// Set by the InitializeAsync() thread once it's actually running
+
+	// Keeps the calibration loop on one core at the highest priority it can get
+	class ScopedPinnedThread
+	{
+	private:
+#if defined(_WIN32)
+		DWORD_PTR m_OldAffinity;
+		int m_OldPriority;
+#else
+		cpu_set_t m_OldAffinity;
+		bool m_Pinned;
+#endif
+
+	public:
+		ScopedPinnedThread()
+		{
+#if defined(_WIN32)
+			m_OldAffinity = SetThreadAffinityMask(GetCurrentThread(), 1ull << GetCurrentProcessorNumber());
+			m_OldPriority = GetThreadPriority(GetCurrentThread());
+
+			SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+			m_Pinned = pthread_getaffinity_np(pthread_self(), sizeof(m_OldAffinity), &m_OldAffinity) == 0;
+
+			if (int cpu = sched_getcpu(); m_Pinned && cpu >= 0)
+			{
+				cpu_set_t pinned;
+				CPU_ZERO(&pinned);
+				CPU_SET(cpu, &pinned);
+
+				m_Pinned = pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned) == 0;
+			}
+#endif
+		}
+
+		~ScopedPinnedThread()
+		{
+#if defined(_WIN32)
+			SetThreadPriority(GetCurrentThread(), m_OldPriority);
+			SetThreadAffinityMask(GetCurrentThread(), m_OldAffinity);
+#else
+			if (m_Pinned)
+				pthread_setaffinity_np(pthread_self(), sizeof(m_OldAffinity), &m_OldAffinity);
+#endif
+		}
+	};
+
+	bool HasInvariantTSC()
+	{
+		// CPUID.80000007H:EDX[8]
+#if defined(_MSC_VER)
+		int regs[4];
+		__cpuid(regs, 0x80000000);
+
+		if ((uint32_t)regs[0] < 0x80000007)
+			return false;
+
+		__cpuid(regs, 0x80000007);
+		return (regs[3] & (1 << 8)) != 0;
+#else
+		uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+		if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+			return false;
+
+		__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+		return (edx & (1 << 8)) != 0;
+#endif
+	}
+
+	bool IsSupported(Source Clock)
+	{
+		switch (Clock)
+		{
+		case Source::TSC:
+			return true;
+
+		case Source::QPC:
+#if defined(_WIN32)
+			return true;
+#else
+			return false;
+#endif
+
+		case Source::MonotonicRaw:
+#if defined(CLOCK_MONOTONIC_RAW)
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		return false;
+	}
+
+	Source GetOSSource()
+	{
+#if defined(_WIN32)
+		return Source::QPC;
+#else
+		return Source::MonotonicRaw;
+#endif
+	}
+
+	const char *GetSourceName(Source Clock)
+	{
+		switch (Clock)
+		{
+		case Source::TSC: return "TSC";
+		case Source::QPC: return "QPC";
+		case Source::MonotonicRaw: return "CLOCK_MONOTONIC_RAW";
+		}
+
+		return "Unknown";
+	}
+
+	uint64_t ReadSource(Source Clock)
+	{
+		switch (Clock)
+		{
+		case Source::TSC:
+			return ReadTSC();
+
+#if defined(_WIN32)
+		case Source::QPC:
+		{
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+			return counter.QuadPart;
+		}
+#endif
+
+#if defined(CLOCK_MONOTONIC_RAW)
+		case Source::MonotonicRaw:
+		{
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+			return ((uint64_t)ts.tv_sec * 1000000000ull) + ts.tv_nsec;
+		}
+#endif
+
+		default:
+			return 0;
+		}
+	}
+
+	uint64_t GetSourceFrequency(Source Clock)
+	{
+		switch (Clock)
+		{
+		case Source::TSC:
+			return CalibrateTSC();
+
+#if defined(_WIN32)
+		case Source::QPC:
+		{
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency(&frequency);
+			return frequency.QuadPart;
+		}
+#endif
+
+		case Source::MonotonicRaw:
+			return 1000000000ull;
+
+		default:
+			return 0;
+		}
+	}
+
+	uint64_t CalibrateTSC()
+	{
+		//
+		// Modified from: https://github.com/benvanik/xenia/issues/801#issuecomment-352202912
+		//
+		ScopedPinnedThread pin;
+
+		const Source reference = GetOSSource();
+		const double referenceToUs = 1000000.0 / (double)GetSourceFrequency(reference);
+
+		auto readPair = [reference](uint64_t& TSC, uint64_t& Reference)
+		{
+			TSC = ReadTSC();
+			Reference = ReadSource(reference);
+		};
+
+		// Loop multiple times and average it. Discard any results where the interval is out of reasonable range.
+		double frequency = 0.0;
+		int samples = 0;
+
+		const int times = 64;
+		const int retries = 10;
+
+		for (int i = 0; i < times; i++)
+		{
+			for (int j = 0; j < retries; j++)
+			{
+				uint64_t tscA, refA;
+				uint64_t tscB, refB;
+				double interval;
+
+				readPair(tscA, refA);
+
+				do
+				{
+					readPair(tscB, refB);
+					interval = double(refB - refA) * referenceToUs;
+				} while (interval < 1000.0);
+
+				if (interval < 1001.0)
+				{
+					frequency += double(tscB - tscA) / interval;
+					samples++;
+					break;
+				}
+			}
+		}
+
+		// MHz to Hz
+		if (samples > 0)
+			return (uint64_t)((frequency / samples) * 1000000.0);
+
+		// Too noisy for short intervals (loaded VM). One long interval is still good to ~0.1%.
+		uint64_t tscA, refA;
+		uint64_t tscB, refB;
+
+		readPair(tscA, refA);
+
+		do
+		{
+			readPair(tscB, refB);
+		} while (double(refB - refA) * referenceToUs < 20000.0);
+
+		return (uint64_t)(double(tscB - tscA) / (double(refB - refA) * referenceToUs) * 1000000.0);
+	}
+
+	Source SelectSource(Source Preferred)
+	{
+		InvariantTSC = HasInvariantTSC();
+
+		if (!IsSupported(Preferred) || (Preferred == Source::TSC && !InvariantTSC))
+			Preferred = GetOSSource();
+
+		// WaitForFrequency() reads ActiveSource once this is set
+		ActiveSource = Preferred;
+		Initialized.store(true);
+		return Preferred;
+	}
+
+	// Only the first calibration to finish is used, so every tick conversion agrees
+	void PublishFrequency(uint64_t Frequency)
+	{
+		uint64_t expected = 0;
+		ActiveFrequency.compare_exchange_strong(expected, Frequency, std::memory_order_release, std::memory_order_relaxed);
+	}
+
+	void Initialize(Source Preferred)
+	{
+		const Source source = SelectSource(Preferred);
+		ActiveFrequency.store(GetSourceFrequency(source), std::memory_order_release);
+	}
+
+	void InitializeAsync(Source Preferred)
+	{
+		const Source source = SelectSource(Preferred);
+
+		// OS clocks report their rate directly. Only the TSC needs the ~64ms pinned measurement loop.
+		if (source != Source::TSC)
+		{
+			ActiveFrequency.store(GetSourceFrequency(source), std::memory_order_release);
+			return;
+		}
+
+		std::thread([]()
+		{
+			CalibrationStarted.store(true);
+			PublishFrequency(CalibrateTSC());
+		}).detach();
+	}
+
+	uint64_t WaitForFrequency()
+	{
+		if (!Initialized.exchange(true))
+			Initialize();
+
+		//
+		// Threads created during DLL load don't start until the loader lock is released. Waiting on a calibration that
+		// hasn't started from inside DllMain would never return, so measure inline instead. A started one normally
+		// takes ~64ms; if it still isn't done after waiting 100ms here, measure inline too. Whichever result lands first is
+		// kept.
+		//
+		const Source reference = GetOSSource();
+		const uint64_t timeout = GetSourceFrequency(reference) / 10;
+		const uint64_t start = ReadSource(reference);
+
+		uint64_t frequency;
+
+		while ((frequency = ActiveFrequency.load(std::memory_order_acquire)) == 0)
+		{
+			if (!CalibrationStarted.load() || ReadSource(reference) - start >= timeout)
+			{
+				PublishFrequency(GetSourceFrequency(ActiveSource));
+				return ActiveFrequency.load(std::memory_order_acquire);
+			}
+
+			std::this_thread::yield();
+		}
+
+		return frequency;
+	}
+}
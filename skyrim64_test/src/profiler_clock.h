@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+
+#ifndef __forceinline
+#define __forceinline inline __attribute__((always_inline))
+#endif
+#endif
+
+//
+// Time sources for the profiler. Everything the profiler records is in ticks of the active source, which is picked
+// once by Initialize() or InitializeAsync() and converted to wall time only when values are read back. TSC is preferred because it's a
+// single instruction, but it's only used when the CPU reports an invariant TSC (constant rate across P/C-states and
+// synchronized between cores). Otherwise the OS clock is used: QPC on Windows, CLOCK_MONOTONIC_RAW elsewhere.
+//
+// Nothing in here depends on the game, so standalone tools can link profiler_clock.cpp on its own.
+//
+namespace Profiler::Clock
+{
+	enum class Source : uint32_t
+	{
+		TSC,
+		QPC,
+		MonotonicRaw,
+	};
+
+	extern Source ActiveSource;
+	extern std::atomic_uint64_t ActiveFrequency;	// Ticks per second, 0 while calibrating. Read with GetFrequency().
+	extern bool InvariantTSC;
+
+	bool HasInvariantTSC();
+	bool IsSupported(Source Clock);
+	Source GetOSSource();
+	const char *GetSourceName(Source Clock);
+
+	uint64_t ReadSource(Source Clock);
+	uint64_t GetSourceFrequency(Source Clock);
+
+	// Measures the TSC rate against the OS clock. Pins the calling thread to its current core while running.
+	uint64_t CalibrateTSC();
+
+	// Falls back to the OS clock if Preferred is TSC and the TSC isn't invariant (or if Preferred isn't supported)
+	void Initialize(Source Preferred = Source::TSC);
+
+	// Same source selection, but the TSC is calibrated on a background thread. Safe to call during DLL load. Ticks
+	// can be recorded right away, only converting them waits for the calibration.
+	void InitializeAsync(Source Preferred = Source::TSC);
+
+	// Waits for a pending calibration, or runs Initialize() if nothing has yet. Calibrates on the calling thread instead
+	// if the background one hasn't started (e.g. the loader lock is held) or hasn't finished within 100ms.
+	uint64_t WaitForFrequency();
+
+	inline uint64_t GetFrequency()
+	{
+		if (uint64_t frequency = ActiveFrequency.load(std::memory_order_acquire); frequency != 0)
+			return frequency;
+
+		return WaitForFrequency();
+	}
+
+	__forceinline uint64_t ReadTSC()
+	{
+		uint32_t unused;
+		return __rdtscp(&unused);
+	}
+
+	__forceinline uint64_t Now()
+	{
+		if (ActiveSource == Source::TSC)
+			return ReadTSC();
+
+		return ReadSource(ActiveSource);
+	}
+
+	inline double TicksToNs(uint64_t Ticks)
+	{
+		return ((double)Ticks / (double)GetFrequency()) * 1000000000.0;
+	}
+
+	inline double TicksToMs(uint64_t Ticks)
+	{
+		return ((double)Ticks / (double)GetFrequency()) * 1000.0;
+	}
+}
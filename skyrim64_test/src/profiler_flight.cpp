@@ -0,0 +1,62 @@
+#include "common.h"
+
+namespace Profiler::FlightRecorder
+{
+	ThreadRings Threads;
+
+	static_assert(sizeof(ThreadHeader::Name) == sizeof(ThreadRings::Buffer::Name));
+
+	void SetThreadName(uint32_t ThreadId, const char *Name)
+	{
+		Threads.SetThreadName(ThreadId, Name);
+	}
+
+	void *CreateSnapshot(uint32_t CrashThreadId, uint32_t *Size)
+	{
+		const uint32_t threadCount = Threads.GetThreadCount();
+		const size_t maxSize = sizeof(StreamHeader) + threadCount * (sizeof(ThreadHeader) + sizeof(Event) * EventsPerThread);
+
+		auto data = (uint8_t *)VirtualAlloc(nullptr, maxSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+		if (!data)
+			return nullptr;
+
+		auto header = (StreamHeader *)data;
+		header->Magic = Magic;
+		header->Version = Version;
+		// Never wait on the calibration thread from the crash handler
+		header->TicksPerSecond = Clock::ActiveFrequency.load(std::memory_order_acquire);
+		header->SnapshotTimestamp = Clock::Now();
+		header->ModuleBase = g_ModuleBase;
+		header->CrashThreadId = CrashThreadId;
+		header->ThreadCount = 0;
+
+		size_t offset = sizeof(StreamHeader);
+
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			const ThreadRings::Buffer *buffer = Threads.GetThread(i);
+
+			if (!buffer)
+				continue;
+
+			auto threadHeader = (ThreadHeader *)(data + offset);
+			threadHeader->ThreadId = buffer->ThreadId;
+			threadHeader->EventCount = ThreadRings::CopyEvents(buffer, (Event *)(data + offset + sizeof(ThreadHeader)));
+			memcpy(threadHeader->Name, buffer->Name, sizeof(threadHeader->Name));
+			threadHeader->Name[ARRAYSIZE(threadHeader->Name) - 1] = '\0';
+
+			offset += sizeof(ThreadHeader) + threadHeader->EventCount * sizeof(Event);
+			header->ThreadCount++;
+		}
+
+		*Size = (uint32_t)offset;
+		return data;
+	}
+
+	void FreeSnapshot(void *Snapshot)
+	{
+		if (Snapshot)
+			VirtualFree(Snapshot, 0, MEM_RELEASE);
+	}
+}
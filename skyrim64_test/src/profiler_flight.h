@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "profiler_clock.h"
+#include "profiler_flight_format.h"
+#include "profiler_thread_ring.h"
+
+//
+// Always-on flight recorder. Every thread keeps its last EventsPerThread engine events (job dispatches, form lookups,
+// render passes, lock waits) in a small ring buffer. Nothing is ever written out except by the crash handler, which
+// snapshots all rings into the minidump as a user stream. Use the flight_dump tool to read it back.
+//
+// Recording is a TLS load, a Clock::Now() (rdtscp on any CPU with an invariant TSC) and a 32 byte store, so it stays
+// enabled in release builds.
+//
+namespace Profiler::FlightRecorder
+{
+	using namespace FlightRecorderFormat;
+
+	constexpr uint32_t EventsPerThread = 1024;		// Must be a power of two
+	constexpr uint32_t MaxThreads = 256;
+
+	using ThreadRings = ThreadRingSet<Event, EventsPerThread, MaxThreads>;
+	extern ThreadRings Threads;
+
+	void SetThreadName(uint32_t ThreadId, const char *Name);
+
+	// Copies every ring into a buffer laid out as described in profiler_flight_format.h. Allocates with VirtualAlloc
+	// so it still works when the crash came from a corrupted heap. Free with FreeSnapshot().
+	void *CreateSnapshot(uint32_t CrashThreadId, uint32_t *Size);
+	void FreeSnapshot(void *Snapshot);
+
+	__forceinline void Record(EventType Type, uint64_t Arg0, uint64_t Arg1 = 0, uint32_t Arg2 = 0)
+	{
+		Threads.Record({ Clock::Now(), Arg0, Arg1, Arg2, (uint16_t)Type, 0 });
+	}
+
+	// Brackets the slow path of a lock so a hang or crash mid-wait still shows who it was waiting on
+	class ScopedLockWait
+	{
+	private:
+		const void *m_Lock;
+		uint64_t m_Start;
+
+		ScopedLockWait() = delete;
+		ScopedLockWait(ScopedLockWait&) = delete;
+
+	public:
+		__forceinline ScopedLockWait(const void *Lock, uint32_t OwnerThreadId = 0) : m_Lock(Lock)
+		{
+			Record(EVENT_LOCK_WAIT_BEGIN, (uintptr_t)m_Lock, 0, OwnerThreadId);
+			m_Start = Clock::Now();
+		}
+
+		__forceinline ~ScopedLockWait()
+		{
+			Record(EVENT_LOCK_WAIT_END, (uintptr_t)m_Lock, Clock::Now() - m_Start);
+		}
+	};
+}
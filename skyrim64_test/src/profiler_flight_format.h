@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+
+//
+// Layout of the flight recorder snapshot that gets attached to crash dumps as a minidump user stream. Shared with the
+// standalone flight_dump tool, so this header must not depend on anything from the game or Windows.
+//
+// Stream layout, little endian, tightly packed:
+//
+//   StreamHeader
+//   StreamHeader.ThreadCount x { ThreadHeader, Event[ThreadHeader.EventCount] }
+//
+// Events are oldest first. Timestamps are ticks of the profiler clock (rdtsc on CPUs with an invariant TSC, the OS
+// clock otherwise); StreamHeader.TicksPerSecond and SnapshotTimestamp turn them into "how long before the crash".
+// TicksPerSecond is 0 if the crash happened before the clock finished calibrating.
+//
+namespace Profiler::FlightRecorderFormat
+{
+	constexpr static uint32_t Magic = 0x43524C46;			// 'FLRC'
+	constexpr static uint32_t Version = 1;
+	constexpr static uint32_t DumpStreamType = 0x534B4652;	// Anything past LastReservedStream (0xFFFF) is ours
+
+	enum EventType : uint16_t
+	{
+		EVENT_NONE = 0,
+		EVENT_FRAME = 1,				// Arg0: frame number
+		EVENT_JOB_BEGIN = 2,			// Arg0: job function RVA, Arg1: job parameter
+		EVENT_JOB_END = 3,				// Arg0: job function RVA
+		EVENT_FORM_LOOKUP = 4,			// Arg0: form ID, Arg1: TESForm pointer (0 if not found)
+		EVENT_RENDER_PASS = 5,			// Arg0: geometry, Arg1: shader, Arg2: technique
+		EVENT_LOCK_WAIT_BEGIN = 6,		// Arg0: lock, Arg2: owning thread ID if known
+		EVENT_LOCK_WAIT_END = 7,		// Arg0: lock, Arg1: ticks spent waiting
+		EVENT_TYPE_COUNT,
+	};
+
+#pragma pack(push, 1)
+	struct StreamHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t TicksPerSecond;
+		uint64_t SnapshotTimestamp;
+		uint64_t ModuleBase;
+		uint32_t CrashThreadId;
+		uint32_t ThreadCount;
+	};
+
+	struct ThreadHeader
+	{
+		uint32_t ThreadId;
+		uint32_t EventCount;
+		char Name[32];
+	};
+
+	struct Event
+	{
+		uint64_t Timestamp;
+		uint64_t Arg0;
+		uint64_t Arg1;
+		uint32_t Arg2;
+		uint16_t Type;
+		uint16_t Reserved;
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(Event) == 32);
+
+	inline const char *GetEventTypeName(uint16_t Type)
+	{
+		switch (Type)
+		{
+		case EVENT_FRAME: return "Frame";
+		case EVENT_JOB_BEGIN: return "JobBegin";
+		case EVENT_JOB_END: return "JobEnd";
+		case EVENT_FORM_LOOKUP: return "FormLookup";
+		case EVENT_RENDER_PASS: return "RenderPass";
+		case EVENT_LOCK_WAIT_BEGIN: return "LockWaitBegin";
+		case EVENT_LOCK_WAIT_END: return "LockWaitEnd";
+		}
+
+		return "Unknown";
+	}
+}
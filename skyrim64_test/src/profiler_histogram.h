@@ -0,0 +1,186 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+namespace Profiler
+{
+	//
+	// Log-linear (HDR style) histogram of durations in ticks. Values below SubBucketCount are exact. Everything above
+	// lands in one of SubBucketCount linear sub buckets per power of two, so a reported value is at most ~3% above the
+	// real one. ConsumeWindow() reports everything recorded since its last call and must only be called from one
+	// thread at a time.
+	//
+	// Buckets are sharded per writer thread so hot scopes (allocator, lock hooks) don't fight over shared cache lines.
+	// A thread's shard is allocated the first time it records into this histogram and only that thread writes to it,
+	// so Record() is a plain load and store. Threads past MaxWriters share one shard with interlocked updates.
+	// ConsumeWindow() merges every shard. A value recorded while a window is being consumed can have its bucket and
+	// its max land in different windows.
+	//
+	// Nothing in here depends on the game or Windows so it can be exercised headlessly.
+	//
+	class LatencyHistogram
+	{
+	public:
+		constexpr static uint32_t SubBucketBits = 5;
+		constexpr static uint32_t SubBucketCount = 1 << SubBucketBits;
+		constexpr static uint32_t MaxValueBits = 48;		// Larger values are clamped into the last bucket
+		constexpr static uint32_t BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+		constexpr static uint32_t MaxWriters = 128;
+
+		struct Window
+		{
+			uint64_t Count;
+			uint64_t P50;
+			uint64_t P95;
+			uint64_t P99;
+			uint64_t Max;
+		};
+
+	private:
+		struct alignas(64) Shard
+		{
+			std::atomic_uint32_t Counts[BucketCount] = {};
+			std::atomic_uint64_t WindowMax = 0;
+		};
+
+		// Process wide, so a thread has the same shard index in every histogram
+		inline static std::atomic_uint32_t NextWriter = 0;
+		inline static thread_local uint32_t WriterIndex = NextWriter.fetch_add(1, std::memory_order_relaxed);
+
+		std::atomic<Shard *> m_Shards[MaxWriters] = {};
+		Shard m_SharedShard;
+		uint32_t m_Previous[BucketCount] = {};		// Reader only
+
+	public:
+		LatencyHistogram() = default;
+		LatencyHistogram(const LatencyHistogram&) = delete;
+		LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+		~LatencyHistogram()
+		{
+			for (auto& shard : m_Shards)
+				delete shard.load(std::memory_order_relaxed);
+		}
+
+		void Record(uint64_t Value)
+		{
+			const uint32_t writer = WriterIndex;
+
+			if (writer >= MaxWriters)
+			{
+				RecordShared(Value);
+				return;
+			}
+
+			Shard *shard = m_Shards[writer].load(std::memory_order_relaxed);
+
+			if (!shard)
+			{
+				shard = new Shard();
+				m_Shards[writer].store(shard, std::memory_order_release);
+			}
+
+			// Single writer: readers can't see a torn value and nothing can be lost
+			std::atomic_uint32_t& count = shard->Counts[GetBucketIndex(Value)];
+			count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+			if (Value > shard->WindowMax.load(std::memory_order_relaxed))
+				shard->WindowMax.store(Value, std::memory_order_relaxed);
+		}
+
+		Window ConsumeWindow()
+		{
+			uint32_t counts[BucketCount] = {};
+			Window window = {};
+
+			auto mergeShard = [&](Shard& Source)
+			{
+				for (uint32_t i = 0; i < BucketCount; i++)
+					counts[i] += Source.Counts[i].load(std::memory_order_relaxed);
+
+				window.Max = std::max(window.Max, Source.WindowMax.exchange(0, std::memory_order_relaxed));
+			};
+
+			mergeShard(m_SharedShard);
+
+			for (auto& shard : m_Shards)
+			{
+				if (Shard *source = shard.load(std::memory_order_acquire))
+					mergeShard(*source);
+			}
+
+			// Buckets are cumulative, the window is the difference to the last snapshot
+			for (uint32_t i = 0; i < BucketCount; i++)
+			{
+				uint32_t current = counts[i];
+
+				counts[i] = current - m_Previous[i];
+				m_Previous[i] = current;
+				window.Count += counts[i];
+			}
+
+			if (window.Count == 0)
+				return window;
+
+			// Bucket upper bounds can overshoot the largest value that was actually seen
+			window.P50 = std::min(GetValueAtRank(counts, (window.Count * 50 + 99) / 100), window.Max);
+			window.P95 = std::min(GetValueAtRank(counts, (window.Count * 95 + 99) / 100), window.Max);
+			window.P99 = std::min(GetValueAtRank(counts, (window.Count * 99 + 99) / 100), window.Max);
+
+			return window;
+		}
+
+		static uint32_t GetBucketIndex(uint64_t Value)
+		{
+			if (Value < SubBucketCount)
+				return (uint32_t)Value;
+
+			uint32_t msb = std::min<uint32_t>(std::bit_width(Value) - 1, MaxValueBits - 1);
+			uint32_t shift = msb - SubBucketBits;
+			uint32_t subBucket = (uint32_t)(std::min<uint64_t>(Value >> shift, (SubBucketCount * 2) - 1) - SubBucketCount);
+
+			return ((shift + 1) * SubBucketCount) + subBucket;
+		}
+
+		// Largest value that maps to Index
+		static uint64_t GetBucketUpperBound(uint32_t Index)
+		{
+			if (Index < SubBucketCount)
+				return Index;
+
+			uint32_t shift = (Index / SubBucketCount) - 1;
+			uint64_t mantissa = (Index % SubBucketCount) + SubBucketCount;
+
+			return ((mantissa + 1) << shift) - 1;
+		}
+
+	private:
+		void RecordShared(uint64_t Value)
+		{
+			m_SharedShard.Counts[GetBucketIndex(Value)].fetch_add(1, std::memory_order_relaxed);
+
+			uint64_t max = m_SharedShard.WindowMax.load(std::memory_order_relaxed);
+
+			while (Value > max && !m_SharedShard.WindowMax.compare_exchange_weak(max, Value, std::memory_order_relaxed))
+				;
+		}
+
+		static uint64_t GetValueAtRank(const uint32_t *Counts, uint64_t Rank)
+		{
+			uint64_t seen = 0;
+
+			for (uint32_t i = 0; i < BucketCount; i++)
+			{
+				seen += Counts[i];
+
+				if (seen >= Rank)
+					return GetBucketUpperBound(i);
+			}
+
+			return GetBucketUpperBound(BucketCount - 1);
+		}
+	};
+}
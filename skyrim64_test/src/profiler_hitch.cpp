@@ -0,0 +1,192 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+#include "profiler_clock.h"
+#include "profiler_hitch.h"
+
+namespace Profiler
+{
+	static void AppendFormat(std::string& Out, const char *Format, ...)
+	{
+		char buffer[1024];
+
+		va_list args;
+		va_start(args, Format);
+		const int length = vsnprintf(buffer, sizeof(buffer), Format, args);
+		va_end(args);
+
+		if (length > 0)
+			Out.append(buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+	}
+
+	HitchDetector::HitchDetector() : HitchDetector(Settings())
+	{
+	}
+
+	HitchDetector::HitchDetector(const Settings& Options) : m_Settings(Options)
+	{
+	}
+
+	bool HitchDetector::AddFrame(float FrameTimeMs, const int64_t *ScopeTotals, uint32_t ScopeCount)
+	{
+		// Judge this frame against the ones before it
+		UpdateBaseline();
+
+		bool hitch = m_FrameCount >= m_Settings.WarmupFrames &&
+			m_FrameCount >= m_CooldownUntil &&
+			FrameTimeMs >= m_BaselineMs * m_Settings.Multiplier &&
+			FrameTimeMs - m_BaselineMs >= m_Settings.MinExcessMs;
+
+		if (hitch)
+			m_CooldownUntil = m_FrameCount + 1 + m_Settings.CooldownFrames;
+
+		// Scopes seen for the first time have no history yet
+		ScopeCount = std::min(ScopeCount, MaxScopes);
+
+		for (uint32_t i = m_ScopeCount; i < ScopeCount; i++)
+		{
+			for (uint32_t j = 0; j < HistoryFrames; j++)
+				m_ScopeDeltas[j][i] = 0;
+
+			m_LastTotals[i] = 0;
+		}
+
+		m_ScopeCount = std::max(m_ScopeCount, ScopeCount);
+
+		int64_t *deltas = m_ScopeDeltas[m_FrameCount & (HistoryFrames - 1)];
+
+		for (uint32_t i = 0; i < ScopeCount; i++)
+		{
+			deltas[i] = ScopeTotals[i] - m_LastTotals[i];
+			m_LastTotals[i] = ScopeTotals[i];
+		}
+
+		for (uint32_t i = ScopeCount; i < m_ScopeCount; i++)
+			deltas[i] = 0;
+
+		m_FrameTimes[m_FrameCount % BaselineFrames] = FrameTimeMs;
+		m_FrameCount++;
+
+		return hitch;
+	}
+
+	uint32_t HitchDetector::GetTopGrowth(ScopeGrowth *Out, uint32_t MaxCount) const
+	{
+		const uint32_t history = GetHistoryCount();
+
+		if (history == 0)
+			return 0;
+
+		ScopeGrowth scopes[MaxScopes];
+		double samples[HistoryFrames];
+
+		for (uint32_t i = 0; i < m_ScopeCount; i++)
+		{
+			scopes[i].Scope = i;
+			scopes[i].FrameMs = GetScopeMs(i, 0);
+			scopes[i].BaselineMs = 0.0;
+
+			if (history > 1)
+			{
+				for (uint32_t age = 1; age < history; age++)
+					samples[age - 1] = GetScopeMs(i, age);
+
+				const uint32_t count = history - 1;
+				std::nth_element(samples, samples + (count / 2), samples + count);
+				scopes[i].BaselineMs = samples[count / 2];
+			}
+		}
+
+		const uint32_t count = std::min(MaxCount, m_ScopeCount);
+
+		std::partial_sort(scopes, scopes + count, scopes + m_ScopeCount, [](const ScopeGrowth& A, const ScopeGrowth& B)
+		{
+			return (A.FrameMs - A.BaselineMs) > (B.FrameMs - B.BaselineMs);
+		});
+
+		std::copy(scopes, scopes + count, Out);
+		return count;
+	}
+
+	double HitchDetector::GetScopeMs(uint32_t Scope, uint32_t Age) const
+	{
+		return Clock::TicksToMs(m_ScopeDeltas[(m_FrameCount - 1 - Age) & (HistoryFrames - 1)][Scope]);
+	}
+
+	bool HitchDetector::FormatReport(std::string& Out, const char *const *ScopeNames, const FrameTelemetry& Telemetry) const
+	{
+		const uint32_t history = GetHistoryCount();
+
+		if (history == 0)
+			return false;
+
+		Out.clear();
+		Out.reserve(32 * 1024);
+
+		const float frameTimeMs = m_FrameTimes[(m_FrameCount - 1) % BaselineFrames];
+		const int percentile = (int)(m_Settings.Percentile * 100.0f + 0.5f);
+
+		AppendFormat(Out, "Hitch: %.2f ms (baseline p%d %.2f ms, %.1fx)\n", frameTimeMs, percentile, m_BaselineMs,
+			(m_BaselineMs > 0.0f) ? frameTimeMs / m_BaselineMs : 0.0f);
+
+		ScopeGrowth top[16];
+		const uint32_t topCount = GetTopGrowth(top, (uint32_t)std::size(top));
+
+		AppendFormat(Out, "\nTimer scopes that grew the most (hitch frame vs. median of the previous %u frames):\n", history - 1);
+
+		for (uint32_t i = 0; i < topCount; i++)
+		{
+			AppendFormat(Out, "  %2u. %-40s %9.3f ms vs %9.3f ms (%+.3f ms)\n", i + 1, ScopeNames[top[i].Scope], top[i].FrameMs, top[i].BaselineMs,
+				top[i].FrameMs - top[i].BaselineMs);
+		}
+
+		// Frame history, oldest first. Telemetry was recorded for the same frames.
+		const uint32_t historyScopes = std::min<uint32_t>(topCount, 8);
+		const uint32_t rows = std::min(history, Telemetry.GetCount());
+
+		AppendFormat(Out, "\nAge,FrameTimeMs,GpuTimeMs,CpuPercent,ThreadPercent");
+
+		for (uint32_t i = 0; i < Telemetry.GetCounterCount(); i++)
+			AppendFormat(Out, ",%s", Telemetry.GetCounterName(i));
+
+		for (uint32_t i = 0; i < historyScopes; i++)
+			AppendFormat(Out, ",%s (ms)", ScopeNames[top[i].Scope]);
+
+		AppendFormat(Out, "\n");
+
+		for (uint32_t age = rows; age-- > 0;)
+		{
+			const FrameSample& sample = Telemetry.GetRecent(age);
+
+			AppendFormat(Out, "%u,%.3f,%.3f,%.1f,%.1f", age, sample.FrameTimeMs, sample.GpuTimeMs, sample.CpuPercent, sample.ThreadPercent);
+
+			for (uint32_t i = 0; i < Telemetry.GetCounterCount(); i++)
+				AppendFormat(Out, ",%lld", (long long)sample.Counters[i]);
+
+			for (uint32_t i = 0; i < historyScopes; i++)
+				AppendFormat(Out, ",%.3f", GetScopeMs(top[i].Scope, age));
+
+			AppendFormat(Out, "\n");
+		}
+
+		return true;
+	}
+
+	void HitchDetector::UpdateBaseline()
+	{
+		const uint32_t count = (m_FrameCount < BaselineFrames) ? (uint32_t)m_FrameCount : BaselineFrames;
+
+		if (count == 0)
+			return;
+
+		float frameTimes[BaselineFrames];
+		memcpy(frameTimes, m_FrameTimes, count * sizeof(float));
+
+		const uint32_t index = std::min((uint32_t)(m_Settings.Percentile * count), count - 1);
+		std::nth_element(frameTimes, frameTimes + index, frameTimes + count);
+
+		m_BaselineMs = frameTimes[index];
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "profiler_telemetry.h"
+
+namespace Profiler
+{
+	//
+	// Flags frames that take much longer than the recent norm. The baseline is a percentile of the last BaselineFrames
+	// frame times, so it follows the scene instead of relying on a fixed threshold. Per-frame deltas of every timer scope
+	// are kept for the last HistoryFrames frames; when a hitch is detected the report ranks the scopes by how much longer
+	// they took in that frame than their median over the history.
+	//
+	// Called once per frame from one thread. Nothing in here depends on the game or Windows.
+	//
+	class HitchDetector
+	{
+	public:
+		constexpr static uint32_t HistoryFrames = 128;		// Must be a power of two
+		constexpr static uint32_t BaselineFrames = 512;
+		constexpr static uint32_t MaxScopes = 256;
+
+		struct Settings
+		{
+			float Percentile = 0.95f;		// Of the baseline window
+			float Multiplier = 2.0f;		// A hitch is at least this many times the baseline...
+			float MinExcessMs = 10.0f;		// ...and at least this much longer than it
+			uint32_t WarmupFrames = 120;	// No detection until the baseline has this many frames
+			uint32_t CooldownFrames = 120;	// Frames after a hitch that can't trigger another one
+		};
+
+		struct ScopeGrowth
+		{
+			uint32_t Scope;			// Index into the totals given to AddFrame()
+			double FrameMs;			// Newest frame
+			double BaselineMs;		// Median over the history, newest frame excluded
+		};
+
+	private:
+		Settings m_Settings;
+		uint64_t m_FrameCount = 0;
+		uint64_t m_CooldownUntil = 0;
+		float m_BaselineMs = 0.0f;
+		float m_FrameTimes[BaselineFrames];
+
+		uint32_t m_ScopeCount = 0;
+		int64_t m_LastTotals[MaxScopes];
+		int64_t m_ScopeDeltas[HistoryFrames][MaxScopes];		// Clock ticks
+
+	public:
+		HitchDetector();
+		HitchDetector(const Settings& Options);
+
+		// ScopeTotals are cumulative clock ticks (ProfileTimer scopes), in the same order every call. New scopes may only
+		// be appended. Returns true if this frame is a hitch.
+		bool AddFrame(float FrameTimeMs, const int64_t *ScopeTotals, uint32_t ScopeCount);
+
+		// Sorted by largest growth first
+		uint32_t GetTopGrowth(ScopeGrowth *Out, uint32_t MaxCount) const;
+
+		// Age 0 is the newest frame. Age must be less than GetHistoryCount().
+		double GetScopeMs(uint32_t Scope, uint32_t Age) const;
+
+		// Text report: the hitch, its top scopes, then one line per frame of history (telemetry and the top scopes).
+		// Only formats it, so the caller can write the file somewhere other than the frame thread.
+		bool FormatReport(std::string& Out, const char *const *ScopeNames, const FrameTelemetry& Telemetry) const;
+
+		float GetBaselineMs() const
+		{
+			return m_BaselineMs;
+		}
+
+		uint32_t GetHistoryCount() const
+		{
+			return (m_FrameCount < HistoryFrames) ? (uint32_t)m_FrameCount : HistoryFrames;
+		}
+
+		uint32_t GetScopeCount() const
+		{
+			return m_ScopeCount;
+		}
+
+	private:
+		void UpdateBaseline();
+	};
+}
@@ -81,12 +81,80 @@ struct Entry
 	const char *Function;
 	const char *Name;
 	bool Init;
+	LatencyHistogram *Histogram;	// ProfileTimerHistogram() only
 };
 
 constexpr int MaxEntries = 16384;
 extern std::array<Entry, MaxEntries> GlobalCounters;
 extern std::unordered_map<uint32_t, Entry *> LookupMap;
-extern int64_t CpuFrequency;
+
+//
+// Counter values are sharded per thread. A thread only ever writes to its own shard, so updates are plain adds
+// instead of locked ones on a cache line shared with every other thread. Readers sum all shards plus Entry::Value,
+// which only takes (interlocked) adds from threads that didn't get a shard. Shards are split into blocks that are
+// allocated the first time the thread touches one of their counters.
+//
+constexpr int ShardBlockEntries = 64;
+constexpr int MaxShards = 256;
+
+struct alignas(64) ShardBlock
+{
+	std::atomic<int64_t> Values[ShardBlockEntries];
+};
+
+struct ThreadShard
+{
+	std::atomic<ShardBlock *> Blocks[MaxEntries / ShardBlockEntries];
+};
+
+extern std::array<std::atomic<ThreadShard *>, MaxShards> Shards;
+extern std::atomic_uint32_t ShardCount;
+extern thread_local ThreadShard *CurrentShard;
+extern ThreadShard OverflowShard;		// Marker for threads that arrived after every shard was taken
+
+constexpr int MaxHistograms = 64;
+extern std::array<LatencyHistogram, MaxHistograms> Histograms;
+extern std::atomic_uint32_t HistogramCount;
+extern LatencyHistogram OverflowHistogram;		// Shared by everything past MaxHistograms and never reported
+
+constexpr int MaxTimers = 1024;
+extern std::array<uint32_t, MaxTimers> TimerIndices;	// Into GlobalCounters
+extern std::atomic_uint32_t TimerCount;
+
+// Entries are filled in on first use. Several threads can get there at once, so the slow path is serialized and Init
+// is only published after the rest of the entry.
+inline bool IsEntryInitialized(Entry& Counter)
+{
+	return std::atomic_ref<bool>(Counter.Init).load(std::memory_order_acquire);
+}
+
+void InitializeEntry(Entry& Counter, const char *File, const char *Function, const char *Name, bool Timer);
+LatencyHistogram *AttachHistogram(Entry& Counter);
+ThreadShard *AttachThreadShard();
+ShardBlock *AllocateShardBlock(ThreadShard *Shard, uint32_t BlockIndex);
+
+__forceinline void AddToCounter(uint32_t Index, Entry& Global, int64_t Add)
+{
+	ThreadShard *shard = CurrentShard;
+
+	if (!shard)
+		shard = AttachThreadShard();
+
+	if (shard == &OverflowShard)
+	{
+		std::atomic_ref<int64_t>(Global.Value).fetch_add(Add);
+		return;
+	}
+
+	ShardBlock *block = shard->Blocks[Index / ShardBlockEntries].load(std::memory_order_relaxed);
+
+	if (!block)
+		block = AllocateShardBlock(shard, Index / ShardBlockEntries);
+
+	// Single writer: a plain load and store, readers can't see a torn value
+	std::atomic<int64_t>& value = block->Values[Index % ShardBlockEntries];
+	value.store(value.load(std::memory_order_relaxed) + Add, std::memory_order_relaxed);
+}
 
 #define COMPILE_TIME_CRC32_STR(x) (Profiler::Internal::XCRCCalculate<sizeof(x)-1>::crc32(x))
 #define COMPILE_TIME_CRC32_INDEX(x) (COMPILE_TIME_CRC32_STR(x) % Profiler::Internal::MaxEntries)
\ No newline at end of file
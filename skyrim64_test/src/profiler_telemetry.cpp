@@ -0,0 +1,242 @@
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "profiler_telemetry.h"
+
+namespace Profiler
+{
+	FILE *OpenTelemetryFile(const char *FilePath)
+	{
+#if defined(_MSC_VER)
+		FILE *f;
+		return (fopen_s(&f, FilePath, "w") == 0) ? f : nullptr;
+#else
+		return fopen(FilePath, "w");
+#endif
+	}
+
+	FrameTelemetry::FrameTelemetry(const char *const *CounterNames, uint32_t CounterCount)
+	{
+		m_CounterCount = std::min(CounterCount, MaxTelemetryCounters);
+
+		for (uint32_t i = 0; i < m_CounterCount; i++)
+			m_CounterNames[i] = CounterNames[i];
+	}
+
+	void FrameTelemetry::Record(const FrameSample& Sample)
+	{
+		// Single writer. Publishing the new head after the sample lets a reader tell which slots might be torn.
+		const uint64_t head = m_Head.load(std::memory_order_relaxed);
+		FrameSample& slot = m_Samples[head & (Capacity - 1)];
+
+		slot = Sample;
+		slot.Frame = head;
+
+		m_Head.store(head + 1, std::memory_order_release);
+	}
+
+	uint32_t FrameTelemetry::Read(uint64_t& First, FrameSample *Out, uint32_t MaxCount) const
+	{
+		const uint64_t head = GetHead();
+		const uint64_t oldest = (head > Capacity) ? head - Capacity : 0;
+
+		First = std::max(First, oldest);
+		uint32_t count = (uint32_t)std::min<uint64_t>(head - std::min(First, head), MaxCount);
+
+		for (uint32_t i = 0; i < count; i++)
+			Out[i] = m_Samples[(First + i) & (Capacity - 1)];
+
+		// Anything the writer could have reached in the meantime (including the slot it's writing now) is suspect
+		const uint64_t newHead = GetHead();
+		const uint64_t safeFirst = (newHead >= Capacity) ? newHead - Capacity + 1 : 0;
+
+		if (safeFirst > First)
+		{
+			uint32_t skip = (uint32_t)std::min<uint64_t>(safeFirst - First, count);
+
+			memmove(Out, Out + skip, (count - skip) * sizeof(FrameSample));
+			First += skip;
+			count -= skip;
+		}
+
+		return count;
+	}
+
+	const FrameSample& FrameTelemetry::GetRecent(uint32_t Age) const
+	{
+		return m_Samples[(m_Head.load(std::memory_order_relaxed) - 1 - Age) & (Capacity - 1)];
+	}
+
+	FrameTelemetry::Summary FrameTelemetry::Summarize(uint32_t FrameCount) const
+	{
+		Summary summary = {};
+		summary.Count = std::min(FrameCount, GetCount());
+
+		if (summary.Count == 0)
+			return summary;
+
+		// Welford's algorithm. Frame times are tiny compared to their sum, so the naive formula loses precision.
+		float *frameTimes = m_SortScratch;
+		double mean = 0.0;
+		double m2 = 0.0;
+
+		for (uint32_t i = 0; i < summary.Count; i++)
+		{
+			const double value = GetRecent(i).FrameTimeMs;
+			const double delta = value - mean;
+
+			mean += delta / (i + 1);
+			m2 += delta * (value - mean);
+
+			frameTimes[i] = (float)value;
+			summary.MaxMs = std::max(summary.MaxMs, value);
+		}
+
+		summary.MeanMs = mean;
+		summary.StdevMs = (summary.Count > 1) ? sqrt(m2 / (summary.Count - 1)) : 0.0;
+		summary.MeanFps = (mean > 0.0) ? 1000.0 / mean : 0.0;
+
+		// Slowest frames first. The 0.1% set is a subset of the 1% set, so only the first partition has to look at
+		// every frame.
+		auto lowFps = [&](uint32_t Divisor, uint32_t Range)
+		{
+			const uint32_t worst = std::max(summary.Count / Divisor, 1u);
+			std::nth_element(frameTimes, frameTimes + (worst - 1), frameTimes + Range, std::greater<float>());
+
+			double sum = 0.0;
+
+			for (uint32_t i = 0; i < worst; i++)
+				sum += frameTimes[i];
+
+			return std::make_pair((sum > 0.0) ? (1000.0 * worst) / sum : 0.0, worst);
+		};
+
+		const auto onePercent = lowFps(100, summary.Count);
+		summary.OnePercentLowFps = onePercent.first;
+		summary.PointOnePercentLowFps = lowFps(1000, onePercent.second).first;
+
+		return summary;
+	}
+
+	FrameTelemetryLog::FrameTelemetryLog(const FrameTelemetry& Telemetry, uint64_t PartBytes, uint32_t MaxParts) :
+		m_Telemetry(Telemetry), m_PartBytes(PartBytes), m_MaxParts(std::max(MaxParts, 1u))
+	{
+	}
+
+	FrameTelemetryLog::~FrameTelemetryLog()
+	{
+		Stop();
+	}
+
+	bool FrameTelemetryLog::Start(const char *BasePath)
+	{
+		if (IsRunning())
+			return true;
+
+		// A whole ring's worth is 700KB, so it's kept between flushes and runs
+		if (!m_Frames)
+			m_Frames = std::make_unique<FrameSample[]>(FrameTelemetry::Capacity);
+
+		m_BasePath = BasePath;
+		m_PartIndex = 0;
+		m_StopRequested = false;
+
+		// Include whatever history is still in the ring
+		m_NextFrame = m_Telemetry.GetHead() - m_Telemetry.GetCount();
+
+		if (!OpenPart())
+			return false;
+
+		m_Thread = std::thread(&FrameTelemetryLog::LogThread, this);
+		return true;
+	}
+
+	void FrameTelemetryLog::Stop()
+	{
+		if (!IsRunning())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_StopRequested = true;
+		}
+
+		m_Wake.notify_one();
+		m_Thread.join();
+	}
+
+	void FrameTelemetryLog::LogThread()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		for (bool stop = false; !stop;)
+		{
+			stop = m_Wake.wait_for(lock, std::chrono::milliseconds(FlushIntervalMs), [this]() { return m_StopRequested; });
+
+			lock.unlock();
+			WriteFrames();
+			lock.lock();
+		}
+
+		if (m_File)
+			fclose(m_File);
+
+		m_File = nullptr;
+	}
+
+	void FrameTelemetryLog::WriteFrames()
+	{
+		if (!m_File)
+			return;
+
+		const uint32_t count = m_Telemetry.Read(m_NextFrame, m_Frames.get(), FrameTelemetry::Capacity);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const FrameSample& frame = m_Frames[i];
+
+			int written = fprintf(m_File, "%llu,%.3f,%.3f,%.1f,%.1f,%.1f,%.1f", (unsigned long long)frame.Frame, frame.FrameTimeMs,
+				frame.GpuTimeMs, frame.CpuPercent, frame.ThreadPercent, frame.Gpu0Percent, frame.Gpu1Percent);
+
+			for (uint32_t j = 0; j < m_Telemetry.GetCounterCount(); j++)
+				written += fprintf(m_File, ",%lld", (long long)frame.Counters[j]);
+
+			written += fprintf(m_File, "\n");
+			m_FileBytes += std::max(written, 0);
+			m_NextFrame = frame.Frame + 1;
+
+			if (m_FileBytes >= m_PartBytes && !OpenPart())
+				return;
+		}
+
+		fflush(m_File);
+	}
+
+	bool FrameTelemetryLog::OpenPart()
+	{
+		if (m_File)
+			fclose(m_File);
+
+		// Drop the oldest part once there are too many
+		if (m_PartIndex >= m_MaxParts)
+			remove((m_BasePath + "_" + std::to_string(m_PartIndex - m_MaxParts) + ".csv").c_str());
+
+		const std::string path = m_BasePath + "_" + std::to_string(m_PartIndex++) + ".csv";
+		m_File = OpenTelemetryFile(path.c_str());
+		m_FileBytes = 0;
+
+		if (!m_File)
+			return false;
+
+		m_FileBytes += fprintf(m_File, "Frame,FrameTimeMs,GpuTimeMs,CpuPercent,ThreadPercent,Gpu0Percent,Gpu1Percent");
+
+		for (uint32_t i = 0; i < m_Telemetry.GetCounterCount(); i++)
+			m_FileBytes += fprintf(m_File, ",%s", m_Telemetry.GetCounterName(i));
+
+		m_FileBytes += fprintf(m_File, "\n");
+		return true;
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Profiler
+{
+	constexpr uint32_t MaxTelemetryCounters = 8;
+
+	FILE *OpenTelemetryFile(const char *FilePath);
+
+	struct FrameSample
+	{
+		uint64_t Frame;			// Filled in by FrameTelemetry::Record()
+		float FrameTimeMs;
+		float GpuTimeMs;
+		float CpuPercent;
+		float ThreadPercent;
+		float Gpu0Percent;
+		float Gpu1Percent;
+		int64_t Counters[MaxTelemetryCounters];		// Per frame deltas of the counters given to the constructor
+	};
+
+	//
+	// Per frame statistics in a ring buffer. One thread calls Record() once per frame, which never shifts or allocates.
+	// GetRecent() and Summarize() are for that same thread (Summarize() reuses a scratch buffer in here). Read() can be called from any other thread and skips
+	// anything the writer overwrote while it was copying.
+	//
+	// Nothing in here depends on the game or Windows so it can be exercised headlessly.
+	//
+	class FrameTelemetry
+	{
+	public:
+		constexpr static uint32_t Capacity = 8192;		// Must be a power of two. About 2 minutes at 60 FPS.
+
+		struct Summary
+		{
+			uint32_t Count;
+			double MeanMs;
+			double StdevMs;
+			double MaxMs;
+			double MeanFps;
+			double OnePercentLowFps;		// Average FPS over the slowest 1% of frames
+			double PointOnePercentLowFps;	// Average FPS over the slowest 0.1% of frames
+		};
+
+	private:
+		FrameSample m_Samples[Capacity];
+		std::atomic_uint64_t m_Head = 0;		// Total frames ever recorded
+		mutable float m_SortScratch[Capacity];	// Summarize() only
+		const char *m_CounterNames[MaxTelemetryCounters] = {};
+		uint32_t m_CounterCount = 0;
+
+	public:
+		FrameTelemetry(const char *const *CounterNames, uint32_t CounterCount);
+
+		void Record(const FrameSample& Sample);
+
+		// Copies frames [First, GetHead()) that are still in the ring into Out, returns how many were copied and sets
+		// First to the first frame actually copied
+		uint32_t Read(uint64_t& First, FrameSample *Out, uint32_t MaxCount) const;
+
+		// Age 0 is the newest frame. Age must be less than GetCount().
+		const FrameSample& GetRecent(uint32_t Age) const;
+
+		// Covers the newest FrameCount frames still in the ring
+		Summary Summarize(uint32_t FrameCount) const;
+
+		uint64_t GetHead() const
+		{
+			return m_Head.load(std::memory_order_acquire);
+		}
+
+		uint32_t GetCount() const
+		{
+			uint64_t head = GetHead();
+			return (head < Capacity) ? (uint32_t)head : Capacity;
+		}
+
+		uint32_t GetCounterCount() const
+		{
+			return m_CounterCount;
+		}
+
+		const char *GetCounterName(uint32_t Index) const
+		{
+			return m_CounterNames[Index];
+		}
+	};
+
+	//
+	// Streams a FrameTelemetry ring to CSV files from a background thread. Files roll over after PartBytes and only the
+	// newest MaxParts are kept, so a soak test can run indefinitely. Frames that were overwritten before the thread got
+	// to them show up as gaps in the Frame column.
+	//
+	class FrameTelemetryLog
+	{
+	public:
+		constexpr static uint64_t DefaultPartBytes = 64ull * 1024 * 1024;
+		constexpr static uint32_t DefaultMaxParts = 8;
+		constexpr static uint32_t FlushIntervalMs = 500;
+
+	private:
+		const FrameTelemetry& m_Telemetry;
+		const uint64_t m_PartBytes;
+		const uint32_t m_MaxParts;
+		std::unique_ptr<FrameSample[]> m_Frames;	// Read() destination, allocated by the first Start()
+		std::thread m_Thread;
+		std::mutex m_Mutex;
+		std::condition_variable m_Wake;
+		bool m_StopRequested = false;
+
+		std::string m_BasePath;
+		FILE *m_File = nullptr;				// Owned by the thread while it runs
+		uint64_t m_FileBytes = 0;
+		uint32_t m_PartIndex = 0;
+		uint64_t m_NextFrame = 0;
+
+	public:
+		FrameTelemetryLog(const FrameTelemetry& Telemetry, uint64_t PartBytes = DefaultPartBytes, uint32_t MaxParts = DefaultMaxParts);
+		~FrameTelemetryLog();
+
+		// BasePath gets "_<part>.csv" appended
+		bool Start(const char *BasePath);
+		void Stop();
+
+		bool IsRunning() const
+		{
+			return m_Thread.joinable();
+		}
+
+		const char *GetBasePath() const
+		{
+			return m_BasePath.c_str();
+		}
+
+	private:
+		void LogThread();
+		void WriteFrames();
+		bool OpenPart();
+	};
+}
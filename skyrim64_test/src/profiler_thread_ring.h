@@ -0,0 +1,173 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#if !defined(_MSC_VER) && !defined(__forceinline)
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
+namespace Profiler
+{
+	//
+	// Per-thread event rings shared by the zone recorder and the flight recorder. A thread gets its own ring the first
+	// time it records and is the only one that ever writes to it, so recording is a TLS load, a store and a release.
+	// Rings outlive their threads so short-lived threads still show up. Anything past MaxThreads shares an overflow
+	// ring that is never read back.
+	//
+	// Readers can copy any ring at any time without stopping the owner, see CopyEvents(). Nothing here allocates after
+	// a thread is attached, so the crash handler can read the rings too.
+	//
+	// The current thread's ring is a static thread_local, so there can only be one instance per template instantiation.
+	//
+	template<typename EventType, uint32_t EventsPerThread, uint32_t MaxThreads>
+	class ThreadRingSet
+	{
+		static_assert(EventsPerThread > 0 && (EventsPerThread & (EventsPerThread - 1)) == 0, "Ring size must be a power of 2");
+
+	public:
+		struct Buffer
+		{
+			uint32_t ThreadId;
+			char Name[32];
+			std::atomic_uint64_t Head;					// Total events ever written, only the owning thread stores
+			EventType Events[EventsPerThread];
+		};
+
+	private:
+		inline static thread_local Buffer *CurrentBuffer;
+
+		std::array<std::atomic<Buffer *>, MaxThreads> m_Threads;
+		std::atomic_uint32_t m_ThreadCount;
+		Buffer m_OverflowBuffer;
+
+	public:
+		__forceinline void Record(const EventType& Event)
+		{
+			Buffer *buffer = CurrentBuffer;
+
+			if (!buffer)
+				buffer = AttachThread();
+
+			// Single writer. Publishing the new head after the event lets a reader tell which slots might be torn.
+			const uint64_t head = buffer->Head.load(std::memory_order_relaxed);
+
+			buffer->Events[head & (EventsPerThread - 1)] = Event;
+			buffer->Head.store(head + 1, std::memory_order_release);
+		}
+
+		Buffer *AttachThread()
+		{
+			uint32_t index = m_ThreadCount.fetch_add(1);
+
+			if (index >= MaxThreads)
+			{
+				CurrentBuffer = &m_OverflowBuffer;
+				return CurrentBuffer;
+			}
+
+			Buffer *buffer = new Buffer();
+			buffer->ThreadId = CurrentThreadId();
+
+			m_Threads[index].store(buffer, std::memory_order_release);
+			CurrentBuffer = buffer;
+			return buffer;
+		}
+
+		// Names the ring of an attached thread. Threads name themselves before doing anything interesting, so the
+		// calling thread gets a ring if it doesn't have one yet.
+		void SetThreadName(uint32_t ThreadId, const char *Name)
+		{
+			if (ThreadId == CurrentThreadId() && !CurrentBuffer)
+				AttachThread();
+
+			const size_t length = std::min(strlen(Name), sizeof(Buffer::Name) - 1);
+
+			for (uint32_t i = 0; i < GetThreadCount(); i++)
+			{
+				Buffer *buffer = m_Threads[i].load(std::memory_order_acquire);
+
+				if (buffer && buffer->ThreadId == ThreadId)
+				{
+					memcpy(buffer->Name, Name, length);
+					buffer->Name[length] = '\0';
+				}
+			}
+		}
+
+		static uint32_t CurrentThreadId()
+		{
+#if defined(_WIN32)
+			return GetCurrentThreadId();
+#else
+			return (uint32_t)syscall(SYS_gettid);
+#endif
+		}
+
+		uint32_t GetThreadCount() const
+		{
+			return std::min(m_ThreadCount.load(), MaxThreads);
+		}
+
+		// Null if the slot was claimed but the pointer isn't published yet
+		const Buffer *GetThread(uint32_t Index) const
+		{
+			return m_Threads[Index].load(std::memory_order_acquire);
+		}
+
+		// Copies the newest events of a ring, oldest first, into Out (EventsPerThread entries) and returns how many
+		// were copied. The owner keeps writing while this runs. Any slot it could have reached between the two head
+		// loads is dropped.
+		static uint32_t CopyEvents(const Buffer *Ring, EventType *Out)
+		{
+			return CopyEventsSince(Ring, Out, [](const EventType&) { return false; });
+		}
+
+		// Same as CopyEvents(), minus the oldest events for which IsBefore(Event) is true. That has to hold for a
+		// prefix of the ring (e.g. timestamps before a cutoff) since it's found with a binary search.
+		template<typename Func>
+		static uint32_t CopyEventsSince(const Buffer *Ring, EventType *Out, Func IsBefore)
+		{
+			const uint64_t head = Ring->Head.load(std::memory_order_acquire);
+			uint64_t first = (head > EventsPerThread) ? head - EventsPerThread : 0;
+
+			// A slot the owner overwrites meanwhile can throw the search off, but those are dropped below anyway
+			for (uint64_t last = head; first < last;)
+			{
+				const uint64_t middle = first + (last - first) / 2;
+
+				if (IsBefore(Ring->Events[middle & (EventsPerThread - 1)]))
+					first = middle + 1;
+				else
+					last = middle;
+			}
+
+			for (uint64_t i = first; i < head; i++)
+				Out[i - first] = Ring->Events[i & (EventsPerThread - 1)];
+
+			// The copies above must not be reordered past the second head load
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t newHead = Ring->Head.load(std::memory_order_acquire);
+			const uint64_t safeFirst = (newHead >= EventsPerThread) ? newHead - EventsPerThread + 1 : 0;
+
+			if (safeFirst <= first)
+				return (uint32_t)(head - first);
+
+			if (safeFirst >= head)
+				return 0;
+
+			memmove(Out, Out + (safeFirst - first), (head - safeFirst) * sizeof(EventType));
+			return (uint32_t)(head - safeFirst);
+		}
+	};
+}
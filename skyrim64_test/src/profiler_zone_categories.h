@@ -0,0 +1,20 @@
+#pragma once
+
+//
+// Compile-time switches for ProfileZoneCat(). Each category covers one engine hot path and compiles to nothing (no
+// Tracy zone, no zone recorder event) when its switch is 0. Only the files that use ProfileZoneCat() include this
+// header, so flipping a switch rebuilds a handful of files instead of the whole project.
+//
+// With Tracy off, an enabled zone costs two zone recorder events: a TLS load, an rdtsc and a 16 byte store each.
+// Measured at 60 ns per zone on a VM where rdtsc alone takes 22 ns. Most of that is the two rdtscs, so expect 20-30 ns
+// on bare metal. A disabled category measured the same as no zone at all. Tracy adds its own per-zone cost on top when
+// SKYRIM64_USE_TRACY is set.
+//
+// The zone recorder keeps the last 16384 events per thread, so the high frequency categories below would push
+// everything else out of its traces within a few frames. They're off by default for that reason.
+//
+#define SKYRIM64_ZONES_JOBS			1	// BSJobs job callbacks, named per job
+#define SKYRIM64_ZONES_TASKS		1	// BSTaskManager task queueing
+#define SKYRIM64_ZONES_LOCKS		1	// BSSpinLock / BSReadWriteLock slow paths (contended acquires only)
+#define SKYRIM64_ZONES_FORMS		0	// TESForm::LookupFormById cache misses
+#define SKYRIM64_ZONES_MEMORY		0	// MemAlloc / MemFree hooks, every engine and CRT allocation
@@ -0,0 +1,243 @@
+#include "common.h"
+#include <memory>
+#include <vector>
+
+namespace Profiler::ZoneRecorder
+{
+	struct TraceSnapshot
+	{
+		struct Thread
+		{
+			uint32_t ThreadId;
+			char Name[sizeof(ThreadRings::Buffer::Name)];
+			std::vector<Event> Events;
+		};
+
+		std::vector<Thread> Threads;
+	};
+
+	ThreadRings Threads;
+
+	// Written by MarkFrame() only
+	uint64_t FrameTimestamps[MaxSnapshotFrames];
+	uint64_t FrameMarkCount;
+
+	constexpr ZoneSite FrameSite { __FILE__, __FUNCTION__, "Frame" };
+
+	// Trace timestamps are in microseconds since this point
+	uint64_t StartTimestamp;
+
+	// Zones, the flight recorder and ProfileTimer() all record Clock::Now() ticks. This runs during DLL load, so the
+	// TSC calibration goes to a background thread and only converting ticks waits for it.
+	STATIC_CONSTRUCTOR(InitializeClock, []
+	{
+		Clock::InitializeAsync();
+		StartTimestamp = Clock::Now();
+	});
+
+	void GetTracePath(char *Buffer, size_t BufferSize)
+	{
+		// Put it next to the exe, same as crash dumps
+		char exePath[MAX_PATH];
+		GetModuleFileNameA(GetModuleHandle(nullptr), exePath, ARRAYSIZE(exePath));
+
+		SYSTEMTIME sysTime;
+		GetSystemTime(&sysTime);
+		sprintf_s(Buffer, BufferSize, "%s_%4d%02d%02d_%02d%02d%02d.json", exePath, sysTime.wYear, sysTime.wMonth, sysTime.wDay, sysTime.wHour, sysTime.wMinute, sysTime.wSecond);
+	}
+
+	void Shutdown()
+	{
+		// Static destructors run under the loader lock, so the exit trace is written from here instead
+		static std::atomic_flag done;
+
+		if (done.test_and_set())
+			return;
+
+		if (ui::opt::SaveZoneTraceOnExit)
+		{
+			char fileName[MAX_PATH];
+			GetTracePath(fileName, ARRAYSIZE(fileName));
+			WriteChromeTrace(fileName, nullptr);
+		}
+	}
+
+	void SetThreadName(uint32_t ThreadId, const char *Name)
+	{
+		Threads.SetThreadName(ThreadId, Name);
+	}
+
+	void MarkFrame()
+	{
+		// Taken before the frame event so a snapshot starting at this frame includes it
+		FrameTimestamps[FrameMarkCount % MaxSnapshotFrames] = Clock::Now();
+
+		Record(&FrameSite, EVENT_FRAME);
+		FlightRecorder::Record(FlightRecorder::EVENT_FRAME, FrameMarkCount++);
+	}
+
+	TraceSnapshot *CreateSnapshot(uint32_t FrameCount)
+	{
+		const uint64_t cutoff = (FrameCount > 0 && FrameCount <= std::min<uint64_t>(FrameMarkCount, MaxSnapshotFrames)) ?
+			FrameTimestamps[(FrameMarkCount - FrameCount) % MaxSnapshotFrames] : 0;
+
+		auto snapshot = new TraceSnapshot();
+		auto events = std::make_unique<Event[]>(EventsPerThread);
+
+		for (uint32_t i = 0; i < Threads.GetThreadCount(); i++)
+		{
+			const ThreadRings::Buffer *buffer = Threads.GetThread(i);
+
+			if (!buffer)
+				continue;
+
+			// Each ring is in recording order, so only the part after the cutoff is copied
+			const uint32_t count = ThreadRings::CopyEventsSince(buffer, events.get(), [cutoff](const Event& Value)
+			{
+				return Value.Timestamp < cutoff;
+			});
+
+			auto& thread = snapshot->Threads.emplace_back();
+			thread.ThreadId = buffer->ThreadId;
+			memcpy(thread.Name, buffer->Name, sizeof(thread.Name));
+			thread.Name[sizeof(thread.Name) - 1] = '\0';
+			thread.Events.assign(events.get(), events.get() + count);
+		}
+
+		return snapshot;
+	}
+
+	void FreeSnapshot(TraceSnapshot *Snapshot)
+	{
+		delete Snapshot;
+	}
+
+	void WriteJsonString(FILE *File, const char *String)
+	{
+		fputc('"', File);
+
+		for (; *String; String++)
+		{
+			if (*String == '"' || *String == '\\')
+				fputc('\\', File);
+
+			// Control characters can't appear in names or paths
+			if ((unsigned char)*String >= ' ')
+				fputc(*String, File);
+		}
+
+		fputc('"', File);
+	}
+
+	bool WriteChromeTrace(const char *FilePath, const TraceSnapshot *Snapshot, uint64_t *EventCount)
+	{
+		const double ticksPerUs = (double)Clock::GetFrequency() / 1000000.0;
+
+		FILE *f;
+		if (fopen_s(&f, FilePath, "w") != 0)
+			return false;
+
+		const uint32_t pid = GetCurrentProcessId();
+		const ZoneSite *stack[256];
+		uint64_t stackStart[256];
+		uint64_t written = 0;
+		bool first = true;
+
+		fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+		for (auto& thread : Snapshot->Threads)
+		{
+			if (thread.Name[0] != '\0')
+			{
+				fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", pid, thread.ThreadId);
+				WriteJsonString(f, thread.Name);
+				fprintf(f, "}}");
+				first = false;
+			}
+
+			// Begin/end pairs become complete ("X") events. Zones that were still open, or whose begin already fell out
+			// of the ring or before the snapshot, are skipped.
+			const std::vector<Event>& events = thread.Events;
+			uint32_t depth = 0;
+
+			for (size_t j = 0; j < events.size(); j++)
+			{
+				const ZoneSite *site = (const ZoneSite *)(events[j].SiteAndType & ~EVENT_TYPE_MASK);
+				const uint64_t timestamp = events[j].Timestamp;
+
+				switch (events[j].SiteAndType & EVENT_TYPE_MASK)
+				{
+				case EVENT_BEGIN:
+					if (depth < ARRAYSIZE(stack))
+					{
+						stack[depth] = site;
+						stackStart[depth] = timestamp;
+					}
+					depth++;
+					break;
+
+				case EVENT_END:
+					if (depth == 0)
+						break;
+
+					depth--;
+
+					if (depth >= ARRAYSIZE(stack) || stack[depth] != site)
+						break;
+
+					fprintf(f, "%s{\"name\":", first ? "" : ",\n");
+					WriteJsonString(f, site->Name);
+					fprintf(f, ",\"cat\":");
+					WriteJsonString(f, site->File);
+					fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"function\":",
+						(double)(int64_t)(stackStart[depth] - StartTimestamp) / ticksPerUs,
+						(double)(timestamp - stackStart[depth]) / ticksPerUs, pid, thread.ThreadId);
+					WriteJsonString(f, site->Function);
+					fprintf(f, "}}");
+					first = false;
+					written++;
+					break;
+
+				case EVENT_FRAME:
+					fprintf(f, "%s{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u}", first ? "" : ",\n",
+						(double)(int64_t)(timestamp - StartTimestamp) / ticksPerUs, pid, thread.ThreadId);
+					first = false;
+					written++;
+					break;
+				}
+			}
+		}
+
+		fprintf(f, "\n]}\n");
+
+		bool valid = ferror(f) == 0;
+		valid = (fclose(f) == 0) && valid;
+
+		if (EventCount)
+			*EventCount = written;
+
+		return valid;
+	}
+
+	bool WriteChromeTrace(const char *FilePath, uint64_t *EventCount)
+	{
+		TraceSnapshot *snapshot = CreateSnapshot(0);
+		const bool valid = WriteChromeTrace(FilePath, snapshot, EventCount);
+
+		FreeSnapshot(snapshot);
+		return valid;
+	}
+
+	void SaveTrace()
+	{
+		char fileName[MAX_PATH];
+		GetTracePath(fileName, ARRAYSIZE(fileName));
+
+		uint64_t eventCount = 0;
+
+		if (WriteChromeTrace(fileName, &eventCount))
+			ui::log::Add("Wrote zone trace (%llu events) to %s\n", eventCount, fileName);
+		else
+			ui::log::Add("Failed to write zone trace to %s\n", fileName);
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "profiler_clock.h"
+#include "profiler_thread_ring.h"
+
+//
+// Always-compiled hierarchical zone recorder. Every thread gets a ring buffer holding its last EventsPerThread
+// begin/end events, which can be written out as a Chrome trace (chrome://tracing, ui.perfetto.dev) at any time. This is
+// independent of SKYRIM64_USE_PROFILER and doesn't need a Tracy build, so traces can be collected on users' machines.
+//
+// ProfileZone(Name) also opens a Tracy zone with the same name. ProfileZoneCat(Category, Name) is the same thing for
+// engine hot paths, compiled out unless SKYRIM64_ZONES_<Category> is set in profiler_zone_categories.h.
+//
+#define PROFILE_ZONE_CONCAT_(a, b)		a##b
+#define PROFILE_ZONE_CONCAT(a, b)		PROFILE_ZONE_CONCAT_(a, b)
+#define PROFILE_ZONE_IMPL(Name, Id) \
+	static constexpr Profiler::ZoneSite PROFILE_ZONE_CONCAT(__zoneSite, Id) { __FILE__, __FUNCTION__, Name }; \
+	Profiler::ScopedZone PROFILE_ZONE_CONCAT(__zone, Id)(&PROFILE_ZONE_CONCAT(__zoneSite, Id))
+
+#define PROFILE_ZONE_CAT_IMPL(Enabled, Name)	PROFILE_ZONE_CONCAT(PROFILE_ZONE_CAT_, Enabled)(Name)
+#define PROFILE_ZONE_CAT_0(Name)		((void)0)
+#define PROFILE_ZONE_CAT_1(Name)		ProfileZone(Name)
+
+#define ProfileZone(Name)				ZoneScopedN(Name); PROFILE_ZONE_IMPL(Name, __COUNTER__)
+#define ProfileZoneC(Name, Color)		ZoneScopedNC(Name, Color); PROFILE_ZONE_IMPL(Name, __COUNTER__)
+#define ProfileZoneCat(Category, Name)	PROFILE_ZONE_CAT_IMPL(PROFILE_ZONE_CONCAT(SKYRIM64_ZONES_, Category), Name)
+#define ProfileFrameMark()				FrameMark; Profiler::ZoneRecorder::MarkFrame()
+
+namespace Profiler
+{
+	struct ZoneSite
+	{
+		const char *File;
+		const char *Function;
+		const char *Name;
+	};
+
+	namespace ZoneRecorder
+	{
+		constexpr uint32_t EventsPerThread = 16384;		// Must be a power of two
+		constexpr uint32_t MaxThreads = 256;
+
+		// Stored in the low bits of the site pointer
+		enum EventType : uintptr_t
+		{
+			EVENT_BEGIN = 0,
+			EVENT_END = 1,
+			EVENT_FRAME = 2,
+			EVENT_TYPE_MASK = 3,
+		};
+
+		struct Event
+		{
+			uintptr_t SiteAndType;
+			uint64_t Timestamp;
+		};
+
+		using ThreadRings = ThreadRingSet<Event, EventsPerThread, MaxThreads>;
+		extern ThreadRings Threads;
+
+		constexpr uint32_t MaxSnapshotFrames = 256;		// Frame marks remembered for CreateSnapshot()
+
+		// Events copied out of the rings, see CreateSnapshot()
+		struct TraceSnapshot;
+
+		void SetThreadName(uint32_t ThreadId, const char *Name);
+		void MarkFrame();
+
+		// Copies every thread's events since the start of the last FrameCount frames (0 for everything still in the
+		// rings) so they can be written out later from another thread. Only the thread that marks frames may pass a
+		// nonzero FrameCount. Free with FreeSnapshot().
+		TraceSnapshot *CreateSnapshot(uint32_t FrameCount);
+		void FreeSnapshot(TraceSnapshot *Snapshot);
+
+		bool WriteChromeTrace(const char *FilePath, const TraceSnapshot *Snapshot, uint64_t *EventCount);
+		bool WriteChromeTrace(const char *FilePath, uint64_t *EventCount);
+		void SaveTrace();
+
+		// Writes the exit trace if the UI option is set. Called once from the game's exit() hook.
+		void Shutdown();
+
+		__forceinline void Record(const ZoneSite *Site, EventType Type)
+		{
+			Threads.Record({ (uintptr_t)Site | Type, Clock::Now() });
+		}
+	}
+
+	class ScopedZone
+	{
+	private:
+		const ZoneSite *m_Site;
+
+		ScopedZone() = delete;
+		ScopedZone(ScopedZone&) = delete;
+
+	public:
+		__forceinline ScopedZone(const ZoneSite *Site) : m_Site(Site)
+		{
+			ZoneRecorder::Record(m_Site, ZoneRecorder::EVENT_BEGIN);
+		}
+
+		__forceinline ~ScopedZone()
+		{
+			ZoneRecorder::Record(m_Site, ZoneRecorder::EVENT_END);
+		}
+	};
+}
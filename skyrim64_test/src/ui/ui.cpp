@@ -23,8 +23,21 @@ namespace ui::opt
 	bool RealtimeOcclusionView = false;
 	bool EnableOcclusionTesting = true;
 	bool EnableOccluderRendering = true;
+	bool EnableBinnedOccluderRendering = false;
 	float OccluderMaxDistance = 15000.0f;
 	float OccluderFirstLevelMinSize = 550.0f;
+	int OccluderCacheBudgetMB = 256;
+	int OccluderTriangleBudget = 1024;
+	float OccluderLodScale = 1.0f;
+	bool EnableDepthReprojection = false;
+	float ReprojectionConfidence = 1.0f;
+	bool EnableAdaptiveOcclusionBudget = false;
+	float OcclusionBudgetMs = 4.0f;
+	bool SaveZoneTraceOnExit = false;
+	bool SaveHitchReports = false;
+	bool EnableTelemetryLog = false;
+	bool EnableFrameLimiter = false;
+	float FrameLimitFps = 60.0f;
 }
 
 namespace ui
@@ -81,6 +94,10 @@ namespace ui
     void HandleInput(HWND Wnd, UINT Msg, WPARAM wParam, LPARAM lParam)
     {
 		ImGui_ImplWin32_WndProcHandler(Wnd, Msg, wParam, lParam);
+
+		// Ctrl+F11, ignoring auto-repeat
+		if (Msg == WM_KEYDOWN && wParam == VK_F11 && (GetKeyState(VK_CONTROL) & 0x8000) && !(lParam & (1 << 30)))
+			Profiler::ZoneRecorder::SaveTrace();
     }
 
 	bool IsMouseDragging()
@@ -93,7 +110,7 @@ namespace ui
 
 	void BeginFrame()
 	{
-		ZoneScopedN("ui::BeginFrame");
+		ProfileZone("ui::BeginFrame");
 
 		InFrame = true;
 		ImGui_ImplDX11_NewFrame();
@@ -109,7 +126,7 @@ namespace ui
 
     void EndFrame()
     {
-		ZoneScopedN("ui::EndFrame");
+		ProfileZone("ui::EndFrame");
 
 		if (!InFrame)
 			return;
@@ -213,6 +230,10 @@ namespace ui
 				showTracyWindow = true;
 			if (ImGui::MenuItem("Close Tracy", nullptr, nullptr, SKYRIM64_USE_TRACY ? true : false))
 				showTracyWindow = false;
+			if (ImGui::MenuItem("Save Zone Trace", "Ctrl+F11"))
+				Profiler::ZoneRecorder::SaveTrace();
+			ImGui::MenuItem("Save Zone Trace On Exit", nullptr, &opt::SaveZoneTraceOnExit);
+			ImGui::MenuItem("Save Hitch Reports", nullptr, &opt::SaveHitchReports);
 			ImGui::Separator();
 			ImGui::MenuItem("Job List", nullptr, &showJobListWindow);
 			ImGui::MenuItem("Task List", nullptr, &showTaskListWindow);
@@ -457,6 +478,9 @@ namespace ui
             {
                 ImGui::Text("Time acquiring read locks: %.2fms", ProfileGetDeltaTime("Read Lock Time"));
                 ImGui::Text("Time acquiring write locks: %.2fms", ProfileGetDeltaTime("Write Lock Time"));
+                ImGui::Spacing();
+                ImGui::Text("Read lock wait: %s", detail::FormatPercentiles(ProfileGetPercentiles("Read Lock Time")));
+                ImGui::Text("Write lock wait: %s", detail::FormatPercentiles(ProfileGetPercentiles("Write Lock Time")));
                 ImGui::EndGroupSplitter();
             }
 
@@ -486,6 +510,9 @@ namespace ui
                 ImGui::Spacing();
                 ImGui::Text("Time spent allocating: %.2fms", ProfileGetDeltaTime("Time Spent Allocating"));
                 ImGui::Text("Time spent freeing: %.2fms", ProfileGetDeltaTime("Time Spent Freeing"));
+                ImGui::Spacing();
+                ImGui::Text("Allocation: %s", detail::FormatPercentiles(ProfileGetPercentiles("Time Spent Allocating")));
+                ImGui::Text("Free: %s", detail::FormatPercentiles(ProfileGetPercentiles("Time Spent Freeing")));
                 ImGui::EndGroupSplitter();
             }
 
@@ -529,6 +556,7 @@ namespace ui
                 ImGui::Spacing();
                 ImGui::Text("Update time: %.2fms", ProfileGetDeltaTime("Cache Update Time"));
                 ImGui::Text("Fetch time: %.2fms", ProfileGetDeltaTime("Cache Fetch Time"));
+                ImGui::Text("Fetch: %s", detail::FormatPercentiles(ProfileGetPercentiles("Cache Fetch Time")));
                 ImGui::EndGroupSplitter();
             }
 
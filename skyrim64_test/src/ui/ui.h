@@ -11,8 +11,21 @@ namespace ui
 		extern bool RealtimeOcclusionView;
 		extern bool EnableOcclusionTesting;
 		extern bool EnableOccluderRendering;
+		extern bool EnableBinnedOccluderRendering;
 		extern float OccluderMaxDistance;
 		extern float OccluderFirstLevelMinSize;
+		extern int OccluderCacheBudgetMB;
+		extern int OccluderTriangleBudget;
+		extern float OccluderLodScale;
+		extern bool EnableDepthReprojection;
+		extern float ReprojectionConfidence;
+		extern bool EnableAdaptiveOcclusionBudget;
+		extern float OcclusionBudgetMs;
+		extern bool SaveZoneTraceOnExit;
+		extern bool SaveHitchReports;
+		extern bool EnableTelemetryLog;
+		extern bool EnableFrameLimiter;
+		extern float FrameLimitFps;
 	}
 
 	extern bool showTracyWindow;
@@ -2,6 +2,7 @@
 #include "../patches/dinput8.h"
 #include "../patches/TES/Setting.h"
 #include "../patches/rendering/GpuTimer.h"
+#include "../patches/rendering/FramePacer.h"
 #include "../patches/TES/BSShader/BSShaderRenderTargets.h"
 #include "../patches/TES/NiMain/NiNode.h"
 #include "imgui_ext.h"
@@ -13,6 +14,10 @@
 #include "../patches/TES/NiMain/BSMultiBoundNode.h"
 #include "../patches/TES/BSShader/BSShaderProperty.h"
 #include "../patches/TES/NiMain/NiCamera.h"
+#include "../patches/TES/MOC.h"
+#include "../patches/TES/MOC_BudgetController.h"
+#include "../profiler_telemetry.h"
+#include "../profiler_hitch.h"
 
 extern LARGE_INTEGER g_FrameDelta;
 std::vector<std::pair<ID3D11ShaderResourceView *, std::string>> g_ResourceViews;
@@ -25,14 +30,155 @@ namespace ui
 	//
 	float LastFpsCount;
 
-	float DeltasFrameTime[240];
-	float DeltasCPUPercent[240];
-	float DeltasThreadPercent[240];
-	float DeltasGPU0Percent[240];
-	float DeltasGPU1Percent[240];
-	float DeltasFrameTimeGPU[240];
-	float DeltasGraphDrawCalls[240];
-	float DeltasGraphDispatchCalls[240];
+	// Profiler counters recorded with every frame, as deltas
+	const char *TelemetryCounterNames[] =
+	{
+		"Draw Calls",
+		"Dispatch Calls",
+		"CB Bytes Requested",
+		"VIB Bytes Requested",
+		"MOC ObjectsRendered",
+		"MOC CullObjectCount",
+		"Dynamic VB Stall Us",
+	};
+
+	Profiler::FrameTelemetry FrameTelemetry(TelemetryCounterNames, ARRAYSIZE(TelemetryCounterNames));
+	Profiler::FrameTelemetryLog FrameTelemetryLog(FrameTelemetry);
+	int64_t TelemetryCounterTotals[ARRAYSIZE(TelemetryCounterNames)];
+
+	// Judges each frame against the recent ones instead of a fixed threshold
+	Profiler::HitchDetector HitchDetector;
+
+	constexpr int FrameGraphLength = 240;
+	constexpr uint32_t UsageSampleFrames = 15;		// ~4 Hz at 60 FPS
+	constexpr uint32_t SummaryRefreshFrames = 30;	// ~2 Hz at 60 FPS
+	constexpr uint32_t HitchTraceFrames = 8;		// Zone trace saved with a hitch report: the hitch and the frames before it
+
+	const Profiler::FrameSample& GetGraphSample(int Index)
+	{
+		static const Profiler::FrameSample emptySample = {};
+		const uint32_t age = FrameGraphLength - 1 - Index;
+
+		return (age < FrameTelemetry.GetCount()) ? FrameTelemetry.GetRecent(age) : emptySample;
+	}
+
+	float GetGraphField(const void *Field, int Index)
+	{
+		return GetGraphSample(Index).*(*(float Profiler::FrameSample::* const *)Field);
+	}
+
+	float GetGraphCounter(const void *CounterIndex, int Index)
+	{
+		return (float)GetGraphSample(Index).Counters[*(const uint32_t *)CounterIndex];
+	}
+
+	void UpdateFrameTelemetryLog()
+	{
+		if (opt::EnableTelemetryLog == FrameTelemetryLog.IsRunning())
+			return;
+
+		if (!opt::EnableTelemetryLog)
+		{
+			FrameTelemetryLog.Stop();
+			ui::log::Add("Stopped frame telemetry log\n");
+			return;
+		}
+
+		// Put it next to the exe, same as crash dumps
+		char exePath[MAX_PATH];
+		char basePath[MAX_PATH];
+		GetModuleFileNameA(GetModuleHandle(nullptr), exePath, ARRAYSIZE(exePath));
+
+		SYSTEMTIME sysTime;
+		GetSystemTime(&sysTime);
+		sprintf_s(basePath, "%s_%4d%02d%02d_%02d%02d%02d_telemetry", exePath, sysTime.wYear, sysTime.wMonth, sysTime.wDay, sysTime.wHour, sysTime.wMinute, sysTime.wSecond);
+
+		if (FrameTelemetryLog.Start(basePath))
+		{
+			ui::log::Add("Logging frame telemetry to %s_*.csv\n", basePath);
+		}
+		else
+		{
+			ui::log::Add("Failed to open frame telemetry log %s_0.csv\n", basePath);
+			opt::EnableTelemetryLog = false;
+		}
+	}
+
+	void SaveHitchReport(const char *const *ScopeNames)
+	{
+		// Only one report is written at a time. Hitches are at least a cooldown apart, so this rarely drops one.
+		static std::atomic_bool writing;
+
+		if (writing.exchange(true))
+		{
+			ui::log::Add("Skipped hitch report, the previous one is still being written\n");
+			return;
+		}
+
+		// Put it next to the exe, same as crash dumps. The zone trace covers the last few frames in more detail.
+		char exePath[MAX_PATH];
+		char reportPath[MAX_PATH];
+		char tracePath[MAX_PATH];
+		GetModuleFileNameA(GetModuleHandle(nullptr), exePath, ARRAYSIZE(exePath));
+
+		SYSTEMTIME sysTime;
+		GetSystemTime(&sysTime);
+		sprintf_s(reportPath, "%s_%4d%02d%02d_%02d%02d%02d_hitch.txt", exePath, sysTime.wYear, sysTime.wMonth, sysTime.wDay, sysTime.wHour, sysTime.wMinute, sysTime.wSecond);
+		sprintf_s(tracePath, "%s_%4d%02d%02d_%02d%02d%02d_hitch.json", exePath, sysTime.wYear, sysTime.wMonth, sysTime.wDay, sysTime.wHour, sysTime.wMinute, sysTime.wSecond);
+
+		// Formatting the report and copying the zones of the last few frames is all that happens on the frame thread.
+		// Both go to disk from a background thread.
+		std::string report;
+		HitchDetector.FormatReport(report, ScopeNames, FrameTelemetry);
+
+		Profiler::ZoneRecorder::TraceSnapshot *trace = Profiler::ZoneRecorder::CreateSnapshot(HitchTraceFrames);
+
+		std::thread([report = std::move(report), trace, reportPath = std::string(reportPath), tracePath = std::string(tracePath)]()
+		{
+			// Deliberately left unnamed. Naming a thread attaches it to the zone and flight recorder rings, which are never
+			// freed.
+			FILE *f = Profiler::OpenTelemetryFile(reportPath.c_str());
+			bool valid = f && fwrite(report.data(), 1, report.size(), f) == report.size();
+			valid = f && (fclose(f) == 0) && valid;
+
+			if (valid)
+				ui::log::Add("Wrote hitch report to %s\n", reportPath.c_str());
+			else
+				ui::log::Add("Failed to write hitch report to %s\n", reportPath.c_str());
+
+			if (Profiler::ZoneRecorder::WriteChromeTrace(tracePath.c_str(), trace, nullptr))
+				ui::log::Add("Wrote hitch zone trace to %s\n", tracePath.c_str());
+			else
+				ui::log::Add("Failed to write hitch zone trace to %s\n", tracePath.c_str());
+
+			Profiler::ZoneRecorder::FreeSnapshot(trace);
+			writing = false;
+		}).detach();
+	}
+
+	void UpdateHitchDetector(float FrameTimeMs)
+	{
+		Profiler::TimerTotal timers[Profiler::HitchDetector::MaxScopes];
+		const uint32_t timerCount = ProfileGetTimerTotals(timers, ARRAYSIZE(timers));
+
+		int64_t totals[ARRAYSIZE(timers)];
+		const char *names[ARRAYSIZE(timers)];
+
+		for (uint32_t i = 0; i < timerCount; i++)
+		{
+			totals[i] = timers[i].Ticks;
+			names[i] = timers[i].Name;
+		}
+
+		if (!HitchDetector.AddFrame(FrameTimeMs, totals, timerCount))
+			return;
+
+		if (opt::LogHitches)
+			ui::log::Add("FRAME HITCH WARNING (%g ms, baseline %g ms)\n", FrameTimeMs, HitchDetector.GetBaselineMs());
+
+		if (opt::SaveHitchReports)
+			SaveHitchReport(names);
+	}
 
 	void RenderFrameStatistics()
 	{
@@ -42,23 +188,62 @@ namespace ui
 
 		float frameTimeMs = 1000.0f * (float)(g_FrameDelta.QuadPart / (double)ticksPerSecond.QuadPart);
 
-		if (ui::opt::LogHitches && frameTimeMs >= 50.0f)
-			ui::log::Add("FRAME HITCH WARNING (%g ms)\n", frameTimeMs);
-
 		LastFpsCount = detail::CalculateTrueAverageFPS();
 
+		// Telemetry is recorded every frame so nothing is lost while the window is closed
+		{
+			Profiler::FrameSample sample = {};
+			sample.FrameTimeMs = frameTimeMs;
+			sample.GpuTimeMs = g_GPUTimers.GetGPUTimeInMS(0);
+
+			// Usage comes from GetProcessTimes()/NvAPI, which are too slow to call every frame. Sample about 4 times a
+			// second and repeat the last values in between.
+			static Profiler::FrameSample usage;
+			static uint32_t usageFrames = UsageSampleFrames;
+
+			if (++usageFrames >= UsageSampleFrames)
+			{
+				usage.CpuPercent = detail::GetProcessorUsagePercent();
+				usage.ThreadPercent = detail::GetThreadUsagePercent();
+				usage.Gpu0Percent = detail::GetGpuUsagePercent(0);
+				usage.Gpu1Percent = detail::GetGpuUsagePercent(1);
+				usageFrames = 0;
+			}
+
+			sample.CpuPercent = usage.CpuPercent;
+			sample.ThreadPercent = usage.ThreadPercent;
+			sample.Gpu0Percent = usage.Gpu0Percent;
+			sample.Gpu1Percent = usage.Gpu1Percent;
+
+			// Peek so the deltas other windows show aren't disturbed
+			for (uint32_t i = 0; i < ARRAYSIZE(TelemetryCounterNames); i++)
+			{
+				int64_t total = ProfilePeekValue(TelemetryCounterNames[i]);
+
+				sample.Counters[i] = total - TelemetryCounterTotals[i];
+				TelemetryCounterTotals[i] = total;
+			}
+
+			FrameTelemetry.Record(sample);
+			UpdateFrameTelemetryLog();
+			UpdateHitchDetector(frameTimeMs);
+		}
+
+		// Percentiles over the whole ring are only worth computing while someone is looking at them, and not every frame
+		static Profiler::FrameTelemetry::Summary summary;
+		static uint32_t summaryFrames = SummaryRefreshFrames;
+
 		if (!showFrameStatsWindow)
+		{
+			summaryFrames = SummaryRefreshFrames;
 			return;
+		}
 
-		// Shift everything else back first...
-		memmove(&DeltasFrameTime[0], &DeltasFrameTime[1], sizeof(DeltasFrameTime) - sizeof(float));
-		memmove(&DeltasFrameTimeGPU[0], &DeltasFrameTimeGPU[1], sizeof(DeltasFrameTimeGPU) - sizeof(float));
-		memmove(&DeltasCPUPercent[0], &DeltasCPUPercent[1], sizeof(DeltasCPUPercent) - sizeof(float));
-		memmove(&DeltasThreadPercent[0], &DeltasThreadPercent[1], sizeof(DeltasThreadPercent) - sizeof(float));
-		memmove(&DeltasGPU0Percent[0], &DeltasGPU0Percent[1], sizeof(DeltasGPU0Percent) - sizeof(float));
-		memmove(&DeltasGPU1Percent[0], &DeltasGPU1Percent[1], sizeof(DeltasGPU1Percent) - sizeof(float));
-		memmove(&DeltasGraphDrawCalls[0], &DeltasGraphDrawCalls[1], sizeof(DeltasGraphDrawCalls) - sizeof(float));
-		memmove(&DeltasGraphDispatchCalls[0], &DeltasGraphDispatchCalls[1], sizeof(DeltasGraphDispatchCalls) - sizeof(float));
+		if (++summaryFrames >= SummaryRefreshFrames)
+		{
+			summary = FrameTelemetry.Summarize(Profiler::FrameTelemetry::Capacity);
+			summaryFrames = 0;
+		}
 
 		if (ImGui::Begin("Frame Statistics", &showFrameStatsWindow))
 		{
@@ -70,45 +255,73 @@ namespace ui
 				ImColor(0.121f, 0.466f, 0.705f)
 			};
 
+			using FieldPtr = float Profiler::FrameSample::*;
+
 			// Draw frame time graph
 			{
-				DeltasFrameTime[239] = frameTimeMs;
-				DeltasFrameTimeGPU[239] = g_GPUTimers.GetGPUTimeInMS(0);
+				const static FieldPtr fields[2] = { &Profiler::FrameSample::FrameTimeMs, &Profiler::FrameSample::GpuTimeMs };
 
 				const char *names[2] = { "CPU", "GPU" };
-				const void *datas[2] = { DeltasFrameTime, DeltasFrameTimeGPU };
+				const void *datas[2] = { &fields[0], &fields[1] };
 
-				ImGui::PlotMultiLines("Frame Time (ms)\n** Minus Present() flip", 2, names, colors, [](const void *a, int idx) { return ((float *)a)[idx]; }, datas, 240, 0.0f, 32.0f, ImVec2(400, 100));
+				ImGui::PlotMultiLines("Frame Time (ms)\n** Minus Present() flip", 2, names, colors, GetGraphField, datas, FrameGraphLength, 0.0f, 32.0f, ImVec2(400, 100));
 			}
 
 			// Draw processor usage (CPU, GPU) graph
 			{
-				DeltasCPUPercent[239] = detail::GetProcessorUsagePercent();
-				DeltasThreadPercent[239] = detail::GetThreadUsagePercent();
-				DeltasGPU0Percent[239] = detail::GetGpuUsagePercent(0);
-				DeltasGPU1Percent[239] = detail::GetGpuUsagePercent(1);
+				const static FieldPtr fields[4] =
+				{
+					&Profiler::FrameSample::CpuPercent,
+					&Profiler::FrameSample::ThreadPercent,
+					&Profiler::FrameSample::Gpu0Percent,
+					&Profiler::FrameSample::Gpu1Percent,
+				};
 
 				const char *names[4] = { "CPU Total", "Main Thread", "GPU 0", "GPU 1" };
-				const void *datas[4] = { DeltasCPUPercent, DeltasThreadPercent, DeltasGPU0Percent, DeltasGPU1Percent };
+				const void *datas[4] = { &fields[0], &fields[1], &fields[2], &fields[3] };
 
-				ImGui::PlotMultiLines("Processor Usage (%)", 4, names, colors, [](const void *a, int idx) { return ((float *)a)[idx]; }, datas, 240, 0.0f, 100.0f, ImVec2(400, 100));
+				ImGui::PlotMultiLines("Processor Usage (%)", 4, names, colors, GetGraphField, datas, FrameGraphLength, 0.0f, 100.0f, ImVec2(400, 100));
 			}
 
-			// Draw calls
+			// Draw calls (TelemetryCounterNames[0] and [1])
 			{
-				DeltasGraphDrawCalls[239] = (float)ProfileGetDeltaValue("Draw Calls");
-				DeltasGraphDispatchCalls[239] = (float)ProfileGetDeltaValue("Dispatch Calls");
+				const static uint32_t counters[2] = { 0, 1 };
 
 				const char *names[2] = { "Draws", "Dispatches" };
-				const void *datas[2] = { DeltasGraphDrawCalls, DeltasGraphDispatchCalls };
+				const void *datas[2] = { &counters[0], &counters[1] };
 
-				ImGui::PlotMultiLines("Draw Calls", 2, names, colors, [](const void *a, int idx) { return ((float *)a)[idx]; }, datas, 240, 0.0f, 10000.0f, ImVec2(400, 100));
-
-				ProfileGetValue("Draw Calls");
-				ProfileGetValue("Dispatch Calls");
+				ImGui::PlotMultiLines("Draw Calls", 2, names, colors, GetGraphCounter, datas, FrameGraphLength, 0.0f, 10000.0f, ImVec2(400, 100));
 			}
 
 			ImGui::Text("FPS: %.2f", LastFpsCount);
+			ImGui::Text("Last %u frames: %.1f FPS, 1%% low %.1f, 0.1%% low %.1f", summary.Count, summary.MeanFps, summary.OnePercentLowFps, summary.PointOnePercentLowFps);
+			ImGui::Text("Frame time: mean %.2fms, stdev %.2fms, max %.2fms", summary.MeanMs, summary.StdevMs, summary.MaxMs);
+
+			// Refresh about once a second so the percentiles have something to work with
+			static FramePacer::ErrorWindow pacing;
+			static uint32_t pacingFrames;
+
+			if (++pacingFrames >= 60)
+			{
+				pacing = g_FramePacer.ConsumeErrorWindow();
+				pacingFrames = 0;
+			}
+
+			ImGui::Checkbox("Frame Limiter", &opt::EnableFrameLimiter);
+			ImGui::SameLine();
+			ImGui::PushItemWidth(100.0f);
+			ImGui::DragFloat("Target FPS", &opt::FrameLimitFps, 1.0f, 10.0f, 500.0f, "%.0f");
+			ImGui::PopItemWidth();
+
+			if (opt::EnableFrameLimiter && pacing.Count > 0)
+				ImGui::Text("Pacing error: p50 %.0fus, p99 %.0fus, max %.0fus (spin %.0fus)", pacing.P50Us, pacing.P99Us, pacing.MaxUs, pacing.SpinUs);
+
+			ImGui::Checkbox("Log To CSV", &opt::EnableTelemetryLog);
+			if (FrameTelemetryLog.IsRunning())
+			{
+				ImGui::SameLine();
+				ImGui::TextDisabled("%s_*.csv", FrameTelemetryLog.GetBasePath());
+			}
 			ImGui::Spacing();
 			ImGui::Text("CB Bytes Requested: %s", ImGui::CommaFormat(ProfileGetDeltaValue("CB Bytes Requested")));
 			ImGui::Text("CB Bytes Wasted: %s", ImGui::CommaFormat(ProfileGetDeltaValue("CB Bytes Wasted")));
@@ -181,7 +394,7 @@ namespace ui
 			ImGui::Text("%.2fms", ProfileGetDeltaTime("MOC RenderGeometry")); ImGui::NextColumn();
 
 			ImGui::Text("Test Occludees:"); ImGui::NextColumn();
-			ImGui::Text("%.2fms", ProfileGetDeltaTime("MOC CullTest")); ImGui::NextColumn();
+			ImGui::Text("%.2fms", ProfileGetDeltaTime("MOC CullTest") + ProfileGetDeltaTime("MOC CullTestBatch")); ImGui::NextColumn();
 
 			ImGui::Text("Object Count:"); ImGui::NextColumn();
 			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC ObjectsRendered"))); ImGui::NextColumn();
@@ -197,14 +410,99 @@ namespace ui
 			ImGui::Text("Passed Objects:"); ImGui::NextColumn();
 			ImGui::Text("%s (%.1f%%)", ImGui::CommaFormat(ProfileGetDeltaValue("MOC CullObjectPassed")), culledPercent); ImGui::NextColumn();
 
+			ImGui::Text("Mesh Cache Hits:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC CacheHits"))); ImGui::NextColumn();
+
+			ImGui::Text("Mesh Cache Misses:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC CacheMisses"))); ImGui::NextColumn();
+
+			ImGui::Text("Mesh Cache Evictions:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC CacheEvictions"))); ImGui::NextColumn();
+
+			ImGui::Text("Mesh Cache Memory:"); ImGui::NextColumn();
+			ImGui::Text("%.1f MB (%s)", (double)MOC::GetMeshCacheMemoryUsage() / (1024.0 * 1024.0), ImGui::CommaFormat(MOC::GetMeshCacheEntryCount())); ImGui::NextColumn();
+
+			float triangleRatio = 100.0f * (float)ProfileGetDeltaValue("MOC TrianglesRendered") / (float)std::max<uint64_t>(ProfileGetDeltaValue("MOC TrianglesSource"), 1);
+
+			ImGui::Text("Source Triangles:"); ImGui::NextColumn();
+			ImGui::Text("%s (%.1f%% drawn)", ImGui::CommaFormat(ProfileGetDeltaValue("MOC TrianglesSource")), triangleRatio); ImGui::NextColumn();
+
+			ImGui::Text("Build LODs:"); ImGui::NextColumn();
+			ImGui::Text("%.2fms", ProfileGetDeltaTime("MOC BuildLods")); ImGui::NextColumn();
+
+			float earlyPercent = 100.0f * (float)ProfileGetDeltaValue("MOC CullDecidedEarly") / (float)std::max<uint64_t>(ProfileGetDeltaValue("MOC CullDecidedEarly") + ProfileGetDeltaValue("MOC CullDecidedLate"), 1);
+
+			ImGui::Text("Decided Early:"); ImGui::NextColumn();
+			ImGui::Text("%s (%.1f%%)", ImGui::CommaFormat(ProfileGetDeltaValue("MOC CullDecidedEarly")), earlyPercent); ImGui::NextColumn();
+
+			ImGui::Text("Decided Late:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC CullDecidedLate"))); ImGui::NextColumn();
+
+			ImGui::Text("Reprojection:"); ImGui::NextColumn();
+			ImGui::Text("%.2fms", ProfileGetDeltaTime("MOC ReprojectCapture") + ProfileGetDeltaTime("MOC Reproject")); ImGui::NextColumn();
+
+			ImGui::Text("Frustum Tests:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC FrustumSphereTests"))); ImGui::NextColumn();
+
+			ImGui::Text("Frustum Tests Skipped:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC FrustumTestsSkipped"))); ImGui::NextColumn();
+
+			ImGui::Text("Worker Parks:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC WorkerParks"))); ImGui::NextColumn();
+
+			const MOC_BudgetController *budget = MOC::GetBudgetController();
+
+			ImGui::Text("Budget Raster/Query:"); ImGui::NextColumn();
+			ImGui::Text("%.2fms / %.2fms", budget ? budget->GetRasterMs() : 0.0f, budget ? budget->GetQueryMs() : 0.0f); ImGui::NextColumn();
+
+			ImGui::Text("Buffer Resolution:"); ImGui::NextColumn();
+			if (budget)
+				ImGui::Text("%ux%u (%u cooldown)", budget->GetWidth(), budget->GetHeight(), budget->GetResizeCooldown());
+			else
+				ImGui::Text("-");
+			ImGui::NextColumn();
+
+			ImGui::Text("Occluder Budget:"); ImGui::NextColumn();
+			if (budget && budget->GetOccluderBudget() != MOC_BudgetController::UnlimitedOccluders)
+				ImGui::Text("%s", ImGui::CommaFormat(budget->GetOccluderBudget()));
+			else
+				ImGui::Text("Unlimited");
+			ImGui::NextColumn();
+
+			ImGui::Text("Over Budget Occluders:"); ImGui::NextColumn();
+			ImGui::Text("%s", ImGui::CommaFormat(ProfileGetDeltaValue("MOC OccludersOverBudget"))); ImGui::NextColumn();
+
+			ImGui::Text("Draw Occluder Latency:"); ImGui::NextColumn();
+			ImGui::Text("%s", detail::FormatPercentiles(ProfileGetPercentiles("MOC RenderGeometry"))); ImGui::NextColumn();
+
+			ImGui::Text("Test Occludee Latency:"); ImGui::NextColumn();
+			ImGui::Text("%s", detail::FormatPercentiles(ProfileGetPercentiles("MOC CullTest"))); ImGui::NextColumn();
+
+			ImGui::Text("Test Batch Latency:"); ImGui::NextColumn();
+			ImGui::Text("%s", detail::FormatPercentiles(ProfileGetPercentiles("MOC CullTestBatch"))); ImGui::NextColumn();
+
 			ProfileGetTime("MOC TraverseSceneGraph");
 			ProfileGetTime("MOC WaitForRender");
 			ProfileGetTime("MOC RenderGeometry");
 			ProfileGetTime("MOC CullTest");
+			ProfileGetTime("MOC CullTestBatch");
+			ProfileGetTime("MOC BuildLods");
+			ProfileGetTime("MOC ReprojectCapture");
+			ProfileGetTime("MOC Reproject");
 			ProfileGetValue("MOC ObjectsRendered");
 			ProfileGetValue("MOC CullObjectCount");
 			ProfileGetValue("MOC TrianglesRendered");
 			ProfileGetValue("MOC CullObjectPassed");
+			ProfileGetValue("MOC CacheHits");
+			ProfileGetValue("MOC CacheMisses");
+			ProfileGetValue("MOC CacheEvictions");
+			ProfileGetValue("MOC TrianglesSource");
+			ProfileGetValue("MOC CullDecidedEarly");
+			ProfileGetValue("MOC CullDecidedLate");
+			ProfileGetValue("MOC FrustumSphereTests");
+			ProfileGetValue("MOC FrustumTestsSkipped");
+			ProfileGetValue("MOC WorkerParks");
+			ProfileGetValue("MOC OccludersOverBudget");
 
 			ImGui::Columns(1);
 			ImGui::Separator();
@@ -212,19 +510,35 @@ namespace ui
 			ImGui::Spacing();
 			ImGui::DragFloat("Max 2D Render Distance", &ui::opt::OccluderMaxDistance, 10.0f, 1.0f, 1000000.0f);
 			ImGui::DragFloat("First Level Occluder Size", &ui::opt::OccluderFirstLevelMinSize, 1.0f, 1.0f, 100000.0f);
+			ImGui::DragInt("Mesh Cache Budget (MB)", &ui::opt::OccluderCacheBudgetMB, 1.0f, 16, 4096);
+			ImGui::DragInt("Occluder Triangle Budget", &ui::opt::OccluderTriangleBudget, 8.0f, 32, 65536);
+			ImGui::DragFloat("Occluder LOD Scale", &ui::opt::OccluderLodScale, 0.01f, 0.1f, 16.0f);
+			ImGui::Checkbox("Depth Reprojection", &ui::opt::EnableDepthReprojection);
+			ImGui::SliderFloat("Reprojection Confidence", &ui::opt::ReprojectionConfidence, 0.5f, 1.0f);
+			ImGui::Checkbox("Adaptive Budget", &ui::opt::EnableAdaptiveOcclusionBudget);
+			ImGui::DragFloat("Budget Target (ms)", &ui::opt::OcclusionBudgetMs, 0.05f, 0.25f, 50.0f);
 			ImGui::Checkbox("Draw Occluders", &ui::opt::EnableOccluderRendering);
+			ImGui::Checkbox("Binned Occluder Rasterization", &ui::opt::EnableBinnedOccluderRendering);
 			ImGui::Checkbox("Test Occludees", &ui::opt::EnableOcclusionTesting);
 			ImGui::Checkbox("Disable Viewer Updates", &disableViewerUpdates);
 			ImGui::Combo("Viewer Resolution", &viewerResolutionIndex, " 640 x 480\0 1024 x 768\0 1920 x 1080\0\0");
+			if (ImGui::Button("Capture Frame"))
+				MOC::RequestFrameCapture();
 			ImGui::Spacing();
 			ImGui::Text("Viewer");
 			ImGui::Separator();
 
+			// The texture is allocated for the largest buffer. Only show the part that's in use.
+			ImVec2 uvMax(1.0f, 1.0f);
+
+			if (budget)
+				uvMax = ImVec2(budget->GetWidth() / (float)budget->GetResolution(0).Width, budget->GetHeight() / (float)budget->GetResolution(0).Height);
+
 			switch (viewerResolutionIndex)
 			{
-			default:ImGui::Image((ImTextureID)g_OcclusionTextureSRV, ImVec2(640, 480)); break;
-			case 1: ImGui::Image((ImTextureID)g_OcclusionTextureSRV, ImVec2(1024, 768)); break;
-			case 2: ImGui::Image((ImTextureID)g_OcclusionTextureSRV, ImVec2(1920, 1080)); break;
+			default:ImGui::Image((ImTextureID)g_OcclusionTextureSRV, ImVec2(640, 480), ImVec2(0, 0), uvMax); break;
+			case 1: ImGui::Image((ImTextureID)g_OcclusionTextureSRV, ImVec2(1024, 768), ImVec2(0, 0), uvMax); break;
+			case 2: ImGui::Image((ImTextureID)g_OcclusionTextureSRV, ImVec2(1920, 1080), ImVec2(0, 0), uvMax); break;
 			}
 		}
 		ImGui::End();
@@ -590,5 +904,19 @@ namespace ui
 
 			return 0.0f;
 		}
+
+		const char *FormatPercentiles(const Profiler::Percentiles& Value)
+		{
+			static char buffer[128];
+
+			if (Value.Count == 0)
+				return "-";
+
+			// Individual scopes are usually well under a millisecond
+			sprintf_s(buffer, "p50 %.1fus, p95 %.1fus, p99 %.1fus, max %.1fus",
+				Value.P50 * 1000.0, Value.P95 * 1000.0, Value.P99 * 1000.0, Value.Max * 1000.0);
+
+			return buffer;
+		}
 	}
 }
\ No newline at end of file
@@ -15,5 +15,6 @@ namespace ui
 		float GetProcessorUsagePercent();
 		float GetThreadUsagePercent();
 		float GetGpuUsagePercent(int GpuIndex);
+		const char *FormatPercentiles(const Profiler::Percentiles& Value);
 	}
 }
\ No newline at end of file
@@ -87,6 +87,9 @@ namespace XUtil
 #endif
 		}
 
+		Profiler::ZoneRecorder::SetThreadName(ThreadID, ThreadName);
+		Profiler::FlightRecorder::SetThreadName(ThreadID, ThreadName);
+
 #pragma pack(push, 8)  
 		const DWORD MS_VC_EXCEPTION = 0x406D1388;
 
@@ -387,9 +390,27 @@ namespace XUtil
 						.ClientPointers = FALSE,
 					};
 
+					// Recent engine events from every thread (see flight_dump)
+					uint32_t flightSize = 0;
+					void *flightData = Profiler::FlightRecorder::CreateSnapshot(g_CrashDumpTargetThreadId, &flightSize);
+
+					MINIDUMP_USER_STREAM flightStream
+					{
+						.Type = Profiler::FlightRecorder::DumpStreamType,
+						.BufferSize = flightSize,
+						.Buffer = flightData,
+					};
+
+					MINIDUMP_USER_STREAM_INFORMATION userStreams
+					{
+						.UserStreamCount = flightData ? 1ul : 0ul,
+						.UserStreamArray = &flightStream,
+					};
+
 					auto dumpFlags = (MINIDUMP_TYPE)(MiniDumpNormal | MiniDumpWithIndirectlyReferencedMemory | MiniDumpWithThreadInfo);
-					dumpWritten = miniDumpWriteDump(GetCurrentProcess(), GetCurrentProcessId(), file, dumpFlags, &dumpInfo, nullptr, nullptr) != FALSE;
+					dumpWritten = miniDumpWriteDump(GetCurrentProcess(), GetCurrentProcessId(), file, dumpFlags, &dumpInfo, &userStreams, nullptr) != FALSE;
 
+					Profiler::FlightRecorder::FreeSnapshot(flightData);
 					CloseHandle(file);
 				}
 			}